@@ -0,0 +1,500 @@
+#include "StandInServer.h"
+
+#include "core/BoundedQueue.h"
+#include "core/TimeUtils.h"
+#include "http/HttpClient.h"
+#include <nlohmann/json.hpp>
+#include <zlib.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+
+using Request = LocalHttpServer::Request;
+using Response = LocalHttpServer::Response;
+
+constexpr const char* kTypes[4] = {"location.gps", "photo", "calendar.event", "location.googletimeline"};
+constexpr double kInf = std::numeric_limits<double>::infinity();
+
+int typeIndex(const std::string& type)
+{
+    for (int i = 0; i < 4; ++i)
+        if (type == kTypes[i]) return i;
+    return -1;
+}
+
+Response error(int status, const std::string& message)
+{
+    Response r;
+    r.status = status;
+    r.body = nlohmann::json{{"detail", message}}.dump();
+    r.headers.emplace_back("Content-Type", "application/json");
+    return r;
+}
+
+bool isGzip(const std::string& body)
+{
+    return body.size() >= 2 && static_cast<unsigned char>(body[0]) == 0x1f &&
+           static_cast<unsigned char>(body[1]) == 0x8b;
+}
+
+bool acceptsGzip(const Request& req)
+{
+    return req.header("accept-encoding").find("gzip") != std::string::npos;
+}
+
+/// Query parameter `name` of a target, %-decoded; empty if absent.
+std::string param(const std::string& target, const std::string& name)
+{
+    size_t q = target.find('?');
+    while (q != std::string::npos) {
+        size_t begin = q + 1;
+        size_t end = target.find('&', begin);
+        size_t eq = target.find('=', begin);
+        if (eq < end && target.compare(begin, eq - begin, name) == 0) {
+            std::string raw = target.substr(eq + 1, end == std::string::npos ? std::string::npos : end - eq - 1);
+            std::string value;
+            for (size_t i = 0; i < raw.size(); ++i) {
+                if (raw[i] == '%' && i + 2 < raw.size()) {
+                    value += static_cast<char>(std::stoi(raw.substr(i + 1, 2), nullptr, 16));
+                    i += 2;
+                } else {
+                    value += raw[i] == '+' ? ' ' : raw[i];
+                }
+            }
+            return value;
+        }
+        q = end;
+    }
+    return {};
+}
+
+double timeParam(const std::string& target, const std::string& name, double fallback)
+{
+    std::string value = param(target, name);
+    return value.empty() ? fallback : TimeUtils::parse_iso8601(value);
+}
+
+void appendString(std::string& out, const std::string& s)
+{
+    out += '"';
+    for (char c : s) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char esc[8];
+            std::snprintf(esc, sizeof(esc), "\\u%04x", c);
+            out += esc;
+        } else {
+            out += c;
+        }
+    }
+    out += '"';
+}
+
+void appendNumber(std::string& out, const std::optional<double>& v)
+{
+    if (!v) {
+        out += "null";
+        return;
+    }
+    char buf[32];
+    out.append(buf, static_cast<size_t>(std::snprintf(buf, sizeof(buf), "%.7f", *v)));
+}
+
+/// One entity in the server's JSON shape (instants have a null t_end).
+void appendEntity(std::string& out, const Entity& e)
+{
+    out += "{\"id\":";
+    appendString(out, e.id);
+    out += ",\"t_start\":\"" + TimeUtils::to_iso8601(e.time_start) + "\",\"t_end\":";
+    if (e.is_instant()) out += "null";
+    else out += "\"" + TimeUtils::to_iso8601(e.time_end) + "\"";
+    out += ",\"lat\":";
+    appendNumber(out, e.lat);
+    out += ",\"lon\":";
+    appendNumber(out, e.lon);
+    if (e.name) {
+        out += ",\"name\":";
+        appendString(out, *e.name);
+    }
+    if (e.color) {
+        out += ",\"color\":";
+        appendString(out, *e.color);
+    }
+    out += '}';
+}
+
+Response entitiesResponse(const std::vector<Entity>& entities)
+{
+    Response r;
+    r.body = "{\"entities\":[";
+    for (size_t i = 0; i < entities.size(); ++i) {
+        if (i) r.body += ',';
+        appendEntity(r.body, entities[i]);
+    }
+    r.body += "]}";
+    r.headers.emplace_back("Content-Type", "application/json");
+    return r;
+}
+
+/// gzip compression of a body produced piece by piece.
+class Deflater {
+public:
+    explicit Deflater(int level) {
+        if (deflateInit2(&m_zs, level, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+            throw std::runtime_error("StandInServer: deflateInit2 failed");
+    }
+    ~Deflater() { deflateEnd(&m_zs); }
+
+    Deflater(const Deflater&) = delete;
+    Deflater& operator=(const Deflater&) = delete;
+
+    /// Compress `in` onto `out`; `finish` ends the gzip member.
+    void write(const std::string& in, std::string& out, bool finish) {
+        m_zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(in.data()));
+        m_zs.avail_in = static_cast<uInt>(in.size());
+        char buf[65536];
+        for (;;) {
+            m_zs.next_out = reinterpret_cast<Bytef*>(buf);
+            m_zs.avail_out = sizeof(buf);
+            int rc = deflate(&m_zs, finish ? Z_FINISH : Z_NO_FLUSH);
+            out.append(buf, sizeof(buf) - m_zs.avail_out);
+            if (rc == Z_STREAM_END) return;
+            if (rc == Z_STREAM_ERROR) throw std::runtime_error("StandInServer: deflate failed");
+            if (m_zs.avail_out != 0 && m_zs.avail_in == 0 && !finish) return;
+        }
+    }
+
+private:
+    z_stream m_zs{};
+};
+
+std::string gunzip(const std::string& in)
+{
+    z_stream zs{};
+    if (inflateInit2(&zs, 15 + 16) != Z_OK) throw std::runtime_error("StandInServer: inflateInit2 failed");
+    zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(in.data()));
+    zs.avail_in = static_cast<uInt>(in.size());
+    std::string out;
+    char buf[65536];
+    int rc = Z_OK;
+    while (rc != Z_STREAM_END) {
+        zs.next_out = reinterpret_cast<Bytef*>(buf);
+        zs.avail_out = sizeof(buf);
+        rc = inflate(&zs, Z_NO_FLUSH);
+        if (rc != Z_OK && rc != Z_STREAM_END) break;
+        out.append(buf, sizeof(buf) - zs.avail_out);
+        if (rc == Z_STREAM_END && zs.avail_in > 0) {
+            inflateReset(&zs);  // concatenated gzip member
+            rc = Z_OK;
+        }
+    }
+    inflateEnd(&zs);
+    if (rc != Z_STREAM_END) throw std::runtime_error("StandInServer: corrupt gzip body");
+    return out;
+}
+
+/// GET /v1/query/export from the generator: a thread streams the range's
+/// batches through a short queue, and each next() formats (and compresses)
+/// one.  Destroying it mid-body stops the generator.
+class ExportStream {
+public:
+    ExportStream(const SyntheticBackend::Config& config, double start, double end, bool gzip, int level)
+        : m_backend("location.gps", config)
+    {
+        if (gzip) m_deflater = std::make_unique<Deflater>(level);
+        m_header = "{\"total\":" + std::to_string(m_backend.count(start, end)) + "}\n";
+        m_producer = std::thread([this, start, end] {
+            try {
+                m_backend.streamAllByType(start, end, [this](std::vector<Entity>&& batch) {
+                    if (!m_batches.push(std::move(batch))) m_backend.cancelFetch();
+                });
+            } catch (const std::exception& e) {
+                std::cerr << "[STANDIN] export generator failed: " << e.what() << "\n";
+            }
+            m_batches.close();
+        });
+    }
+
+    ~ExportStream() {
+        m_batches.close();
+        m_backend.cancelFetch();
+        m_producer.join();
+    }
+
+    bool next(std::string& piece) {
+        std::string text;
+        text.swap(m_header);
+        std::vector<Entity> batch;
+        bool more = m_batches.pop(batch);
+        text.reserve(text.size() + batch.size() * 128);
+        for (const auto& e : batch) {
+            appendEntity(text, e);
+            text += '\n';
+        }
+        if (m_deflater) m_deflater->write(text, piece, !more);
+        else piece.swap(text);
+        return more;
+    }
+
+private:
+    SyntheticBackend m_backend;
+    BoundedQueue<std::vector<Entity>> m_batches{4};
+    std::unique_ptr<Deflater> m_deflater;
+    std::string m_header;  ///< {"total":N}, sent with the first piece
+    std::thread m_producer;
+};
+
+/// The first `limit` entities of `type` in [start, end] that `keep` accepts.
+/// Generates a growing window at a time rather than the whole range.
+template<typename Keep>
+std::vector<Entity> firstEntities(const SyntheticBackend::Config& config, const std::string& type,
+                                  double start, double end, size_t limit, Keep keep)
+{
+    SyntheticBackend backend(type, config);
+    start = std::max(start, config.start);
+    end = std::min(end, config.end);
+    std::vector<Entity> out;
+    double window = 30 * 86400.0;
+    for (double from = start; from <= end && out.size() < limit; window *= 2) {
+        double to = std::min(end, from + window);
+        for (auto& e : backend.generate(from, to)) {
+            // Windows share their boundary instant
+            if (e.time_start == from && from != start) continue;
+            if (out.size() < limit && keep(e)) out.push_back(std::move(e));
+        }
+        if (to >= end) break;
+        from = to;
+    }
+    return out;
+}
+
+} // namespace
+
+StandInServer::StandInServer(Config config)
+    : m_config(std::move(config))
+    , m_started(std::chrono::steady_clock::now())
+{
+    switch (m_config.mode) {
+    case Mode::Synthetic:
+        for (int i = 0; i < 4; ++i)
+            m_stats[i] = std::make_unique<SyntheticBackend>(kTypes[i], m_config.synthetic);
+        break;
+    case Mode::Record:
+        if (m_config.upstream.empty()) throw std::runtime_error("StandInServer: Record needs an upstream URL");
+        m_upstream = std::make_unique<HttpClient>(m_config.apiKey);
+        [[fallthrough]];
+    case Mode::Replay:
+        if (m_config.recordDir.empty()) throw std::runtime_error("StandInServer: no recording directory");
+        std::filesystem::create_directories(m_config.recordDir);
+        break;
+    }
+    m_server = std::make_unique<LocalHttpServer>([this](const Request& req) { return handle(req); },
+                                                 m_config.port);
+}
+
+StandInServer::~StandInServer() = default;
+
+LocalHttpServer::Response StandInServer::handle(const Request& req)
+{
+    Response r;
+    try {
+        switch (m_config.mode) {
+        case Mode::Synthetic: r = synthetic(req); break;
+        case Mode::Record:    r = record(req); break;
+        case Mode::Replay:    r = replay(req); break;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "[STANDIN] " << req.method << " " << req.target << ": " << e.what() << "\n";
+        r = error(400, e.what());
+    }
+    r.delayMs = m_config.latencyMs;
+    r.bytesPerSecond = m_config.bytesPerSecond;
+    return r;
+}
+
+LocalHttpServer::Response StandInServer::synthetic(const Request& req)
+{
+    const auto& config = m_config.synthetic;
+    std::string path = req.target.substr(0, req.target.find('?'));
+
+    if (req.method == "GET" && path == "/stats") {
+        nlohmann::json byType = nlohmann::json::array();
+        int total = 0;
+        for (auto& backend : m_stats) {
+            int n = backend->fetchStats().total_entities;
+            total += n;
+            byType.push_back({{"type", backend->entityType()}, {"count", n}});
+        }
+        Response r;
+        r.body = nlohmann::json{
+            {"total_entities", total},
+            {"database", {{"size_mb", total * 120.0 / (1 << 20)}}},
+            {"uptime_seconds", std::chrono::duration<double>(std::chrono::steady_clock::now() - m_started).count()},
+            {"time_coverage", {{"oldest", TimeUtils::to_iso8601(config.start)},
+                               {"newest", TimeUtils::to_iso8601(config.end)}}},
+            {"entities_by_type", byType},
+        }.dump();
+        r.headers.emplace_back("Content-Type", "application/json");
+        return r;
+    }
+
+    if (req.method == "GET" && path == "/v1/query/export") {
+        // [start, end): the generator's ranges are closed
+        double start = timeParam(req.target, "start", -kInf);
+        double end = std::nextafter(timeParam(req.target, "end", kInf), -kInf);
+        bool gzip = acceptsGzip(req);
+        auto stream = std::make_shared<ExportStream>(config, start, end, gzip, m_config.gzipLevel);
+        Response r;
+        r.stream = [stream](std::string& piece) { return stream->next(piece); };
+        r.headers.emplace_back("Content-Type", "application/x-ndjson");
+        if (gzip) r.headers.emplace_back("Content-Encoding", "gzip");
+        return r;
+    }
+
+    if (req.method == "POST" && (path == "/v1/query/time" || path == "/v1/query/bbox")) {
+        auto q = nlohmann::json::parse(req.body);
+        std::string type = q.at("types").at(0).get<std::string>();
+        if (typeIndex(type) < 0) return error(400, "unknown type " + type);
+
+        if (path == "/v1/query/time") {
+            double start = TimeUtils::parse_iso8601(q.at("start").get<std::string>());
+            double end = TimeUtils::parse_iso8601(q.at("end").get<std::string>());
+            size_t limit = q.value("limit", 2000);
+            return entitiesResponse(firstEntities(config, type, start, end, limit,
+                                                  [](const Entity&) { return true; }));
+        }
+        const auto& bbox = q.at("bbox");
+        double minLon = bbox.at(0), minLat = bbox.at(1), maxLon = bbox.at(2), maxLat = bbox.at(3);
+        double start = TimeUtils::parse_iso8601(q.at("time").at("start").get<std::string>());
+        double end = TimeUtils::parse_iso8601(q.at("time").at("end").get<std::string>());
+        size_t limit = q.value("limit", 5000);
+        return entitiesResponse(firstEntities(config, type, start, end, limit, [&](const Entity& e) {
+            return e.has_location() && *e.lat >= minLat && *e.lat <= maxLat &&
+                   *e.lon >= minLon && *e.lon <= maxLon;
+        }));
+    }
+
+    const std::string photoPrefix = "/v1/photo/";
+    const std::string thumbSuffix = "/thumb";
+    if (req.method == "GET" && path.size() > photoPrefix.size() + thumbSuffix.size() &&
+        path.compare(0, photoPrefix.size(), photoPrefix) == 0 &&
+        path.compare(path.size() - thumbSuffix.size(), thumbSuffix.size(), thumbSuffix) == 0) {
+        std::string id = path.substr(photoPrefix.size(),
+                                     path.size() - photoPrefix.size() - thumbSuffix.size());
+        auto bytes = m_stats[1]->fetchPhotoThumb(id);
+        Response r;
+        r.body.assign(bytes.begin(), bytes.end());
+        r.headers.emplace_back("Content-Type", "image/bmp");
+        return r;
+    }
+
+    return error(404, "not served by the stand-in: " + req.method + " " + path);
+}
+
+std::string StandInServer::recordPath(const Request& req) const
+{
+    // FNV-1a over everything that selects the response
+    const std::string accept = req.header("accept");
+    uint64_t h = 1469598103934665603ull;
+    for (const std::string* part : {&req.method, &req.target, &accept, &req.body}) {
+        for (unsigned char c : *part) h = (h ^ c) * 1099511628211ull;
+        h = (h ^ 0xff) * 1099511628211ull;
+    }
+    char name[24];
+    std::snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(h));
+    return (std::filesystem::path(m_config.recordDir) / (std::string(name) + ".body")).string();
+}
+
+LocalHttpServer::Response StandInServer::record(const Request& req)
+{
+    std::string url = m_config.upstream + req.target;
+    std::string accept = req.header("accept");
+    std::string body;
+    auto sink = [&body](const char* data, size_t len) {
+        body.append(data, len);
+        return true;
+    };
+    try {
+        if (req.method == "POST")
+            m_upstream->post_raw_stream(url, nlohmann::json::parse(req.body), sink, accept);
+        else
+            m_upstream->get_raw_stream(url, sink, accept);
+    } catch (const std::exception& e) {
+        return error(502, e.what());
+    }
+    // The upstream is always asked for gzip; keep what this client can read
+    if (isGzip(body) && !acceptsGzip(req)) body = gunzip(body);
+
+    std::string file = recordPath(req);
+    {
+        std::ofstream out(file, std::ios::binary | std::ios::trunc);
+        out.write(body.data(), static_cast<std::streamsize>(body.size()));
+        if (!out) throw std::runtime_error("StandInServer: cannot write " + file);
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_indexMutex);
+        std::ofstream index(std::filesystem::path(m_config.recordDir) / "index.tsv", std::ios::app);
+        index << std::filesystem::path(file).filename().string() << '\t' << req.method << '\t'
+              << req.target << '\t' << body.size() << '\n';
+    }
+    std::cerr << "[STANDIN] recorded " << req.method << " " << req.target << " (" << body.size() << " bytes)\n";
+
+    Response r;
+    if (isGzip(body)) r.headers.emplace_back("Content-Encoding", "gzip");
+    r.body = std::move(body);
+    return r;
+}
+
+LocalHttpServer::Response StandInServer::replay(const Request& req)
+{
+    auto file = std::make_shared<std::ifstream>(recordPath(req), std::ios::binary);
+    if (!*file) {
+        std::cerr << "[STANDIN] no recording of " << req.method << " " << req.target << "\n";
+        return error(404, "not recorded: " + req.method + " " + req.target);
+    }
+
+    char magic[2] = {};
+    file->read(magic, 2);
+    bool gzip = file->gcount() == 2 && isGzip(std::string(magic, 2));
+    file->seekg(0);
+
+    Response r;
+    if (gzip && !acceptsGzip(req)) {
+        std::string body((std::istreambuf_iterator<char>(*file)), std::istreambuf_iterator<char>());
+        r.body = gunzip(body);
+        return r;
+    }
+    if (gzip) r.headers.emplace_back("Content-Encoding", "gzip");
+    r.stream = [file](std::string& piece) {
+        piece.resize(256 * 1024);
+        file->read(&piece[0], static_cast<std::streamsize>(piece.size()));
+        piece.resize(static_cast<size_t>(file->gcount()));
+        return static_cast<bool>(*file);
+    };
+    return r;
+}
+
+bool applyStandInOption(StandInServer::Config& config, const std::string& flag, const std::string& value)
+{
+    if (flag == "--gps") config.synthetic.gpsPoints = std::stoull(value);
+    else if (flag == "--seed") config.synthetic.seed = std::stoull(value);
+    else if (flag == "--record") { config.mode = StandInServer::Mode::Record; config.upstream = value; }
+    else if (flag == "--replay") { config.mode = StandInServer::Mode::Replay; config.recordDir = value; }
+    else if (flag == "--dir") config.recordDir = value;
+    else if (flag == "--api-key") config.apiKey = value;
+    else if (flag == "--latency") config.latencyMs = std::stoi(value);
+    else if (flag == "--bandwidth") config.bytesPerSecond = std::stod(value) * 1e6;
+    else if (flag == "--port") config.port = std::stoi(value);
+    else return false;
+    return true;
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "LocalHttpServer.h"
+#include "SyntheticBackend.h"
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+
+class HttpClient;
+
+/// Stand-in for the Reckoner server, for end-to-end ingest benchmarks
+/// without the production backend.  Serves the endpoints the app uses:
+///   GET  /stats
+///   GET  /v1/query/export       NDJSON, gzipped if the client accepts it
+///   POST /v1/query/bbox
+///   POST /v1/query/time
+///   GET  /v1/photo/{id}/thumb
+/// from one of three sources:
+///   Synthetic - generated on the fly by SyntheticBackend (all four layers)
+///   Record    - proxied to a real server, each response saved to a directory
+///   Replay    - the responses saved by Record, byte for byte
+/// Every response can be shaped: a latency before the status line and a
+/// bandwidth cap on the body.  Large bodies are streamed, not built whole.
+class StandInServer {
+public:
+    enum class Mode { Synthetic, Record, Replay };
+
+    struct Config {
+        Mode mode = Mode::Synthetic;
+        SyntheticBackend::Config synthetic{};  ///< Synthetic: the world to serve
+        std::string upstream;                  ///< Record: base URL of the real server
+        std::string apiKey;                    ///< Record: sent upstream as X-API-Key
+        std::string recordDir;                 ///< Record/Replay: one file per response
+        int latencyMs = 0;                     ///< before every response
+        double bytesPerSecond = 0.0;           ///< per response body; 0 = unlimited
+        int gzipLevel = 1;                     ///< export bodies, when accepted
+        int port = 0;                          ///< 0 picks a free one
+    };
+
+    explicit StandInServer(Config config);
+    ~StandInServer();
+
+    StandInServer(const StandInServer&) = delete;
+    StandInServer& operator=(const StandInServer&) = delete;
+
+    std::string url() const { return m_server->url(); }
+    int port() const { return m_server->port(); }
+    size_t requestsServed() const { return m_server->requestsServed(); }
+
+    /// Answer one request (what the server calls, per connection thread).
+    LocalHttpServer::Response handle(const LocalHttpServer::Request& req);
+
+private:
+    LocalHttpServer::Response synthetic(const LocalHttpServer::Request& req);
+    LocalHttpServer::Response record(const LocalHttpServer::Request& req);
+    LocalHttpServer::Response replay(const LocalHttpServer::Request& req);
+
+    /// Recording file for a request: its method, target, Accept and body.
+    std::string recordPath(const LocalHttpServer::Request& req) const;
+
+    Config m_config;
+    std::chrono::steady_clock::time_point m_started;
+    std::unique_ptr<SyntheticBackend> m_stats[4];  ///< Synthetic: per layer, for /stats and thumbs
+    std::unique_ptr<HttpClient> m_upstream;         ///< Record
+    std::mutex m_indexMutex;                        ///< Record: appends to index.tsv
+    std::unique_ptr<LocalHttpServer> m_server;      ///< last: stops serving before the rest goes
+};
+
+/// Apply one option shared by the stand-in command lines:
+///   --gps N          synthetic GPS points         --seed S        synthetic seed
+///   --record URL     proxy and record this server  --replay DIR   serve a recording
+///   --dir DIR        where --record saves          --api-key KEY  for --record
+///   --latency MS     per response                  --bandwidth MB per second, per response
+///   --port P
+/// Returns false if `flag` is not one of them.
+bool applyStandInOption(StandInServer::Config& config, const std::string& flag, const std::string& value);
@@ -0,0 +1,123 @@
+// Per-request latency of small GETs against a loopback stand-in server:
+//   fresh   - curl_easy_init/perform/cleanup per request (the old HttpClient)
+//   nopool  - HttpTransport, easy handle created per request, headers rebuilt
+//   pooled  - HttpTransport with its handle pool and a shared HeaderList
+//
+// Usage: reckoner_http_latency_bench [requests]
+//
+// Loopback has no TLS and ~no RTT, so this isolates handle setup and the TCP
+// handshake; against a real HTTPS backend the gap widens by a TLS handshake
+// per fresh connection.
+
+#include "http/HttpTransport.h"
+#include "LocalHttpServer.h"
+#include <curl/curl.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+size_t discard(char*, size_t size, size_t nmemb, void*) { return size * nmemb; }
+
+void report(const char* name, std::vector<double> us, size_t connections)
+{
+    std::sort(us.begin(), us.end());
+    double sum = 0;
+    for (double v : us) sum += v;
+    std::printf("%-8s  mean %8.1f us   p50 %8.1f us   p99 %8.1f us   connections %zu\n",
+                name, sum / us.size(), us[us.size() / 2], us[us.size() * 99 / 100], connections);
+}
+
+template <typename Fn>
+std::vector<double> timeRequests(size_t n, Fn&& fn)
+{
+    std::vector<double> us;
+    us.reserve(n);
+    for (size_t i = 0; i < n; ++i) {
+        auto t0 = Clock::now();
+        if (!fn()) {
+            std::fprintf(stderr, "request %zu failed\n", i);
+            std::exit(1);
+        }
+        us.push_back(std::chrono::duration<double, std::micro>(Clock::now() - t0).count());
+    }
+    return us;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    size_t n = (argc > 1) ? std::strtoull(argv[1], nullptr, 10) : 2000;
+    curl_global_init(CURL_GLOBAL_DEFAULT);
+
+    LocalHttpServer::Handler handler = [](const LocalHttpServer::Request&) {
+        LocalHttpServer::Response r;
+        r.body = R"({"total_entities":123456,"oldest":"2014-01-01T00:00:00Z"})";
+        return r;
+    };
+    const std::vector<std::string> headerLines = {"X-API-Key: bench-key", "Accept: application/json"};
+
+    std::printf("%zu sequential GETs per mode\n", n);
+
+    {
+        LocalHttpServer server(handler);
+        std::string url = server.url() + "/stats";
+        auto us = timeRequests(n, [&] {
+            CURL* easy = curl_easy_init();
+            curl_slist* headers = nullptr;
+            for (const auto& h : headerLines) headers = curl_slist_append(headers, h.c_str());
+            curl_easy_setopt(easy, CURLOPT_URL, url.c_str());
+            curl_easy_setopt(easy, CURLOPT_HTTPHEADER, headers);
+            curl_easy_setopt(easy, CURLOPT_WRITEFUNCTION, discard);
+            curl_easy_setopt(easy, CURLOPT_NOSIGNAL, 1L);
+            CURLcode res = curl_easy_perform(easy);
+            curl_slist_free_all(headers);
+            curl_easy_cleanup(easy);
+            return res == CURLE_OK;
+        });
+        report("fresh", us, server.connectionsAccepted());
+    }
+
+    {
+        LocalHttpServer server(handler);
+        HttpTransport transport;
+        HttpTransport::Options opts = transport.options();
+        opts.handlePoolSize = 0;
+        transport.configure(opts);
+        std::string url = server.url() + "/stats";
+        auto us = timeRequests(n, [&] {
+            HttpTransport::Request req;
+            req.url = url;
+            req.headers = headerLines;
+            return transport.perform(std::move(req)).ok();
+        });
+        report("nopool", us, server.connectionsAccepted());
+    }
+
+    {
+        LocalHttpServer server(handler);
+        HttpTransport transport;
+        auto headers = std::make_shared<const HttpTransport::HeaderList>(headerLines);
+        std::string url = server.url() + "/stats";
+        auto us = timeRequests(n, [&] {
+            HttpTransport::Request req;
+            req.url = url;
+            req.sharedHeaders = headers;
+            return transport.perform(std::move(req)).ok();
+        });
+        report("pooled", us, server.connectionsAccepted());
+        std::printf("pooled transport created %zu easy handle(s)\n", transport.handlesCreated());
+    }
+
+    curl_global_cleanup();
+    return 0;
+}
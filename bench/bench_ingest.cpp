@@ -0,0 +1,208 @@
+// End-to-end ingest over HTTP, against the stand-in server (StandInServer)
+// instead of the production one:
+//   backend - HttpBackend::streamAllEntities for the GPS layer (the sharded,
+//             gzipped export), appended into one vector
+//   app     - FetchOrchestrator::startFullLoad of all four layers, drained
+//             into an AppModel the way the main loop does, frame budget
+//             and all
+// Each phase reports time to the first batch, total load time and the peak
+// RSS of its process.
+//
+// Usage: reckoner_ingest_bench [backend|app|both] [--shards N] [--url URL]
+//                              [stand-in options: --gps N --seed S
+//                               --latency MS --bandwidth MB/s --replay DIR]
+//
+// The stand-in runs in a child process (unless --url points elsewhere), and
+// each phase in another, so neither the server's memory nor an earlier
+// phase's peak is counted.  Synthetic data defaults to 2M GPS points.
+
+#include "StandInServer.h"
+#include "FetchOrchestrator.h"
+#include "HttpBackend.h"
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double secondsSince(Clock::time_point t0)
+{
+    return std::chrono::duration<double>(Clock::now() - t0).count();
+}
+
+double peakRssMB()
+{
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    return usage.ru_maxrss / 1e6;  // bytes
+#else
+    return usage.ru_maxrss / 1e3;  // kilobytes
+#endif
+}
+
+void report(const char* phase, double firstSec, double totalSec, size_t entities)
+{
+    std::printf("%-8s first batch %7.3f s   total %7.3f s   %9zu entities   %6.2f M entities/s   peak RSS %7.1f MB\n",
+                phase, firstSec, totalSec, entities, entities / totalSec / 1e6, peakRssMB());
+    std::fflush(stdout);
+}
+
+void benchBackend(const std::string& url, int shards)
+{
+    HttpBackend gps(url, "", "location.gps");
+    gps.setExportShards(shards);
+    std::vector<Entity> layer;
+    double first = -1.0;
+    auto t0 = Clock::now();
+    gps.streamAllEntities(
+        [&layer](size_t total) { layer.reserve(total); },
+        [&](std::vector<Entity>&& batch) {
+            if (first < 0) first = secondsSince(t0);
+            layer.insert(layer.end(), std::make_move_iterator(batch.begin()),
+                         std::make_move_iterator(batch.end()));
+        });
+    double total = secondsSince(t0);
+    if (!gps.lastStreamComplete()) std::printf("backend  stream incomplete\n");
+    report("backend", first, total, layer.size());
+}
+
+void benchApp(const std::string& url, int shards)
+{
+    BackendConfig config;
+    config.type = BackendConfig::Type::Http;
+    config.exportShards = shards;
+    FetchOrchestrator orchestrator;
+    orchestrator.setBackends(createBackends(config, url), config.type);
+
+    AppModel model;
+    double first = -1.0;
+    auto t0 = Clock::now();
+    orchestrator.startFullLoad(model);
+    for (;;) {
+        // One frame: what the main loop does with the queue
+        auto frame = Clock::now();
+        orchestrator.drainCompletedBatches(model);
+        size_t loaded = 0;
+        bool fetching = false;
+        for (const auto& layer : model.layers) {
+            loaded += layer.entities.size();
+            fetching = fetching || layer.is_fetching;
+        }
+        if (first < 0 && loaded > 0) first = secondsSince(t0);
+        if (!fetching && orchestrator.queueStats().depth == 0) break;
+        std::this_thread::sleep_until(frame + std::chrono::microseconds(16667));
+    }
+    double total = secondsSince(t0);
+    orchestrator.cancelAndWaitAll();
+
+    size_t entities = 0;
+    for (const auto& layer : model.layers) {
+        std::printf("app      %-24s %9zu\n", layer.name.c_str(), layer.entities.size());
+        entities += layer.entities.size();
+    }
+    report("app", first, total, entities);
+}
+
+/// Run `phase` in a child process and wait for it.
+template<typename Fn>
+bool runIsolated(Fn&& phase)
+{
+    std::fflush(stdout);
+    pid_t pid = fork();
+    if (pid == 0) {
+        try {
+            phase();
+        } catch (const std::exception& e) {
+            std::fprintf(stderr, "%s\n", e.what());
+            std::_Exit(1);
+        }
+        std::fflush(stdout);
+        std::_Exit(0);
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    std::string phases = "both";
+    std::string url;
+    int shards = BackendConfig{}.exportShards;
+    StandInServer::Config config;
+
+    int i = 1;
+    if (i < argc && argv[i][0] != '-') phases = argv[i++];
+    for (; i < argc; i += 2) {
+        std::string flag = argv[i];
+        std::string value = (i + 1 < argc) ? argv[i + 1] : "";
+        if (flag == "--url") url = value;
+        else if (flag == "--shards") shards = std::atoi(value.c_str());
+        else if (value.empty() || !applyStandInOption(config, flag, value)) {
+            std::fprintf(stderr, "unknown option %s (see the top of bench/bench_ingest.cpp)\n", flag.c_str());
+            return 2;
+        }
+    }
+
+    // The stand-in, in a child that lives until its pipe closes
+    pid_t server = -1;
+    int keepAlive[2] = {-1, -1};
+    if (url.empty()) {
+        int ready[2];
+        if (pipe(ready) != 0 || pipe(keepAlive) != 0) return 1;
+        server = fork();
+        if (server == 0) {
+            close(ready[0]);
+            close(keepAlive[1]);
+            try {
+                StandInServer standIn(config);
+                int port = standIn.port();
+                (void)!write(ready[1], &port, sizeof(port));
+                close(ready[1]);
+                char c;
+                while (read(keepAlive[0], &c, 1) > 0) {}
+                std::fprintf(stderr, "stand-in served %zu requests\n", standIn.requestsServed());
+            } catch (const std::exception& e) {
+                std::fprintf(stderr, "stand-in: %s\n", e.what());
+                std::_Exit(1);
+            }
+            std::_Exit(0);
+        }
+        close(ready[1]);
+        close(keepAlive[0]);
+        int port = 0;
+        if (read(ready[0], &port, sizeof(port)) != sizeof(port)) {
+            std::fprintf(stderr, "stand-in server failed to start\n");
+            return 1;
+        }
+        close(ready[0]);
+        url = "http://127.0.0.1:" + std::to_string(port);
+    }
+
+    std::printf("ingest from %s, %d export shards, latency %d ms, ", url.c_str(), shards, config.latencyMs);
+    if (config.bytesPerSecond > 0) std::printf("%.1f MB/s\n", config.bytesPerSecond / 1e6);
+    else std::printf("unlimited bandwidth\n");
+
+    bool ok = true;
+    if (phases == "backend" || phases == "both") ok = runIsolated([&] { benchBackend(url, shards); }) && ok;
+    if (phases == "app" || phases == "both") ok = runIsolated([&] { benchApp(url, shards); }) && ok;
+
+    if (server > 0) {
+        close(keepAlive[1]);
+        waitpid(server, nullptr, 0);
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,83 @@
+// Throughput of ISO-8601 timestamp parsing: the old istringstream + std::get_time
+// path vs TimeUtils::parse_iso8601 (single and batch).
+//
+// Usage: reckoner_iso8601_bench [count]
+
+#include "core/TimeUtils.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <iomanip>
+#include <random>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// The previous implementation, kept here as the baseline.
+double legacyParse(const std::string& iso8601)
+{
+    std::tm tm = {};
+    std::istringstream ss(iso8601);
+    ss >> std::get_time(&tm, "%Y-%m-%dT%H:%M:%S");
+    if (ss.fail()) std::abort();
+    return static_cast<double>(timegm(&tm));
+}
+
+template <typename Fn>
+double timeIt(Fn&& fn)
+{
+    auto t0 = Clock::now();
+    fn();
+    return std::chrono::duration<double>(Clock::now() - t0).count();
+}
+
+void report(const char* name, double secs, size_t count)
+{
+    std::printf("%-26s %12.0f timestamps/s  %7.1f ns/ts  (%.3f s)\n",
+                name, static_cast<double>(count) / secs, secs * 1e9 / static_cast<double>(count), secs);
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    size_t n = (argc > 1) ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+
+    std::mt19937_64 rng(7);
+    std::uniform_real_distribution<double> dist(946684800.0, 1893456000.0);  // 2000..2030
+    std::vector<std::string> strings;
+    strings.reserve(n);
+    for (size_t i = 0; i < n; ++i)
+        strings.push_back(TimeUtils::to_iso8601(static_cast<double>(static_cast<int64_t>(dist(rng)))));
+
+    std::vector<std::string_view> views(strings.begin(), strings.end());
+    std::vector<double> legacy(n), single(n), batch(n);
+
+    double tLegacy = timeIt([&] {
+        for (size_t i = 0; i < n; ++i) legacy[i] = legacyParse(strings[i]);
+    });
+    double tSingle = timeIt([&] {
+        for (size_t i = 0; i < n; ++i) single[i] = TimeUtils::parse_iso8601(views[i]);
+    });
+    size_t ok = 0;
+    double tBatch = timeIt([&] {
+        ok = TimeUtils::parse_iso8601_batch(views.data(), batch.data(), n);
+    });
+
+    if (ok != n || legacy != single || single != batch) {
+        std::fprintf(stderr, "result mismatch between parsers\n");
+        return 1;
+    }
+
+    report("istringstream + get_time", tLegacy, n);
+    report("parse_iso8601", tSingle, n);
+    report("parse_iso8601_batch", tBatch, n);
+    std::printf("speedup: %.1fx (single), %.1fx (batch)\n", tLegacy / tSingle, tLegacy / tBatch);
+    return 0;
+}
@@ -0,0 +1,86 @@
+// Cost of splitting a streamed NDJSON body into lines at different curl chunk
+// sizes: the old append + substr + erase(0, pos+1) splitter vs LineReader.
+//
+// Usage: reckoner_line_reader_bench [megabytes]
+//
+// The old splitter shifts the remaining buffer on every line, so its cost per
+// chunk grows with (lines per chunk) x (chunk size); LineReader is linear.
+
+#include "core/LineReader.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <string>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// The previous HttpClient::stream_write_callback body, kept as the baseline.
+struct LegacySplitter {
+    std::string buffer;
+    std::function<bool(const std::string&)> callback;
+
+    void feed(const char* data, size_t len) {
+        buffer.append(data, len);
+        size_t pos;
+        while ((pos = buffer.find('\n')) != std::string::npos) {
+            std::string line = buffer.substr(0, pos);
+            buffer.erase(0, pos + 1);
+            if (!line.empty()) callback(line);
+        }
+    }
+};
+
+std::string makeBody(size_t bytes)
+{
+    std::string body;
+    body.reserve(bytes + 256);
+    const char* line =
+        R"({"id":"3f2a9c1e-7b4d-4e8a-9c2f-1a2b3c4d5e6f","t_start":"2021-06-15T12:30:00Z",)"
+        R"("t_end":null,"lat":34.0522350,"lon":-118.2436830,"name":null,"color":null})" "\n";
+    while (body.size() < bytes) body += line;
+    return body;
+}
+
+template <typename Feed>
+double timeChunks(const std::string& body, size_t chunk, Feed&& feed)
+{
+    auto t0 = Clock::now();
+    for (size_t pos = 0; pos < body.size(); pos += chunk)
+        feed(body.data() + pos, std::min(chunk, body.size() - pos));
+    return std::chrono::duration<double>(Clock::now() - t0).count();
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    size_t mb = (argc > 1) ? std::strtoull(argv[1], nullptr, 10) : 32;
+    std::string body = makeBody(mb << 20);
+    double mbytes = static_cast<double>(body.size()) / (1024.0 * 1024.0);
+    std::printf("%.1f MB of NDJSON\n", mbytes);
+
+    const size_t chunks[] = {16 * 1024, 1024 * 1024};
+    for (size_t chunk : chunks) {
+        size_t legacyLines = 0, readerLines = 0;
+
+        LegacySplitter legacy;
+        legacy.callback = [&](const std::string& line) { legacyLines += line.size() > 0; return true; };
+        double tLegacy = timeChunks(body, chunk, [&](const char* d, size_t n) { legacy.feed(d, n); });
+
+        LineReader reader;
+        auto onLine = [&](std::string_view line) { readerLines += line.size() > 0; return true; };
+        double tReader = timeChunks(body, chunk, [&](const char* d, size_t n) { reader.feed(d, n, onLine); });
+
+        if (legacyLines != readerLines) {
+            std::fprintf(stderr, "line count mismatch: %zu vs %zu\n", legacyLines, readerLines);
+            return 1;
+        }
+
+        std::printf("chunk %7zu KB: substr/erase %8.1f MB/s   LineReader %8.1f MB/s   (%.1fx)\n",
+                    chunk / 1024, mbytes / tLegacy, mbytes / tReader, tLegacy / tReader);
+    }
+    return 0;
+}
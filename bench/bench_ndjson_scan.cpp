@@ -0,0 +1,105 @@
+// Throughput of the export-line parsers: EntityScanner vs nlohmann DOM + parse_entity.
+//
+// Usage: reckoner_ndjson_bench [num_lines]
+//
+// Generates synthetic GPS-shaped NDJSON in memory (no network) so the numbers
+// isolate parsing cost.
+
+#include "http/EntityScanner.h"
+#include "http/BackendAPI.h"
+#include "core/TimeUtils.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+std::vector<std::string> makeLines(size_t n)
+{
+    std::mt19937_64 rng(42);
+    std::uniform_real_distribution<double> lat(33.9, 34.3);
+    std::uniform_real_distribution<double> lon(-118.7, -118.1);
+
+    std::vector<std::string> lines;
+    lines.reserve(n);
+    double t = 1500000000.0;
+    char buf[512];
+    for (size_t i = 0; i < n; ++i) {
+        t += 5.0 + static_cast<double>(rng() % 30);
+        uint64_t a = rng(), b = rng();
+        std::snprintf(buf, sizeof(buf),
+            R"({"id":"%08x-%04x-%04x-%04x-%012llx","t_start":"%s","t_end":null,)"
+            R"("lat":%.7f,"lon":%.7f,"name":null,"color":null,"render_offset":0.0})",
+            static_cast<unsigned>(a), static_cast<unsigned>(a >> 32) & 0xFFFF,
+            static_cast<unsigned>(a >> 48), static_cast<unsigned>(b) & 0xFFFF,
+            static_cast<unsigned long long>(b >> 16),
+            TimeUtils::to_iso8601(t).c_str(), lat(rng), lon(rng));
+        lines.emplace_back(buf);
+    }
+    return lines;
+}
+
+struct Result {
+    double seconds;
+    double checksum;
+};
+
+template <typename Fn>
+Result run(const std::vector<std::string>& lines, Fn&& parseLine)
+{
+    double checksum = 0.0;
+    auto t0 = Clock::now();
+    for (const auto& line : lines)
+        checksum += parseLine(line);
+    double secs = std::chrono::duration<double>(Clock::now() - t0).count();
+    return {secs, checksum};
+}
+
+void report(const char* name, const Result& r, size_t bytes, size_t count)
+{
+    std::printf("%-22s %8.1f MB/s  %10.0f entities/s  (%.3f s)\n",
+                name,
+                static_cast<double>(bytes) / (1024.0 * 1024.0) / r.seconds,
+                static_cast<double>(count) / r.seconds,
+                r.seconds);
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    size_t n = (argc > 1) ? std::strtoull(argv[1], nullptr, 10) : 500000;
+    auto lines = makeLines(n);
+
+    size_t bytes = 0;
+    for (const auto& l : lines) bytes += l.size() + 1;
+    std::printf("%zu lines, %.1f MB of NDJSON\n", n, static_cast<double>(bytes) / (1024.0 * 1024.0));
+
+    Result dom = run(lines, [](const std::string& line) {
+        Entity e = BackendAPI::parse_entity(nlohmann::json::parse(line));
+        return e.time_start + *e.lat;
+    });
+
+    EntityScanner scanner;
+    Entity scratch;
+    Result fast = run(lines, [&](const std::string& line) {
+        if (!scanner.scan(line, scratch)) std::abort();
+        Entity e = std::move(scratch);  // same hand-off as fetch_export
+        return e.time_start + *e.lat;
+    });
+
+    if (dom.checksum != fast.checksum) {
+        std::fprintf(stderr, "checksum mismatch: dom=%f scanner=%f\n", dom.checksum, fast.checksum);
+        return 1;
+    }
+
+    report("nlohmann + parse_entity", dom, bytes, n);
+    report("EntityScanner", fast, bytes, n);
+    std::printf("speedup: %.1fx\n", dom.seconds / fast.seconds);
+    return 0;
+}
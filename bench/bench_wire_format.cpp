@@ -0,0 +1,169 @@
+// NDJSON vs the columnar export format (ColumnarFormat.h):
+//   size     - body bytes, raw and gzipped
+//   decode   - in-memory decode to entity batches (IngestPipeline vs Decoder)
+//   export   - BackendAPI::fetch_export end to end against a loopback server
+//
+// Usage: reckoner_wire_format_bench [entities]
+//
+// Rows look like the GPS layer: UUID ids, a fix every few seconds, a slowly
+// wandering position.  Loopback removes the network, so the export numbers
+// show client cost; on a real link the size ratio matters as much.
+
+#include "http/BackendAPI.h"
+#include "http/ColumnarFormat.h"
+#include "http/IngestPipeline.h"
+#include "core/TimeUtils.h"
+#include "LocalHttpServer.h"
+#include <curl/curl.h>
+#include <zlib.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double secondsSince(Clock::time_point t0)
+{
+    return std::chrono::duration<double>(Clock::now() - t0).count();
+}
+
+std::vector<Entity> makeRows(size_t n)
+{
+    std::mt19937_64 rng(7);
+    std::uniform_real_distribution<double> step(-0.0002, 0.0002);
+    std::vector<Entity> rows(n);
+    double t = 1500000000.0, lat = 34.05, lon = -118.25;
+    for (size_t i = 0; i < n; ++i) {
+        uint64_t a = rng(), b = rng();
+        char id[40];
+        std::snprintf(id, sizeof(id), "%08x-%04x-4%03x-8%03x-%012llx",
+                      static_cast<unsigned>(a), static_cast<unsigned>(a >> 32) & 0xffff,
+                      static_cast<unsigned>(a >> 48) & 0xfff, static_cast<unsigned>(b) & 0xfff,
+                      static_cast<unsigned long long>(b >> 16));
+        t += 2.0 + static_cast<double>(rng() % 5000) / 1000.0;
+        lat += step(rng);
+        lon += step(rng);
+        rows[i].id = id;
+        rows[i].time_start = rows[i].time_end = t;
+        rows[i].lat = lat;
+        rows[i].lon = lon;
+    }
+    return rows;
+}
+
+std::string toNdjson(const std::vector<Entity>& rows)
+{
+    std::string body = "{\"total\": " + std::to_string(rows.size()) + "}\n";
+    char num[64];
+    for (const auto& e : rows) {
+        body += "{\"id\":\"" + e.id + "\",\"t_start\":\"" + TimeUtils::to_iso8601(e.time_start) + "\",\"t_end\":null";
+        std::snprintf(num, sizeof(num), ",\"lat\":%.7f,\"lon\":%.7f}\n", *e.lat, *e.lon);
+        body += num;
+    }
+    return body;
+}
+
+size_t gzippedSize(const std::string& in)
+{
+    z_stream zs{};
+    deflateInit2(&zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY);
+    std::string out(deflateBound(&zs, static_cast<uLong>(in.size())), '\0');
+    zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(in.data()));
+    zs.avail_in = static_cast<uInt>(in.size());
+    zs.next_out = reinterpret_cast<Bytef*>(out.data());
+    zs.avail_out = static_cast<uInt>(out.size());
+    deflate(&zs, Z_FINISH);
+    size_t n = zs.total_out;
+    deflateEnd(&zs);
+    return n;
+}
+
+constexpr size_t kChunk = 64 * 1024;  // roughly what curl hands over per callback
+
+double decodeNdjson(const std::string& body, size_t& rows)
+{
+    rows = 0;
+    auto t0 = Clock::now();
+    IngestPipeline pipeline(nullptr, [&rows](std::vector<Entity>&& b) { rows += b.size(); return true; });
+    for (size_t off = 0; off < body.size(); off += kChunk)
+        pipeline.push(body.data() + off, std::min(kChunk, body.size() - off));
+    pipeline.finish();
+    return secondsSince(t0);
+}
+
+double decodeColumnar(const std::string& body, size_t& rows)
+{
+    rows = 0;
+    auto t0 = Clock::now();
+    ColumnarFormat::Decoder decoder;
+    for (size_t off = 0; off < body.size(); off += kChunk)
+        decoder.feed(body.data() + off, std::min(kChunk, body.size() - off), nullptr,
+                     [&rows](std::vector<Entity>&& b) { rows += b.size(); return true; });
+    decoder.finish();
+    return secondsSince(t0);
+}
+
+double fetchExport(BackendAPI& api, size_t& rows)
+{
+    rows = 0;
+    auto t0 = Clock::now();
+    api.fetch_export(nullptr, [&rows](std::vector<Entity>&& b) { rows += b.size(); return true; });
+    return secondsSince(t0);
+}
+
+void report(const char* name, double seconds, size_t rows, size_t bytes)
+{
+    std::printf("  %-10s %7.3f s   %7.2f M rows/s   %8.1f MB/s\n", name, seconds,
+                rows / seconds / 1e6, bytes / seconds / 1e6);
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    size_t n = (argc > 1) ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+    curl_global_init(CURL_GLOBAL_DEFAULT);
+
+    auto rows = makeRows(n);
+    std::string ndjson = toNdjson(rows);
+    std::string columnar = ColumnarFormat::Encoder::encode(rows);
+
+    std::printf("%zu entities\n", n);
+    std::printf("size\n");
+    std::printf("  ndjson   %8.1f MB raw  %8.1f MB gzip  %6.1f B/row\n",
+                ndjson.size() / 1e6, gzippedSize(ndjson) / 1e6, double(ndjson.size()) / n);
+    std::printf("  columnar %8.1f MB raw  %8.1f MB gzip  %6.1f B/row\n",
+                columnar.size() / 1e6, gzippedSize(columnar) / 1e6, double(columnar.size()) / n);
+
+    size_t got = 0;
+    std::printf("decode\n");
+    double s = decodeNdjson(ndjson, got);
+    report("ndjson", s, got, ndjson.size());
+    s = decodeColumnar(columnar, got);
+    report("columnar", s, got, columnar.size());
+
+    LocalHttpServer server([&](const LocalHttpServer::Request& req) {
+        LocalHttpServer::Response r;
+        bool binary = req.header("accept").find(ColumnarFormat::kContentType) != std::string::npos;
+        r.body = binary ? columnar : ndjson;
+        r.chunkBytes = 1 << 20;
+        return r;
+    });
+    BackendAPI api(server.url(), "key");
+
+    std::printf("export (loopback)\n");
+    api.set_columnar_export(false);
+    s = fetchExport(api, got);
+    report("ndjson", s, got, ndjson.size());
+    api.set_columnar_export(true);
+    s = fetchExport(api, got);
+    report("columnar", s, got, columnar.size());
+
+    curl_global_cleanup();
+    return 0;
+}
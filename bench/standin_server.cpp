@@ -0,0 +1,59 @@
+// Stand-in Reckoner server on 127.0.0.1 (StandInServer), for pointing the
+// app or a benchmark at generated or recorded data.
+//
+// Usage: reckoner_standin [options]            synthetic data
+//        reckoner_standin --record URL --dir DIR [options]
+//        reckoner_standin --replay DIR [options]
+// Options: --gps N --seed S --latency MS --bandwidth MB/s --port P --api-key KEY
+//
+// Record proxies every request to URL and saves the response under DIR;
+// Replay serves those responses again.  The API key for --record defaults to
+// API_KEY from .env, as HttpBackend reads it.  Runs until interrupted.
+
+#include "StandInServer.h"
+#include "core/EnvLoader.h"
+#include <pthread.h>
+#include <signal.h>
+#include <cstdio>
+#include <exception>
+#include <string>
+
+int main(int argc, char** argv)
+{
+    StandInServer::Config config;
+    config.port = 8765;
+    for (int i = 1; i < argc; ++i) {
+        std::string flag = argv[i];
+        if (i + 1 >= argc || !applyStandInOption(config, flag, argv[i + 1])) {
+            std::fprintf(stderr, "unknown option %s (see the top of bench/standin_server.cpp)\n", argv[i]);
+            return 2;
+        }
+        ++i;
+    }
+    if (config.mode == StandInServer::Mode::Record && config.apiKey.empty()) {
+        config.apiKey = EnvLoader::get(EnvLoader::load(".env"), "API_KEY");
+        if (config.apiKey.empty()) config.apiKey = EnvLoader::get(EnvLoader::load("../.env"), "API_KEY");
+    }
+
+    // Block the signals before any thread starts, then wait for one here
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+    try {
+        StandInServer server(config);
+        const char* modes[] = {"synthetic", "record", "replay"};
+        std::printf("stand-in server (%s) at %s\n", modes[static_cast<int>(config.mode)], server.url().c_str());
+        std::fflush(stdout);
+
+        int sig = 0;
+        sigwait(&signals, &sig);
+        std::printf("served %zu requests\n", server.requestsServed());
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+    return 0;
+}
@@ -1,11 +1,14 @@
 #pragma once
 
 #include "core/Entity.h"
+#include "core/EntityColumns.h"
 #include "core/TimeExtent.h"
 #include "AppModel.h"
 #include <vector>
 #include <string>
 #include <functional>
+#include <future>
+#include <optional>
 #include <cstdint>
 
 /// Stats returned by the /stats endpoint
@@ -18,6 +21,22 @@ struct ServerStats {
     double uptime_seconds{0.0};
 };
 
+/// One time bucket of the server's data for a type, as listed by
+/// GET /v1/cache/bucket-hashes (doc/LOCAL_CACHE.md).  Covers [start, end).
+struct BucketSummary {
+    double start{0.0};
+    double end{0.0};
+    size_t count{0};
+    uint64_t hash{0};
+};
+
+/// How much of a region fetchRegion() delivered.
+enum class RegionStatus {
+    Complete,   ///< every entity in the region
+    Truncated,  ///< the source's row limit was hit; the region is incomplete
+    Failed,     ///< nothing usable (network/HTTP error)
+};
+
 /// Backend interface for fetching entities.
 /// Implementations can be real HTTP backends or fake data generators.
 /// Methods beyond fetchEntities have default no-op implementations so that
@@ -32,6 +51,18 @@ public:
         std::function<void(std::vector<Entity>&&)> callback
     ) = 0;
 
+    /// Fetch the entities in one space-time region for viewport loading,
+    /// and say whether that was all of them.  The default delegates to
+    /// fetchEntities, which has no limit to report.
+    virtual RegionStatus fetchRegion(
+        const TimeExtent& time,
+        const SpatialExtent& space,
+        std::function<void(std::vector<Entity>&&)> callback
+    ) {
+        fetchEntities(time, space, std::move(callback));
+        return RegionStatus::Complete;
+    }
+
     virtual void streamAllEntities(
         std::function<void(size_t total)> /*on_total*/,
         std::function<void(std::vector<Entity>&&)> /*batch_callback*/
@@ -43,8 +74,69 @@ public:
         std::function<void(std::vector<Entity>&&)> /*batch_callback*/
     ) {}
 
+    /// streamAllEntities as EntityColumns batches.  Backends that can decode
+    /// straight into columns override this; the default converts each entity
+    /// batch, so every backend supports it.
+    virtual void streamAllColumns(
+        std::function<void(size_t total)> on_total,
+        std::function<void(EntityColumns&&)> batch_callback
+    ) {
+        streamAllEntities(std::move(on_total), [&batch_callback](std::vector<Entity>&& batch) {
+            batch_callback(EntityColumns::fromEntities(batch));
+        });
+    }
+
+    /// streamAllByType as EntityColumns batches; the default converts.
+    virtual void streamColumnsByType(
+        double startTime,
+        double endTime,
+        std::function<void(EntityColumns&&)> batch_callback
+    ) {
+        streamAllByType(startTime, endTime, [&batch_callback](std::vector<Entity>&& batch) {
+            batch_callback(EntityColumns::fromEntities(batch));
+        });
+    }
+
     virtual void cancelFetch() {}
+
+    /// True if the last streamAllEntities / streamAllByType call delivered
+    /// everything: not cancelled and no error swallowed along the way.
+    virtual bool lastStreamComplete() const { return true; }
+
+    /// Per-bucket counts and hashes of this type's data, for cache sync.
+    /// Empty if the source cannot provide them (no endpoint, unreachable).
+    virtual std::optional<std::vector<BucketSummary>> fetchBucketSummaries(int /*bucketSeconds*/) {
+        return std::nullopt;
+    }
+
+    /// Stream every entity with time_start in one of `ranges` (half-open,
+    /// ascending), oldest first.  Returns true only if all of it arrived.
+    virtual bool streamBuckets(
+        const std::vector<TimeExtent>& /*ranges*/,
+        std::function<void(std::vector<Entity>&&)> /*batch_callback*/
+    ) { return false; }
+
+    /// An in-place change to a loaded layer: drop the entities whose
+    /// time_start falls in one of `ranges` (half-open), then add `entities`.
+    using RangeUpdate = std::function<void(std::vector<TimeExtent>&& ranges, std::vector<Entity>&& entities)>;
+
+    /// Bring data delivered by an earlier full load up to date, reporting
+    /// what changed through `on_update` (not called if nothing did).
+    virtual void refresh(RangeUpdate /*on_update*/) {}
+
     virtual std::vector<uint8_t> fetchPhotoThumb(const std::string& /*entityId*/) { return {}; }
+
+    /// Non-blocking thumbnail fetch; resolves to empty bytes on failure.
+    /// The default runs fetchPhotoThumb inline and returns a ready future.
+    virtual std::future<std::vector<uint8_t>> fetchPhotoThumbAsync(const std::string& entityId) {
+        std::promise<std::vector<uint8_t>> p;
+        try {
+            p.set_value(fetchPhotoThumb(entityId));
+        } catch (const std::exception&) {
+            p.set_value({});
+        }
+        return p.get_future();
+    }
     virtual ServerStats fetchStats() { return {}; }
 
     virtual const std::string& entityType() const {
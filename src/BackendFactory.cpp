@@ -1,6 +1,10 @@
 #include "BackendFactory.h"
+#include "CacheBackend.h"
 #include "FakeBackend.h"
 #include "HttpBackend.h"
+#include "SyntheticBackend.h"
+#include "core/EnvLoader.h"
+#include <cstdlib>
 
 void BackendSet::cancelAll()
 {
@@ -21,17 +25,60 @@ Backend* BackendSet::byIndex(int i)
     }
 }
 
+std::string defaultCacheDir()
+{
+    auto env = EnvLoader::load(".env");
+    std::string dir = EnvLoader::get(env, "CACHE_DIR");
+    if (dir.empty()) dir = EnvLoader::get(EnvLoader::load("../.env"), "CACHE_DIR");
+    if (dir.empty()) dir = "~/.reckoner/cache";
+
+    if (dir[0] == '~') {
+        const char* home = std::getenv("HOME");
+#ifdef _WIN32
+        if (!home) home = std::getenv("USERPROFILE");
+#endif
+        dir = std::string(home ? home : ".") + dir.substr(1);
+    }
+    return dir;
+}
+
 BackendSet createBackends(const BackendConfig& config, const std::string& url)
 {
     BackendSet set;
 
     if (config.type == BackendConfig::Type::Fake) {
         set.gps = std::make_unique<FakeBackend>(1000);
-    } else {
-        set.gps             = std::make_unique<HttpBackend>(url, "location.gps");
-        set.photo           = std::make_unique<HttpBackend>(url, "photo");
-        set.calendar        = std::make_unique<HttpBackend>(url, "calendar.event");
-        set.googleTimeline  = std::make_unique<HttpBackend>(url, "location.googletimeline");
+        return set;
+    }
+
+    if (config.type == BackendConfig::Type::Synthetic) {
+        SyntheticBackend::Config synth;
+        synth.seed = config.syntheticSeed;
+        synth.gpsPoints = config.syntheticGpsPoints;
+        set.gps             = std::make_unique<SyntheticBackend>("location.gps", synth);
+        set.photo           = std::make_unique<SyntheticBackend>("photo", synth);
+        set.calendar        = std::make_unique<SyntheticBackend>("calendar.event", synth);
+        set.googleTimeline  = std::make_unique<SyntheticBackend>("location.googletimeline", synth);
+        return set;
+    }
+
+    auto gps = std::make_unique<HttpBackend>(url, "location.gps");
+    gps->setExportShards(config.exportShards);
+    set.gps             = std::move(gps);
+    set.photo           = std::make_unique<HttpBackend>(url, "photo");
+    set.calendar        = std::make_unique<HttpBackend>(url, "calendar.event");
+    set.googleTimeline  = std::make_unique<HttpBackend>(url, "location.googletimeline");
+
+    if (config.type == BackendConfig::Type::Cached) {
+        std::string dir = config.cacheDir.empty() ? defaultCacheDir() : config.cacheDir;
+        auto cached = [&dir](std::unique_ptr<Backend>& slot) {
+            std::string type = slot->entityType();
+            slot = std::make_unique<CacheBackend>(std::move(slot), dir + "/" + type + ".rkcf", type);
+        };
+        cached(set.gps);
+        cached(set.photo);
+        cached(set.calendar);
+        cached(set.googleTimeline);
     }
 
     return set;
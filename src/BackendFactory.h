@@ -1,13 +1,30 @@
 #pragma once
 
 #include "Backend.h"
+#include <cstdint>
 #include <memory>
 #include <string>
 
 /// Configuration for backend creation
 struct BackendConfig {
-    enum class Type { Fake, Http };
+    /// Cached: HTTP backends behind a local RKCF cache file per layer.
+    /// Synthetic: generated data for all four layers (SyntheticBackend)
+    enum class Type { Fake, Http, Cached, Synthetic };
     Type type{Type::Http};
+    /// GPS export: concurrent time shards (1 = single stream).  Relies on the
+    /// server honouring start/end on /v1/query/export.
+    int exportShards{4};
+    /// Directory for the Cached backends' <type>.rkcf files; empty uses
+    /// defaultCacheDir().
+    std::string cacheDir{};
+    /// Load the location layers by visible region on demand instead of in
+    /// full (FetchOrchestrator::updateViewport).
+    bool viewportFetch{false};
+    /// Drop Google Timeline fixes that repeat a GPS fix (DuplicateRule).
+    bool dedupeTimeline{false};
+    /// Synthetic: world seed and GPS layer size
+    uint64_t syntheticSeed{1};
+    size_t syntheticGpsPoints{2000000};
 };
 
 /// A complete set of backends, one per layer
@@ -24,6 +41,10 @@ struct BackendSet {
     Backend* byIndex(int i);
 };
 
+/// CACHE_DIR from .env (or ../.env), else ~/.reckoner/cache.  A leading
+/// "~" expands to the home directory.
+std::string defaultCacheDir();
+
 /// Create a full set of backends from configuration.
-/// url is only used when config.type == Http.
+/// url is only used when config.type is Http or Cached.
 BackendSet createBackends(const BackendConfig& config, const std::string& url = "");
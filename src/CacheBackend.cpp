@@ -0,0 +1,225 @@
+#include "CacheBackend.h"
+#include "cache/CacheReader.h"
+#include "cache/CacheSync.h"
+#include "cache/CacheWriter.h"
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <iostream>
+#include <limits>
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    inline long ms_since(Clock::time_point t0) {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - t0).count();
+    }
+
+    // FetchOrchestrator asks for [0, 2e9] when it wants a whole layer; only
+    // such loads may become the cache
+    constexpr double kWholeTimelineEnd = 2000000000.0;
+}
+
+CacheBackend::CacheBackend(std::unique_ptr<Backend> upstream, std::string cachePath, std::string entityType)
+    : m_upstream(std::move(upstream))
+    , m_cachePath(std::move(cachePath))
+    , m_entityType(std::move(entityType))
+{
+}
+
+bool CacheBackend::loadFromCache(double start, double end,
+                                 const std::function<void(size_t)>& on_total,
+                                 const std::function<void(std::vector<Entity>&&)>& batch_callback)
+{
+    std::error_code ec;
+    if (!std::filesystem::exists(m_cachePath, ec)) return false;
+
+    auto t0 = Clock::now();
+    std::vector<std::vector<Entity>> batches;
+    size_t count = 0;
+    try {
+        CacheReader reader(m_cachePath);
+        if (reader.entityType() != m_entityType) {
+            std::cerr << "[CACHE] " << m_cachePath << " holds '" << reader.entityType()
+                      << "', expected '" << m_entityType << "'; ignoring it\n";
+            return false;
+        }
+        size_t first = reader.lowerBound(start);
+        size_t last = reader.lowerBound(std::nextafter(end, std::numeric_limits<double>::infinity()));
+        count = last - first;
+        // Everything is converted before the first batch goes out, so a
+        // corrupt record falls back cleanly instead of leaving half a layer
+        batches = reader.readBatches(first, last, kBatchRows, 0, &m_cancelled);
+    } catch (const std::exception& e) {
+        std::cerr << "[CACHE] " << e.what() << "; discarding it\n";
+        std::filesystem::remove(m_cachePath, ec);
+        return false;
+    }
+
+    std::cerr << "[CACHE] " << m_entityType << ": " << count << " entities mapped in "
+              << ms_since(t0) << "ms\n";
+    if (on_total) on_total(count);
+    for (auto& batch : batches) {
+        if (m_cancelled.load()) return true;
+        batch_callback(std::move(batch));
+    }
+    m_lastStreamComplete.store(!m_cancelled.load());
+    return true;
+}
+
+void CacheBackend::loadFromUpstream(bool writeCache,
+                                    const std::function<void(std::function<void(std::vector<Entity>&&)>)>& load,
+                                    const std::function<void(std::vector<Entity>&&)>& batch_callback)
+{
+    if (!m_upstream) return;
+
+    std::unique_ptr<CacheWriter> writer;
+    if (writeCache) {
+        writer = std::make_unique<CacheWriter>(m_entityType);
+        // Taken before the load, so every row the hashes cover is in it; a
+        // row that lands during the load only makes its bucket look stale
+        if (auto summaries = m_upstream->fetchBucketSummaries(CacheFormat::kDefaultBucketSeconds))
+            for (const auto& s : *summaries) writer->setBucketHash(s.start, s.hash, s.count);
+    }
+
+    load([&](std::vector<Entity>&& batch) {
+        if (writer) writer->add(batch);
+        batch_callback(std::move(batch));
+    });
+
+    bool complete = !m_cancelled.load() && m_upstream->lastStreamComplete();
+    m_lastStreamComplete.store(complete);
+    if (!writer || !complete) return;
+
+    auto t0 = Clock::now();
+    try {
+        writer->finish(m_cachePath);
+        std::cerr << "[CACHE] wrote " << writer->size() << " " << m_entityType << " entities to "
+                  << m_cachePath << " in " << ms_since(t0) << "ms\n";
+    } catch (const std::exception& e) {
+        std::cerr << "[CACHE] " << e.what() << "\n";
+    }
+}
+
+void CacheBackend::fetchEntities(
+    const TimeExtent& time,
+    const SpatialExtent& space,
+    std::function<void(std::vector<Entity>&&)> callback
+) {
+    m_cancelled.store(false);
+    std::vector<Entity> hits;
+    bool cached = loadFromCache(time.start, time.end, nullptr, [&](std::vector<Entity>&& batch) {
+        for (auto& e : batch) {
+            if (e.has_location() &&
+                *e.lat >= space.min_lat && *e.lat <= space.max_lat &&
+                *e.lon >= space.min_lon && *e.lon <= space.max_lon)
+                hits.push_back(std::move(e));
+        }
+    });
+    if (cached) {
+        callback(std::move(hits));
+    } else if (m_upstream) {
+        m_upstream->fetchEntities(time, space, std::move(callback));
+    } else {
+        callback({});
+    }
+}
+
+RegionStatus CacheBackend::fetchRegion(
+    const TimeExtent& time,
+    const SpatialExtent& space,
+    std::function<void(std::vector<Entity>&&)> callback
+) {
+    m_cancelled.store(false);
+    std::error_code ec;
+    if (std::filesystem::exists(m_cachePath, ec)) {
+        try {
+            CacheReader reader(m_cachePath);
+            if (reader.entityType() == m_entityType) {
+                size_t first = reader.lowerBound(time.start);
+                size_t last = reader.lowerBound(std::nextafter(time.end, std::numeric_limits<double>::infinity()));
+                std::vector<Entity> hits;
+                // Position is tested on the raw records; only hits are converted
+                const CacheEntity* records = reader.records();
+                for (size_t i = first; i < last; ++i) {
+                    const CacheEntity& r = records[i];
+                    if (r.lat >= space.min_lat && r.lat <= space.max_lat &&
+                        r.lon >= space.min_lon && r.lon <= space.max_lon)
+                        hits.push_back(reader.entity(i));
+                }
+                if (m_cancelled.load()) return RegionStatus::Failed;
+                callback(std::move(hits));
+                return RegionStatus::Complete;
+            }
+        } catch (const std::exception& e) {
+            std::cerr << "[CACHE] " << e.what() << "; region goes upstream\n";
+        }
+    }
+    if (m_upstream) return m_upstream->fetchRegion(time, space, std::move(callback));
+    callback({});
+    return RegionStatus::Complete;
+}
+
+void CacheBackend::streamAllEntities(
+    std::function<void(size_t)> on_total,
+    std::function<void(std::vector<Entity>&&)> batch_callback
+) {
+    m_cancelled.store(false);
+    m_lastStreamComplete.store(false);
+    constexpr double inf = std::numeric_limits<double>::infinity();
+    m_lastLoadFromCache.store(loadFromCache(-inf, inf, on_total, batch_callback));
+    if (m_lastLoadFromCache.load()) return;
+
+    loadFromUpstream(true, [&](std::function<void(std::vector<Entity>&&)> tee) {
+        m_upstream->streamAllEntities(on_total, std::move(tee));
+    }, batch_callback);
+}
+
+void CacheBackend::streamAllByType(
+    double startTime,
+    double endTime,
+    std::function<void(std::vector<Entity>&&)> batch_callback
+) {
+    m_cancelled.store(false);
+    m_lastStreamComplete.store(false);
+    m_lastLoadFromCache.store(loadFromCache(startTime, endTime, nullptr, batch_callback));
+    if (m_lastLoadFromCache.load()) return;
+
+    bool wholeTimeline = startTime <= 0.0 && endTime >= kWholeTimelineEnd;
+    loadFromUpstream(wholeTimeline, [&](std::function<void(std::vector<Entity>&&)> tee) {
+        m_upstream->streamAllByType(startTime, endTime, std::move(tee));
+    }, batch_callback);
+}
+
+void CacheBackend::refresh(RangeUpdate on_update)
+{
+    std::error_code ec;
+    if (!m_upstream || !std::filesystem::exists(m_cachePath, ec)) return;
+    m_cancelled.store(false);
+
+    CacheSync::Result result = CacheSync::sync(m_cachePath, m_entityType, *m_upstream, &m_cancelled);
+    if (result.ok && !result.replaced.empty() && on_update)
+        on_update(std::move(result.replaced), std::move(result.entities));
+}
+
+void CacheBackend::cancelFetch()
+{
+    m_cancelled.store(true);
+    if (m_upstream) m_upstream->cancelFetch();
+}
+
+std::vector<uint8_t> CacheBackend::fetchPhotoThumb(const std::string& entityId)
+{
+    return m_upstream ? m_upstream->fetchPhotoThumb(entityId) : std::vector<uint8_t>{};
+}
+
+std::future<std::vector<uint8_t>> CacheBackend::fetchPhotoThumbAsync(const std::string& entityId)
+{
+    if (m_upstream) return m_upstream->fetchPhotoThumbAsync(entityId);
+    return Backend::fetchPhotoThumbAsync(entityId);
+}
+
+ServerStats CacheBackend::fetchStats()
+{
+    return m_upstream ? m_upstream->fetchStats() : ServerStats{};
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "Backend.h"
+#include <atomic>
+#include <memory>
+#include <string>
+
+/// Serves one entity type from a local RKCF cache file (doc/LOCAL_CACHE.md),
+/// in front of an upstream backend that stays the source of truth.
+///
+/// With a valid cache, full loads come straight from the memory-mapped
+/// records, converted to entities on all cores.  Without one (first run,
+/// or a corrupt file) the load goes to the upstream backend as before, and
+/// a load that completes is written out as the cache for the next start.
+/// refresh() then keeps the file current by syncing only the time buckets
+/// that changed upstream (CacheSync).  Thumbnails and stats always go
+/// upstream.
+class CacheBackend : public Backend {
+public:
+    /// Entities per delivered batch when loading from the cache.
+    static constexpr size_t kBatchRows = 50000;
+
+    /// @param upstream may be null for a cache-only backend (tests, benchmarks)
+    CacheBackend(std::unique_ptr<Backend> upstream, std::string cachePath, std::string entityType);
+
+    void fetchEntities(
+        const TimeExtent& time,
+        const SpatialExtent& space,
+        std::function<void(std::vector<Entity>&&)> callback
+    ) override;
+
+    /// Served from the cache file when there is one, scanning only the
+    /// region's time slice; otherwise passed upstream.
+    RegionStatus fetchRegion(
+        const TimeExtent& time,
+        const SpatialExtent& space,
+        std::function<void(std::vector<Entity>&&)> callback
+    ) override;
+
+    void streamAllEntities(
+        std::function<void(size_t total)> on_total,
+        std::function<void(std::vector<Entity>&&)> batch_callback
+    ) override;
+
+    void streamAllByType(
+        double startTime,
+        double endTime,
+        std::function<void(std::vector<Entity>&&)> batch_callback
+    ) override;
+
+    /// Sync the cache file with the upstream bucket summaries and report
+    /// the re-fetched and dropped ranges.  A no-op without a cache file or
+    /// when the upstream cannot provide summaries.
+    void refresh(RangeUpdate on_update) override;
+
+    void cancelFetch() override;
+
+    bool lastStreamComplete() const override { return m_lastStreamComplete.load(); }
+
+    std::vector<uint8_t> fetchPhotoThumb(const std::string& entityId) override;
+    std::future<std::vector<uint8_t>> fetchPhotoThumbAsync(const std::string& entityId) override;
+    ServerStats fetchStats() override;
+
+    const std::string& entityType() const override { return m_entityType; }
+
+    const std::string& cachePath() const { return m_cachePath; }
+    Backend* upstream() const { return m_upstream.get(); }
+
+    /// Whether the last load was served from the cache file.
+    bool lastLoadFromCache() const { return m_lastLoadFromCache.load(); }
+
+private:
+    /// Deliver records with time_start in [start, end] from the cache file.
+    /// Returns false, delivering nothing, if there is no usable cache.
+    bool loadFromCache(double start, double end,
+                       const std::function<void(size_t)>& on_total,
+                       const std::function<void(std::vector<Entity>&&)>& batch_callback);
+
+    /// Run an upstream load, teeing its batches into a new cache file that
+    /// is written only if the load completes.
+    void loadFromUpstream(bool writeCache,
+                          const std::function<void(std::function<void(std::vector<Entity>&&)>)>& load,
+                          const std::function<void(std::vector<Entity>&&)>& batch_callback);
+
+    std::unique_ptr<Backend> m_upstream;
+    std::string m_cachePath;
+    std::string m_entityType;
+    std::atomic<bool> m_cancelled{false};
+    std::atomic<bool> m_lastStreamComplete{false};
+    std::atomic<bool> m_lastLoadFromCache{false};
+};
@@ -0,0 +1,341 @@
+#include "CoverageMap.h"
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+
+namespace {
+    constexpr int kMaxLevel = 30;  // cell indices stay well inside int64
+
+    int64_t cellsAt(int level) { return int64_t(1) << level; }
+
+    /// Cell index of a coordinate along an axis of `extent` degrees starting at
+    /// `origin`; the far edge of the world belongs to the last cell.
+    int64_t cellIndex(double v, double origin, double extent, int level)
+    {
+        int64_t n = cellsAt(level);
+        auto i = static_cast<int64_t>(std::floor((v - origin) / extent * static_cast<double>(n)));
+        return std::clamp<int64_t>(i, 0, n - 1);
+    }
+
+    /// Index of the last cell reaching past `v` (the cell holding the far
+    /// edge of a range that ends at v, exclusive).
+    int64_t lastCellIndex(double v, double origin, double extent, int level)
+    {
+        int64_t n = cellsAt(level);
+        auto i = static_cast<int64_t>(std::ceil((v - origin) / extent * static_cast<double>(n))) - 1;
+        return std::clamp<int64_t>(i, 0, n - 1);
+    }
+
+    /// Clip a set of half-open intervals to [lo, hi).
+    template <typename Intervals>
+    Intervals clipped(const Intervals& set, double lo, double hi)
+    {
+        Intervals out;
+        for (const auto& [s, e] : set) {
+            double a = std::max(s, lo), b = std::min(e, hi);
+            if (a < b) out.emplace(a, b);
+        }
+        return out;
+    }
+}
+
+bool CoverageMap::Request::owns(double lat, double lon, double t) const
+{
+    if (t < time.start || t >= time.end) return false;
+    if (lat < -90.0 || lat > 90.0 || lon < -180.0 || lon > 180.0) return false;
+    int64_t x = cellIndex(lon, -180.0, 360.0, level);
+    int64_t y = cellIndex(lat, -90.0, 180.0, level);
+    return x >= x0 && x <= x1 && y >= y0 && y <= y1;
+}
+
+SpatialExtent CoverageMap::bounds(const Cell& cell)
+{
+    double n = static_cast<double>(cellsAt(cell.level));
+    SpatialExtent s;
+    s.min_lon = -180.0 + 360.0 * static_cast<double>(cell.x) / n;
+    s.max_lon = -180.0 + 360.0 * static_cast<double>(cell.x + 1) / n;
+    s.min_lat = -90.0 + 180.0 * static_cast<double>(cell.y) / n;
+    s.max_lat = -90.0 + 180.0 * static_cast<double>(cell.y + 1) / n;
+    return s;
+}
+
+int CoverageMap::levelFor(const SpatialExtent& view) const
+{
+    // Fraction of the world the view spans along its wider axis
+    double span = std::max(view.lon_span() / 360.0, view.lat_span() / 180.0);
+    int maxLevel = std::clamp(m_config.maxLevel, 0, kMaxLevel);
+    if (!(span > 0.0)) return maxLevel;
+    double level = std::ceil(std::log2(std::max(1, m_config.cellsAcross) / span));
+    return static_cast<int>(std::clamp(level, 0.0, static_cast<double>(maxLevel)));
+}
+
+double CoverageMap::timeCellFor(const TimeExtent& window) const
+{
+    double target = window.duration() / std::max(1, m_config.timeCellsAcross);
+    if (!(target > m_config.minTimeCell)) return m_config.minTimeCell;
+    return std::exp2(std::floor(std::log2(target)));
+}
+
+bool CoverageMap::block(const SpatialExtent& view, const TimeExtent& window, Request& out) const
+{
+    SpatialExtent v;
+    v.min_lat = std::max(view.min_lat, -90.0);
+    v.max_lat = std::min(view.max_lat, 90.0);
+    v.min_lon = std::max(view.min_lon, -180.0);
+    v.max_lon = std::min(view.max_lon, 180.0);
+    if (!(v.min_lat < v.max_lat && v.min_lon < v.max_lon && window.start < window.end)) return false;
+
+    out.level = levelFor(v);
+    out.x0 = cellIndex(v.min_lon, -180.0, 360.0, out.level);
+    out.x1 = lastCellIndex(v.max_lon, -180.0, 360.0, out.level);
+    out.y0 = cellIndex(v.min_lat, -90.0, 180.0, out.level);
+    out.y1 = lastCellIndex(v.max_lat, -90.0, 180.0, out.level);
+    SpatialExtent lo = bounds({out.level, out.x0, out.y0});
+    SpatialExtent hi = bounds({out.level, out.x1, out.y1});
+    out.space.min_lon = lo.min_lon;
+    out.space.min_lat = lo.min_lat;
+    out.space.max_lon = hi.max_lon;
+    out.space.max_lat = hi.max_lat;
+
+    double w = timeCellFor(window);
+    out.time.start = std::floor(window.start / w) * w;
+    out.time.end = std::ceil(window.end / w) * w;
+    if (out.time.end <= out.time.start) out.time.end = out.time.start + w;
+    return true;
+}
+
+void CoverageMap::leaves(const Cell& cell, const SpatialExtent& view, std::vector<Cell>& out) const
+{
+    SpatialExtent b = bounds(cell);
+    if (b.max_lon <= view.min_lon || b.min_lon >= view.max_lon ||
+        b.max_lat <= view.min_lat || b.min_lat >= view.max_lat)
+        return;
+    if (cell.level < m_config.maxLevel && (m_dense.count(cell) || m_branches.count(cell))) {
+        for (int64_t dy = 0; dy < 2; ++dy)
+            for (int64_t dx = 0; dx < 2; ++dx)
+                leaves({cell.level + 1, cell.x * 2 + dx, cell.y * 2 + dy}, view, out);
+        return;
+    }
+    out.push_back(cell);
+}
+
+bool CoverageMap::covered(const Cell& cell, double t0, double t1) const
+{
+    // Walk t forward through any interval containing it, on the cell or
+    // any ancestor, until the range is covered or nothing extends it
+    double t = t0;
+    while (t < t1) {
+        double next = t;
+        Cell c = cell;
+        for (;;) {
+            auto node = m_nodes.find(c);
+            if (node != m_nodes.end()) {
+                auto it = node->second.upper_bound(t);
+                if (it != node->second.begin() && std::prev(it)->second > t)
+                    next = std::max(next, std::prev(it)->second);
+            }
+            if (c.level == 0) break;
+            c = {c.level - 1, c.x >> 1, c.y >> 1};
+        }
+        if (next <= t) return false;
+        t = next;
+    }
+    return true;
+}
+
+std::vector<CoverageMap::Request> CoverageMap::plan(const SpatialExtent& view, const TimeExtent& window) const
+{
+    Request area;
+    if (!block(view, window, area)) return {};
+
+    std::vector<Cell> cells;
+    for (int64_t y = area.y0; y <= area.y1; ++y)
+        for (int64_t x = area.x0; x <= area.x1; ++x)
+            leaves({area.level, x, y}, view, cells);
+
+    const size_t maxCells = std::max<size_t>(1, m_config.maxCellsPerRequest);
+    const double w = timeCellFor(window);
+
+    // Rectangles of uncovered cells for each time cell, then runs of time
+    // cells with the same rectangle become one request
+    std::vector<Request> open;  // rectangles still extendable in time
+    std::vector<Request> out;
+    for (double t = area.time.start; t < area.time.end; t += w) {
+        // Uncovered cells by level, row-major
+        std::map<int, std::vector<std::pair<int64_t, int64_t>>> byLevel;
+        for (const auto& c : cells)
+            if (!covered(c, t, t + w)) byLevel[c.level].push_back({c.y, c.x});
+
+        std::vector<Request> rects;
+        for (auto& [level, yx] : byLevel) {
+            std::sort(yx.begin(), yx.end());
+            // Horizontal runs per row
+            std::vector<Request> runs;
+            for (size_t i = 0; i < yx.size();) {
+                size_t j = i + 1;
+                while (j < yx.size() && yx[j].first == yx[i].first &&
+                       yx[j].second == yx[j - 1].second + 1 && j - i < maxCells)
+                    ++j;
+                Request r;
+                r.level = level;
+                r.y0 = r.y1 = yx[i].first;
+                r.x0 = yx[i].second;
+                r.x1 = yx[j - 1].second;
+                runs.push_back(r);
+                i = j;
+            }
+            // Stack runs with the same columns from consecutive rows
+            std::vector<Request> merged;
+            for (const auto& run : runs) {
+                auto above = std::find_if(merged.begin(), merged.end(), [&](const Request& m) {
+                    return m.x0 == run.x0 && m.x1 == run.x1 && m.y1 + 1 == run.y0 &&
+                           m.cells() + run.cells() <= maxCells;
+                });
+                if (above != merged.end())
+                    above->y1 = run.y1;
+                else
+                    merged.push_back(run);
+            }
+            rects.insert(rects.end(), merged.begin(), merged.end());
+        }
+
+        std::vector<Request> stillOpen;
+        for (auto& r : rects) {
+            r.time = {t, t + w};
+            auto prev = std::find_if(open.begin(), open.end(), [&](const Request& o) {
+                return o.level == r.level && o.x0 == r.x0 && o.x1 == r.x1 && o.y0 == r.y0 && o.y1 == r.y1;
+            });
+            size_t spans = prev == open.end() ? 0
+                : static_cast<size_t>(std::llround(prev->time.duration() / w));
+            if (prev != open.end() && (spans + 1) * r.cells() <= maxCells) {
+                prev->time.end = r.time.end;
+                stillOpen.push_back(*prev);
+                prev->level = -1;  // taken
+            } else {
+                stillOpen.push_back(r);
+            }
+        }
+        for (const auto& o : open)
+            if (o.level >= 0) out.push_back(o);
+        open = std::move(stillOpen);
+    }
+    out.insert(out.end(), open.begin(), open.end());
+
+    for (auto& r : out) {
+        SpatialExtent lo = bounds({r.level, r.x0, r.y0});
+        SpatialExtent hi = bounds({r.level, r.x1, r.y1});
+        r.space.min_lon = lo.min_lon;
+        r.space.min_lat = lo.min_lat;
+        r.space.max_lon = hi.max_lon;
+        r.space.max_lat = hi.max_lat;
+    }
+    std::stable_sort(out.begin(), out.end(),
+                     [](const Request& a, const Request& b) { return a.time.start < b.time.start; });
+    return out;
+}
+
+void CoverageMap::insert(Intervals& set, double t0, double t1)
+{
+    if (!(t0 < t1)) return;
+    // Absorb every interval that overlaps or touches [t0, t1)
+    auto it = set.upper_bound(t0);
+    if (it != set.begin() && std::prev(it)->second >= t0) --it;
+    while (it != set.end() && it->first <= t1) {
+        t0 = std::min(t0, it->first);
+        t1 = std::max(t1, it->second);
+        it = set.erase(it);
+    }
+    set.emplace(t0, t1);
+}
+
+void CoverageMap::markCovered(const Request& request)
+{
+    for (int64_t y = request.y0; y <= request.y1; ++y)
+        for (int64_t x = request.x0; x <= request.x1; ++x) {
+            insert(m_nodes[{request.level, x, y}], request.time.start, request.time.end);
+            addBranch({request.level, x, y});
+        }
+}
+
+void CoverageMap::addBranch(Cell cell)
+{
+    while (cell.level > 0) {
+        cell = {cell.level - 1, cell.x >> 1, cell.y >> 1};
+        if (!m_branches.insert(cell).second) break;  // the rest are there already
+    }
+}
+
+void CoverageMap::markDense(const Request& request)
+{
+    if (request.level >= m_config.maxLevel) return;
+    for (int64_t y = request.y0; y <= request.y1; ++y)
+        for (int64_t x = request.x0; x <= request.x1; ++x)
+            m_dense.insert({request.level, x, y});
+}
+
+CoverageMap::Request CoverageMap::retain(const SpatialExtent& view, const TimeExtent& window)
+{
+    Request keep;
+    if (!block(view, window, keep)) {
+        clear();
+        return keep;  // owns nothing
+    }
+    const int L = keep.level;
+
+    std::unordered_map<Cell, Intervals, CellHash> kept;
+    for (const auto& [cell, intervals] : m_nodes) {
+        Intervals times = clipped(intervals, keep.time.start, keep.time.end);
+        if (times.empty()) continue;
+
+        // The node's extent in level-L cells
+        int64_t x0, x1, y0, y1;
+        if (cell.level >= L) {
+            x0 = x1 = cell.x >> (cell.level - L);
+            y0 = y1 = cell.y >> (cell.level - L);
+        } else {
+            int shift = L - cell.level;
+            x0 = cell.x << shift;
+            y0 = cell.y << shift;
+            x1 = x0 + (int64_t(1) << shift) - 1;
+            y1 = y0 + (int64_t(1) << shift) - 1;
+        }
+        int64_t ix0 = std::max(x0, keep.x0), ix1 = std::min(x1, keep.x1);
+        int64_t iy0 = std::max(y0, keep.y0), iy1 = std::min(y1, keep.y1);
+        if (ix0 > ix1 || iy0 > iy1) continue;
+
+        if (ix0 == x0 && ix1 == x1 && iy0 == y0 && iy1 == y1) {
+            for (const auto& [s, e] : times) insert(kept[cell], s, e);
+            continue;
+        }
+        // A coarse node straddling the edge: keep its coverage on the
+        // level-L cells inside the block only
+        for (int64_t y = iy0; y <= iy1; ++y)
+            for (int64_t x = ix0; x <= ix1; ++x)
+                for (const auto& [s, e] : times) insert(kept[{L, x, y}], s, e);
+    }
+    m_nodes = std::move(kept);
+    m_branches.clear();
+    for (const auto& node : m_nodes) addBranch(node.first);
+
+    for (auto it = m_dense.begin(); it != m_dense.end();) {
+        const Cell& c = *it;
+        bool inside;
+        if (c.level >= L) {
+            int64_t x = c.x >> (c.level - L), y = c.y >> (c.level - L);
+            inside = x >= keep.x0 && x <= keep.x1 && y >= keep.y0 && y <= keep.y1;
+        } else {
+            int shift = L - c.level;
+            inside = (keep.x1 >> shift) >= c.x && (keep.x0 >> shift) <= c.x &&
+                     (keep.y1 >> shift) >= c.y && (keep.y0 >> shift) <= c.y;
+        }
+        it = inside ? std::next(it) : m_dense.erase(it);
+    }
+    return keep;
+}
+
+void CoverageMap::clear()
+{
+    m_nodes.clear();
+    m_dense.clear();
+    m_branches.clear();
+}
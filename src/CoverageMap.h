@@ -0,0 +1,117 @@
+#pragma once
+
+#include "AppModel.h"
+#include "core/TimeExtent.h"
+#include <cstdint>
+#include <map>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+/// Which space-time regions of one layer have been loaded, for viewport-
+/// driven fetching.
+///
+/// Space is a quadtree of lat/lon cells: level L splits the world into
+/// 2^L x 2^L equal cells (x from -180 lon, y from -90 lat).  Each node keeps
+/// the time intervals loaded for its whole cell, so coverage recorded at a
+/// coarse level also covers every finer cell inside it.  Time is cut into
+/// power-of-two-second cells sized to the timeline window.
+///
+/// plan() decomposes a view into cells at a level sized to it, drops the
+/// covered ones, and coalesces the rest into rectangular requests.  A cell
+/// with finer coverage below it (loaded while zoomed in) is split into its
+/// four children, so nothing is requested twice; so is a cell whose request
+/// the source truncated (marked dense).  All regions are half-open: an
+/// entity belongs to exactly one cell.
+class CoverageMap {
+public:
+    struct Config {
+        int cellsAcross = 4;        ///< spatial cells across the view, at least
+        int timeCellsAcross = 8;    ///< time cells across the window, at least
+        int maxLevel = 22;          ///< finest cells (~10 m); truncation is accepted there
+        double minTimeCell = 64.0;  ///< seconds, a power of two
+        size_t maxCellsPerRequest = 32;
+    };
+
+    struct Cell {
+        int level;
+        int64_t x;
+        int64_t y;
+        bool operator==(const Cell& o) const { return level == o.level && x == o.x && y == o.y; }
+    };
+
+    /// A cell-aligned block: cells [x0, x1] x [y0, y1] at `level`, over `time`.
+    struct Request {
+        int level = 0;
+        int64_t x0 = 0, y0 = 0, x1 = -1, y1 = -1;
+        SpatialExtent space;  ///< bounds of the cells
+        TimeExtent time{0.0, 0.0};
+
+        size_t cells() const { return static_cast<size_t>((x1 - x0 + 1) * (y1 - y0 + 1)); }
+        /// Whether an entity at (lat, lon, time_start) belongs to this block.
+        bool owns(double lat, double lon, double t) const;
+    };
+
+    CoverageMap() = default;
+    explicit CoverageMap(Config config) : m_config(config) {}
+
+    const Config& config() const { return m_config; }
+
+    /// The uncovered part of view x window as requests, oldest time first.
+    std::vector<Request> plan(const SpatialExtent& view, const TimeExtent& window) const;
+
+    /// Record that every entity of the request's block is loaded.
+    void markCovered(const Request& request);
+
+    /// Record that the request's block is too dense for one response.
+    void markDense(const Request& request);
+
+    bool covered(const Cell& cell, double t0, double t1) const;
+
+    /// Forget coverage outside the cell-aligned block around view x window
+    /// (what plan() would use), for evicting the entities outside it.
+    /// Returns that block; entities it does not own() should be dropped.
+    Request retain(const SpatialExtent& view, const TimeExtent& window);
+
+    void clear();
+
+    /// Quadtree nodes holding coverage.
+    size_t nodeCount() const { return m_nodes.size(); }
+
+    /// The level plan() uses for a view.
+    int levelFor(const SpatialExtent& view) const;
+
+    /// The time cell width plan() uses for a window (seconds).
+    double timeCellFor(const TimeExtent& window) const;
+
+    static SpatialExtent bounds(const Cell& cell);
+
+private:
+    struct CellHash {
+        size_t operator()(const Cell& c) const {
+            uint64_t h = static_cast<uint64_t>(c.x) * 0x9E3779B97F4A7C15ull;
+            h ^= static_cast<uint64_t>(c.y) + 0x7F4A7C159E3779B9ull + (h << 6) + (h >> 2);
+            return static_cast<size_t>(h ^ static_cast<uint64_t>(c.level));
+        }
+    };
+
+    /// Disjoint half-open time intervals, start -> end.
+    using Intervals = std::map<double, double>;
+
+    static void insert(Intervals& set, double t0, double t1);
+
+    /// The view's cell-aligned block at levelFor(view), clamped to the world.
+    bool block(const SpatialExtent& view, const TimeExtent& window, Request& out) const;
+
+    /// The cells to test for one base cell: itself, or its descendants
+    /// inside `view` where it is dense or has coverage below it.
+    void leaves(const Cell& cell, const SpatialExtent& view, std::vector<Cell>& out) const;
+
+    /// Add the strict ancestors of `cell` to m_branches.
+    void addBranch(Cell cell);
+
+    Config m_config;
+    std::unordered_map<Cell, Intervals, CellHash> m_nodes;
+    std::unordered_set<Cell, CellHash> m_dense;
+    std::unordered_set<Cell, CellHash> m_branches;  ///< cells with nodes below them
+};
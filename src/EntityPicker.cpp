@@ -1,55 +1,57 @@
 #include "EntityPicker.h"
 #include <algorithm>
 #include <cmath>
+#include <functional>
 #include <limits>
 
-void EntityPicker::rebuild(const std::vector<Entity>& entities)
+void EntityPicker::rebuild(const EntityStore& entities)
 {
     m_entities = &entities;
     m_mapGrid.clear();
-    m_timeSorted.clear();
-    m_timeSorted.reserve(entities.size());
-
-    for (int i = 0; i < static_cast<int>(entities.size()); ++i) {
-        const auto& e = entities[i];
-
-        // Timeline index: all entities (time always present)
-        m_timeSorted.push_back({e.time_mid(), i});
-
-        // Map index: only entities with a location
-        if (e.has_location()) {
-            int32_t cx = static_cast<int32_t>(std::floor(*e.lon / MAP_CELL_SIZE));
-            int32_t cy = static_cast<int32_t>(std::floor(*e.lat / MAP_CELL_SIZE));
-            m_mapGrid[cellKey(cx, cy)].indices.push_back(i);
-        }
-    }
-
-    std::sort(m_timeSorted.begin(), m_timeSorted.end());
+    m_timeRuns.clear();
+    m_indexed = 0;
+    addEntities(entities, 0);
 }
 
-void EntityPicker::addEntities(const std::vector<Entity>& entities, size_t fromIdx)
+void EntityPicker::addEntities(const EntityStore& entities, size_t fromIdx, size_t toIdx)
 {
     m_entities = &entities;
-
-    // Remember where the already-sorted portion ends
-    auto mid = static_cast<ptrdiff_t>(m_timeSorted.size());
-
-    for (size_t i = fromIdx; i < entities.size(); ++i) {
-        const auto& e = entities[i];
-        int idx = static_cast<int>(i);
-
-        m_timeSorted.push_back({e.time_mid(), idx});
-
-        if (e.has_location()) {
-            int32_t cx = static_cast<int32_t>(std::floor(*e.lon / MAP_CELL_SIZE));
-            int32_t cy = static_cast<int32_t>(std::floor(*e.lat / MAP_CELL_SIZE));
-            m_mapGrid[cellKey(cx, cy)].indices.push_back(idx);
+    toIdx = std::min(toIdx, entities.size());
+
+    size_t i = fromIdx;
+    while (i < toIdx) {
+        // Run r is the store's segment r
+        size_t runIdx = i / TIME_RUN_SIZE;
+        if (m_timeRuns.size() <= runIdx) m_timeRuns.resize(runIdx + 1);
+        TimeRun& run = m_timeRuns[runIdx];
+        size_t runStart = runIdx * TIME_RUN_SIZE;
+        size_t runEnd = std::min(toIdx, runStart + TIME_RUN_SIZE);
+        const EntityColumns& c = entities.segment(runIdx);
+
+        // Remember where the already-sorted portion of the run ends
+        auto mid = static_cast<ptrdiff_t>(run.size());
+
+        for (; i < runEnd; ++i) {
+            int idx = static_cast<int>(i);
+            size_t row = i - runStart;
+
+            // Timeline index: all entities (time always present)
+            run.push_back({(c.time_start[row] + c.time_end[row]) / 2.0, idx});
+
+            // Map index: only entities with a location
+            if (c.hasLocation(row)) {
+                int32_t cx = static_cast<int32_t>(std::floor(c.lon[row] / MAP_CELL_SIZE));
+                int32_t cy = static_cast<int32_t>(std::floor(c.lat[row] / MAP_CELL_SIZE));
+                m_mapGrid[cellKey(cx, cy)].indices.push_back(idx);
+            }
         }
+
+        // Sort the new part, then merge it with the run's sorted front
+        std::sort(run.begin() + mid, run.end());
+        std::inplace_merge(run.begin(), run.begin() + mid, run.end());
     }
 
-    // Sort the new chunk, then merge it with the already-sorted front in O(n)
-    std::sort(m_timeSorted.begin() + mid, m_timeSorted.end());
-    std::inplace_merge(m_timeSorted.begin(), m_timeSorted.begin() + mid, m_timeSorted.end());
+    m_indexed = std::max(m_indexed, toIdx);
 }
 
 int EntityPicker::pickMap(double lon, double lat, double radiusDeg) const
@@ -70,9 +72,11 @@ int EntityPicker::pickMap(double lon, double lat, double radiusDeg) const
             if (it == m_mapGrid.end()) continue;
 
             for (int idx : it->second.indices) {
-                const auto& e = (*m_entities)[idx];
-                double dlon = *e.lon - lon;
-                double dlat = *e.lat - lat;
+                if (static_cast<size_t>(idx) >= m_entities->size()) continue;  // stale
+                const EntityColumns& c = m_entities->segment(idx / TIME_RUN_SIZE);
+                size_t row = idx % TIME_RUN_SIZE;
+                double dlon = c.lon[row] - lon;
+                double dlat = c.lat[row] - lat;
                 double d2 = dlon * dlon + dlat * dlat;
                 if (d2 < bestDist2) {
                     bestDist2 = d2;
@@ -88,33 +92,74 @@ int EntityPicker::pickMap(double lon, double lat, double radiusDeg) const
 int EntityPicker::pickTimeline(double time, float renderOffset,
                                 double timeRadius, float yRadius) const
 {
-    if (!m_entities || m_timeSorted.empty()) return -1;
-
-    // Binary search for the time window [time - timeRadius, time + timeRadius]
-    auto lo = std::lower_bound(m_timeSorted.begin(), m_timeSorted.end(),
-                               std::make_pair(time - timeRadius,
-                                              std::numeric_limits<int>::min()));
-    auto hi = std::upper_bound(m_timeSorted.begin(), m_timeSorted.end(),
-                               std::make_pair(time + timeRadius,
-                                              std::numeric_limits<int>::max()));
+    if (!m_entities || m_timeRuns.empty()) return -1;
 
     int bestIdx = -1;
     double bestDist2 = 2.0; // normalized distance threshold > 1 means "none"
 
-    for (auto it = lo; it != hi; ++it) {
-        int idx = it->second;
-        const auto& e = (*m_entities)[idx];
-
-        // Normalize both axes: 1.0 = at the edge of the search radius
-        double dt = (e.time_mid() - time) / timeRadius;
-        double dy = (static_cast<double>(e.render_offset) - renderOffset) / yRadius;
-        double d2 = dt * dt + dy * dy;
-
-        if (d2 < bestDist2) {
-            bestDist2 = d2;
-            bestIdx = idx;
+    for (size_t r = 0; r < m_timeRuns.size(); ++r) {
+        const TimeRun& run = m_timeRuns[r];
+        // Binary search for the time window [time - timeRadius, time + timeRadius]
+        auto lo = std::lower_bound(run.begin(), run.end(),
+                                   std::make_pair(time - timeRadius,
+                                                  std::numeric_limits<int>::min()));
+        auto hi = std::upper_bound(lo, run.end(),
+                                   std::make_pair(time + timeRadius,
+                                                  std::numeric_limits<int>::max()));
+        if (lo == hi) continue;
+        if (r >= m_entities->segmentCount()) break;  // stale
+        const EntityColumns& c = m_entities->segment(r);
+
+        for (auto it = lo; it != hi; ++it) {
+            int idx = it->second;
+            if (static_cast<size_t>(idx - r * TIME_RUN_SIZE) >= c.size()) continue;
+
+            // Normalize both axes: 1.0 = at the edge of the search radius
+            double dt = (it->first - time) / timeRadius;
+            double dy = (static_cast<double>(c.render_offset[idx - r * TIME_RUN_SIZE]) - renderOffset) / yRadius;
+            double d2 = dt * dt + dy * dy;
+
+            if (d2 < bestDist2) {
+                bestDist2 = d2;
+                bestIdx = idx;
+            }
         }
     }
 
     return bestIdx;
 }
+
+std::vector<int> EntityPicker::nearestInTime(int entityIdx, size_t perSide) const
+{
+    std::vector<int> result;
+    if (!m_entities || entityIdx < 0 || static_cast<size_t>(entityIdx) >= m_indexed ||
+        static_cast<size_t>(entityIdx) >= m_entities->size())
+        return result;
+
+    const auto key = std::make_pair((*m_entities)[entityIdx].time_mid(), entityIdx);
+
+    // The nearest perSide on each side within every run, then the nearest of those
+    std::vector<std::pair<double, int>> before, after;
+    for (const auto& run : m_timeRuns) {
+        auto it = std::lower_bound(run.begin(), run.end(), key);
+        auto next = (it != run.end() && *it == key) ? it + 1 : it;
+        for (auto a = next; a != run.end() && a - next < static_cast<ptrdiff_t>(perSide); ++a)
+            after.push_back(*a);
+        for (auto b = it; b != run.begin() && it - b < static_cast<ptrdiff_t>(perSide);)
+            before.push_back(*--b);
+    }
+    std::sort(after.begin(), after.end());
+    std::sort(before.begin(), before.end(), std::greater<>());
+    after.resize(std::min(after.size(), perSide));
+    before.resize(std::min(before.size(), perSide));
+
+    // Interleave by distance in time
+    size_t a = 0, b = 0;
+    while (a < after.size() || b < before.size()) {
+        bool takeAfter = b == before.size() ||
+            (a < after.size() && after[a].first - key.first <= key.first - before[b].first);
+        int idx = takeAfter ? after[a++].second : before[b++].second;
+        if (static_cast<size_t>(idx) < m_entities->size()) result.push_back(idx);  // else stale
+    }
+    return result;
+}
@@ -1,12 +1,16 @@
 #pragma once
 
-#include "core/Entity.h"
+#include "core/EntityStore.h"
 #include <vector>
 #include <unordered_map>
+#include <cstddef>
 #include <cstdint>
 
 /// Spatial index for fast entity picking in both the map and timeline views.
 /// Build once via rebuild() whenever entities change; query every frame.
+/// A picker left over from before an edit only returns indices the store
+/// still has, but they may name other rows: callers should not pick with
+/// it until it is rebuilt (InteractionController::pickerCurrent).
 class EntityPicker
 {
 public:
@@ -14,13 +18,24 @@ public:
     // Smaller = faster queries but more memory; 0.05° ≈ 5 km.
     static constexpr double MAP_CELL_SIZE = 0.05;
 
+    // Entities per sorted run of the timeline index: one EntityStore segment.
+    // Each run covers a fixed range of entity indices, so appending only
+    // re-sorts the last run.
+    static constexpr size_t TIME_RUN_SIZE = EntityStore::kSegmentSize;
+
     /// Full rebuild from scratch. Call when the entity list is cleared/reloaded.
     /// O(n log n).
-    void rebuild(const std::vector<Entity>& entities);
+    void rebuild(const EntityStore& entities);
+
+    /// Incrementally insert entities[fromIdx..toIdx) into the existing index
+    /// (toIdx clamped to entities.size()); fromIdx must be where the previous
+    /// call stopped.  O(batch_size) for the grid + O(TIME_RUN_SIZE) per
+    /// touched time run, independent of how many entities are indexed.
+    void addEntities(const EntityStore& entities, size_t fromIdx,
+                     size_t toIdx = SIZE_MAX);
 
-    /// Incrementally insert entities[fromIdx..end) into the existing index.
-    /// O(batch_size) for the grid + O(n) for the merge — safe to call per chunk.
-    void addEntities(const std::vector<Entity>& entities, size_t fromIdx);
+    /// Entities indexed so far.
+    size_t indexedCount() const { return m_indexed; }
 
     /// Find the nearest entity within radiusDeg of (lon, lat) in the map view.
     /// Returns the index into the entities vector, or -1 if none found.
@@ -32,18 +47,25 @@ public:
     int pickTimeline(double time, float renderOffset,
                      double timeRadius, float yRadius) const;
 
+    /// Up to `perSide` indexed entities just before and just after entity
+    /// `entityIdx` in time_mid order, nearest first.  Empty if it is not indexed.
+    std::vector<int> nearestInTime(int entityIdx, size_t perSide) const;
+
     bool empty() const { return m_entities == nullptr || m_entities->empty(); }
 
 private:
     struct GridCell { std::vector<int> indices; };
 
-    const std::vector<Entity>* m_entities = nullptr;
+    const EntityStore* m_entities = nullptr;
 
     // Map: 2D flat hash grid in lat/lon space
     std::unordered_map<uint64_t, GridCell> m_mapGrid;
 
-    // Timeline: entities sorted by time_mid for binary-search range queries
-    std::vector<std::pair<double, int>> m_timeSorted; // (time_mid, entity_idx)
+    // Timeline: runs of (time_mid, entity_idx) sorted by time_mid for
+    // binary-search range queries; run r holds entities [r, r+1) * TIME_RUN_SIZE
+    using TimeRun = std::vector<std::pair<double, int>>;
+    std::vector<TimeRun> m_timeRuns;
+    size_t m_indexed = 0;
 
     static uint64_t cellKey(int32_t cx, int32_t cy)
     {
@@ -1,7 +1,10 @@
 #include "FetchOrchestrator.h"
+#include <algorithm>
 #include <iostream>
 #include <chrono>
 #include <iterator>
+#include <string_view>
+#include <unordered_set>
 
 namespace {
     using Clock = std::chrono::steady_clock;
@@ -9,6 +12,53 @@ namespace {
     inline long ms_since(Clock::time_point t0) {
         return std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - t0).count();
     }
+
+    constexpr double kFirstRetrySec = 1.0;
+    constexpr double kMaxRetrySec = 30.0;
+
+    /// A layer's unsorted tail is merged once it is 1/kMergeFraction of the
+    /// sorted rows, so each row is copied a bounded number of times however
+    /// the batches arrive.
+    constexpr size_t kMergeFraction = 4;
+
+    /// Merge a refresh's `entities` in by id, then drop the rows with
+    /// time_start in `ranges` (half-open, ascending) that it no longer
+    /// lists.  Bumps the revision only if a row changed or went; rows
+    /// appended out of time order are left to mergeUnsorted.
+    void replaceRanges(Layer& layer, const std::vector<TimeExtent>& ranges, EntityColumns&& entities)
+    {
+        auto inRanges = [&ranges](double t) {
+            auto it = std::upper_bound(ranges.begin(), ranges.end(), t,
+                                       [](double v, const TimeExtent& r) { return v < r.start; });
+            return it != ranges.begin() && t < std::prev(it)->end;
+        };
+
+        auto& store = layer.entities;
+        std::unordered_set<std::string_view> listed;
+        listed.reserve(entities.size());
+        for (size_t i = 0; i < entities.size(); ++i) listed.insert(entities.idAt(i));
+        std::vector<uint32_t> stale;
+        auto check = [&](const EntityColumns& c, size_t row, size_t i) {
+            if (inRanges(c.time_start[row]) && !listed.count(c.idAt(row)))
+                stale.push_back(static_cast<uint32_t>(i));
+        };
+        // Only the rows in the ranges are read, plus any unsorted tail
+        for (const auto& r : ranges) {
+            auto [from, to] = store.timeRange(r.start, r.end);
+            store.forEach(from, to, check);
+        }
+        store.forEach(store.sortedCount(), store.size(), check);
+
+        // The stale rows go in the rewrite that drops the moved ones
+        bool dropped = !stale.empty();
+        EntityStore::UpsertResult result = store.upsert(entities, std::move(stale));
+        if (result.updated > 0 || dropped) ++layer.revision;
+    }
+}
+
+FetchOrchestrator::FetchOrchestrator(size_t queueCapacity)
+    : m_completedBatches(queueCapacity)
+{
 }
 
 FetchOrchestrator::~FetchOrchestrator()
@@ -20,93 +70,123 @@ void FetchOrchestrator::setBackends(BackendSet backends, BackendConfig::Type typ
 {
     m_backendType = type;
     m_backends = std::move(backends);
-    std::lock_guard<std::mutex> lock(m_batchMutex);
-    m_completedBatches.clear();
+    discardQueued();
+}
+
+bool FetchOrchestrator::enqueue(PendingBatch&& batch, const char* tag)
+{
+    int li = batch.layerIndex;
+    bool counted = li >= 0 && li < static_cast<int>(m_queuedPerLayer.size());
+    if (counted) ++m_queuedPerLayer[li];
+
+    auto t = Clock::now();
+    bool queued = m_completedBatches.push(std::move(batch), [this] { return m_queueCancelled.load(); });
+    long waitMs = ms_since(t);
+    if (waitMs > 5)
+        std::cerr << "[" << tag << "] waited " << waitMs << "ms for space in the batch queue\n";
+    if (!queued && counted) --m_queuedPerLayer[li];
+    return queued;
+}
+
+void FetchOrchestrator::discardQueued()
+{
+    PendingBatch pb;
+    while (m_completedBatches.tryPop(pb))
+        if (pb.layerIndex >= 0 && pb.layerIndex < static_cast<int>(m_queuedPerLayer.size()))
+            --m_queuedPerLayer[pb.layerIndex];
+    // A merge still reads its layer, so it is waited for before the layer
+    // can be cleared
+    for (auto& m : m_merges) {
+        if (m.merged.valid()) m.merged.wait();
+        m = LayerMerge{};
+    }
+}
+
+bool FetchOrchestrator::merging(int layerIndex) const
+{
+    const LayerMerge& m = m_merges.at(layerIndex);
+    return m.merged.valid() || !m.held.empty();
+}
+
+FetchOrchestrator::QueueStats FetchOrchestrator::queueStats() const
+{
+    return m_completedBatches.stats();
 }
 
 void FetchOrchestrator::startFullLoad(AppModel& model)
 {
     std::cerr << "[LOAD] startFullLoad begin\n";
 
-    {
-        std::lock_guard<std::mutex> lock(m_batchMutex);
-        m_completedBatches.clear();
-    }
+    discardQueued();
 
+    // A revision bump, so views that catch up over several frames start over
+    // even if the reload outgrows what they had seen before the next frame
     for (auto& layer : model.layers) {
         layer.entities.clear();
+        ++layer.revision;
         layer.is_fetching = false;
     }
     model.initial_load_complete.store(false);
     model.total_expected.store(0);
+    m_sweptKeep = {SIZE_MAX, 0};
+    m_sweepPending = false;
+    m_refreshed = {};
+
+    if (m_viewportFetch) {
+        // updateViewport() loads the location layers as they come into view
+        for (auto& vl : m_viewport) vl = ViewportLayer{};
+        model.initial_load_complete.store(true);
+    }
 
-    if (m_backendType == BackendConfig::Type::Http) {
-        if (m_backends.gps) {
+    if (m_backendType != BackendConfig::Type::Fake) {
+        if (m_backends.gps && !m_viewportFetch) {
             auto* gps = m_backends.gps.get();
             model.layers[0].startFetch();
+            model.layers[0].entities.indexIds();  // as it loads, for the refresh after
             m_pendingGpsFetch = std::async(std::launch::async, [this, &model, gps]() {
                 std::cerr << "[GPS] stream started\n";
                 size_t batchNum = 0;
-                gps->streamAllEntities(
+                gps->streamAllColumns(
                     [&model](size_t total) {
                         std::cerr << "[GPS] total expected: " << total << "\n";
                         model.total_expected.store(total);
                     },
-                    [this, &batchNum](std::vector<Entity>&& batch) {
+                    [this, &batchNum](EntityColumns&& batch) {
                         ++batchNum;
                         std::cerr << "[GPS] batch " << batchNum
                                   << " size=" << batch.size() << "\n";
-                        auto t = Clock::now();
-                        std::lock_guard<std::mutex> lock(m_batchMutex);
-                        long lockMs = ms_since(t);
-                        if (lockMs > 5)
-                            std::cerr << "[GPS] waited " << lockMs << "ms for batchMutex\n";
-                        m_completedBatches.push_back({0, std::move(batch)});
+                        enqueue({0, std::move(batch)}, "GPS");
                     });
                 std::cerr << "[GPS] stream complete, " << batchNum << " batches\n";
                 model.fetch_latencies.push(static_cast<float>(
                     ms_since(model.layers[0].last_fetch_start)));
                 model.layers[0].endFetch();
                 model.initial_load_complete.store(true);
+                if (gps->lastStreamComplete()) gps->refresh(queueUpdates(0, "GPS"));
             });
         }
 
-        struct TypeFetch {
-            int layerIndex;
-            Backend* backend;
-            std::future<void>* future;
-            const char* tag;
-        };
-        TypeFetch typeFetches[] = {
-            {1, m_backends.photo.get(),          &m_pendingPhotoFetch,           "PHOTO"},
-            {2, m_backends.calendar.get(),       &m_pendingCalendarFetch,        "CALENDAR"},
-            {3, m_backends.googleTimeline.get(),  &m_pendingGoogleTimelineFetch, "GTIMELINE"},
-        };
-
-        for (auto& tf : typeFetches) {
-            if (!tf.backend) continue;
+        for (auto& tf : layerFetches()) {
+            if (tf.layerIndex == 0 || (m_viewportFetch && isViewportLayer(tf.layerIndex))) continue;
             int li = tf.layerIndex;
             Backend* be = tf.backend;
             const char* tag = tf.tag;
             model.layers[li].startFetch();
+            model.layers[li].entities.indexIds();
             *tf.future = std::async(std::launch::async, [this, &model, be, li, tag]() {
                 std::cerr << "[" << tag << "] fetch started\n";
-                be->streamAllByType(
+                be->streamColumnsByType(
                     0.0, 2000000000.0,
-                    [this, li, tag](std::vector<Entity>&& batch) {
+                    [this, li, tag](EntityColumns&& batch) {
                         std::cerr << "[" << tag << "] batch size=" << batch.size() << "\n";
-                        auto t = Clock::now();
-                        std::lock_guard<std::mutex> lock(m_batchMutex);
-                        long lockMs = ms_since(t);
-                        if (lockMs > 5)
-                            std::cerr << "[" << tag << "] waited " << lockMs << "ms for batchMutex\n";
-                        m_completedBatches.push_back({li, std::move(batch)});
+                        enqueue({li, std::move(batch)}, tag);
                     });
                 std::cerr << "[" << tag << "] fetch complete\n";
                 model.layers[li].endFetch();
+                if (be->lastStreamComplete()) be->refresh(queueUpdates(li, tag));
             });
         }
-    } else {
+    } else if (!m_viewportFetch) {
         model.layers[0].startFetch();
         TimeExtent fullTime = model.time_extent;
         SpatialExtent fullSpace;
@@ -118,8 +198,7 @@ void FetchOrchestrator::startFullLoad(AppModel& model)
         m_pendingGpsFetch = std::async(std::launch::async, [this, &model, fullTime, fullSpace]() {
             m_backends.gps->fetchEntities(fullTime, fullSpace,
                 [this](std::vector<Entity>&& batch) {
-                    std::lock_guard<std::mutex> lock(m_batchMutex);
-                    m_completedBatches.push_back({0, std::move(batch)});
+                    enqueue({0, EntityColumns::fromEntities(batch)}, "GPS");
                 });
             model.layers[0].endFetch();
             model.initial_load_complete.store(true);
@@ -127,33 +206,308 @@ void FetchOrchestrator::startFullLoad(AppModel& model)
     }
 }
 
+std::vector<FetchOrchestrator::LayerFetch> FetchOrchestrator::layerFetches()
+{
+    LayerFetch all[] = {
+        {0, m_backends.gps.get(),            &m_pendingGpsFetch,            "GPS"},
+        {1, m_backends.photo.get(),          &m_pendingPhotoFetch,          "PHOTO"},
+        {2, m_backends.calendar.get(),       &m_pendingCalendarFetch,       "CALENDAR"},
+        {3, m_backends.googleTimeline.get(), &m_pendingGoogleTimelineFetch, "GTIMELINE"},
+    };
+    std::vector<LayerFetch> present;
+    for (const auto& lf : all)
+        if (lf.backend) present.push_back(lf);
+    return present;
+}
+
+Backend::RangeUpdate FetchOrchestrator::queueUpdates(int layerIndex, const char* tag)
+{
+    return [this, layerIndex, tag](std::vector<TimeExtent>&& ranges, std::vector<Entity>&& entities) {
+        std::cerr << "[" << tag << "] sync replaces " << ranges.size() << " ranges with "
+                  << entities.size() << " entities\n";
+        enqueue({layerIndex, EntityColumns::fromEntities(entities), std::move(ranges)}, tag);
+    };
+}
+
+bool FetchOrchestrator::startSync()
+{
+    bool started = false;
+    for (auto& lf : layerFetches()) {
+        // A layer still loading refreshes by itself when the load completes
+        if (lf.future->valid() &&
+            lf.future->wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+            continue;
+        // A viewport-mode layer holds only what was on screen; a refresh
+        // would splice whole time ranges into it
+        if (m_viewportFetch && isViewportLayer(lf.layerIndex)) continue;
+
+        Backend* be = lf.backend;
+        int li = lf.layerIndex;
+        const char* tag = lf.tag;
+        *lf.future = std::async(std::launch::async, [this, be, li, tag]() {
+            std::cerr << "[" << tag << "] sync started\n";
+            be->refresh(queueUpdates(li, tag));
+        });
+        started = true;
+    }
+    return started;
+}
+
 bool FetchOrchestrator::drainCompletedBatches(AppModel& model)
 {
-    std::deque<PendingBatch> batches;
-    {
-        std::lock_guard<std::mutex> lock(m_batchMutex);
-        batches.swap(m_completedBatches);
+    // What is queued now; batches pushed meanwhile wait for the next frame,
+    // as do those left over once the budget is spent
+    auto t0 = std::chrono::steady_clock::now();
+    auto budget = std::chrono::duration<double>(m_drainBudget);
+    auto spent = [&] {
+        return m_drainBudget > 0.0 && std::chrono::steady_clock::now() - t0 >= budget;
+    };
+    std::array<uint64_t, 4> revisions{};
+    for (size_t li = 0; li < revisions.size() && li < model.layers.size(); ++li)
+        revisions[li] = model.layers[li].revision;
+    bool swapped = swapMerged(model);
+    size_t drained = 0;
+
+    // Batches held back while their layer was merged go first, in order
+    for (auto& m : m_merges) {
+        for (; !m.merged.valid() && !m.held.empty(); ++drained) {
+            if (drained > 0 && spent()) break;
+            applyBatch(model, std::move(m.held.front()));
+            m.held.pop_front();
+        }
     }
 
-    for (auto& pb : batches) {
+    size_t available = m_completedBatches.size();
+    PendingBatch pb;
+    for (size_t popped = 0; popped < available; ++popped, ++drained) {
+        if (drained > 0 && spent()) break;
+        if (!m_completedBatches.tryPop(pb)) break;
+        if (pb.layerIndex >= 0 && pb.layerIndex < static_cast<int>(m_queuedPerLayer.size()))
+            --m_queuedPerLayer[pb.layerIndex];
         if (pb.layerIndex < 0 || pb.layerIndex >= static_cast<int>(model.layers.size())) continue;
-        auto& layerEntities = model.layers[pb.layerIndex].entities;
-        layerEntities.reserve(layerEntities.size() + pb.entities.size());
-        layerEntities.insert(layerEntities.end(),
-            std::make_move_iterator(pb.entities.begin()),
-            std::make_move_iterator(pb.entities.end()));
+        // A layer being merged is not edited: its batches wait for the swap
+        if (merging(pb.layerIndex)) {
+            m_merges[pb.layerIndex].held.push_back(std::move(pb));
+            continue;
+        }
+        applyBatch(model, std::move(pb));
+    }
+
+    bool merged = mergeUnsorted(model, t0, revisions);
+    bool swept = suppressDuplicates(model);
+    return drained > 0 || swapped || merged || swept;
+}
+
+void FetchOrchestrator::applyBatch(AppModel& model, PendingBatch&& pb)
+{
+    if (m_duplicateRule && pb.layerIndex == m_duplicateRule->dropLayer) dropDuplicates(model, pb.entities);
+    Layer& layer = model.layers[pb.layerIndex];
+    if (!pb.replaceRanges.empty()) {
+        replaceRanges(layer, pb.replaceRanges, std::move(pb.entities));
+        m_refreshed[pb.layerIndex] = true;
+        return;
+    }
+    if (pb.region && !acceptRegion(pb)) return;
+    // Once a layer has been refreshed, a batch that repeats rows (a
+    // re-streamed range) replaces them; until then batches are appended,
+    // indexed by id as they go if the layer loads in full
+    if (m_refreshed[pb.layerIndex]) {
+        if (layer.entities.upsert(pb.entities).updated > 0) ++layer.revision;
+    } else {
+        layer.entities.append(pb.entities);
+    }
+}
+
+bool FetchOrchestrator::layerBusy(int layerIndex)
+{
+    if (m_queuedPerLayer[layerIndex].load() > 0 || merging(layerIndex)) return true;
+    for (auto& lf : layerFetches())
+        if (lf.layerIndex == layerIndex)
+            return lf.future->valid() &&
+                   lf.future->wait_for(std::chrono::seconds(0)) != std::future_status::ready;
+    return false;
+}
+
+void FetchOrchestrator::dropDuplicates(const AppModel& model, EntityColumns& batch)
+{
+    const DuplicateRule& rule = *m_duplicateRule;
+    const Layer& keep = model.layers[rule.keepLayer];
+    if (m_sweptKeep != std::make_pair(keep.entities.size(), keep.revision)) {
+        m_sweepPending = true;
+        return;
+    }
+    batch.filter([&](size_t i) { return !rule.duplicates(keep.entities, batch, i); });
+}
+
+bool FetchOrchestrator::suppressDuplicates(AppModel& model)
+{
+    if (!m_duplicateRule) return false;
+    const DuplicateRule& rule = *m_duplicateRule;
+    const Layer& keep = model.layers[rule.keepLayer];
+    auto seen = std::make_pair(keep.entities.size(), keep.revision);
+    if ((seen == m_sweptKeep && !m_sweepPending) || layerBusy(rule.keepLayer)) return false;
+    if (merging(rule.dropLayer)) return false;  // swept once it is swapped in
+
+    m_sweptKeep = seen;
+    m_sweepPending = false;
+    Layer& drop = model.layers[rule.dropLayer];
+    size_t before = drop.entities.size();
+    drop.entities.filter([&](const EntityColumns& c, size_t row) {
+        return !rule.duplicates(keep.entities, c, row);
+    });
+    if (drop.entities.size() == before) return false;
+    ++drop.revision;
+    std::cerr << "[DEDUPE] layer " << rule.dropLayer << ": dropped " << before - drop.entities.size()
+              << " rows duplicating layer " << rule.keepLayer << "\n";
+    return true;
+}
+
+bool FetchOrchestrator::mergeUnsorted(AppModel& model, std::chrono::steady_clock::time_point started,
+                                      const std::array<uint64_t, 4>& revisions)
+{
+    auto budget = std::chrono::duration<double>(m_drainBudget);
+    bool merged = false;
+    for (auto& lf : layerFetches()) {
+        int li = lf.layerIndex;
+        if (li >= static_cast<int>(model.layers.size())) continue;
+        Layer& layer = model.layers[li];
+        size_t unsorted = layer.entities.size() - layer.entities.sortedCount();
+        if (unsorted == 0 || merging(li)) continue;
+
+        // A tail this large is merged now, or rows would be copied again and
+        // again; a smaller one of an idle layer waits for a frame with budget
+        if (unsorted * kMergeFraction < layer.entities.sortedCount()) {
+            if (layerBusy(li)) continue;
+            if (m_drainBudget > 0.0 && std::chrono::steady_clock::now() - started >= budget) continue;
+        }
+        if (layer.entities.size() >= m_backgroundMergeRows) {
+            // Nothing edits the layer until swapMerged replaces it
+            const EntityStore* store = &layer.entities;
+            m_merges[li].merged = std::async(std::launch::async, [store] { return store->mergedByTime(); });
+            continue;
+        }
+        layer.entities.mergeByTime();
+        // A layer this drain already edited is caught up on once for both
+        if (layer.revision == revisions[li]) ++layer.revision;
+        merged = true;
+    }
+    return merged;
+}
+
+bool FetchOrchestrator::swapMerged(AppModel& model)
+{
+    bool swapped = false;
+    for (size_t li = 0; li < m_merges.size() && li < model.layers.size(); ++li) {
+        std::future<EntityStore>& merged = m_merges[li].merged;
+        if (!merged.valid() || merged.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+            continue;
+        Layer& layer = model.layers[li];
+        layer.entities = merged.get();
+        ++layer.revision;
+        swapped = true;
+    }
+    return swapped;
+}
+
+bool FetchOrchestrator::acceptRegion(const PendingBatch& batch)
+{
+    ViewportLayer& vl = m_viewport[batch.layerIndex];
+    const CoverageMap::Request& region = *batch.region;
+    switch (batch.status) {
+    case RegionStatus::Failed:
+        // Left uncovered: planned again once the backoff expires
+        vl.retryDelay = vl.retryDelay > 0.0 ? std::min(vl.retryDelay * 2.0, kMaxRetrySec) : kFirstRetrySec;
+        vl.retryAt = Clock::now() + std::chrono::duration_cast<Clock::duration>(
+                                        std::chrono::duration<double>(vl.retryDelay));
+        return false;
+    case RegionStatus::Truncated:
+        if (region.level < vl.coverage.config().maxLevel) {
+            // Refetched as the cells' children, each with its own limit
+            vl.coverage.markDense(region);
+            return false;
+        }
+        std::cerr << "[VIEWPORT] layer " << batch.layerIndex << ": region truncated at the finest level, "
+                  << batch.entities.size() << " entities kept\n";
+        break;
+    case RegionStatus::Complete:
+        break;
     }
+    vl.retryDelay = 0.0;
+    vl.coverage.markCovered(region);
+    return true;
+}
+
+bool FetchOrchestrator::updateViewport(AppModel& model)
+{
+    if (!m_viewportFetch) return false;
+
+    bool edited = false;
+    for (auto& lf : layerFetches()) {
+        int li = lf.layerIndex;
+        if (!isViewportLayer(li) || li >= static_cast<int>(model.layers.size())) continue;
+        if (lf.future->valid() &&
+            lf.future->wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+            continue;
+        // Regions not drained yet are not in the coverage; wait for them
+        if (m_queuedPerLayer[li].load() > 0 || merging(li)) continue;
+        ViewportLayer& vl = m_viewport[li];
+        if (Clock::now() < vl.retryAt) continue;
+
+        Layer& layer = model.layers[li];
+        if (layer.entities.size() > m_viewportBudget) {
+            CoverageMap::Request keep = vl.coverage.retain(model.spatial_extent, model.time_extent);
+            size_t before = layer.entities.size();
+            layer.entities.filter([&keep](const EntityColumns& c, size_t row) {
+                return c.hasLocation(row) && keep.owns(c.lat[row], c.lon[row], c.time_start[row]);
+            });
+            ++layer.revision;
+            edited = true;
+            std::cerr << "[" << lf.tag << "] viewport evicted " << before - layer.entities.size() << " of "
+                      << before << " entities\n";
+        }
+
+        std::vector<CoverageMap::Request> regions = vl.coverage.plan(model.spatial_extent, model.time_extent);
+        if (regions.empty()) continue;
+        if (regions.size() > kRegionsPerRound) regions.resize(kRegionsPerRound);
 
-    return !batches.empty();
+        Backend* be = lf.backend;
+        const char* tag = lf.tag;
+        m_viewportCancelled.store(false);
+        layer.startFetch();
+        *lf.future = std::async(std::launch::async, [this, &model, be, li, tag, regions = std::move(regions)]() {
+            for (const auto& region : regions) {
+                if (m_viewportCancelled.load()) break;
+                EntityColumns owned;
+                RegionStatus status = be->fetchRegion(region.time, region.space,
+                    [&region, &owned](std::vector<Entity>&& batch) {
+                        // bbox bounds are inclusive; keep only what the region owns,
+                        // so neighbouring regions never deliver an entity twice
+                        for (const auto& e : batch)
+                            if (e.has_location() && region.owns(*e.lat, *e.lon, e.time_start))
+                                owned.push_back(e);
+                    });
+                if (m_viewportCancelled.load()) break;
+                enqueue({li, std::move(owned), {}, region, status}, tag);
+            }
+            model.layers[li].endFetch();
+        });
+    }
+    return edited;
 }
 
 void FetchOrchestrator::cancelAndWaitAll()
 {
+    m_viewportCancelled.store(true);
+    m_queueCancelled.store(true);
     m_backends.cancelAll();
     if (m_pendingGpsFetch.valid())             m_pendingGpsFetch.wait();
     if (m_pendingPhotoFetch.valid())           m_pendingPhotoFetch.wait();
     if (m_pendingCalendarFetch.valid())        m_pendingCalendarFetch.wait();
     if (m_pendingGoogleTimelineFetch.valid())  m_pendingGoogleTimelineFetch.wait();
+    // Merges run to the end; the next drain swaps them in
+    for (auto& m : m_merges)
+        if (m.merged.valid()) m.merged.wait();
+    m_queueCancelled.store(false);
 }
 
 std::pair<ServerStats, bool> FetchOrchestrator::fetchServerStats()
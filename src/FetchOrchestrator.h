@@ -2,16 +2,32 @@
 
 #include "BackendFactory.h"
 #include "AppModel.h"
-#include <future>
-#include <mutex>
+#include "CoverageMap.h"
+#include "core/DuplicateRule.h"
+#include "core/MpscRing.h"
+#include <array>
+#include <atomic>
+#include <chrono>
 #include <deque>
+#include <future>
+#include <optional>
+#include <utility>
 #include <vector>
 
 /// Owns backends and async fetch lifecycle.
-/// Thread-safe batch queue delivers entities from background threads to main thread.
+/// A bounded lock-free queue (MpscRing) delivers entity batches from the
+/// layer threads to the main thread.  When it is full, producers wait, so a
+/// main thread that falls behind slows the transfers down instead of letting
+/// batches pile up in memory.
 class FetchOrchestrator {
 public:
-    FetchOrchestrator() = default;
+    /// Batches queued at most by default: at the export's batch sizes, a
+    /// few hundred MB of entities.
+    static constexpr size_t kDefaultQueueCapacity = 64;
+
+    using QueueStats = MpscRingStats;
+
+    explicit FetchOrchestrator(size_t queueCapacity = kDefaultQueueCapacity);
     ~FetchOrchestrator();
 
     /// Replace backends and discard any stale queued batches.
@@ -20,16 +36,164 @@ public:
 
     const BackendSet& backends() const { return m_backends; }
 
+    /// Load every layer from scratch.  Once a layer's load completes, its
+    /// backend's refresh() runs on the same worker (cache sync), and any
+    /// change it reports is queued as an in-place edit of the layer.
+    /// A refresh is merged by id (EntityStore::upsert): rows it repeats
+    /// unchanged cost a lookup, and the layer is only edited where it differs.
     void startFullLoad(AppModel& model);
+
+    /// Run refresh() on every backend that is not busy loading, without
+    /// clearing the layers.  Returns false if none could start.
+    bool startSync();
+
+    /// Drain budget by default: a quarter of a 60 fps frame.
+    static constexpr double kDefaultDrainBudget = 0.004;
+
+    /// Apply queued batches to their layers: appends, or in-place edits from
+    /// a refresh (which bump Layer::revision).  Stops once the drain budget
+    /// is spent (after at least one batch); the rest stay queued for the
+    /// next frame.  Entities that arrived out of time order are then merged
+    /// in (see mergeUnsorted; a finished background merge is swapped in
+    /// first), and duplicates dropped if a DuplicateRule is set.  Main
+    /// thread only.
     bool drainCompletedBatches(AppModel& model);
+
+    /// Seconds drainCompletedBatches may spend per call; <= 0 drains
+    /// everything queued.
+    void setDrainBudget(double seconds) { m_drainBudget = seconds; }
+    double drainBudget() const { return m_drainBudget; }
+
+    /// Layers from this many rows up are merged into time order on a
+    /// worker (EntityStore::mergedByTime), not in the drain, as a merge
+    /// rewrites the whole layer.
+    static constexpr size_t kBackgroundMergeRows = 4 * EntityStore::kSegmentSize;
+    void setBackgroundMergeRows(size_t rows) { m_backgroundMergeRows = rows; }
+
+    /// Layer `layerIndex` is being merged on a worker, or batches that
+    /// arrived meanwhile are not applied yet.  Its entities are not edited
+    /// until then.
+    bool merging(int layerIndex) const;
+
+    /// Viewport mode: the location layers (GPS, photos, Google Timeline) load
+    /// only what is on screen, on demand, instead of everything up front.
+    /// Takes effect at the next startFullLoad.
+    void setViewportFetch(bool enabled) { m_viewportFetch = enabled; }
+    bool viewportFetch() const { return m_viewportFetch; }
+
+    /// Entities a viewport-mode layer holds before what is off screen is evicted.
+    void setViewportBudget(size_t entities) { m_viewportBudget = entities; }
+
+    /// Viewport mode: for each idle location layer, fetch the part of the
+    /// map extent x timeline window its CoverageMap does not cover yet,
+    /// evicting off-screen entities first if the layer is over budget.
+    /// Main thread, once per frame after drainCompletedBatches.  Returns
+    /// true if a layer was edited in place (eviction bumps Layer::revision).
+    bool updateViewport(AppModel& model);
+
+    /// What a viewport-mode layer has loaded.
+    const CoverageMap& coverage(int layerIndex) const { return m_viewport.at(layerIndex).coverage; }
+
+    /// Drop the rule's drop-layer rows that duplicate a keep-layer fix, as
+    /// they are drained and again whenever the keep layer changes; nullopt
+    /// (the default) keeps every row.  Takes effect at the next startFullLoad.
+    void setDuplicateRule(std::optional<DuplicateRule> rule) { m_duplicateRule = rule; }
+    const std::optional<DuplicateRule>& duplicateRule() const { return m_duplicateRule; }
+
+    /// Cancel every fetch and wait for the workers.  Producers waiting on a
+    /// full queue give up, dropping their batch.
     void cancelAndWaitAll();
     std::pair<ServerStats, bool> fetchServerStats();
 
+    /// Depth, high-water mark and producer stall time of the batch queue.
+    QueueStats queueStats() const;
+
 private:
     struct PendingBatch {
+        int layerIndex = -1;
+        EntityColumns entities;
+        /// Non-empty for a refresh: the entities are merged in by id, and the
+        /// layer's rows with time_start in these ranges (half-open,
+        /// ascending) that they do not list are dropped
+        std::vector<TimeExtent> replaceRanges{};
+        /// Set for a viewport fetch: the region the entities were fetched for
+        std::optional<CoverageMap::Request> region{};
+        RegionStatus status{RegionStatus::Complete};
+    };
+
+    /// Region requests one viewport fetch round issues at most.
+    static constexpr size_t kRegionsPerRound = 8;
+
+    struct ViewportLayer {
+        CoverageMap coverage;
+        std::chrono::steady_clock::time_point retryAt{};  ///< after a failed region
+        double retryDelay = 0.0;                          ///< seconds, doubles per failure
+    };
+
+    static bool isViewportLayer(int layerIndex) { return layerIndex != 2; }
+
+    /// Record a viewport batch's region.  False if its entities are dropped.
+    bool acceptRegion(const PendingBatch& batch);
+
+    /// Queue a batch for the main thread, waiting while the queue is full.
+    /// Returns false if the batch was dropped because of a cancel.
+    bool enqueue(PendingBatch&& batch, const char* tag);
+
+    /// Drop everything queued, waiting for and dropping any background
+    /// merge with the batches held for it.  Main thread (the consumer) only.
+    void discardQueued();
+
+    /// Apply one drained batch to its layer.
+    void applyBatch(AppModel& model, PendingBatch&& batch);
+
+    /// Merge each layer's unsorted tail (EntityStore::sortedCount) into its
+    /// time order: at once if the tail has grown to 1/4 of the sorted rows,
+    /// else once the layer has loaded, nothing of it is queued, and the
+    /// drain that began at `started` left budget over.  The growth rule
+    /// bounds how often a row is copied while loading, and the idle merge
+    /// comes once per fetch round, as the tail is then empty.  A layer of
+    /// kBackgroundMergeRows or more is merged on a worker and swapped in
+    /// by a later drain (swapMerged), which bumps Layer::revision.  A
+    /// smaller one is merged here, bumping it unless the drain already has
+    /// since it read `revisions` (one per layer).
+    bool mergeUnsorted(AppModel& model, std::chrono::steady_clock::time_point started,
+                       const std::array<uint64_t, 4>& revisions);
+
+    /// Replace each layer whose background merge has finished with the
+    /// merged copy.
+    bool swapMerged(AppModel& model);
+
+    /// Batches of layer `layerIndex` are queued, or its worker is running.
+    bool layerBusy(int layerIndex);
+
+    /// Drop the rows of a drop-layer batch that the duplicate rule matches,
+    /// if the keep layer is as the last sweep saw it; otherwise leave them
+    /// for the next sweep.
+    void dropDuplicates(const AppModel& model, EntityColumns& batch);
+
+    /// Once the keep layer is idle: if it changed since the last sweep, or
+    /// drop-layer rows went in unchecked, filter the whole drop layer
+    /// (bumping its revision if a row goes).
+    bool suppressDuplicates(AppModel& model);
+
+    /// A layer's background merge, and the batches drained for the layer
+    /// while it runs, applied in order once it is swapped in.
+    struct LayerMerge {
+        std::future<EntityStore> merged;
+        std::deque<PendingBatch> held;
+    };
+
+    /// Queues a backend's refresh() changes for layer `layerIndex`.
+    Backend::RangeUpdate queueUpdates(int layerIndex, const char* tag);
+
+    /// One backend per layer, with the future its fetches run on.
+    struct LayerFetch {
         int layerIndex;
-        std::vector<Entity> entities;
+        Backend* backend;
+        std::future<void>* future;
+        const char* tag;
     };
+    std::vector<LayerFetch> layerFetches();
 
     BackendConfig::Type m_backendType{BackendConfig::Type::Http};
     BackendSet m_backends;
@@ -38,6 +202,21 @@ private:
     std::future<void> m_pendingCalendarFetch;
     std::future<void> m_pendingGoogleTimelineFetch;
 
-    std::mutex m_batchMutex;
-    std::deque<PendingBatch> m_completedBatches;
+    MpscRing<PendingBatch> m_completedBatches;
+    std::array<std::atomic<size_t>, 4> m_queuedPerLayer{};  ///< batches queued, not yet drained
+    std::atomic<bool> m_queueCancelled{false};
+    std::array<bool, 4> m_refreshed{};  ///< a refresh was applied since the last startFullLoad
+
+    double m_drainBudget{kDefaultDrainBudget};
+    size_t m_backgroundMergeRows{kBackgroundMergeRows};
+    std::array<LayerMerge, 4> m_merges;
+
+    std::optional<DuplicateRule> m_duplicateRule;
+    std::pair<size_t, uint64_t> m_sweptKeep{SIZE_MAX, 0};  ///< keep layer (size, revision) at the last sweep
+    bool m_sweepPending{false};                            ///< drop-layer rows went in unchecked
+
+    bool m_viewportFetch{false};
+    size_t m_viewportBudget{2000000};
+    std::array<ViewportLayer, 4> m_viewport;
+    std::atomic<bool> m_viewportCancelled{false};
 };
@@ -18,12 +18,23 @@ HttpBackend::HttpBackend(const std::string& base_url, const std::string& entity_
     }
 
     m_api = std::make_unique<BackendAPI>(base_url, api_key);
+    configureExportRetry();
 }
 
 HttpBackend::HttpBackend(const std::string& base_url, const std::string& api_key, const std::string& entity_type)
     : m_api(std::make_unique<BackendAPI>(base_url, api_key))
     , m_entityType(entity_type)
 {
+    configureExportRetry();
+}
+
+void HttpBackend::configureExportRetry()
+{
+    // A dropped export resumes from its checkpoint; cancelFetch() also ends
+    // any backoff in progress
+    BackendAPI::ExportRetry retry;
+    retry.cancelled = [this] { return m_cancelled.load(); };
+    m_api->set_export_retry(std::move(retry));
 }
 
 void HttpBackend::fetchEntities(
@@ -40,21 +51,47 @@ void HttpBackend::fetchEntities(
     }
 }
 
+RegionStatus HttpBackend::fetchRegion(
+    const TimeExtent& time,
+    const SpatialExtent& space,
+    std::function<void(std::vector<Entity>&&)> callback
+) {
+    try {
+        std::vector<Entity> entities = m_api->fetch_region(m_entityType, time, space, m_regionLimit);
+        bool truncated = entities.size() >= static_cast<size_t>(m_regionLimit);
+        callback(std::move(entities));
+        return truncated ? RegionStatus::Truncated : RegionStatus::Complete;
+    } catch (const std::exception& e) {
+        std::cerr << "HttpBackend: region fetch failed: " << e.what() << std::endl;
+        return RegionStatus::Failed;
+    }
+}
+
 void HttpBackend::streamAllByType(
     double startTime,
     double endTime,
     std::function<void(std::vector<Entity>&&)> batch_callback
 ) {
-    static constexpr int LIMIT = 100000;
+    m_cancelled.store(false);
+    m_lastStreamComplete.store(false);
+
+    size_t count = 0;
     try {
-        TimeExtent time{startTime, endTime};
-        auto entities = m_api->fetch_time(m_entityType, time, LIMIT, "t_start_asc");
-        std::cerr << "HttpBackend: streamAllByType got " << entities.size()
+        // One batch per page, oldest first; the first page reaches the layer
+        // while the rest are still in flight
+        m_api->stream_time_pages(m_entityType, TimeExtent{startTime, endTime},
+            [&](std::vector<Entity>&& page) -> bool {
+                if (m_cancelled.load()) return false;
+                count += page.size();
+                batch_callback(std::move(page));
+                return true;
+            });
+        std::cerr << "HttpBackend: streamAllByType got " << count
                   << " entities of type '" << m_entityType << "'" << std::endl;
-        if (!entities.empty())
-            batch_callback(std::move(entities));
+        m_lastStreamComplete.store(!m_cancelled.load());
     } catch (const std::exception& e) {
-        std::cerr << "HttpBackend: streamAllByType failed: " << e.what() << std::endl;
+        std::cerr << "HttpBackend: streamAllByType failed after " << count
+                  << " entities: " << e.what() << std::endl;
     }
 }
 
@@ -62,33 +99,66 @@ void HttpBackend::streamAllEntities(
     std::function<void(size_t)> on_total,
     std::function<void(std::vector<Entity>&&)> batch_callback
 ) {
-    static constexpr size_t BATCH_SIZE = 5000;
+    streamAllColumns(std::move(on_total), [&batch_callback](EntityColumns&& batch) {
+        batch_callback(batch.toEntities());
+    });
+}
 
+void HttpBackend::streamAllColumns(
+    std::function<void(size_t)> on_total,
+    std::function<void(EntityColumns&&)> batch_callback
+) {
     m_cancelled.store(false);
-
-    std::vector<Entity> batch;
-    batch.reserve(BATCH_SIZE);
+    m_lastStreamComplete.store(false);
 
     try {
-        m_api->fetch_export(
-            std::move(on_total),
-            [&](Entity&& entity) -> bool {
-                if (m_cancelled.load()) return false;
-
-                batch.push_back(std::move(entity));
-                if (batch.size() >= BATCH_SIZE) {
-                    batch_callback(std::move(batch));
-                    batch.clear();
-                    batch.reserve(BATCH_SIZE);
-                }
-                return true;
-            }
-        );
+        // Batches arrive slab-sized (~1 MB of NDJSON each) and in stream order
+        auto forward = [&](EntityColumns&& batch) -> bool {
+            if (m_cancelled.load()) return false;
+            batch_callback(std::move(batch));
+            return true;
+        };
+        if (m_exportShards > 1) {
+            // Sharded batches are reassembled into time order before delivery
+            m_api->fetch_export_sharded_columns(m_api->fetch_stats(), m_exportShards,
+                                                std::move(on_total), forward);
+        } else {
+            m_api->fetch_export_columns(std::move(on_total), forward);
+        }
+        m_lastStreamComplete.store(!m_cancelled.load());
     } catch (const std::exception& e) {
         std::cerr << "HttpBackend: Stream failed: " << e.what() << std::endl;
     }
+}
+
+std::optional<std::vector<BucketSummary>> HttpBackend::fetchBucketSummaries(int bucketSeconds)
+{
+    try {
+        return m_api->fetch_bucket_hashes(m_entityType, bucketSeconds);
+    } catch (const std::exception& e) {
+        std::cerr << "HttpBackend: bucket hashes for '" << m_entityType << "' unavailable: "
+                  << e.what() << std::endl;
+        return std::nullopt;
+    }
+}
 
-    if (!batch.empty()) {
-        batch_callback(std::move(batch));
+bool HttpBackend::streamBuckets(
+    const std::vector<TimeExtent>& ranges,
+    std::function<void(std::vector<Entity>&&)> batch_callback
+) {
+    m_cancelled.store(false);
+    size_t count = 0;
+    try {
+        m_api->stream_bucket_data(m_entityType, ranges, [&](std::vector<Entity>&& batch) -> bool {
+            if (m_cancelled.load()) return false;
+            count += batch.size();
+            batch_callback(std::move(batch));
+            return true;
+        });
+        return !m_cancelled.load();
+    } catch (const std::exception& e) {
+        std::cerr << "HttpBackend: bucket data failed after " << count << " entities: "
+                  << e.what() << std::endl;
+        return false;
     }
 }
@@ -2,6 +2,7 @@
 
 #include "Backend.h"
 #include "http/BackendAPI.h"
+#include <algorithm>
 #include <memory>
 #include <atomic>
 #include <functional>
@@ -22,11 +23,28 @@ public:
         std::function<void(std::vector<Entity>&&)> callback
     ) override;
 
+    /// One bbox query of at most regionLimit() rows (oldest first);
+    /// Truncated when the limit is reached.
+    RegionStatus fetchRegion(
+        const TimeExtent& time,
+        const SpatialExtent& space,
+        std::function<void(std::vector<Entity>&&)> callback
+    ) override;
+
+    void setRegionLimit(int limit) { m_regionLimit = std::clamp(limit, 1, BackendAPI::kBboxMaxLimit); }
+    int regionLimit() const { return m_regionLimit; }
+
     void streamAllEntities(
         std::function<void(size_t total)> on_total,
         std::function<void(std::vector<Entity>&&)> batch_callback
     ) override;
 
+    /// The export, decoded into columns (the entity stream converts them).
+    void streamAllColumns(
+        std::function<void(size_t total)> on_total,
+        std::function<void(EntityColumns&&)> batch_callback
+    ) override;
+
     void streamAllByType(
         double startTime,
         double endTime,
@@ -35,19 +53,42 @@ public:
 
     void cancelFetch() override { m_cancelled.store(true); }
 
+    bool lastStreamComplete() const override { return m_lastStreamComplete.load(); }
+
+    /// Number of concurrent time shards streamAllEntities splits the export
+    /// into (1 = one stream).  Needs the server's time coverage from /stats.
+    void setExportShards(int shards) { m_exportShards = shards < 1 ? 1 : shards; }
+    int exportShards() const { return m_exportShards; }
+
     std::vector<uint8_t> fetchPhotoThumb(const std::string& entityId) override {
         return m_api->fetch_photo_thumb(entityId);
     }
 
+    std::future<std::vector<uint8_t>> fetchPhotoThumbAsync(const std::string& entityId) override {
+        return m_api->fetch_photo_thumb_async(entityId);
+    }
+
     ServerStats fetchStats() override { return m_api->fetch_stats(); }
 
+    std::optional<std::vector<BucketSummary>> fetchBucketSummaries(int bucketSeconds) override;
+
+    bool streamBuckets(
+        const std::vector<TimeExtent>& ranges,
+        std::function<void(std::vector<Entity>&&)> batch_callback
+    ) override;
+
     const std::string& entityType() const override { return m_entityType; }
 
     /// The configured API key (for building URLs externally if needed).
     const std::string& apiKey() const { return m_api->apiKey(); }
 
 private:
+    void configureExportRetry();
+
     std::unique_ptr<BackendAPI> m_api;
     std::string m_entityType;
     std::atomic<bool> m_cancelled{false};
+    std::atomic<bool> m_lastStreamComplete{false};
+    int m_exportShards{1};
+    int m_regionLimit{BackendAPI::kBboxMaxLimit};
 };
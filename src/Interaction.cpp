@@ -1,13 +1,15 @@
 #include "Interaction.h"
 #include "AppModel.h"
+#include "BackendFactory.h"
 #include "core/PickingLogic.h"
+#include "renderer/TextureUploader.h"
 #include <imgui.h>
+#include <algorithm>
 #include <ctime>
 #include <cmath>
 #include <cstdio>
 #include <limits>
 #include <iostream>
-#include <thread>
 #include <chrono>
 
 #define GL_GLEXT_PROTOTYPES
@@ -20,15 +22,52 @@
 
 #include <stb_image.h>  // implementation compiled in RasterTileCache.cpp
 
+// Runs on the thumbnail cache's worker threads
+static bool decodeThumbnail(const std::vector<uint8_t>& encoded, Thumbnail& out)
+{
+    int w = 0, h = 0, channels = 0;
+    unsigned char* pixels = stbi_load_from_memory(
+        encoded.data(), static_cast<int>(encoded.size()),
+        &w, &h, &channels, 4);  // force RGBA
+    if (!pixels) return false;
+
+    out.width  = w;
+    out.height = h;
+    out.rgba.assign(pixels, pixels + static_cast<size_t>(w) * h * 4);
+    stbi_image_free(pixels);
+    return true;
+}
+
+static ThumbnailCache::Config thumbnailConfig()
+{
+    ThumbnailCache::Config config;
+    config.diskDir = defaultCacheDir() + "/thumbs";
+    config.maxWidth = 1024;  // until the details panel reports its width
+    return config;
+}
+
+InteractionController::InteractionController()
+    : m_thumbnails(decodeThumbnail, thumbnailConfig())
+    , m_uploader(std::make_unique<TextureUploader>())
+{
+}
+
+InteractionController::~InteractionController() = default;
+
 // ---- Spatial index management ----
 
 void InteractionController::resetPickers()
 {
     for (auto& count : m_lastEntityCounts)
         count = std::numeric_limits<size_t>::max();
+    for (size_t li = 0; li < m_shadowPickers.size(); ++li) {
+        m_shadowPickers[li] = EntityPicker{};
+        m_shadowRevisions[li] = kNoShadow;
+    }
     m_hoveredMap      = {};
     m_hoveredTimeline = {};
     m_selected        = {};
+    m_prefetchAnchor  = {};
     m_pickersDirty    = true;
     clearPhotoTexture();  // selection cleared; drop stale texture from previous session
 }
@@ -38,6 +77,9 @@ void InteractionController::ensurePickers(size_t count)
     while (m_pickers.size() < count) {
         m_pickers.emplace_back();
         m_lastEntityCounts.push_back(std::numeric_limits<size_t>::max());
+        m_lastRevisions.push_back(0);
+        m_shadowPickers.emplace_back();
+        m_shadowRevisions.push_back(kNoShadow);
     }
 }
 
@@ -47,24 +89,62 @@ void InteractionController::update(const AppModel& model)
 
     ensurePickers(model.layers.size());
 
+    // Edits are indexed again into a shadow picker, appends into the live
+    // one, both up to the frame's budget
+    size_t budget = kPickerEntitiesPerFrame;
+    bool behind = false;
     for (size_t li = 0; li < model.layers.size(); ++li) {
         const auto& entities = model.layers[li].entities;
         size_t n    = entities.size();
         size_t last = m_lastEntityCounts[li];
+        uint64_t revision = model.layers[li].revision;
+
+        if (n < last || revision != m_lastRevisions[li]) {
+            // A hover into the edited layer may name another row now
+            if (m_hoveredMap.layerIndex == static_cast<int>(li)) m_hoveredMap = {};
+            if (m_hoveredTimeline.layerIndex == static_cast<int>(li)) m_hoveredTimeline = {};
+            EntityPicker& shadow = m_shadowPickers[li];
+            // Edited again while being indexed: start over
+            if (m_shadowRevisions[li] != revision || shadow.indexedCount() > n) {
+                shadow = EntityPicker{};
+                m_shadowRevisions[li] = revision;
+            }
+            size_t from = shadow.indexedCount();
+            size_t count = std::min(n - from, budget);
+            if (count > 0) shadow.addEntities(entities, from, from + count);
+            budget -= count;
+            if (from + count < n) {
+                behind = true;  // picks skip the layer meanwhile (pickerCurrent)
+                continue;
+            }
+            std::swap(m_pickers[li], shadow);
+            shadow = EntityPicker{};
+            m_shadowRevisions[li] = kNoShadow;
+            last = n;
+        } else if (n > last) {
+            size_t count = std::min(n - last, budget);
+            if (count > 0) m_pickers[li].addEntities(entities, last, last + count);
+            budget -= count;
+            last += count;
+        }
 
-        if (n < last)
-            m_pickers[li].rebuild(entities);
-        else if (n > last)
-            m_pickers[li].addEntities(entities, last);
-
-        m_lastEntityCounts[li] = n;
+        m_lastEntityCounts[li] = last;
+        m_lastRevisions[li] = revision;
+        behind = behind || last < n;
     }
 
-    m_pickersDirty = false;
+    m_pickersDirty = behind;
 }
 
 // ---- Pick helpers ----
 
+bool InteractionController::pickerCurrent(size_t li, const AppModel& model) const
+{
+    // Behind an edit, the live picker's indices may name other rows
+    const Layer& layer = model.layers[li];
+    return layer.revision == m_lastRevisions[li] && layer.entities.size() >= m_lastEntityCounts[li];
+}
+
 PickResult InteractionController::pickMap(const Camera& camera, Vec2 localPx, const AppModel& model) const
 {
     Vec2   worldPos = camera.screenToWorld(localPx);
@@ -73,7 +153,7 @@ PickResult InteractionController::pickMap(const Camera& camera, Vec2 localPx, co
     // Iterate in reverse so higher-indexed layers (higher render priority) win
     for (int li = static_cast<int>(m_pickers.size()) - 1; li >= 0; --li) {
         if (li >= static_cast<int>(model.layers.size())) continue;
-        if (!model.layers[li].visible) continue;
+        if (!model.layers[li].visible || !pickerCurrent(li, model)) continue;
         int idx = m_pickers[li].pickMap(worldPos.x, worldPos.y, radius);
         if (idx >= 0) return {li, idx};
     }
@@ -89,7 +169,7 @@ PickResult InteractionController::pickTimeline(const TimelineCamera& camera, flo
 
     for (int li = static_cast<int>(m_pickers.size()) - 1; li >= 0; --li) {
         if (li >= static_cast<int>(model.layers.size())) continue;
-        if (!model.layers[li].visible) continue;
+        if (!model.layers[li].visible || !pickerCurrent(li, model)) continue;
         // Subtract the layer's yOffset so the cursor maps into entity render_offset space
         float layerOffset = renderOffset - model.layers[li].yOffset;
         int idx = m_pickers[li].pickTimeline(time, layerOffset, timeRadius, yRadius);
@@ -117,8 +197,10 @@ void InteractionController::onMapHover(const Camera& camera, Vec2 localPx, const
 {
     m_state.panning = false;
     m_hoveredMap = pickMap(camera, localPx, model);
-    if (m_hoveredMap.valid())
+    if (m_hoveredMap.valid()) {
         drawEntityTooltip(m_hoveredMap, model);
+        prefetchAround(m_hoveredMap, model);
+    }
 }
 
 void InteractionController::onMapClick(const Camera& camera, Vec2 localPx, const AppModel& model)
@@ -158,8 +240,10 @@ void InteractionController::onTimelineScroll(TimelineCamera& camera, float yoffs
 void InteractionController::onTimelineHover(const TimelineCamera& camera, float localX, float localY, float panelHeight, const AppModel& model)
 {
     m_hoveredTimeline = pickTimeline(camera, localX, localY, panelHeight, model);
-    if (m_hoveredTimeline.valid())
+    if (m_hoveredTimeline.valid()) {
         drawEntityTooltip(m_hoveredTimeline, model);
+        prefetchAround(m_hoveredTimeline, model);
+    }
 }
 
 void InteractionController::onTimelineClick(const TimelineCamera& camera, float localX, float localY, float panelHeight, const AppModel& model)
@@ -189,6 +273,7 @@ void InteractionController::onTimelineUnhovered()
 void InteractionController::clearPhotoTexture()
 {
     if (m_photoTexture.texture != 0) {
+        m_uploader->cancel(m_photoTexture.texture);
         glDeleteTextures(1, &m_photoTexture.texture);
         m_photoTexture.texture = 0;
         m_photoTexture.texW    = 0;
@@ -200,19 +285,19 @@ void InteractionController::clearPhotoTexture()
 
 void InteractionController::waitForPhotoFetch()
 {
-    if (m_photoTexture.pendingFetch.valid())
-        m_photoTexture.pendingFetch.wait();
+    m_thumbnails.cancelAndWait();
 }
 
 void InteractionController::shutdown()
 {
     waitForPhotoFetch();
     clearPhotoTexture();
+    m_uploader->shutdown();
 }
 
 void InteractionController::maybeStartPhotoFetch(const AppModel& model)
 {
-    if (!m_selected.valid() || !m_photoFetcher) {
+    if (!m_selected.valid()) {
         clearPhotoTexture();
         return;
     }
@@ -223,55 +308,69 @@ void InteractionController::maybeStartPhotoFetch(const AppModel& model)
         return;
     }
 
-    const auto& e = layer.entities[m_selected.entityIndex];
+    const EntityRow e = layer.entities[m_selected.entityIndex];
     if (m_photoTexture.forEntityId == e.id)
         return;  // already loaded or loading for this entity
 
-    // Detach any still-running previous fetch (backend is still alive, safe to discard)
-    if (m_photoTexture.pendingFetch.valid()) {
-        std::thread([f = std::move(m_photoTexture.pendingFetch)]() mutable {
-            f.wait();
-        }).detach();
-    }
+    // A previous photo's load keeps running; its thumbnail stays cached
     clearPhotoTexture();
 
     m_photoTexture.forEntityId = e.id;
     m_photoTexture.loading     = true;
 
-    std::string eid     = e.id;
-    auto        fetcher = m_photoFetcher;  // capture by value so the lambda is self-contained
-    m_photoTexture.pendingFetch = std::async(std::launch::async,
-        [fetcher, eid]() -> std::vector<uint8_t> {
-            return fetcher(eid);
-        });
+    m_thumbnails.request(m_photoTexture.forEntityId);
+    prefetchAround(m_selected, model);
+}
+
+void InteractionController::prefetchAround(PickResult pick, const AppModel& model)
+{
+    if (!pick.valid() || pick == m_prefetchAnchor) return;
+    if (static_cast<size_t>(pick.layerIndex) >= m_pickers.size()) return;
+    const auto& layer = model.layers[pick.layerIndex];
+    if (layer.name != "photo" || !pickerCurrent(pick.layerIndex, model)) return;
+    m_prefetchAnchor = pick;
+
+    // The photo itself first (when hovered), then its neighbours in time
+    std::vector<std::string> ids;
+    ids.emplace_back(layer.entities[pick.entityIndex].id);
+    for (int idx : m_pickers[pick.layerIndex].nearestInTime(pick.entityIndex, kPrefetchNeighbors))
+        ids.emplace_back(layer.entities[idx].id);
+    m_thumbnails.prefetch(ids);
 }
 
 void InteractionController::drainPhotoTexture()
 {
-    if (!m_photoTexture.loading || !m_photoTexture.pendingFetch.valid())
-        return;
+    m_thumbnails.poll();
 
-    if (m_photoTexture.pendingFetch.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+    if (!m_photoTexture.loading)
         return;
 
-    std::vector<uint8_t> bytes = m_photoTexture.pendingFetch.get();
-    m_photoTexture.loading = false;
-
-    if (bytes.empty()) {
-        std::cerr << "[Photo] fetch returned empty bytes for " << m_photoTexture.forEntityId << "\n";
+    if (m_photoTexture.texture != 0) {  // uploading
+        m_uploader->process();
+        if (!m_uploader->pending(m_photoTexture.texture))
+            m_photoTexture.loading = false;
         return;
     }
 
-    int w = 0, h = 0, channels = 0;
-    unsigned char* pixels = stbi_load_from_memory(
-        bytes.data(), static_cast<int>(bytes.size()),
-        &w, &h, &channels, 4);  // force RGBA
-
-    if (!pixels) {
-        std::cerr << "[Photo] stbi_load failed: " << stbi_failure_reason() << "\n";
+    switch (m_thumbnails.state(m_photoTexture.forEntityId)) {
+    case ThumbnailCache::State::Ready:
+        break;
+    case ThumbnailCache::State::Missing:  // its load was cancelled: ask again
+        m_thumbnails.request(m_photoTexture.forEntityId);
+        return;
+    case ThumbnailCache::State::Failed:
+        m_photoTexture.loading = false;
+        std::cerr << "[Photo] no thumbnail for " << m_photoTexture.forEntityId << "\n";
+        return;
+    default:
         return;
     }
 
+    // Decoded and downscaled on a worker; here only allocate the texture
+    // and hand the pixels to the uploader
+    auto thumbnail = m_thumbnails.get(m_photoTexture.forEntityId);
+    int w = thumbnail->width, h = thumbnail->height;
+
     unsigned int tex = 0;
     glGenTextures(1, &tex);
     glBindTexture(GL_TEXTURE_2D, tex);
@@ -279,13 +378,16 @@ void InteractionController::drainPhotoTexture()
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
     glBindTexture(GL_TEXTURE_2D, 0);
-    stbi_image_free(pixels);
 
     m_photoTexture.texture = tex;
     m_photoTexture.texW    = w;
     m_photoTexture.texH    = h;
+    m_uploader->upload(tex, w, h, thumbnail->rgba.data(), thumbnail);
+    m_uploader->process();
+    if (!m_uploader->pending(tex))
+        m_photoTexture.loading = false;
 }
 
 // ---- ImGui rendering ----
@@ -294,7 +396,7 @@ void InteractionController::drawEntityTooltip(PickResult pick, const AppModel& m
 {
     if (!pick.valid()) return;
     const auto& layer = model.layers[pick.layerIndex];
-    const auto& e     = layer.entities[pick.entityIndex];
+    const Entity e    = layer.entities.entity(pick.entityIndex);
 
     ImGui::BeginTooltip();
 
@@ -340,7 +442,7 @@ void InteractionController::drawDetailsPanel(const AppModel& model)
         return;
     }
 
-    const auto& e     = layer.entities[m_selected.entityIndex];
+    const Entity e    = layer.entities.entity(m_selected.entityIndex);
     ImVec4      col(layer.color.r, layer.color.g, layer.color.b, 1.0f);
 
     // ── Header: type badge | name | [×] ──────────────────────────────────────
@@ -440,6 +542,10 @@ void InteractionController::drawDetailsPanel(const AppModel& model)
     // ── Photo thumbnail ───────────────────────────────────────────────────────
     if (layer.name == "photo") {
         ImGui::Separator();
+        // New thumbnails are downscaled to the width they are shown at
+        float panelPx = ImGui::GetContentRegionAvail().x * ImGui::GetIO().DisplayFramebufferScale.x;
+        if (panelPx >= 1.0f)
+            m_thumbnails.setMaxWidth(static_cast<int>(std::ceil(panelPx)));
         if (m_photoTexture.loading) {
             ImGui::TextDisabled("Loading image...");
         } else if (m_photoTexture.texture != 0) {
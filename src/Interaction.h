@@ -5,6 +5,7 @@
 #include "Camera.h"
 #include "TimelineCamera.h"
 #include "EntityPicker.h"
+#include "ThumbnailCache.h"
 #include <vector>
 #include <cstddef>
 #include <cstdint>
@@ -12,8 +13,10 @@
 #include <string>
 #include <future>
 #include <functional>
+#include <memory>
 
 class AppModel;
+class TextureUploader;
 
 /// Public state of the interaction system (passed to renderers for visual feedback)
 struct InteractionState {
@@ -25,7 +28,21 @@ struct InteractionState {
 class InteractionController
 {
 public:
+    /// Photos on each side (in time) of the selected or hovered one whose
+    /// thumbnails are prefetched.
+    static constexpr size_t kPrefetchNeighbors = 4;
+
+    InteractionController();
+    ~InteractionController();
+
     // --- Spatial index management ---
+    /// Entities update() indexes per call, across all layers; the rest wait
+    /// for the next frame (pickers stay dirty until caught up).  Appends are
+    /// indexed in place; an edited layer (revision bump) is indexed again
+    /// into a shadow picker under the same budget and swapped in once
+    /// complete; the layer is not picked until then.
+    static constexpr size_t kPickerEntitiesPerFrame = 200000;
+
     void markPickersDirty() { m_pickersDirty = true; }
     void resetPickers();                   ///< Clear indices + hover/selection (call on data reload)
     void update(const AppModel& model);    ///< Incremental picker rebuild if dirty
@@ -54,20 +71,26 @@ public:
 
     // --- Photo thumbnail loading ---
     /// Set by MainScreen after constructing the photo backend.
-    /// The fetcher is a blocking function called on a background thread.
-    /// Clear it (pass {}) before destroying the backend it captures.
-    void setPhotoFetcher(std::function<std::vector<uint8_t>(const std::string& entityId)> f) {
-        m_photoFetcher = std::move(f);
+    /// The fetcher starts a non-blocking request and returns its future.
+    /// Call waitForPhotoFetch() first, and clear it (pass {}) before
+    /// destroying the backend it captures.
+    using PhotoFetcher = ThumbnailCache::Fetcher;
+    void setPhotoFetcher(PhotoFetcher f) {
+        m_thumbnails.setFetcher(std::move(f));
     }
 
-    /// Call each frame from onUpdate — non-blocking check; uploads texture to GL if ready.
+    /// Call each frame from onUpdate — non-blocking check; once the thumbnail
+    /// is decoded, streams it into the texture a budgeted slice per frame.
     void drainPhotoTexture();
 
-    /// Block until the current thumbnail fetch completes. Call before destroying
-    /// the backend that the fetcher function captures.
+    /// Cancel queued thumbnail loads and block until running ones complete.
+    /// Call before destroying the backend that the fetcher function captures.
     void waitForPhotoFetch();
 
-    /// Block on any pending fetch, then delete the GL texture. Call from onDetach.
+    ThumbnailCache::Stats thumbnailStats() const { return m_thumbnails.stats(); }
+
+    /// Block on any pending fetch, then delete the GL texture and upload
+    /// buffers. Call from onDetach.
     void shutdown();
 
     // --- ImGui rendering ---
@@ -79,6 +102,10 @@ private:
     // Pickers
     std::vector<EntityPicker> m_pickers;
     std::vector<size_t>       m_lastEntityCounts;
+    std::vector<uint64_t>     m_lastRevisions;
+    std::vector<EntityPicker> m_shadowPickers;     ///< edited layers, being indexed again
+    std::vector<uint64_t>     m_shadowRevisions;   ///< revision each shadow indexes; kNoShadow if none
+    static constexpr uint64_t kNoShadow = UINT64_MAX;
     bool                      m_pickersDirty{true};
 
     // Hover / selection
@@ -91,18 +118,23 @@ private:
         unsigned int texture{0};   // GLuint — unsigned int avoids GL header in .h
         int          texW{0};
         int          texH{0};
-        bool         loading{false};
+        bool         loading{false};   // until decoded and fully uploaded
         std::string  forEntityId;  // entity whose texture is loaded/loading
-        std::future<std::vector<uint8_t>> pendingFetch;
     };
-    PhotoTexture m_photoTexture;
-    std::function<std::vector<uint8_t>(const std::string&)> m_photoFetcher;
+    PhotoTexture   m_photoTexture;
+    ThumbnailCache m_thumbnails;
+    PickResult     m_prefetchAnchor{};  // photo whose neighbours were last prefetched
+    std::unique_ptr<TextureUploader> m_uploader;
 
     void maybeStartPhotoFetch(const AppModel& model);
+    void prefetchAround(PickResult pick, const AppModel& model);
     void clearPhotoTexture();   // deletes GL texture, resets struct (call from main thread)
 
     // Internal pick helpers
     void ensurePickers(size_t count);
+    /// Layer li's live picker indexes its current revision: false while an
+    /// edit is being indexed into the shadow picker, and picks skip it.
+    bool pickerCurrent(size_t li, const AppModel& model) const;
     PickResult pickMap(const Camera& camera, Vec2 localPx, const AppModel& model) const;
     PickResult pickTimeline(const TimelineCamera& camera, float localX, float localY, float panelHeight, const AppModel& model) const;
     void drawEntityTooltip(PickResult pick, const AppModel& model) const;
@@ -1,10 +1,11 @@
 #pragma once
 
-#include "core/Entity.h"
+#include "core/EntityStore.h"
 #include "core/Color.h"
 #include <string>
 #include <vector>
 #include <chrono>
+#include <cstdint>
 
 /// A layer corresponds to one entity type (e.g. "location.gps", "photo").
 /// Each layer has its own entity storage, visibility, and color.
@@ -15,7 +16,8 @@ struct Layer {
     int colorMode = 0;            // 0=turbo colormap, 1=solid layer color
     int shape = 0;                // 0=circle, 1=square
     float yOffset = 0.0f;         // NDC Y offset applied post-projection (screen-space shift)
-    std::vector<Entity> entities;
+    EntityStore entities;
+    uint64_t revision = 0;        // bumped when entities change other than by appending
 
     // Per-layer fetch state
     bool is_fetching = false;
@@ -4,6 +4,9 @@
 #include <cmath>
 #include "core/Theme.h"
 
+static_assert(PointRenderer::CHUNK_SIZE == EntityStore::kSegmentSize,
+              "a point chunk is uploaded from one layer segment");
+
 static constexpr float kPi = 3.14159265358979323846f;
 
 static const char* rasterUrlForMode(TileMode mode) {
@@ -64,6 +67,7 @@ void Renderer::ensureLayerRenderer(size_t layerIndex) {
         pr->setPointSize(m_pointSize);
         m_layerPoints.push_back(std::move(pr));
         m_layerEntityCounts.push_back(0);
+        m_layerRevisions.push_back(0);
     }
 }
 
@@ -138,26 +142,24 @@ void Renderer::rebuildLayerChunk(size_t layerIndex, size_t chunkIndex, const Lay
 {
    m_chunkBuildBuf.clear();
 
-   size_t start = chunkIndex * PointRenderer::CHUNK_SIZE;
-   size_t end = std::min(start + PointRenderer::CHUNK_SIZE, layer.entities.size());
-
-   for (size_t i = start; i < end; i++) {
-      const auto& entity = layer.entities[i];
+   // Chunk i is the layer's segment i
+   const EntityColumns& c = layer.entities.segment(chunkIndex);
 
+   for (size_t i = 0; i < c.size(); i++) {
       // Entities without GPS use a sentinel far outside any map view.
       // On the map: the sentinel projects off-screen and is GPU-clipped (invisible).
       // On the timeline: the sentinel is treated as "out of map view" (gray/muted pass).
       // Subtract the fixed reference before casting to float so that the stored
       // values are small (≈ ±1°) and float has ~0.013m precision instead of ~0.7m.
-      Vec2 geo = entity.has_location()
-          ? Vec2(static_cast<float>(*entity.lon - kRefLon),
-                 static_cast<float>(*entity.lat - kRefLat))
+      Vec2 geo = c.hasLocation(i)
+          ? Vec2(static_cast<float>(c.lon[i] - kRefLon),
+                 static_cast<float>(c.lat[i] - kRefLat))
           : Vec2(-9999.0f, -9999.0f);
 
       m_chunkBuildBuf.push_back({
           geo,
-          static_cast<float>(entity.time_mid()),
-          entity.render_offset
+          static_cast<float>((c.time_start[i] + c.time_end[i]) / 2.0),
+          c.render_offset[i]
       });
    }
 
@@ -210,6 +212,7 @@ void Renderer::renderEntities(const Camera &camera, const AppModel &model)
        static_cast<float>(camera.latBottom() - kRefLat),
        static_cast<float>(camera.latTop()    - kRefLat));
 
+   size_t uploadBudget = kChunkUploadsPerFrame;
    for (size_t li = 0; li < model.layers.size(); ++li) {
       const Layer& layer = model.layers[li];
       if (!layer.visible) continue;
@@ -222,19 +225,25 @@ void Renderer::renderEntities(const Camera &camera, const AppModel &model)
 
       size_t numActiveChunks = (entityCount + PointRenderer::CHUNK_SIZE - 1) / PointRenderer::CHUNK_SIZE;
 
-      // Only rebuild chunks that contain newly added entities
-      if (entityCount != m_layerEntityCounts[li]) {
+      // Only rebuild chunks that contain newly added entities, unless the
+      // layer was edited in place (cache sync), which redoes them all.
+      // Uploads stop at the frame's chunk budget and resume next frame.
+      bool edited = layer.revision != m_layerRevisions[li];
+      if ((entityCount != m_layerEntityCounts[li] || edited) && uploadBudget > 0) {
          pr.ensureChunks(numActiveChunks);
 
-         size_t firstDirtyChunk = (entityCount > m_layerEntityCounts[li])
+         size_t firstDirtyChunk = (entityCount > m_layerEntityCounts[li] && !edited)
             ? m_layerEntityCounts[li] / PointRenderer::CHUNK_SIZE
             : 0;
+         size_t lastDirtyChunk = std::min(numActiveChunks, firstDirtyChunk + uploadBudget);
 
-         for (size_t c = firstDirtyChunk; c < numActiveChunks; c++) {
+         for (size_t c = firstDirtyChunk; c < lastDirtyChunk; c++) {
             rebuildLayerChunk(li, c, layer);
          }
+         uploadBudget -= lastDirtyChunk - firstDirtyChunk;
 
-         m_layerEntityCounts[li] = entityCount;
+         m_layerEntityCounts[li] = std::min(entityCount, lastDirtyChunk * PointRenderer::CHUNK_SIZE);
+         m_layerRevisions[li] = layer.revision;
       }
 
       pr.drawChunked(relativeVP, aspectRatio, numActiveChunks, timeMin, timeMax,
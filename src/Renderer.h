@@ -36,6 +36,10 @@ enum class TileMode {
 class Renderer
 {
 public:
+    /// Point chunks (PointRenderer::CHUNK_SIZE entities each) uploaded per
+    /// frame across all layers; a large load reaches the GPU over a few frames.
+    static constexpr size_t kChunkUploadsPerFrame = 4;
+
     Renderer();
     void init();
     void shutdown();
@@ -79,7 +83,8 @@ private:
 
     // One PointRenderer per layer (grown to match model.layers on demand)
     std::vector<std::unique_ptr<PointRenderer>> m_layerPoints;
-    std::vector<size_t> m_layerEntityCounts;  // dirty-check per layer
+    std::vector<size_t> m_layerEntityCounts;  // dirty-check per layer (entities uploaded so far)
+    std::vector<uint64_t> m_layerRevisions;   // Layer::revision last uploaded
 
     std::vector<PointVertex> m_chunkBuildBuf;  // Reusable scratch buffer
 
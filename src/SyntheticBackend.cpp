@@ -0,0 +1,901 @@
+#include "SyntheticBackend.h"
+#include "core/TimeUtils.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <iostream>
+#include <iterator>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+
+constexpr double kDay = 86400.0;
+constexpr double kHour = 3600.0;
+constexpr double kPi = 3.14159265358979323846;
+constexpr double kMetersPerDegree = 111320.0;
+constexpr uint64_t kGolden = 0x9e3779b97f4a7c15ull;
+
+uint64_t finalize(uint64_t z)
+{
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+}
+
+/// splitmix64 of one value: a bijection, so distinct keys hash distinctly
+uint64_t mix(uint64_t x) { return finalize(x + kGolden); }
+
+/// splitmix64 stream.  Hand-rolled distributions: the std:: ones are
+/// implementation-defined, so the data would change between toolchains.
+class Rng {
+public:
+    explicit Rng(uint64_t seed) : m_state(seed) {}
+
+    uint64_t next() { m_state += kGolden; return finalize(m_state); }
+    double uniform() { return static_cast<double>(next() >> 11) * 0x1.0p-53; }
+    double uniform(double a, double b) { return a + (b - a) * uniform(); }
+    int below(int n) { return static_cast<int>(uniform() * n); }
+    bool chance(double p) { return uniform() < p; }
+
+    double normal() {
+        double u1 = 1.0 - uniform();  // (0, 1]
+        double u2 = uniform();
+        return std::sqrt(-2.0 * std::log(u1)) * std::cos(2.0 * kPi * u2);
+    }
+
+    int poisson(double lambda) {
+        double limit = std::exp(-lambda), p = 1.0;
+        int k = 0;
+        while ((p *= uniform()) > limit) ++k;
+        return k;
+    }
+
+private:
+    uint64_t m_state;
+};
+
+struct City {
+    const char* name;
+    double lat, lon;
+    int utcOffsetHours;  ///< standard time; no DST
+};
+
+const City kCities[] = {
+    {"Los Angeles", 34.05, -118.25, -8}, {"San Francisco", 37.77, -122.42, -8},
+    {"Seattle", 47.61, -122.33, -8},     {"Denver", 39.74, -104.99, -7},
+    {"Chicago", 41.88, -87.63, -6},      {"New York", 40.71, -74.01, -5},
+    {"Mexico City", 19.43, -99.13, -6},  {"London", 51.51, -0.13, 0},
+    {"Lisbon", 38.72, -9.14, 0},         {"Paris", 48.86, 2.35, 1},
+    {"Berlin", 52.52, 13.40, 1},         {"Cape Town", -33.92, 18.42, 2},
+    {"Tokyo", 35.68, 139.69, 9},         {"Seoul", 37.57, 126.98, 9},
+    {"Sydney", -33.87, 151.21, 10},      {"Reykjavik", 64.15, -21.94, 0},
+};
+constexpr int kCityCount = sizeof(kCities) / sizeof(kCities[0]);
+
+const char* const kOutingPlaces[] = {
+    "Coffee shop", "Grocery store", "Park", "Restaurant", "Gym", "Museum", "Beach",
+    "Bookstore", "Farmers market", "Cinema", "Friend's place", "Hardware store",
+    "Trailhead", "Bar",
+};
+const char* const kLunchPlaces[] = {"Cafe", "Taqueria", "Sandwich shop", "Ramen bar", "Salad place"};
+const char* const kMeetings[] = {
+    "1:1", "Design review", "Sprint planning", "All hands", "Interview", "Customer call",
+    "Retro", "Lunch & learn", "Roadmap sync",
+};
+const char* const kPersonalEvents[] = {
+    "Dentist", "Dinner with friends", "Gym class", "Haircut", "Concert", "Birthday party",
+    "Doctor", "Book club", "Soccer game",
+};
+
+template <size_t N>
+const char* pick(Rng& rng, const char* const (&names)[N]) { return names[rng.below(N)]; }
+
+const char* const kWorkColor = "#4285F4";
+const char* const kInterviewColor = "#8E24AA";
+const char* const kPersonalColor = "#33B679";
+const char* const kTravelColor = "#F4511E";
+
+enum class Kind : uint64_t { Gps = 1, Photo = 2, Calendar = 3, Timeline = 4 };
+
+Kind kindOf(const std::string& entityType)
+{
+    if (entityType == "location.gps") return Kind::Gps;
+    if (entityType == "photo") return Kind::Photo;
+    if (entityType == "calendar.event") return Kind::Calendar;
+    if (entityType == "location.googletimeline") return Kind::Timeline;
+    throw std::runtime_error("SyntheticBackend: unknown entity type '" + entityType + "'");
+}
+
+struct LatLon {
+    double lat = 0.0, lon = 0.0;
+    bool operator==(const LatLon& o) const { return lat == o.lat && lon == o.lon; }
+};
+
+LatLon offsetMeters(LatLon p, double north, double east)
+{
+    p.lat += north / kMetersPerDegree;
+    p.lon += east / (kMetersPerDegree * std::cos(p.lat * kPi / 180.0));
+    return p;
+}
+
+LatLon scatter(Rng& rng, LatLon p, double sigmaMeters)
+{
+    return offsetMeters(p, rng.normal() * sigmaMeters, rng.normal() * sigmaMeters);
+}
+
+LatLon awayFrom(Rng& rng, LatLon p, double minMeters, double maxMeters)
+{
+    double angle = rng.uniform(0.0, 2.0 * kPi);
+    double dist = rng.uniform(minMeters, maxMeters);
+    return offsetMeters(p, dist * std::cos(angle), dist * std::sin(angle));
+}
+
+double distanceMeters(LatLon a, LatLon b)
+{
+    double north = (b.lat - a.lat) * kMetersPerDegree;
+    double east = (b.lon - a.lon) * kMetersPerDegree * std::cos((a.lat + b.lat) * kPi / 360.0);
+    return std::sqrt(north * north + east * east);
+}
+
+struct Era {
+    int64_t firstDay;
+    int city;
+    LatLon home, work;
+};
+
+struct Trip {
+    int64_t firstDay, lastDay;
+    int city;
+    LatLon hotel;
+};
+
+} // namespace
+
+/// Where the person lives and travels, drawn once from the seed.  Days are
+/// unix day numbers (days since 1970-01-01).
+struct SyntheticWorld {
+    uint64_t seed = 0;
+    int64_t firstDay = 0, lastDay = 0;
+    std::vector<Era> eras;    ///< ascending; the first covers firstDay - 1
+    std::vector<Trip> trips;  ///< ascending, disjoint
+    double gpsPerDay = 0.0;
+    double photosPerDay = 0.0;
+    double meetingsPerWorkday = 0.0;
+
+    const Era& era(int64_t day) const {
+        auto it = std::upper_bound(eras.begin(), eras.end(), day,
+                                   [](int64_t d, const Era& e) { return d < e.firstDay; });
+        return it == eras.begin() ? eras.front() : *(it - 1);
+    }
+
+    const Trip* trip(int64_t day) const {
+        auto it = std::upper_bound(trips.begin(), trips.end(), day,
+                                   [](int64_t d, const Trip& t) { return d < t.firstDay; });
+        if (it == trips.begin()) return nullptr;
+        --it;
+        return day <= it->lastDay ? &*it : nullptr;
+    }
+
+    /// Where the day starts and ends
+    LatLon base(int64_t day) const {
+        const Trip* t = trip(day);
+        return t ? t->hotel : era(day).home;
+    }
+
+    /// Local midnight, in the home city's time zone (trips keep it)
+    double midnight(int64_t day) const {
+        return day * kDay - kCities[era(day).city].utcOffsetHours * kHour;
+    }
+
+    /// The day's entities start in [windowStart(day), windowStart(day + 1)),
+    /// so days stay in order where a move shifts the time zone
+    double windowStart(int64_t day) const {
+        return std::max(midnight(day), midnight(day - 1) + kDay);
+    }
+
+    uint64_t daySeed(int64_t day, uint64_t salt) const {
+        return mix(seed ^ mix(static_cast<uint64_t>(day) * 8 + salt));
+    }
+
+    std::string id(Kind layer, int64_t day, uint64_t n) const {
+        uint64_t key = (static_cast<uint64_t>(layer) << 56)
+                     | ((static_cast<uint64_t>(day) & 0xffffffffull) << 24)
+                     | (n & 0xffffffull);
+        char buf[17];
+        std::snprintf(buf, sizeof(buf), "%016llx",
+                      static_cast<unsigned long long>(mix(key ^ mix(seed))));
+        return buf;
+    }
+};
+
+namespace {
+
+std::shared_ptr<const SyntheticWorld> buildWorld(const SyntheticBackend::Config& config)
+{
+    auto world = std::make_shared<SyntheticWorld>();
+    world->seed = config.seed;
+    world->firstDay = static_cast<int64_t>(std::floor(config.start / kDay)) - 1;
+    world->lastDay = static_cast<int64_t>(std::floor(config.end / kDay)) + 1;
+    world->photosPerDay = config.photosPerDay;
+    world->meetingsPerWorkday = config.meetingsPerWorkday;
+    // About 8% of samples fall in outages
+    world->gpsPerDay = static_cast<double>(config.gpsPoints)
+                     / std::max<int64_t>(1, world->lastDay - world->firstDay - 1) / 0.92;
+
+    Rng rng(mix(config.seed));
+    int city = rng.below(kCityCount);
+    for (int64_t day = world->firstDay - 1; day <= world->lastDay + 1;) {
+        Era era;
+        era.firstDay = day;
+        era.city = city;
+        era.home = scatter(rng, {kCities[city].lat, kCities[city].lon}, 3000.0);
+        era.work = awayFrom(rng, era.home, 3000.0, 12000.0);
+        world->eras.push_back(era);
+        day += 500 + rng.below(1000);
+        city = (city + 1 + rng.below(kCityCount - 1)) % kCityCount;
+    }
+
+    for (int64_t day = world->firstDay + 20 + rng.below(60); day <= world->lastDay;) {
+        Trip trip;
+        trip.firstDay = day;
+        trip.lastDay = day + 1 + rng.below(9);
+        int home = world->era(day).city;
+        trip.city = (home + 1 + rng.below(kCityCount - 1)) % kCityCount;
+        trip.hotel = scatter(rng, {kCities[trip.city].lat, kCities[trip.city].lon}, 2000.0);
+        world->trips.push_back(trip);
+        day = trip.lastDay + 40 + rng.below(100);
+    }
+    return world;
+}
+
+// ---- One day's itinerary ---------------------------------------------------
+
+enum class Mode { Walk, Cycle, Drive };
+
+double speed(Mode mode)  // m/s, door to door
+{
+    switch (mode) {
+        case Mode::Walk:  return 1.4;
+        case Mode::Cycle: return 4.5;
+        default:          return 11.0;
+    }
+}
+
+const char* activityName(Mode mode)
+{
+    switch (mode) {
+        case Mode::Walk:  return "Walking";
+        case Mode::Cycle: return "Cycling";
+        default:          return "Driving";
+    }
+}
+
+/// Times are seconds after local midnight.  moves[i] goes from stays[i] to
+/// stays[i + 1]; the first and last stay are at the day's base.
+struct Stay {
+    LatLon at;
+    double t0, t1;
+    std::string place;
+    bool atBase;
+};
+
+struct Move {
+    LatLon from, via, to;  // via bends the path off the straight line
+    double t0, t1;
+    Mode mode;
+
+    LatLon at(double t) const {
+        double f = (t - t0) / (t1 - t0), g = 1.0 - f;
+        return {g * g * from.lat + 2 * f * g * via.lat + f * f * to.lat,
+                g * g * from.lon + 2 * f * g * via.lon + f * f * to.lon};
+    }
+};
+
+struct DayPlan {
+    int64_t day = 0;
+    double midnight = 0.0;  ///< utc
+    double lo = 0.0, hi = 0.0;  ///< utc window entities may start in
+    bool workday = false;
+    bool weekend = false;
+    const Trip* trip = nullptr;
+    std::vector<Stay> stays;
+    std::vector<Move> moves;
+};
+
+DayPlan planDay(const SyntheticWorld& world, int64_t day)
+{
+    Rng rng(world.daySeed(day, 0));
+    DayPlan plan;
+    plan.day = day;
+    plan.midnight = world.midnight(day);
+    plan.lo = world.windowStart(day);
+    plan.hi = world.windowStart(day + 1);
+    plan.trip = world.trip(day);
+    const Era& era = world.era(day);
+
+    int weekday = static_cast<int>(((day + 4) % 7 + 7) % 7);  // 0 = Sunday; 1970-01-01 was a Thursday
+    plan.weekend = weekday == 0 || weekday == 6;
+    plan.workday = !plan.trip && !plan.weekend && !rng.chance(0.06);
+
+    LatLon base = world.base(day);
+    std::string baseName = plan.trip ? "Hotel" : "Home";
+
+    struct Visit {
+        LatLon at;
+        double leave;  // earliest departure towards it
+        double duration;
+        std::string place;
+        bool atBase;
+    };
+    std::vector<Visit> visits;
+    if (plan.workday) {
+        double leave = 7.5 * kHour + rng.uniform(0.0, 1.5 * kHour);
+        double workEnd = leave + 8.5 * kHour + rng.uniform(-0.5 * kHour, 1.5 * kHour);
+        if (rng.chance(0.35)) {
+            double lunch = 12.0 * kHour + rng.uniform(0.0, kHour);
+            LatLon cafe = awayFrom(rng, era.work, 200.0, 900.0);
+            double lunchTime = rng.uniform(0.5 * kHour, kHour);
+            visits.push_back({era.work, leave, lunch - leave, "Work", false});
+            visits.push_back({cafe, lunch, lunchTime, pick(rng, kLunchPlaces), false});
+            visits.push_back({era.work, 0.0, workEnd - lunch - lunchTime, "Work", false});
+        } else {
+            visits.push_back({era.work, leave, workEnd - leave, "Work", false});
+        }
+        if (rng.chance(0.4))
+            visits.push_back({awayFrom(rng, base, 1000.0, 5000.0), 0.0,
+                              rng.uniform(0.5 * kHour, 1.5 * kHour), pick(rng, kOutingPlaces), false});
+    } else {
+        int outings = plan.trip ? 2 + rng.below(3) : rng.below(4);
+        double t = 9.0 * kHour + rng.uniform(0.0, 3.0 * kHour);
+        for (int i = 0; i < outings; ++i) {
+            double duration = rng.uniform(kHour, plan.trip ? 3.0 * kHour : 4.0 * kHour);
+            LatLon at = plan.trip ? awayFrom(rng, base, 300.0, 6000.0)
+                                  : awayFrom(rng, base, 1000.0, 25000.0);
+            visits.push_back({at, t, duration, pick(rng, kOutingPlaces), false});
+            t += duration + rng.uniform(0.5 * kHour, 2.0 * kHour);
+            if (i + 1 < outings && rng.chance(0.5))
+                visits.push_back({base, 0.0, rng.uniform(0.5 * kHour, 2.0 * kHour), baseName, true});
+        }
+    }
+
+    plan.stays.push_back({base, 0.0, kDay, baseName, true});
+    double cursor = 0.0;
+    auto travel = [&rng](LatLon from, LatLon to, Mode& mode) {
+        double dist = distanceMeters(from, to);
+        mode = dist < 1200.0 ? Mode::Walk : (dist < 5000.0 && rng.chance(0.3)) ? Mode::Cycle : Mode::Drive;
+        return dist * 1.3 / speed(mode) + rng.uniform(120.0, 420.0);
+    };
+    auto goTo = [&](LatLon to, double depart, double duration, std::string place, bool atBase) {
+        Move move;
+        move.from = plan.stays.back().at;
+        move.to = to;
+        move.t0 = depart;
+        move.t1 = depart + travel(move.from, to, move.mode);
+        LatLon mid{(move.from.lat + to.lat) / 2, (move.from.lon + to.lon) / 2};
+        double bend = distanceMeters(move.from, to) * 0.15;
+        move.via = scatter(rng, mid, bend);
+        plan.stays.back().t1 = depart;
+        plan.moves.push_back(move);
+        plan.stays.push_back({to, move.t1, move.t1 + duration, std::move(place), atBase});
+        cursor = move.t1 + duration;
+    };
+
+    for (auto& v : visits) {
+        double depart = std::max(cursor, v.leave);
+        double home = distanceMeters(v.at, base) * 1.3 / speed(Mode::Drive) + 900.0;
+        if (depart + v.duration + home + kHour > 23.5 * kHour) break;
+        goTo(v.at, depart, v.duration, std::move(v.place), v.atBase);
+    }
+    if (!plan.stays.back().atBase)
+        goTo(base, cursor, 0.0, baseName, true);
+    plan.stays.back().t1 = kDay;
+    return plan;
+}
+
+// ---- Layers -----------------------------------------------------------------
+
+/// Keeps entities that start inside both the day's window and the range,
+/// numbering every candidate so ids do not depend on the range.
+struct DayOutput {
+    const SyntheticWorld& world;
+    Kind layer;
+    const DayPlan& plan;
+    double start, end;
+    std::vector<Entity>* out;
+    uint64_t serial = 0;
+    size_t count = 0;
+
+    bool wants(double utc) const {
+        return utc >= plan.lo && utc < plan.hi && utc >= start && utc <= end;
+    }
+
+    /// Returns the entity to fill in, or null if it is outside
+    Entity* add(double t0, double t1) {
+        uint64_t n = serial++;
+        if (!wants(t0)) return nullptr;
+        ++count;
+        if (!out) return nullptr;
+        Entity& e = out->emplace_back();
+        e.id = world.id(layer, plan.day, n);
+        e.time_start = t0;
+        e.time_end = t1;
+        return &e;
+    }
+};
+
+void gpsDay(DayOutput& o)
+{
+    const DayPlan& plan = o.plan;
+    Rng rng(o.world.daySeed(plan.day, 1));
+    if (rng.chance(0.03)) return;  // phone off all day
+
+    double outageStart[2] = {0, 0}, outageEnd[2] = {0, 0};
+    for (int i = 0; i < 2; ++i) {
+        if (!rng.chance(0.15)) continue;
+        outageStart[i] = rng.uniform(0.0, kDay);
+        outageEnd[i] = outageStart[i] + rng.uniform(kHour, 5.0 * kHour);
+    }
+    auto inOutage = [&](double t) {
+        return (t >= outageStart[0] && t < outageEnd[0]) || (t >= outageStart[1] && t < outageEnd[1]);
+    };
+
+    // Eight times denser while moving
+    double moving = 0.0;
+    for (const auto& m : plan.moves) moving += m.t1 - m.t0;
+    double stayInterval = (kDay + 7.0 * moving) / std::max(1.0, o.world.gpsPerDay);
+    double moveInterval = stayInterval / 8.0;
+
+    // Jitter has its own stream, drawn for every sample when generating, so
+    // counting (which skips it) agrees and the range does not shift it
+    Rng jitter(o.world.daySeed(plan.day, 2));
+    double t = rng.uniform(0.0, stayInterval);
+    for (size_t s = 0; s < plan.stays.size(); ++s) {
+        const Stay& stay = plan.stays[s];
+        for (; t < stay.t1; t += stayInterval) {
+            if (inOutage(t)) { ++o.serial; continue; }
+            // Drift of a few metres, now and then a poor fix
+            LatLon p;
+            if (o.out) p = scatter(jitter, stay.at, jitter.chance(0.05) ? 40.0 : 8.0);
+            if (Entity* e = o.add(plan.midnight + t, plan.midnight + t)) {
+                e->lat = p.lat;
+                e->lon = p.lon;
+            }
+        }
+        if (s >= plan.moves.size()) break;
+        const Move& move = plan.moves[s];
+        t = std::max(t, move.t0);
+        for (; t < move.t1; t += moveInterval) {
+            if (inOutage(t)) { ++o.serial; continue; }
+            LatLon p;
+            if (o.out) p = scatter(jitter, move.at(t), jitter.chance(0.05) ? 40.0 : 5.0);
+            if (Entity* e = o.add(plan.midnight + t, plan.midnight + t)) {
+                e->lat = p.lat;
+                e->lon = p.lon;
+            }
+        }
+    }
+}
+
+void photoDay(DayOutput& o)
+{
+    const DayPlan& plan = o.plan;
+    Rng rng(o.world.daySeed(plan.day, 3));
+    double rate = o.world.photosPerDay * (plan.trip ? 3.0 : plan.weekend ? 1.5 : 0.6);
+    int shots = rng.poisson(rate);
+
+    // Awake hours, mostly away from home
+    auto span = [](const Stay& s, double& a, double& b) {
+        a = std::max(s.t0, 7.0 * kHour);
+        b = std::min(s.t1, 23.0 * kHour);
+        return std::max(0.0, b - a) * (s.atBase ? 0.15 : 1.0);
+    };
+    double total = 0.0, a, b;
+    for (const auto& s : plan.stays) total += span(s, a, b);
+    if (total <= 0.0) return;
+
+    struct Shot { double t; LatLon at; };
+    std::vector<Shot> taken;
+    for (int i = 0; i < shots; ++i) {
+        double pickAt = rng.uniform(0.0, total);
+        const Stay* stay = &plan.stays.back();
+        for (const auto& s : plan.stays) {
+            double w = span(s, a, b);
+            if (pickAt < w) { stay = &s; break; }
+            pickAt -= w;
+        }
+        span(*stay, a, b);
+        double t = rng.uniform(a, std::max(a, b));
+        LatLon at = scatter(rng, stay->at, 25.0);
+        taken.push_back({t, at});
+        int burst = rng.chance(0.3) ? 1 + rng.below(4) : 0;  // a few more in quick succession
+        for (int k = 0; k < burst; ++k) {
+            t += rng.uniform(1.0, 20.0);
+            taken.push_back({t, scatter(rng, at, 3.0)});
+        }
+    }
+    std::sort(taken.begin(), taken.end(), [](const Shot& x, const Shot& y) { return x.t < y.t; });
+
+    for (const auto& shot : taken) {
+        Entity* e = o.add(plan.midnight + shot.t, plan.midnight + shot.t);
+        if (!e) continue;
+        e->lat = shot.at.lat;
+        e->lon = shot.at.lon;
+        char name[16];
+        std::snprintf(name, sizeof(name), "IMG_%04u.JPG", static_cast<unsigned>(mix(o.serial) % 10000));
+        e->name = name;
+    }
+}
+
+void calendarDay(DayOutput& o)
+{
+    const DayPlan& plan = o.plan;
+    Rng rng(o.world.daySeed(plan.day, 4));
+
+    struct Event { double t0, t1; std::string name; const char* color; };
+    std::vector<Event> events;
+    if (plan.trip && plan.trip->firstDay == plan.day) {
+        double days = static_cast<double>(plan.trip->lastDay - plan.trip->firstDay + 1);
+        events.push_back({0.0, days * kDay, std::string("Trip to ") + kCities[plan.trip->city].name, kTravelColor});
+    }
+
+    if (plan.workday) {
+        double workStart = kDay, workEnd = 0.0;
+        for (const auto& s : plan.stays) {
+            if (s.place != "Work") continue;
+            workStart = std::min(workStart, s.t0);
+            workEnd = std::max(workEnd, s.t1);
+        }
+        if (workStart < workEnd) {
+            if (workStart <= 9.5 * kHour && rng.chance(0.9))
+                events.push_back({9.5 * kHour, 9.75 * kHour, "Standup", kWorkColor});
+            double first = std::ceil(workStart / 1800.0) * 1800.0;
+            int slots = static_cast<int>((workEnd - first) / 1800.0) - 1;
+            int meetings = slots > 0 ? rng.poisson(o.world.meetingsPerWorkday) : 0;
+            static const double kLengths[] = {1800.0, 1800.0, 3600.0, 3600.0, 5400.0};
+            for (int i = 0; i < meetings; ++i) {
+                double t0 = first + rng.below(slots) * 1800.0;
+                const char* name = pick(rng, kMeetings);
+                events.push_back({t0, t0 + kLengths[rng.below(5)], name,
+                                  std::string(name) == "Interview" ? kInterviewColor : kWorkColor});
+            }
+        }
+    } else {
+        int personal = rng.poisson(0.6);
+        for (int i = 0; i < personal; ++i) {
+            double t0 = (10 + rng.below(11)) * kHour;
+            events.push_back({t0, t0 + (1 + rng.below(3)) * kHour, pick(rng, kPersonalEvents), kPersonalColor});
+        }
+    }
+    std::stable_sort(events.begin(), events.end(), [](const Event& x, const Event& y) { return x.t0 < y.t0; });
+
+    for (auto& ev : events) {
+        Entity* e = o.add(plan.midnight + ev.t0, plan.midnight + ev.t1);
+        if (!e) continue;
+        e->name = std::move(ev.name);
+        e->color = ev.color;
+    }
+}
+
+void timelineDay(DayOutput& o)
+{
+    const DayPlan& plan = o.plan;
+    const SyntheticWorld& world = o.world;
+
+    // A night at the same base is one visit: it belongs to the evening it
+    // starts, and ends when the next day's first stay does
+    bool continuesYesterday = world.base(plan.day - 1) == world.base(plan.day);
+    bool continuesTomorrow = world.base(plan.day + 1) == world.base(plan.day);
+
+    for (size_t s = 0; s < plan.stays.size(); ++s) {
+        const Stay& stay = plan.stays[s];
+        if (s == 0 && continuesYesterday) {
+            ++o.serial;
+        } else {
+            double t0 = std::max(plan.midnight + stay.t0, plan.lo);
+            double t1 = plan.midnight + stay.t1;
+            if (s + 1 == plan.stays.size() && continuesTomorrow)
+                t1 = world.midnight(plan.day + 1) + planDay(world, plan.day + 1).stays.front().t1;
+            if (Entity* e = o.add(t0, std::max(t0, t1))) {
+                e->lat = stay.at.lat;
+                e->lon = stay.at.lon;
+                e->name = stay.place;
+            }
+        }
+        if (s >= plan.moves.size()) break;
+        const Move& move = plan.moves[s];
+        if (Entity* e = o.add(plan.midnight + move.t0, plan.midnight + move.t1)) {
+            e->lat = move.from.lat;
+            e->lon = move.from.lon;
+            e->name = activityName(move.mode);
+        }
+    }
+}
+
+/// Entities of `layer` for one day with time_start in [start, end], appended
+/// to `out` (if given) in time order.  Returns how many.
+size_t generateDay(const SyntheticWorld& world, Kind layer, int64_t day,
+                   double start, double end, std::vector<Entity>* out)
+{
+    DayPlan plan = planDay(world, day);
+    DayOutput o{world, layer, plan, start, end, out};
+    switch (layer) {
+        case Kind::Gps:      gpsDay(o); break;
+        case Kind::Photo:    photoDay(o); break;
+        case Kind::Calendar: calendarDay(o); break;
+        case Kind::Timeline: timelineDay(o); break;
+    }
+    return o.count;
+}
+
+unsigned threadCount(unsigned configured, size_t work)
+{
+    unsigned n = configured ? configured : std::max(1u, std::thread::hardware_concurrency());
+    return static_cast<unsigned>(std::max<size_t>(1, std::min<size_t>(n, work)));
+}
+
+/// produce(i) for i in [0, n) on worker threads, at most `window` batches
+/// ahead of consume(), which runs on the calling thread in index order.
+/// Returns false if `stop` cut it short.
+bool produceInOrder(size_t n, unsigned threads, size_t window, const std::atomic<bool>& stop,
+                    const std::function<std::vector<Entity>(size_t)>& produce,
+                    const std::function<void(std::vector<Entity>&&)>& consume)
+{
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::vector<std::optional<std::vector<Entity>>> ready(n);
+    size_t claimed = 0, delivered = 0;
+    bool quit = false;
+
+    auto worker = [&] {
+        for (;;) {
+            size_t i;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                cv.wait(lock, [&] { return quit || claimed >= n || claimed < delivered + window; });
+                if (quit || claimed >= n) return;
+                i = claimed++;
+            }
+            std::vector<Entity> batch;
+            if (!stop.load()) batch = produce(i);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                ready[i] = std::move(batch);
+            }
+            cv.notify_all();
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (unsigned t = 0; t < threads; ++t) pool.emplace_back(worker);
+
+    auto join = [&] {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            quit = true;
+        }
+        cv.notify_all();
+        for (auto& t : pool) t.join();
+    };
+
+    size_t i = 0;
+    try {
+        for (; i < n && !stop.load(); ++i) {
+            std::vector<Entity> batch;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                cv.wait(lock, [&] { return ready[i].has_value(); });
+                batch = std::move(*ready[i]);
+                ready[i].reset();
+                delivered = i + 1;
+            }
+            cv.notify_all();
+            if (stop.load()) break;
+            consume(std::move(batch));
+        }
+    } catch (...) {
+        join();
+        throw;
+    }
+    join();
+    return i == n && !stop.load();
+}
+
+} // namespace
+
+SyntheticBackend::SyntheticBackend(std::string entityType, Config config)
+    : m_entityType(std::move(entityType))
+    , m_config(config)
+    , m_world(buildWorld(m_config))
+{
+    kindOf(m_entityType);  // reject unknown types up front
+}
+
+SyntheticBackend::SyntheticBackend(std::string entityType)
+    : SyntheticBackend(std::move(entityType), Config{})
+{
+}
+
+std::optional<size_t> SyntheticBackend::stream(double start, double end,
+                                               const std::function<void(size_t)>& on_total,
+                                               const std::function<void(std::vector<Entity>&&)>& batch_callback)
+{
+    const SyntheticWorld& world = *m_world;
+    Kind layer = kindOf(m_entityType);
+    start = std::max(start, m_config.start);
+    end = std::min(end, m_config.end);
+
+    // Local midnights are within 14 hours of utc ones
+    int64_t firstDay = std::max(world.firstDay, static_cast<int64_t>(std::floor(start / kDay)) - 1);
+    int64_t lastDay = std::min(world.lastDay, static_cast<int64_t>(std::floor(end / kDay)) + 1);
+    if (start > end || firstDay > lastDay) {
+        if (on_total) on_total(0);
+        return 0;
+    }
+    size_t dayCount = static_cast<size_t>(lastDay - firstDay + 1);
+    unsigned threads = threadCount(m_config.threads, dayCount);
+
+    // Count first, so the total is known and batches can be cut by size
+    std::vector<size_t> counts(dayCount);
+    {
+        std::atomic<size_t> next{0};
+        auto work = [&] {
+            for (size_t d; (d = next.fetch_add(1)) < dayCount && !m_cancelled.load();)
+                counts[d] = generateDay(world, layer, firstDay + static_cast<int64_t>(d), start, end, nullptr);
+        };
+        std::vector<std::thread> pool;
+        for (unsigned t = 1; t < threads; ++t) pool.emplace_back(work);
+        work();
+        for (auto& t : pool) t.join();
+    }
+    if (m_cancelled.load()) return std::nullopt;
+
+    size_t total = 0;
+    struct Batch { size_t firstDay, endDay, rows; };
+    std::vector<Batch> batches;
+    for (size_t d = 0; d < dayCount; ++d) {
+        if (counts[d] == 0) continue;
+        total += counts[d];
+        if (batches.empty() || batches.back().rows >= m_config.batchRows)
+            batches.push_back({d, d, 0});
+        batches.back().endDay = d + 1;
+        batches.back().rows += counts[d];
+    }
+    if (on_total) on_total(total);
+    if (!batch_callback) return total;
+
+    bool complete = produceInOrder(
+        batches.size(), threads, 2 * static_cast<size_t>(threads), m_cancelled,
+        [&](size_t b) {
+            std::vector<Entity> rows;
+            rows.reserve(batches[b].rows);
+            for (size_t d = batches[b].firstDay; d < batches[b].endDay; ++d)
+                generateDay(world, layer, firstDay + static_cast<int64_t>(d), start, end, &rows);
+            return rows;
+        },
+        batch_callback);
+    if (!complete) return std::nullopt;
+    return total;
+}
+
+void SyntheticBackend::fetchEntities(
+    const TimeExtent& time,
+    const SpatialExtent& space,
+    std::function<void(std::vector<Entity>&&)> callback)
+{
+    m_cancelled.store(false);
+    stream(time.start, time.end, nullptr, [&](std::vector<Entity>&& batch) {
+        batch.erase(std::remove_if(batch.begin(), batch.end(), [&space](const Entity& e) {
+            return e.has_location() && (*e.lat < space.min_lat || *e.lat > space.max_lat ||
+                                        *e.lon < space.min_lon || *e.lon > space.max_lon);
+        }), batch.end());
+        if (!batch.empty()) callback(std::move(batch));
+    });
+}
+
+void SyntheticBackend::streamAllEntities(
+    std::function<void(size_t total)> on_total,
+    std::function<void(std::vector<Entity>&&)> batch_callback)
+{
+    m_cancelled.store(false);
+    m_lastStreamComplete.store(false);
+    auto total = stream(m_config.start, m_config.end, on_total, batch_callback);
+    m_lastStreamComplete.store(total.has_value());
+}
+
+void SyntheticBackend::streamAllByType(
+    double startTime,
+    double endTime,
+    std::function<void(std::vector<Entity>&&)> batch_callback)
+{
+    m_cancelled.store(false);
+    m_lastStreamComplete.store(false);
+    auto total = stream(startTime, endTime, nullptr, batch_callback);
+    m_lastStreamComplete.store(total.has_value());
+}
+
+size_t SyntheticBackend::count(double start, double end)
+{
+    m_cancelled.store(false);
+    size_t total = 0;
+    stream(start, end, [&total](size_t n) { total = n; }, nullptr);
+    return total;
+}
+
+std::vector<Entity> SyntheticBackend::generate(double start, double end)
+{
+    m_cancelled.store(false);
+    std::vector<Entity> all;
+    stream(start, end, [&all](size_t n) { all.reserve(n); }, [&all](std::vector<Entity>&& batch) {
+        std::move(batch.begin(), batch.end(), std::back_inserter(all));
+    });
+    return all;
+}
+
+ServerStats SyntheticBackend::fetchStats()
+{
+    size_t total;
+    {
+        std::lock_guard<std::mutex> lock(m_statsMutex);
+        if (!m_total) {
+            auto t0 = std::chrono::steady_clock::now();
+            m_total = count(m_config.start, m_config.end);
+            std::cerr << "[SYNTH] " << m_entityType << ": " << *m_total << " entities, counted in "
+                      << std::chrono::duration_cast<std::chrono::milliseconds>(
+                             std::chrono::steady_clock::now() - t0).count()
+                      << "ms\n";
+        }
+        total = *m_total;
+    }
+
+    ServerStats stats;
+    stats.total_entities = static_cast<int>(total);
+    stats.entities_by_type.emplace_back(m_entityType, static_cast<int>(total));
+    stats.oldest_time = TimeUtils::to_iso8601(m_config.start);
+    stats.newest_time = TimeUtils::to_iso8601(m_config.end);
+    return stats;
+}
+
+std::vector<uint8_t> SyntheticBackend::fetchPhotoThumb(const std::string& entityId)
+{
+    if (m_entityType != "photo" || entityId.empty()) return {};
+
+    // Sky over ground, both tinted by the id
+    uint64_t h = mix(std::hash<std::string>{}(entityId));
+    uint8_t sky[3] = {static_cast<uint8_t>(120 + (h & 0x7f)), static_cast<uint8_t>(140 + ((h >> 8) & 0x5f)), 230};
+    uint8_t ground[3] = {static_cast<uint8_t>(40 + ((h >> 16) & 0x7f)), static_cast<uint8_t>(90 + ((h >> 24) & 0x7f)),
+                         static_cast<uint8_t>(30 + ((h >> 32) & 0x3f))};
+    const int width = 320, height = 240;
+    int horizon = height / 3 + static_cast<int>((h >> 40) % (height / 3));
+
+    // 24-bit BMP, rows bottom-up, each padded to 4 bytes
+    const size_t rowBytes = (width * 3 + 3) & ~size_t(3);
+    const size_t fileSize = 54 + rowBytes * height;
+    std::vector<uint8_t> bmp(fileSize, 0);
+    auto put = [&bmp](size_t at, uint32_t v, int bytes) {
+        for (int i = 0; i < bytes; ++i) bmp[at + i] = static_cast<uint8_t>(v >> (8 * i));
+    };
+    bmp[0] = 'B';
+    bmp[1] = 'M';
+    put(2, static_cast<uint32_t>(fileSize), 4);
+    put(10, 54, 4);
+    put(14, 40, 4);
+    put(18, width, 4);
+    put(22, height, 4);
+    put(26, 1, 2);
+    put(28, 24, 2);
+    put(34, static_cast<uint32_t>(rowBytes * height), 4);
+    for (int y = 0; y < height; ++y) {
+        const uint8_t* c = (height - 1 - y) < horizon ? sky : ground;
+        float shade = 0.7f + 0.3f * static_cast<float>(y) / height;
+        uint8_t* row = bmp.data() + 54 + rowBytes * y;
+        for (int x = 0; x < width; ++x) {
+            row[x * 3 + 0] = static_cast<uint8_t>(c[2] * shade);
+            row[x * 3 + 1] = static_cast<uint8_t>(c[1] * shade);
+            row[x * 3 + 2] = static_cast<uint8_t>(c[0] * shade);
+        }
+    }
+    return bmp;
+}
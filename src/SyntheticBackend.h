@@ -0,0 +1,102 @@
+#pragma once
+
+#include "Backend.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+struct SyntheticWorld;
+
+/// Deterministic synthetic data for load testing without the server: years
+/// of one person's plausible history for each of the four layers.
+///
+/// A seed fixes the whole world: where they live (moving city every few
+/// years), when they travel, and every day's itinerary — stays at home,
+/// work and other places, joined by walks, rides and drives.  Each layer
+/// is a view of that itinerary:
+///   location.gps            - samples along it, dense while moving, sparse
+///                             at stays, with whole days and hours missing
+///   photo                   - taken at stays, more on weekends and trips
+///   calendar.event          - meetings on workdays, personal events, trips
+///   location.googletimeline - one visit per stay, one activity per move
+///
+/// Days are generated independently (each from its own seeded generator),
+/// in parallel across cores, and delivered in time order; the output does
+/// not depend on the thread count or on the range asked for.  Ids are
+/// unique 16-hex-digit strings.  gpsPoints scales the GPS layer to tens
+/// of millions of entities; the other layers follow the day count.
+class SyntheticBackend : public Backend {
+public:
+    struct Config {
+        uint64_t seed = 1;
+        double start = 1420070400.0;    ///< 2015-01-01T00:00:00Z
+        double end = 1735689600.0;      ///< 2025-01-01T00:00:00Z
+        size_t gpsPoints = 2000000;     ///< GPS samples over the whole range, roughly
+        double photosPerDay = 4.0;      ///< on an ordinary day; weekends and trips have more
+        double meetingsPerWorkday = 3.0;
+        size_t batchRows = 50000;       ///< entities per delivered batch, roughly (days are not split)
+        unsigned threads = 0;           ///< 0 = all cores
+    };
+
+    /// @param entityType location.gps, photo, calendar.event or
+    ///                   location.googletimeline
+    SyntheticBackend(std::string entityType, Config config);
+    explicit SyntheticBackend(std::string entityType);
+
+    /// Entities in the time range whose location is inside `space` (those
+    /// without one are kept), a batch at a time.
+    void fetchEntities(
+        const TimeExtent& time,
+        const SpatialExtent& space,
+        std::function<void(std::vector<Entity>&&)> callback
+    ) override;
+
+    void streamAllEntities(
+        std::function<void(size_t total)> on_total,
+        std::function<void(std::vector<Entity>&&)> batch_callback
+    ) override;
+
+    void streamAllByType(
+        double startTime,
+        double endTime,
+        std::function<void(std::vector<Entity>&&)> batch_callback
+    ) override;
+
+    void cancelFetch() override { m_cancelled.store(true); }
+    bool lastStreamComplete() const override { return m_lastStreamComplete.load(); }
+
+    /// A small BMP, coloured by the id, for any photo id.
+    std::vector<uint8_t> fetchPhotoThumb(const std::string& entityId) override;
+
+    /// Counts over the configured range (computed once).
+    ServerStats fetchStats() override;
+
+    const std::string& entityType() const override { return m_entityType; }
+    const Config& config() const { return m_config; }
+
+    /// Entities with time_start in [start, end], without generating them.
+    size_t count(double start, double end);
+
+    /// Every entity with time_start in [start, end], in time order.  For
+    /// tests and benchmarks; the streams deliver the same in batches.
+    std::vector<Entity> generate(double start, double end);
+
+private:
+    /// Generate [start, end] and deliver it in order; returns the total,
+    /// or nothing if cancelled.
+    std::optional<size_t> stream(double start, double end,
+                                 const std::function<void(size_t)>& on_total,
+                                 const std::function<void(std::vector<Entity>&&)>& batch_callback);
+
+    std::string m_entityType;
+    Config m_config;
+    std::shared_ptr<const SyntheticWorld> m_world;  ///< eras and trips, fixed by the seed
+    std::atomic<bool> m_cancelled{false};
+    std::atomic<bool> m_lastStreamComplete{false};
+    std::mutex m_statsMutex;
+    std::optional<size_t> m_total;  ///< guarded by m_statsMutex
+};
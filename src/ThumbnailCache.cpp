@@ -0,0 +1,248 @@
+#include "ThumbnailCache.h"
+#include "core/ImageScale.h"
+#include <algorithm>
+#include <iostream>
+
+ThumbnailCache::ThumbnailCache(Decoder decode, Config config)
+    : m_decode(std::move(decode))
+    , m_config(std::move(config))
+    , m_store(m_config.diskDir, m_config.diskBytes)
+    , m_maxWidth(m_config.maxWidth)
+    , m_pool(std::max<size_t>(m_config.maxConcurrent, 1))
+{
+}
+
+ThumbnailCache::~ThumbnailCache()
+{
+    cancelAndWait();
+}
+
+std::shared_ptr<const Thumbnail> ThumbnailCache::get(const std::string& entityId)
+{
+    auto it = m_entries.find(entityId);
+    if (it == m_entries.end()) {
+        ++m_stats.misses;
+        return nullptr;
+    }
+    m_lru.splice(m_lru.begin(), m_lru, it->second.lru);
+    ++m_stats.hits;
+    return it->second.thumbnail;
+}
+
+void ThumbnailCache::request(const std::string& entityId, Priority priority)
+{
+    if (m_entries.count(entityId)) return;
+    auto running = m_loading.find(entityId);
+    if (running != m_loading.end()) {
+        // Wanted again: a prefetch list that dropped it no longer applies
+        running->second.cancel->store(false);
+        if (priority == Priority::Now && running->second.priority == Priority::Prefetch) {
+            running->second.priority = Priority::Now;
+            --m_prefetching;
+        }
+        return;
+    }
+
+    auto queued = std::find_if(m_queue.begin(), m_queue.end(),
+                               [&](const Pending& p) { return p.entityId == entityId; });
+    if (queued != m_queue.end()) {
+        if (priority == Priority::Prefetch || queued->priority == Priority::Now) return;
+        m_queue.erase(queued);  // a prefetch the user now wants: move it up
+    } else if (m_failed.count(entityId)) {
+        if (priority == Priority::Prefetch) return;
+        m_failed.erase(entityId);
+    }
+
+    if (priority == Priority::Now)
+        m_queue.push_front({entityId, priority});
+    else
+        m_queue.push_back({entityId, priority});
+    startQueued();
+}
+
+void ThumbnailCache::prefetch(const std::vector<std::string>& entityIds)
+{
+    m_queue.erase(std::remove_if(m_queue.begin(), m_queue.end(),
+                                 [](const Pending& p) { return p.priority == Priority::Prefetch; }),
+                  m_queue.end());
+    std::unordered_set<std::string> wanted(entityIds.begin(), entityIds.end());
+    for (auto& [id, running] : m_loading)
+        if (running.priority == Priority::Prefetch && !wanted.count(id)) running.cancel->store(true);
+    for (const auto& id : entityIds) request(id, Priority::Prefetch);
+}
+
+void ThumbnailCache::poll()
+{
+    std::vector<Result> results;
+    {
+        std::lock_guard<std::mutex> lock(m_resultMutex);
+        results.swap(m_results);
+    }
+
+    for (auto& r : results) {
+        auto running = m_loading.find(r.entityId);
+        if (running == m_loading.end()) continue;
+        Running done = std::move(running->second);
+        m_loading.erase(running);
+        if (done.priority == Priority::Prefetch) --m_prefetching;
+        if (r.cancelled) {
+            ++m_stats.cancelled;
+            // Asked for again after the flag was checked: load it once more
+            if (!done.cancel->load()) {
+                if (done.priority == Priority::Now) m_queue.push_front({r.entityId, done.priority});
+                else m_queue.push_back({r.entityId, done.priority});
+            }
+            continue;
+        }
+        if (r.fromDisk) ++m_stats.diskHits;
+        else ++m_stats.fetches;
+        if (r.thumbnail) {
+            insert(r.entityId, std::move(r.thumbnail));
+        } else {
+            ++m_stats.failures;
+            m_failed.insert(r.entityId);
+        }
+    }
+
+    startQueued();
+}
+
+ThumbnailCache::State ThumbnailCache::state(const std::string& entityId) const
+{
+    if (m_entries.count(entityId)) return State::Ready;
+    if (m_loading.count(entityId)) return State::Loading;
+    for (const auto& p : m_queue)
+        if (p.entityId == entityId) return State::Queued;
+    if (m_failed.count(entityId)) return State::Failed;
+    return State::Missing;
+}
+
+void ThumbnailCache::cancelAndWait()
+{
+    m_queue.clear();
+    m_cancelled = true;
+
+    std::vector<Result> results;
+    {
+        std::unique_lock<std::mutex> lock(m_resultMutex);
+        m_resultCv.wait(lock, [this] { return m_outstanding == 0; });
+        results.swap(m_results);
+    }
+    m_cancelled = false;
+
+    // Keep what finished; a load cut short is not a failure
+    for (auto& r : results) {
+        m_loading.erase(r.entityId);
+        if (r.thumbnail) insert(r.entityId, std::move(r.thumbnail));
+    }
+    m_loading.clear();
+    m_prefetching = 0;
+}
+
+ThumbnailCache::Stats ThumbnailCache::stats() const
+{
+    Stats s = m_stats;
+    s.entries = m_entries.size();
+    s.bytes = m_bytes;
+    return s;
+}
+
+void ThumbnailCache::startQueued()
+{
+    while (m_loading.size() < m_config.maxConcurrent && !m_queue.empty()) {
+        // Requests are queued first; prefetches leave them a slot
+        if (m_queue.front().priority == Priority::Prefetch && m_config.maxConcurrent > 1 &&
+            m_prefetching + 1 >= m_config.maxConcurrent)
+            break;
+        Pending next = std::move(m_queue.front());
+        m_queue.pop_front();
+        if (m_entries.count(next.entityId) || m_loading.count(next.entityId)) continue;
+        start(next);
+    }
+}
+
+void ThumbnailCache::start(const Pending& pending)
+{
+    auto cancel = std::make_shared<std::atomic<bool>>(false);
+    m_loading[pending.entityId] = {pending.priority, cancel};
+    if (pending.priority == Priority::Prefetch) ++m_prefetching;
+    {
+        std::lock_guard<std::mutex> lock(m_resultMutex);
+        ++m_outstanding;
+    }
+    m_pool.submit([this, entityId = pending.entityId, fetcher = m_fetcher, maxWidth = m_maxWidth,
+                   cancel = std::move(cancel)] {
+        Result result = load(entityId, fetcher, maxWidth, *cancel);
+        std::lock_guard<std::mutex> lock(m_resultMutex);
+        m_results.push_back(std::move(result));
+        --m_outstanding;
+        m_resultCv.notify_all();  // under the lock: cancelAndWait may be waiting
+    });
+}
+
+ThumbnailCache::Result ThumbnailCache::load(const std::string& entityId, const Fetcher& fetcher,
+                                            int maxWidth, const std::atomic<bool>& cancel)
+{
+    Result result;
+    result.entityId = entityId;
+    if (m_cancelled) return result;
+    if (cancel) {
+        result.cancelled = true;
+        return result;
+    }
+
+    std::vector<uint8_t> bytes = m_store.get(entityId);
+    result.fromDisk = !bytes.empty();
+    if (bytes.empty() && fetcher) {
+        try {
+            auto pending = fetcher(entityId);
+            if (pending.valid()) bytes = pending.get();
+        } catch (const std::exception& e) {
+            std::cerr << "[THUMBS] fetch failed for " << entityId << ": " << e.what() << "\n";
+        }
+        m_store.put(entityId, bytes);
+    }
+    if (bytes.empty()) return result;
+    if (cancel) {
+        // Stored above, so asking again costs a disk read, not a fetch
+        result.cancelled = true;
+        return result;
+    }
+
+    auto thumbnail = std::make_shared<Thumbnail>();
+    if (!m_decode(bytes, *thumbnail) || thumbnail->rgba.empty()) {
+        std::cerr << "[THUMBS] cannot decode the thumbnail of " << entityId << "\n";
+        return result;
+    }
+    if (maxWidth > 0 && thumbnail->width > maxWidth) {
+        int height = ImageScale::fitHeight(thumbnail->width, thumbnail->height, maxWidth);
+        thumbnail->rgba = ImageScale::downscaleBox(thumbnail->rgba.data(), thumbnail->width,
+                                                   thumbnail->height, maxWidth, height);
+        thumbnail->width = maxWidth;
+        thumbnail->height = height;
+    }
+    result.thumbnail = std::move(thumbnail);
+    return result;
+}
+
+void ThumbnailCache::insert(const std::string& entityId, std::shared_ptr<const Thumbnail> thumbnail)
+{
+    auto it = m_entries.find(entityId);
+    if (it != m_entries.end()) {
+        m_bytes -= it->second.thumbnail->bytes();
+        m_lru.erase(it->second.lru);
+        m_entries.erase(it);
+    }
+
+    m_bytes += thumbnail->bytes();
+    m_lru.push_front(entityId);
+    m_entries[entityId] = {std::move(thumbnail), m_lru.begin()};
+
+    // Least recently used out first; the newest stays even if it alone is over
+    while (m_bytes > m_config.memoryBytes && m_lru.size() > 1) {
+        auto victim = m_entries.find(m_lru.back());
+        m_bytes -= victim->second.thumbnail->bytes();
+        m_entries.erase(victim);
+        m_lru.pop_back();
+    }
+}
@@ -0,0 +1,164 @@
+#pragma once
+
+#include "cache/ThumbnailStore.h"
+#include "core/ThreadPool.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+/// A decoded photo thumbnail, RGBA8.
+struct Thumbnail {
+    int width = 0;
+    int height = 0;
+    std::vector<uint8_t> rgba;
+
+    size_t bytes() const { return rgba.size(); }
+};
+
+/// Photo thumbnails for the details panel, in two tiers: decoded images in
+/// an LRU capped in bytes, over a ThumbnailStore on disk.
+///
+/// A load reads the disk store, else fetches from the backend and stores
+/// what arrives, then decodes and box-filters the image down to the
+/// display width — all on worker threads, at most
+/// maxConcurrent at a time.  Requests wait in a queue where the one the
+/// user asked for goes ahead of prefetches, and prefetches leave one of
+/// the slots free for it.  A new prefetch list cancels the prefetches it
+/// no longer names: queued ones at once, running ones before they decode
+/// (what they fetched is still stored on disk).  Everything but the
+/// workers runs on the main thread: request(), prefetch() and get(), with
+/// poll() once per frame.
+class ThumbnailCache {
+public:
+    /// Starts a non-blocking fetch of the encoded thumbnail; resolves to
+    /// empty bytes on failure.
+    using Fetcher = std::function<std::future<std::vector<uint8_t>>(const std::string& entityId)>;
+    /// Encoded image -> RGBA; false if it cannot be decoded.  Runs on the
+    /// worker threads.
+    using Decoder = std::function<bool(const std::vector<uint8_t>& encoded, Thumbnail& out)>;
+
+    struct Config {
+        size_t memoryBytes = 128u << 20;  ///< decoded RGBA kept in memory
+        size_t maxConcurrent = 4;         ///< loads in flight
+        std::string diskDir;              ///< ThumbnailStore directory; empty keeps nothing on disk
+        uint64_t diskBytes = ThumbnailStore::kDefaultMaxBytes;  ///< ThumbnailStore budget
+        int maxWidth = 0;                 ///< downscale wider images to this; 0 keeps full size
+    };
+
+    enum class Priority { Now, Prefetch };
+    enum class State { Missing, Queued, Loading, Ready, Failed };
+
+    struct Stats {
+        size_t entries = 0;
+        size_t bytes = 0;
+        uint64_t hits = 0;       ///< get() found it in memory
+        uint64_t misses = 0;
+        uint64_t diskHits = 0;   ///< loads served by the disk store
+        uint64_t fetches = 0;    ///< loads that went to the backend
+        uint64_t failures = 0;
+        uint64_t cancelled = 0;  ///< running prefetches dropped before decoding
+    };
+
+    ThumbnailCache(Decoder decode, Config config);
+    ~ThumbnailCache();
+
+    ThumbnailCache(const ThumbnailCache&) = delete;
+    ThumbnailCache& operator=(const ThumbnailCache&) = delete;
+
+    /// Replace the fetcher.  Call cancelAndWait() first if loads may be
+    /// running with the old one; with none set, only the disk store is read.
+    void setFetcher(Fetcher fetcher) { m_fetcher = std::move(fetcher); }
+
+    /// Width loads started from now on are downscaled to (0 keeps full
+    /// size).  Thumbnails already in memory keep theirs.
+    void setMaxWidth(int width) { m_maxWidth = width; }
+    int maxWidth() const { return m_maxWidth; }
+
+    /// The decoded thumbnail, if in memory (it becomes most recently used).
+    std::shared_ptr<const Thumbnail> get(const std::string& entityId);
+
+    /// Queue a load unless the thumbnail is in memory or on its way.  A
+    /// `Now` request also retries a thumbnail that failed before.
+    void request(const std::string& entityId, Priority priority = Priority::Now);
+
+    /// Make `entityIds` (nearest first) the prefetch queue: queued
+    /// prefetches not among them are cancelled.
+    void prefetch(const std::vector<std::string>& entityIds);
+
+    /// Main thread, once per frame: keep finished loads, start queued ones.
+    void poll();
+
+    State state(const std::string& entityId) const;
+
+    /// Drop everything queued and wait for running loads to finish.
+    void cancelAndWait();
+
+    Stats stats() const;
+
+    const Config& config() const { return m_config; }
+
+private:
+    struct Result {
+        std::string entityId;
+        std::shared_ptr<const Thumbnail> thumbnail;  ///< null if the load failed
+        bool fromDisk = false;
+        bool cancelled = false;  ///< dropped before decoding; not a failure
+    };
+
+    struct Entry {
+        std::shared_ptr<const Thumbnail> thumbnail;
+        std::list<std::string>::iterator lru;
+    };
+
+    struct Pending {
+        std::string entityId;
+        Priority priority;
+    };
+
+    struct Running {
+        Priority priority;
+        std::shared_ptr<std::atomic<bool>> cancel;  ///< set to drop the load before it decodes
+    };
+
+    void start(const Pending& pending);
+    Result load(const std::string& entityId, const Fetcher& fetcher, int maxWidth,
+                const std::atomic<bool>& cancel);
+    void insert(const std::string& entityId, std::shared_ptr<const Thumbnail> thumbnail);
+    void startQueued();
+
+    Decoder m_decode;
+    Config m_config;
+    Fetcher m_fetcher;
+    ThumbnailStore m_store;
+
+    // Main thread
+    std::unordered_map<std::string, Entry> m_entries;
+    std::list<std::string> m_lru;  ///< most recently used first
+    size_t m_bytes = 0;
+    std::deque<Pending> m_queue;
+    std::unordered_map<std::string, Running> m_loading;
+    size_t m_prefetching = 0;  ///< entries of m_loading with Prefetch priority
+    std::unordered_set<std::string> m_failed;
+    int m_maxWidth = 0;
+    Stats m_stats;
+
+    // Hand-off from the workers
+    std::mutex m_resultMutex;
+    std::condition_variable m_resultCv;
+    std::vector<Result> m_results;
+    size_t m_outstanding = 0;  ///< guarded by m_resultMutex
+    std::atomic<bool> m_cancelled{false};
+
+    // Declared last so it is joined before the members its tasks touch
+    ThreadPool m_pool;
+};
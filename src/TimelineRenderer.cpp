@@ -290,7 +290,7 @@ void TimelineRenderer::renderHistogram(const TimelineCamera& camera, const AppMo
     if (model.layers.empty() || model.layers[0].entities.empty()) return;
 
     TimeExtent visible = camera.getTimeExtent();
-    m_histogram.draw(camera.getTransform(), model.layers[0].entities,
+    m_histogram.draw(camera.getTransform(), model.layers[0].entities, model.layers[0].revision,
                      visible.start, visible.end, m_histogramBins);
 }
 
@@ -324,6 +324,11 @@ void TimelineRenderer::renderEntities(const TimelineCamera& camera, const AppMod
     float tMin = static_cast<float>(visible.start);
     float tMax = static_cast<float>(visible.end);
 
+    // Rows just outside the range still reach into it: a point's radius, and
+    // a float time_mid is off by up to 128 s at today's timestamps
+    double pad = 0.05 * (visible.end - visible.start) + 256.0;
+    TimeExtent padded{visible.start - pad, visible.end + pad};
+
     // geo_pos in VBOs is stored relative to kRefLon/kRefLat, so the mapExtent
     // bounds must use the same relative offset for the in-map/out-of-map test.
     PointRenderer::MapExtent mapExtent{
@@ -339,7 +344,7 @@ void TimelineRenderer::renderEntities(const TimelineCamera& camera, const AppMod
 
         // Calendar events use a dedicated rect renderer: per-entity color + duration width.
         if (layer.name == "calendar.event") {
-            m_calendar.draw(camera.getTransform(), layer.entities,
+            m_calendar.draw(camera.getTransform(), layer.entities, padded.start, padded.end,
                             layer.yOffset, camera.width());
             continue;
         }
@@ -347,10 +352,17 @@ void TimelineRenderer::renderEntities(const TimelineCamera& camera, const AppMod
         PointRenderer* pr = layerRenderers[li];
         if (!pr) continue;
 
-        size_t numChunks = (layer.entities.size() + PointRenderer::CHUNK_SIZE - 1)
-                           / PointRenderer::CHUNK_SIZE;
-
-        pr->drawForTimeline(camera.getTransform(), aspect, numChunks, tMin, tMax, mapExtent,
+        // Only the chunks holding the visible rows; an unsorted tail (not
+        // merged into time order yet) is drawn whole
+        const EntityStore& entities = layer.entities;
+        size_t numChunks = (entities.size() + PointRenderer::CHUNK_SIZE - 1) / PointRenderer::CHUNK_SIZE;
+        auto [first, last] = entities.timeRange(padded.start - entities.maxDuration(), padded.end);
+        size_t firstChunk = first / PointRenderer::CHUNK_SIZE;
+        size_t endChunk = entities.sortedByTime()
+                        ? (last + PointRenderer::CHUNK_SIZE - 1) / PointRenderer::CHUNK_SIZE
+                        : numChunks;
+
+        pr->drawForTimeline(camera.getTransform(), aspect, firstChunk, endChunk, tMin, tMax, mapExtent,
                             layer.colorMode,
                             layer.color.r, layer.color.g, layer.color.b, layer.color.a,
                             layer.yOffset, layer.shape);
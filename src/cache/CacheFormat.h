@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/// On-disk layout of an RKCF entity cache file (see doc/LOCAL_CACHE.md).
+///
+///     header        CacheHeader
+///     strings       UTF-8, referenced by (offset, length); no terminators
+///     records       entity_count x CacheEntity, sorted by (time_start, id),
+///                   starting on a 64-byte boundary
+///     buckets       bucket_count x CacheBucket, ascending bucket_start
+///
+/// All fields are little-endian and the structs are read in place from a
+/// memory map, so their layout is fixed by the static_asserts below.
+namespace CacheFormat {
+
+constexpr char kMagic[4] = {'R', 'K', 'C', 'F'};
+constexpr uint32_t kVersion = 1;
+constexpr int kDefaultBucketSeconds = 86400;
+constexpr size_t kRecordAlignment = 64;
+
+enum EntityFlag : uint32_t {
+    kHasLocation = 1u << 0,
+    kHasName     = 1u << 1,
+    kHasColor    = 1u << 2,
+};
+
+} // namespace CacheFormat
+
+struct CacheHeader {
+    char     magic[4];              // "RKCF"
+    uint32_t version;               // CacheFormat::kVersion
+    char     entity_type[32];       // NUL-padded, e.g. "location.gps"
+    uint64_t entity_count;
+    uint64_t string_table_offset;
+    uint64_t string_table_size;
+    uint64_t entity_offset;
+    uint64_t bucket_index_offset;
+    uint32_t bucket_count;
+    uint32_t bucket_seconds;        // bucket duration used for the index
+    uint8_t  reserved[8];
+};
+static_assert(sizeof(CacheHeader) == 96, "CacheHeader layout changed");
+
+struct CacheEntity {
+    double   time_start;
+    double   time_end;
+    float    lat;                   // NaN if absent
+    float    lon;                   // NaN if absent
+    float    render_offset;
+    uint32_t flags;                 // CacheFormat::EntityFlag
+    uint32_t id_offset;
+    uint16_t id_length;
+    uint32_t name_offset;           // valid if kHasName
+    uint16_t name_length;
+    uint32_t color_offset;          // valid if kHasColor
+    uint16_t color_length;
+    uint32_t padding;
+};
+static_assert(sizeof(CacheEntity) == 64, "CacheEntity must stay one cache line");
+
+struct CacheBucket {
+    double   bucket_start;          // unix seconds, a multiple of bucket_seconds
+    uint32_t entity_start_idx;
+    uint32_t entity_count;
+    uint64_t hash;                  // server bucket hash; 0 = unknown
+};
+static_assert(sizeof(CacheBucket) == 24, "CacheBucket layout changed");
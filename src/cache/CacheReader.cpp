@@ -0,0 +1,205 @@
+#include "CacheReader.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+[[noreturn]] void corrupt(const std::string& path, const char* what)
+{
+    throw std::runtime_error("Cache file " + path + " is invalid: " + what);
+}
+
+} // namespace
+
+CacheReader::CacheReader(const std::string& path)
+{
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                              OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) throw std::runtime_error("Cannot open cache file " + path);
+    m_file = file;
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+        CloseHandle(file);
+        corrupt(path, "empty");
+    }
+    m_size = static_cast<size_t>(size.QuadPart);
+    m_mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    m_data = m_mapping ? MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    if (!m_data) {
+        if (m_mapping) CloseHandle(m_mapping);
+        CloseHandle(file);
+        throw std::runtime_error("Cannot map cache file " + path);
+    }
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) throw std::runtime_error("Cannot open cache file " + path);
+    struct stat st{};
+    if (::fstat(fd, &st) != 0 || st.st_size == 0) {
+        ::close(fd);
+        corrupt(path, "empty");
+    }
+    m_size = static_cast<size_t>(st.st_size);
+    void* data = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);  // the mapping keeps the file alive
+    if (data == MAP_FAILED) throw std::runtime_error("Cannot map cache file " + path);
+    m_data = data;
+    // Bulk loads walk the records front to back
+    ::madvise(m_data, m_size, MADV_SEQUENTIAL);
+    ::madvise(m_data, m_size, MADV_WILLNEED);
+#endif
+
+    try {
+        const char* base = static_cast<const char*>(m_data);
+        if (m_size < sizeof(CacheHeader)) corrupt(path, "truncated header");
+        m_header = reinterpret_cast<const CacheHeader*>(base);
+        const CacheHeader& h = *m_header;
+        if (std::memcmp(h.magic, CacheFormat::kMagic, sizeof(h.magic)) != 0) corrupt(path, "bad magic");
+        if (h.version != CacheFormat::kVersion) corrupt(path, "unsupported version");
+        if (std::memchr(h.entity_type, '\0', sizeof(h.entity_type)) == nullptr) corrupt(path, "entity type");
+
+        auto within = [this](uint64_t offset, uint64_t bytes) {
+            return offset <= m_size && bytes <= m_size - offset;
+        };
+        if (!within(h.string_table_offset, h.string_table_size)) corrupt(path, "string table out of range");
+        if (h.entity_offset % alignof(CacheEntity) != 0 ||
+            h.entity_count > m_size / sizeof(CacheEntity) ||
+            !within(h.entity_offset, h.entity_count * sizeof(CacheEntity)))
+            corrupt(path, "records out of range");
+        if (h.bucket_index_offset % alignof(CacheBucket) != 0 ||
+            !within(h.bucket_index_offset, uint64_t(h.bucket_count) * sizeof(CacheBucket)))
+            corrupt(path, "bucket index out of range");
+
+        m_strings = base + h.string_table_offset;
+        m_records = reinterpret_cast<const CacheEntity*>(base + h.entity_offset);
+        m_buckets = reinterpret_cast<const CacheBucket*>(base + h.bucket_index_offset);
+        for (size_t i = 0; i < h.bucket_count; ++i) {
+            if (uint64_t(m_buckets[i].entity_start_idx) + m_buckets[i].entity_count > h.entity_count)
+                corrupt(path, "bucket past the last record");
+        }
+    } catch (...) {
+        unmap();
+        throw;
+    }
+}
+
+CacheReader::~CacheReader()
+{
+    unmap();
+}
+
+void CacheReader::unmap()
+{
+    if (!m_data) return;
+#ifdef _WIN32
+    UnmapViewOfFile(m_data);
+    CloseHandle(m_mapping);
+    CloseHandle(m_file);
+#else
+    ::munmap(m_data, m_size);
+#endif
+    m_data = nullptr;
+}
+
+std::string CacheReader::entityType() const
+{
+    return std::string(m_header->entity_type);
+}
+
+std::string_view CacheReader::string(uint32_t offset, uint16_t length) const
+{
+    if (uint64_t(offset) + length > m_header->string_table_size)
+        throw std::runtime_error("Cache record references a string outside the table");
+    return std::string_view(m_strings + offset, length);
+}
+
+size_t CacheReader::lowerBound(double t) const
+{
+    const CacheEntity* end = m_records + size();
+    return static_cast<size_t>(std::lower_bound(m_records, end, t,
+        [](const CacheEntity& r, double v) { return r.time_start < v; }) - m_records);
+}
+
+Entity CacheReader::entity(size_t index) const
+{
+    const CacheEntity& r = m_records[index];
+    Entity e;
+    e.id = string(r.id_offset, r.id_length);
+    e.time_start = r.time_start;
+    e.time_end = r.time_end;
+    if (!std::isnan(r.lat)) e.lat = r.lat;
+    if (!std::isnan(r.lon)) e.lon = r.lon;
+    if (r.flags & CacheFormat::kHasName) e.name = std::string(string(r.name_offset, r.name_length));
+    if (r.flags & CacheFormat::kHasColor) e.color = std::string(string(r.color_offset, r.color_length));
+    e.render_offset = r.render_offset;
+    return e;
+}
+
+std::vector<std::vector<Entity>> CacheReader::readBatches(size_t begin, size_t end, size_t batchRows,
+                                                          unsigned threads,
+                                                          const std::atomic<bool>* cancelled) const
+{
+    end = std::min(end, size());
+    if (begin >= end) return {};
+    if (batchRows == 0) batchRows = end - begin;
+
+    size_t batchCount = (end - begin + batchRows - 1) / batchRows;
+    std::vector<std::vector<Entity>> batches(batchCount);
+
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    threads = static_cast<unsigned>(std::min<size_t>(threads, batchCount));
+
+    // Workers claim whole batches, so each output vector has one writer
+    std::atomic<size_t> next{0};
+    std::mutex errorMutex;
+    std::exception_ptr error;
+    auto work = [&] {
+        for (;;) {
+            size_t b = next.fetch_add(1);
+            if (b >= batchCount || (cancelled && cancelled->load())) return;
+            size_t first = begin + b * batchRows;
+            size_t last = std::min(end, first + batchRows);
+            try {
+                auto& out = batches[b];
+                out.reserve(last - first);
+                for (size_t i = first; i < last; ++i) out.push_back(entity(i));
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(errorMutex);
+                if (!error) error = std::current_exception();
+                next = batchCount;  // stop the others
+                return;
+            }
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (unsigned t = 1; t < threads; ++t) pool.emplace_back(work);
+    work();
+    for (auto& t : pool) t.join();
+
+    if (error) std::rethrow_exception(error);
+    if (cancelled && cancelled->load()) {
+        // Keep the leading run of finished batches so callers see a prefix
+        size_t done = 0;
+        while (done < batchCount && batches[done].size() == std::min(batchRows, end - begin - done * batchRows))
+            ++done;
+        batches.resize(done);
+    }
+    return batches;
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "cache/CacheFormat.h"
+#include "core/Entity.h"
+#include <atomic>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/// Read-only view of an RKCF cache file through a memory map.
+///
+/// Opening validates the header and section bounds only; nothing is copied.
+/// Records are turned into Entity objects on demand, in parallel for bulk
+/// loads, and every string reference is bounds-checked on the way.
+class CacheReader {
+public:
+    /// @throws std::runtime_error if the file is missing, truncated, or not
+    ///         an RKCF file of a supported version
+    explicit CacheReader(const std::string& path);
+    ~CacheReader();
+
+    CacheReader(const CacheReader&) = delete;
+    CacheReader& operator=(const CacheReader&) = delete;
+
+    const CacheHeader& header() const { return *m_header; }
+    std::string entityType() const;
+
+    size_t size() const { return static_cast<size_t>(m_header->entity_count); }
+    const CacheEntity* records() const { return m_records; }
+
+    size_t bucketCount() const { return m_header->bucket_count; }
+    const CacheBucket* buckets() const { return m_buckets; }
+
+    /// Index of the first record with time_start >= t.
+    size_t lowerBound(double t) const;
+
+    /// A string table entry (id, name or color of a record).
+    /// @throws std::runtime_error if it lies outside the table
+    std::string_view string(uint32_t offset, uint16_t length) const;
+
+    /// Convert one record.
+    /// @throws std::runtime_error on a string reference outside the table
+    Entity entity(size_t index) const;
+
+    /// Convert records [begin, end) into batches of at most batchRows, in
+    /// record order, using up to `threads` workers (0 = hardware threads).
+    /// Returns early with what it has if `cancelled` becomes true.
+    /// @throws std::runtime_error on a corrupt record
+    std::vector<std::vector<Entity>> readBatches(size_t begin, size_t end, size_t batchRows,
+                                                 unsigned threads = 0,
+                                                 const std::atomic<bool>* cancelled = nullptr) const;
+
+private:
+    void unmap();
+
+    void* m_data = nullptr;
+    size_t m_size = 0;
+#ifdef _WIN32
+    void* m_file = nullptr;
+    void* m_mapping = nullptr;
+#endif
+    const CacheHeader* m_header = nullptr;
+    const char* m_strings = nullptr;
+    const CacheEntity* m_records = nullptr;
+    const CacheBucket* m_buckets = nullptr;
+};
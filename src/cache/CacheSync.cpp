@@ -0,0 +1,153 @@
+#include "CacheSync.h"
+#include "CacheReader.h"
+#include "CacheWriter.h"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    /// Append [start, end) to ascending ranges, merging it into the last one
+    /// when they touch.
+    void appendRange(std::vector<TimeExtent>& ranges, double start, double end)
+    {
+        if (!ranges.empty() && ranges.back().end >= start)
+            ranges.back().end = std::max(ranges.back().end, end);
+        else
+            ranges.push_back({start, end});
+    }
+
+    /// Whether t lies in one of the ascending, disjoint half-open ranges.
+    bool inRanges(const std::vector<TimeExtent>& ranges, double t)
+    {
+        auto it = std::upper_bound(ranges.begin(), ranges.end(), t,
+                                   [](double v, const TimeExtent& r) { return v < r.start; });
+        return it != ranges.begin() && t < std::prev(it)->end;
+    }
+}
+
+CacheSync::Plan CacheSync::plan(const CacheReader& local, const std::vector<BucketSummary>& server)
+{
+    std::unordered_map<double, const CacheBucket*> localBuckets;
+    for (size_t i = 0; i < local.bucketCount(); ++i)
+        localBuckets[local.buckets()[i].bucket_start] = &local.buckets()[i];
+
+    std::vector<BucketSummary> sorted = server;
+    std::sort(sorted.begin(), sorted.end(),
+              [](const BucketSummary& a, const BucketSummary& b) { return a.start < b.start; });
+
+    Plan plan;
+    std::unordered_set<double> onServer;
+    for (const auto& s : sorted) {
+        onServer.insert(s.start);
+        auto it = localBuckets.find(s.start);
+        bool current = it != localBuckets.end() && it->second->hash != 0 &&
+                       it->second->hash == s.hash && it->second->entity_count == s.count;
+        if (current) continue;
+        appendRange(plan.fetch, s.start, s.end);
+        ++plan.fetchBuckets;
+    }
+
+    double width = local.header().bucket_seconds;
+    for (size_t i = 0; i < local.bucketCount(); ++i) {
+        double start = local.buckets()[i].bucket_start;
+        if (onServer.count(start)) continue;
+        appendRange(plan.drop, start, start + width);
+        ++plan.dropBuckets;
+    }
+    return plan;
+}
+
+CacheSync::Result CacheSync::sync(const std::string& cachePath, const std::string& entityType,
+                                  Backend& upstream, const std::atomic<bool>* cancelled)
+{
+    auto t0 = Clock::now();
+    auto elapsed = [t0] { return std::chrono::duration<double>(Clock::now() - t0).count(); };
+    auto isCancelled = [cancelled] { return cancelled && cancelled->load(); };
+
+    Result result;
+    try {
+        auto reader = std::make_unique<CacheReader>(cachePath);
+        if (reader->entityType() != entityType) {
+            std::cerr << "[CACHE] " << cachePath << " holds '" << reader->entityType()
+                      << "', expected '" << entityType << "'; not syncing it\n";
+            return result;
+        }
+        const int bucketSeconds = static_cast<int>(reader->header().bucket_seconds);
+
+        auto summaries = upstream.fetchBucketSummaries(bucketSeconds);
+        if (!summaries) {
+            std::cerr << "[CACHE] " << entityType << ": no bucket summaries from the server; "
+                      << "keeping the cache as-is\n";
+            return result;
+        }
+        result.bucketsChecked = summaries->size();
+
+        Plan plan = CacheSync::plan(*reader, *summaries);
+        if (plan.empty()) {
+            result.ok = true;
+            result.seconds = elapsed();
+            std::cerr << "[CACHE] " << entityType << ": all " << result.bucketsChecked
+                      << " buckets current\n";
+            return result;
+        }
+
+        std::vector<Entity> fetched;
+        if (!plan.fetch.empty()) {
+            bool complete = upstream.streamBuckets(plan.fetch, [&](std::vector<Entity>&& batch) {
+                for (auto& e : batch)
+                    if (inRanges(plan.fetch, e.time_start)) fetched.push_back(std::move(e));
+            });
+            if (!complete || isCancelled()) {
+                std::cerr << "[CACHE] " << entityType << ": bucket fetch incomplete; "
+                          << "keeping the cache as-is\n";
+                return result;
+            }
+        }
+
+        std::vector<TimeExtent> replaced;
+        {
+            std::vector<TimeExtent> all = plan.fetch;
+            all.insert(all.end(), plan.drop.begin(), plan.drop.end());
+            std::sort(all.begin(), all.end(),
+                      [](const TimeExtent& a, const TimeExtent& b) { return a.start < b.start; });
+            for (const auto& r : all) appendRange(replaced, r.start, r.end);
+        }
+
+        // Unchanged buckets are copied record by record; nothing is converted
+        CacheWriter writer(entityType, bucketSeconds);
+        for (size_t i = 0; i < reader->bucketCount(); ++i) {
+            const CacheBucket& b = reader->buckets()[i];
+            if (!inRanges(replaced, b.bucket_start))
+                writer.add(*reader, b.entity_start_idx, size_t(b.entity_start_idx) + b.entity_count);
+        }
+        writer.add(fetched);
+
+        for (const auto& s : *summaries) writer.setBucketHash(s.start, s.hash, s.count);
+
+        // Unmapped before the rename; Windows cannot replace a mapped file
+        reader.reset();
+        if (isCancelled()) return result;
+        writer.finish(cachePath);
+
+        result.ok = true;
+        result.bucketsFetched = plan.fetchBuckets;
+        result.bucketsDropped = plan.dropBuckets;
+        result.replaced = std::move(replaced);
+        result.entities = std::move(fetched);
+        result.seconds = elapsed();
+        std::cerr << "[CACHE] " << entityType << ": synced " << result.bucketsFetched << " of "
+                  << result.bucketsChecked << " buckets (" << result.entities.size() << " entities, "
+                  << result.bucketsDropped << " dropped) in "
+                  << static_cast<long>(result.seconds * 1000.0) << "ms\n";
+    } catch (const std::exception& e) {
+        std::cerr << "[CACHE] sync of " << cachePath << " failed: " << e.what() << "\n";
+        result = Result{};
+    }
+    return result;
+}
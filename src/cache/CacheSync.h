@@ -0,0 +1,51 @@
+#pragma once
+
+#include "Backend.h"
+#include "core/TimeExtent.h"
+#include <atomic>
+#include <string>
+#include <vector>
+
+class CacheReader;
+
+/// Incremental sync of an RKCF cache file with its upstream backend
+/// (doc/LOCAL_CACHE.md, "Client Sync Algorithm").
+///
+/// The bucket index of the file is compared with the server's bucket
+/// summaries; only buckets that are new, changed, or gone are fetched or
+/// dropped, and the file is rewritten with the unchanged records copied
+/// across as-is.  The file is replaced only when every stale bucket arrived.
+class CacheSync {
+public:
+    /// What differs between a cache file and the server.
+    struct Plan {
+        std::vector<TimeExtent> fetch;  ///< coalesced ranges to re-fetch (half-open)
+        std::vector<TimeExtent> drop;   ///< coalesced ranges the server no longer has
+        size_t fetchBuckets = 0;
+        size_t dropBuckets = 0;
+
+        bool empty() const { return fetch.empty() && drop.empty(); }
+    };
+
+    struct Result {
+        bool ok = false;               ///< the file now matches the summaries
+        size_t bucketsChecked = 0;     ///< buckets listed by the server
+        size_t bucketsFetched = 0;
+        size_t bucketsDropped = 0;
+        /// Ranges whose content changed, coalesced and ascending; a layer
+        /// holding the old data drops these and adds `entities`
+        std::vector<TimeExtent> replaced;
+        std::vector<Entity> entities;  ///< current content of `replaced`
+        double seconds = 0.0;
+    };
+
+    /// A local bucket is stale when the server's count or hash differs or
+    /// its hash is unknown (0); server buckets missing locally are fetched,
+    /// and local buckets missing on the server are dropped.
+    static Plan plan(const CacheReader& local, const std::vector<BucketSummary>& server);
+
+    /// Sync `cachePath` (which must hold `entityType`) with `upstream`.
+    /// Never throws; failures are logged and leave the file untouched.
+    static Result sync(const std::string& cachePath, const std::string& entityType,
+                       Backend& upstream, const std::atomic<bool>* cancelled = nullptr);
+};
@@ -0,0 +1,154 @@
+#include "CacheWriter.h"
+#include "CacheReader.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <limits>
+#include <stdexcept>
+#include <string_view>
+
+CacheWriter::CacheWriter(std::string entityType, int bucketSeconds)
+    : m_entityType(std::move(entityType))
+    , m_bucketSeconds(bucketSeconds > 0 ? bucketSeconds : CacheFormat::kDefaultBucketSeconds)
+{
+    if (m_entityType.size() >= sizeof(CacheHeader::entity_type))
+        throw std::invalid_argument("Cache entity type too long: " + m_entityType);
+}
+
+uint32_t CacheWriter::addString(std::string_view s, uint16_t& length)
+{
+    if (s.size() > std::numeric_limits<uint16_t>::max())
+        throw std::runtime_error("Cache string too long (" + std::to_string(s.size()) + " bytes)");
+    if (m_strings.size() + s.size() > std::numeric_limits<uint32_t>::max())
+        throw std::runtime_error("Cache string table exceeds 4 GB");
+    auto offset = static_cast<uint32_t>(m_strings.size());
+    m_strings += s;
+    length = static_cast<uint16_t>(s.size());
+    return offset;
+}
+
+void CacheWriter::add(const Entity& e)
+{
+    constexpr float nan = std::numeric_limits<float>::quiet_NaN();
+    CacheEntity r{};
+    r.time_start = e.time_start;
+    r.time_end = e.time_end;
+    r.lat = e.lat ? static_cast<float>(*e.lat) : nan;
+    r.lon = e.lon ? static_cast<float>(*e.lon) : nan;
+    r.render_offset = e.render_offset;
+    if (e.has_location()) r.flags |= CacheFormat::kHasLocation;
+    r.id_offset = addString(e.id, r.id_length);
+    if (e.name) {
+        r.flags |= CacheFormat::kHasName;
+        r.name_offset = addString(*e.name, r.name_length);
+    }
+    if (e.color) {
+        r.flags |= CacheFormat::kHasColor;
+        r.color_offset = addString(*e.color, r.color_length);
+    }
+    m_records.push_back(r);
+}
+
+void CacheWriter::add(const std::vector<Entity>& batch)
+{
+    m_records.reserve(m_records.size() + batch.size());
+    for (const auto& e : batch) add(e);
+}
+
+void CacheWriter::add(const CacheReader& reader, size_t begin, size_t end)
+{
+    end = std::min(end, reader.size());
+    if (begin >= end) return;
+    m_records.reserve(m_records.size() + (end - begin));
+    for (size_t i = begin; i < end; ++i) {
+        CacheEntity r = reader.records()[i];
+        r.id_offset = addString(reader.string(r.id_offset, r.id_length), r.id_length);
+        if (r.flags & CacheFormat::kHasName)
+            r.name_offset = addString(reader.string(r.name_offset, r.name_length), r.name_length);
+        if (r.flags & CacheFormat::kHasColor)
+            r.color_offset = addString(reader.string(r.color_offset, r.color_length), r.color_length);
+        m_records.push_back(r);
+    }
+}
+
+void CacheWriter::finish(const std::string& path)
+{
+    // Same order as the server's bucket hashes: (t_start, id)
+    auto idOf = [this](const CacheEntity& r) {
+        return std::string_view(m_strings.data() + r.id_offset, r.id_length);
+    };
+    std::stable_sort(m_records.begin(), m_records.end(), [&](const CacheEntity& a, const CacheEntity& b) {
+        if (a.time_start != b.time_start) return a.time_start < b.time_start;
+        return idOf(a) < idOf(b);
+    });
+
+    if (m_records.size() > std::numeric_limits<uint32_t>::max())
+        throw std::runtime_error("Cache holds more records than its bucket index can address");
+
+    std::vector<CacheBucket> buckets;
+    for (size_t i = 0; i < m_records.size(); ++i) {
+        double start = std::floor(m_records[i].time_start / m_bucketSeconds) * m_bucketSeconds;
+        if (buckets.empty() || buckets.back().bucket_start != start)
+            buckets.push_back({start, static_cast<uint32_t>(i), 0, 0});
+        ++buckets.back().entity_count;
+    }
+    for (auto& bucket : buckets) {
+        auto it = m_bucketHashes.find(bucket.bucket_start);
+        if (it != m_bucketHashes.end() && it->second.second == bucket.entity_count)
+            bucket.hash = it->second.first;
+    }
+
+    CacheHeader header{};
+    std::memcpy(header.magic, CacheFormat::kMagic, sizeof(header.magic));
+    header.version = CacheFormat::kVersion;
+    std::memcpy(header.entity_type, m_entityType.data(), m_entityType.size());
+    header.entity_count = m_records.size();
+    header.string_table_offset = sizeof(CacheHeader);
+    header.string_table_size = m_strings.size();
+    size_t align = CacheFormat::kRecordAlignment;
+    header.entity_offset = (header.string_table_offset + m_strings.size() + align - 1) / align * align;
+    header.bucket_index_offset = header.entity_offset + m_records.size() * sizeof(CacheEntity);
+    header.bucket_count = static_cast<uint32_t>(buckets.size());
+    header.bucket_seconds = static_cast<uint32_t>(m_bucketSeconds);
+
+    namespace fs = std::filesystem;
+    fs::path target(path);
+    std::error_code ec;
+    if (target.has_parent_path()) fs::create_directories(target.parent_path(), ec);
+
+    // Written to a sibling and renamed, so a crash never leaves a torn cache
+    std::string tmp = path + ".tmp";
+    FILE* f = std::fopen(tmp.c_str(), "wb");
+    if (!f) throw std::runtime_error("Cannot create cache file " + tmp);
+
+    static const char zeros[CacheFormat::kRecordAlignment] = {};
+    size_t pad = header.entity_offset - header.string_table_offset - m_strings.size();
+    bool ok = std::fwrite(&header, sizeof(header), 1, f) == 1 &&
+              std::fwrite(m_strings.data(), 1, m_strings.size(), f) == m_strings.size() &&
+              std::fwrite(zeros, 1, pad, f) == pad &&
+              std::fwrite(m_records.data(), sizeof(CacheEntity), m_records.size(), f) == m_records.size() &&
+              std::fwrite(buckets.data(), sizeof(CacheBucket), buckets.size(), f) == buckets.size();
+    ok = (std::fclose(f) == 0) && ok;
+    if (!ok) {
+        fs::remove(tmp, ec);
+        throw std::runtime_error("Failed writing cache file " + tmp);
+    }
+
+    fs::rename(tmp, target, ec);
+    if (ec) {
+        fs::remove(tmp, ec);
+        throw std::runtime_error("Cannot replace cache file " + path + ": " + ec.message());
+    }
+}
+
+void CacheWriter::write(const std::string& path,
+                        const std::string& entityType,
+                        const std::vector<Entity>& entities,
+                        int bucketSeconds)
+{
+    CacheWriter writer(entityType, bucketSeconds);
+    writer.add(entities);
+    writer.finish(path);
+}
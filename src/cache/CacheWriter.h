@@ -0,0 +1,60 @@
+#pragma once
+
+#include "cache/CacheFormat.h"
+#include "core/Entity.h"
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+class CacheReader;
+
+/// Builds an RKCF cache file for one entity type.
+///
+/// Entities are packed into records and a string table as they are added,
+/// so a streaming load can feed batches straight in without keeping a
+/// second copy of every Entity.  finish() sorts, builds the bucket index and
+/// writes to a temporary file that is renamed over `path` only on success.
+class CacheWriter {
+public:
+    explicit CacheWriter(std::string entityType,
+                         int bucketSeconds = CacheFormat::kDefaultBucketSeconds);
+
+    void add(const Entity& e);
+    void add(const std::vector<Entity>& batch);
+
+    /// Copy records [begin, end) of an existing cache as they are, without
+    /// converting them to entities.
+    /// @throws std::runtime_error on a corrupt string reference
+    void add(const CacheReader& reader, size_t begin, size_t end);
+
+    /// Record the server's hash for the bucket starting at `bucketStart`.
+    /// It is written only if the bucket ends up with `count` records, so a
+    /// bucket that changed while it was being fetched stays at hash 0
+    /// (unknown) and is fetched again by the next sync.
+    void setBucketHash(double bucketStart, uint64_t hash, size_t count) {
+        m_bucketHashes[bucketStart] = {hash, count};
+    }
+
+    size_t size() const { return m_records.size(); }
+
+    /// @throws std::runtime_error if the file cannot be written
+    void finish(const std::string& path);
+
+    /// One-shot convenience: add everything, then finish().
+    static void write(const std::string& path,
+                      const std::string& entityType,
+                      const std::vector<Entity>& entities,
+                      int bucketSeconds = CacheFormat::kDefaultBucketSeconds);
+
+private:
+    /// Append to the string table; returns the offset.
+    uint32_t addString(std::string_view s, uint16_t& length);
+
+    std::string m_entityType;
+    int m_bucketSeconds;
+    std::vector<CacheEntity> m_records;
+    std::string m_strings;
+    std::unordered_map<double, std::pair<uint64_t, size_t>> m_bucketHashes;  ///< start -> (hash, count)
+};
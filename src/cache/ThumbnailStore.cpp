@@ -0,0 +1,271 @@
+#include "ThumbnailStore.h"
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+/// Index lines below which the index is never rewritten
+constexpr size_t kMinCompactLines = 1024;
+
+} // namespace
+
+ThumbnailStore::ThumbnailStore(std::string dir, uint64_t maxBytes)
+    : m_dir(std::move(dir))
+    , m_maxBytes(maxBytes)
+{
+    if (m_dir.empty()) return;
+
+    std::error_code ec;
+    fs::create_directories(m_dir + "/objects", ec);
+    if (ec) {
+        std::cerr << "[THUMBS] cannot create " << m_dir << ": " << ec.message() << "\n";
+        return;
+    }
+
+    scanObjects();
+    size_t lines = loadIndex();
+    removeFiles(evict());
+
+    // Ids whose object is gone would only miss
+    for (auto it = m_index.begin(); it != m_index.end();) {
+        if (m_objects.count(it->second)) ++it;
+        else it = m_index.erase(it);
+    }
+    if (lines >= kMinCompactLines && lines > 2 * m_index.size()) rewriteIndex();
+}
+
+void ThumbnailStore::scanObjects()
+{
+    struct Found {
+        fs::file_time_type used;
+        uint64_t hash;
+        uint64_t bytes;
+    };
+    std::vector<Found> found;
+
+    std::error_code ec;
+    fs::recursive_directory_iterator it(m_dir + "/objects", ec), end;
+    for (; !ec && it != end; it.increment(ec)) {
+        if (!it->is_regular_file(ec)) continue;
+        std::string name = it->path().filename().string();
+        uint64_t hash = 0;
+        if (name.size() != 16 || std::sscanf(name.c_str(), "%16" SCNx64, &hash) != 1) {
+            // A sibling left behind by a crash mid-write
+            if (name.find(".tmp") != std::string::npos) fs::remove(it->path(), ec);
+            continue;
+        }
+        auto used = it->last_write_time(ec);
+        auto bytes = it->file_size(ec);
+        if (!ec) found.push_back({used, hash, bytes});
+        ec.clear();
+    }
+
+    std::sort(found.begin(), found.end(),
+              [](const Found& a, const Found& b) { return a.used > b.used; });
+    for (const auto& f : found) {
+        m_lru.push_back(f.hash);
+        m_objects[f.hash] = {f.bytes, std::prev(m_lru.end())};
+        m_bytes += f.bytes;
+    }
+}
+
+size_t ThumbnailStore::loadIndex()
+{
+    // One "<16 hex digits> <entity id>" line per put
+    std::ifstream in(indexPath());
+    std::string line;
+    size_t lines = 0;
+    while (std::getline(in, line)) {
+        ++lines;
+        if (line.size() < 18 || line[16] != ' ') continue;
+        uint64_t hash = 0;
+        if (std::sscanf(line.c_str(), "%16" SCNx64, &hash) != 1) continue;
+        m_index[line.substr(17)] = hash;
+    }
+    return lines;
+}
+
+void ThumbnailStore::rewriteIndex()
+{
+    std::string tmp = indexPath() + ".tmp";
+    bool ok;
+    {
+        std::ofstream out(tmp, std::ios::trunc);
+        char prefix[18];
+        for (const auto& [id, hash] : m_index) {
+            std::snprintf(prefix, sizeof(prefix), "%016" PRIx64 " ", hash);
+            out << prefix << id << "\n";
+        }
+        out.flush();
+        ok = static_cast<bool>(out);
+    }
+    std::error_code ec;
+    if (ok) fs::rename(tmp, indexPath(), ec);
+    if (!ok || ec) {
+        fs::remove(tmp, ec);
+        std::cerr << "[THUMBS] cannot rewrite " << indexPath() << "\n";
+    }
+}
+
+void ThumbnailStore::touch(uint64_t hash, uint64_t bytes)
+{
+    auto it = m_objects.find(hash);
+    if (it != m_objects.end()) {
+        m_lru.splice(m_lru.begin(), m_lru, it->second.lru);
+        return;
+    }
+    m_lru.push_front(hash);
+    m_objects[hash] = {bytes, m_lru.begin()};
+    m_bytes += bytes;
+}
+
+std::vector<std::string> ThumbnailStore::evict()
+{
+    // Ids pointing at an evicted object stay indexed until looked up
+    std::vector<std::string> victims;
+    while (m_bytes > m_maxBytes && m_lru.size() > 1) {
+        auto it = m_objects.find(m_lru.back());
+        m_bytes -= it->second.bytes;
+        victims.push_back(objectPath(it->first));
+        m_objects.erase(it);
+        m_lru.pop_back();
+    }
+    return victims;
+}
+
+void ThumbnailStore::removeFiles(const std::vector<std::string>& paths)
+{
+    std::error_code ec;
+    for (const auto& path : paths) fs::remove(path, ec);
+}
+
+uint64_t ThumbnailStore::contentHash(const std::vector<uint8_t>& bytes)
+{
+    uint64_t h = 0xcbf29ce484222325ull;
+    for (uint8_t b : bytes) {
+        h ^= b;
+        h *= 0x100000001b3ull;
+    }
+    return h;
+}
+
+std::string ThumbnailStore::objectPath(uint64_t hash) const
+{
+    char name[17];
+    std::snprintf(name, sizeof(name), "%016" PRIx64, hash);
+    return m_dir + "/objects/" + std::string(name, 2) + "/" + name;
+}
+
+std::vector<uint8_t> ThumbnailStore::get(const std::string& entityId)
+{
+    uint64_t hash;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_index.find(entityId);
+        if (it == m_index.end()) return {};
+        if (!m_objects.count(it->second)) {
+            m_index.erase(it);  // evicted
+            return {};
+        }
+        hash = it->second;
+    }
+
+    std::string path = objectPath(hash);
+    std::vector<uint8_t> bytes;
+    if (FILE* f = std::fopen(path.c_str(), "rb")) {
+        std::error_code ec;
+        auto size = fs::file_size(path, ec);
+        if (!ec) {
+            bytes.resize(static_cast<size_t>(size));
+            if (std::fread(bytes.data(), 1, bytes.size(), f) != bytes.size()) bytes.clear();
+        }
+        std::fclose(f);
+    }
+
+    std::error_code ec;
+    if (!bytes.empty() && contentHash(bytes) == hash) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            auto it = m_objects.find(hash);
+            if (it != m_objects.end()) m_lru.splice(m_lru.begin(), m_lru, it->second.lru);
+        }
+        // The use is remembered in the mtime for the next session's order
+        fs::last_write_time(path, fs::file_time_type::clock::now(), ec);
+        return bytes;
+    }
+
+    // Missing or damaged: forget it so the caller fetches it again
+    fs::remove(path, ec);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_index.erase(entityId);
+    auto it = m_objects.find(hash);
+    if (it != m_objects.end()) {
+        m_bytes -= it->second.bytes;
+        m_lru.erase(it->second.lru);
+        m_objects.erase(it);
+    }
+    return {};
+}
+
+void ThumbnailStore::put(const std::string& entityId, const std::vector<uint8_t>& bytes)
+{
+    if (m_dir.empty() || bytes.empty()) return;
+
+    uint64_t hash = contentHash(bytes);
+    std::string path = objectPath(hash);
+
+    std::error_code ec;
+    if (!fs::exists(path, ec)) {
+        fs::create_directories(fs::path(path).parent_path(), ec);
+
+        // Written to a sibling and renamed, so a crash never leaves a torn
+        // object; per thread, as two workers may store the same image
+        std::string tmp = path + ".tmp" + std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id()));
+        FILE* f = std::fopen(tmp.c_str(), "wb");
+        bool ok = f && std::fwrite(bytes.data(), 1, bytes.size(), f) == bytes.size();
+        ok = (f && std::fclose(f) == 0) && ok;
+        if (ok) fs::rename(tmp, path, ec);
+        if (!ok || ec) {
+            fs::remove(tmp, ec);
+            std::cerr << "[THUMBS] cannot write " << path << "\n";
+            return;
+        }
+    }
+
+    std::vector<std::string> victims;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        touch(hash, bytes.size());
+        victims = evict();
+
+        auto it = m_index.find(entityId);
+        if (it == m_index.end() || it->second != hash) {
+            m_index[entityId] = hash;
+            char prefix[18];
+            std::snprintf(prefix, sizeof(prefix), "%016" PRIx64 " ", hash);
+            std::ofstream out(indexPath(), std::ios::app);
+            out << prefix << entityId << "\n";
+        }
+    }
+    removeFiles(victims);
+}
+
+size_t ThumbnailStore::size() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_index.size();
+}
+
+uint64_t ThumbnailStore::bytes() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_bytes;
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/// On-disk store of encoded photo thumbnails, content-addressed.
+///
+/// Each distinct image is one file, objects/<hh>/<hash>, named by the
+/// FNV-1a hash of its bytes and written to a sibling then renamed.  An
+/// append-only index maps entity ids to content hashes (the last line for
+/// an id wins), so photos that share a thumbnail share a file.  get()
+/// re-hashes what it reads: a torn or corrupted object is a miss and is
+/// removed.  Never throws; failures are logged and behave as misses.
+/// Thread-safe.
+///
+/// The objects are kept under a byte budget, least recently used out
+/// first; a hit touches the object's mtime, so the order survives a
+/// restart.  An id whose object was evicted is a miss.  Opening rewrites
+/// the index once most of its lines are superseded or point at evicted
+/// objects.
+class ThumbnailStore {
+public:
+    static constexpr uint64_t kDefaultMaxBytes = 512ull << 20;
+
+    /// Open (creating) the store in `dir`, load its index and evict down
+    /// to `maxBytes`.  An empty `dir` gives a store that holds nothing.
+    explicit ThumbnailStore(std::string dir, uint64_t maxBytes = kDefaultMaxBytes);
+
+    /// The thumbnail stored for `entityId`; empty if there is none.
+    std::vector<uint8_t> get(const std::string& entityId);
+
+    /// Store `bytes` as the thumbnail of `entityId`.  Empty bytes are ignored.
+    void put(const std::string& entityId, const std::vector<uint8_t>& bytes);
+
+    /// Entity ids with a stored thumbnail; one whose object was evicted
+    /// counts until it is looked up.
+    size_t size() const;
+    /// Bytes of the objects on disk.
+    uint64_t bytes() const;
+
+    const std::string& dir() const { return m_dir; }
+
+    static uint64_t contentHash(const std::vector<uint8_t>& bytes);
+
+private:
+    struct Object {
+        uint64_t bytes = 0;
+        std::list<uint64_t>::iterator lru;
+    };
+
+    std::string objectPath(uint64_t hash) const;
+    std::string indexPath() const { return m_dir + "/index"; }
+
+    /// Objects on disk by mtime, newest first.
+    void scanObjects();
+    /// Index lines -> m_index; returns the number of lines read.
+    size_t loadIndex();
+    /// Write m_index as a fresh index and swap it in.
+    void rewriteIndex();
+    /// Track `hash` as most recently used.  Locked.
+    void touch(uint64_t hash, uint64_t bytes);
+    /// Remove least recently used objects until under budget, keeping the
+    /// newest.  Locked; returns the files to delete.
+    std::vector<std::string> evict();
+    static void removeFiles(const std::vector<std::string>& paths);
+
+    std::string m_dir;
+    uint64_t m_maxBytes;
+    mutable std::mutex m_mutex;
+    std::unordered_map<std::string, uint64_t> m_index;  ///< entity id -> content hash
+    std::unordered_map<uint64_t, Object> m_objects;     ///< content hash -> object on disk
+    std::list<uint64_t> m_lru;                          ///< content hashes, most recent first
+    uint64_t m_bytes = 0;
+};
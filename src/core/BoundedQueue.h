@@ -0,0 +1,76 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+
+/// Blocking FIFO with a fixed capacity, for connecting pipeline stages.
+/// push() blocks while the queue is full, pop() blocks while it is empty.
+/// After close(), push() fails immediately and pop() drains what is left,
+/// then returns false.
+template<typename T>
+class BoundedQueue {
+public:
+    explicit BoundedQueue(size_t capacity) : m_capacity(capacity ? capacity : 1) {}
+
+    BoundedQueue(const BoundedQueue&) = delete;
+    BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+    /// Returns false (and drops item) if the queue was closed.
+    bool push(T item) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_notFull.wait(lock, [this] { return m_closed || m_items.size() < m_capacity; });
+        if (m_closed) return false;
+        m_items.push_back(std::move(item));
+        lock.unlock();
+        m_notEmpty.notify_one();
+        return true;
+    }
+
+    /// Returns false once the queue is closed and empty.
+    bool pop(T& out) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_notEmpty.wait(lock, [this] { return m_closed || !m_items.empty(); });
+        if (m_items.empty()) return false;
+        out = std::move(m_items.front());
+        m_items.pop_front();
+        lock.unlock();
+        m_notFull.notify_one();
+        return true;
+    }
+
+    /// Stop accepting items and wake every blocked producer and consumer.
+    void close() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_closed = true;
+        }
+        m_notFull.notify_all();
+        m_notEmpty.notify_all();
+    }
+
+    /// Drop everything still queued (used on cancel so producers unblock at once).
+    void clear() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_items.clear();
+        }
+        m_notFull.notify_all();
+    }
+
+    size_t size() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_items.size();
+    }
+
+    size_t capacity() const { return m_capacity; }
+
+private:
+    const size_t m_capacity;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_notFull;
+    std::condition_variable m_notEmpty;
+    std::deque<T> m_items;
+    bool m_closed = false;
+};
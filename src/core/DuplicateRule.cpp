@@ -0,0 +1,30 @@
+#include "DuplicateRule.h"
+
+#include <cmath>
+
+namespace {
+
+constexpr double kMetersPerDegree = 111320.0;
+constexpr double kDegToRad = 3.14159265358979323846 / 180.0;
+
+} // namespace
+
+bool DuplicateRule::duplicates(const EntityStore& keep, const EntityColumns& c, size_t row) const
+{
+    double t = c.time_start[row];
+    if (!c.hasLocation(row) || c.time_end[row] != t) return false;
+
+    // Equirectangular distance: exact enough at tens of meters
+    double lat = c.lat[row], lon = c.lon[row];
+    double lonScale = std::cos(lat * kDegToRad);
+    double maxSq = (meters / kMetersPerDegree) * (meters / kMetersPerDegree);
+
+    bool found = false;
+    keep.forEachInTime(t - seconds, t + seconds, [&](const EntityColumns& k, size_t r, size_t) {
+        if (found || !k.hasLocation(r) || std::abs(k.time_start[r] - t) > seconds) return;
+        double dy = k.lat[r] - lat;
+        double dx = (k.lon[r] - lon) * lonScale;
+        found = dx * dx + dy * dy <= maxSq;
+    });
+    return found;
+}
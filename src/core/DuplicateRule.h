@@ -0,0 +1,21 @@
+#pragma once
+
+#include "EntityStore.h"
+#include <cstddef>
+
+/// Cross-layer duplicate suppression.  A location fix can reach two layers
+/// (a phone's GPS fix in location.gps, and again in the Google Timeline
+/// export); the rule treats a row of the drop layer as a duplicate when the
+/// keep layer holds a fix within `seconds` and `meters` of it.  Only
+/// instants with a location are compared, so a Timeline visit spanning
+/// hours is never taken for a fix.
+struct DuplicateRule {
+    int keepLayer = 0;   ///< location.gps
+    int dropLayer = 3;   ///< location.googletimeline
+    double seconds = 30.0;
+    double meters = 25.0;
+
+    /// True if row `row` of `c` duplicates a fix in `keep`.  A time range
+    /// lookup per row: O(log n) plus the fixes within `seconds`.
+    bool duplicates(const EntityStore& keep, const EntityColumns& c, size_t row) const;
+};
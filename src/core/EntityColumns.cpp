@@ -0,0 +1,146 @@
+#include "EntityColumns.h"
+
+#include <stdexcept>
+
+void EntityColumns::reserve(size_t rows, size_t stringBytes)
+{
+    time_start.reserve(rows);
+    time_end.reserve(rows);
+    lat.reserve(rows);
+    lon.reserve(rows);
+    render_offset.reserve(rows);
+    flags.reserve(rows);
+    id.reserve(rows);
+    name.reserve(rows);
+    color.reserve(rows);
+    strings.reserve(stringBytes);
+}
+
+void EntityColumns::clear()
+{
+    resize(0);
+    strings.clear();
+}
+
+void EntityColumns::resize(size_t rows)
+{
+    time_start.resize(rows);
+    time_end.resize(rows);
+    lat.resize(rows);
+    lon.resize(rows);
+    render_offset.resize(rows);
+    flags.resize(rows);
+    id.resize(rows);
+    name.resize(rows);
+    color.resize(rows);
+}
+
+StringRef EntityColumns::addString(std::string_view s)
+{
+    if (strings.size() + s.size() > UINT32_MAX)
+        throw std::length_error("EntityColumns: string pool over 4 GB");
+    StringRef ref{static_cast<uint32_t>(strings.size()), static_cast<uint32_t>(s.size())};
+    strings.append(s);
+    return ref;
+}
+
+void EntityColumns::push_back(const Entity& e)
+{
+    push_back(e, e.name ? addString(*e.name) : StringRef{}, e.color ? addString(*e.color) : StringRef{});
+}
+
+void EntityColumns::push_back(const Entity& e, StringRef nameRef, StringRef colorRef)
+{
+    uint8_t f = 0;
+    if (e.lat) f |= kHasLat;
+    if (e.lon) f |= kHasLon;
+    if (e.name) f |= kHasName;
+    if (e.color) f |= kHasColor;
+
+    time_start.push_back(e.time_start);
+    time_end.push_back(e.time_end);
+    lat.push_back(e.lat.value_or(0.0));
+    lon.push_back(e.lon.value_or(0.0));
+    render_offset.push_back(e.render_offset);
+    flags.push_back(f);
+    id.push_back(addString(e.id));
+    name.push_back(e.name ? nameRef : StringRef{});
+    color.push_back(e.color ? colorRef : StringRef{});
+}
+
+void EntityColumns::append(const EntityColumns& other)
+{
+    if (strings.size() + other.strings.size() > UINT32_MAX)
+        throw std::length_error("EntityColumns: string pool over 4 GB");
+    auto base = static_cast<uint32_t>(strings.size());
+    size_t first = size();
+
+    time_start.insert(time_start.end(), other.time_start.begin(), other.time_start.end());
+    time_end.insert(time_end.end(), other.time_end.begin(), other.time_end.end());
+    lat.insert(lat.end(), other.lat.begin(), other.lat.end());
+    lon.insert(lon.end(), other.lon.begin(), other.lon.end());
+    render_offset.insert(render_offset.end(), other.render_offset.begin(), other.render_offset.end());
+    flags.insert(flags.end(), other.flags.begin(), other.flags.end());
+    id.insert(id.end(), other.id.begin(), other.id.end());
+    name.insert(name.end(), other.name.begin(), other.name.end());
+    color.insert(color.end(), other.color.begin(), other.color.end());
+    strings.append(other.strings);
+
+    if (base == 0) return;
+    for (size_t i = first; i < size(); ++i) {
+        id[i].offset += base;
+        name[i].offset += base;
+        color[i].offset += base;
+    }
+}
+
+void EntityColumns::moveRow(size_t from, size_t to)
+{
+    time_start[to] = time_start[from];
+    time_end[to] = time_end[from];
+    lat[to] = lat[from];
+    lon[to] = lon[from];
+    render_offset[to] = render_offset[from];
+    flags[to] = flags[from];
+    id[to] = id[from];
+    name[to] = name[from];
+    color[to] = color[from];
+}
+
+Entity EntityColumns::row(size_t i) const
+{
+    Entity e;
+    e.id.assign(idAt(i));
+    e.time_start = time_start[i];
+    e.time_end = time_end[i];
+    if (flags[i] & kHasLat) e.lat = lat[i];
+    if (flags[i] & kHasLon) e.lon = lon[i];
+    if (flags[i] & kHasName) e.name.emplace(str(name[i]));
+    if (flags[i] & kHasColor) e.color.emplace(str(color[i]));
+    e.render_offset = render_offset[i];
+    return e;
+}
+
+void EntityColumns::appendTo(std::vector<Entity>& out) const
+{
+    out.reserve(out.size() + size());
+    for (size_t i = 0; i < size(); ++i) out.push_back(row(i));
+}
+
+std::vector<Entity> EntityColumns::toEntities() const
+{
+    std::vector<Entity> out;
+    appendTo(out);
+    return out;
+}
+
+EntityColumns EntityColumns::fromEntities(const std::vector<Entity>& rows)
+{
+    EntityColumns c;
+    size_t bytes = 0;
+    for (const auto& e : rows)
+        bytes += e.id.size() + (e.name ? e.name->size() : 0) + (e.color ? e.color->size() : 0);
+    c.reserve(rows.size(), bytes);
+    for (const auto& e : rows) c.push_back(e);
+    return c;
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "Entity.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/// A string in an EntityColumns pool: byte offset and length.
+struct StringRef {
+    uint32_t offset = 0;
+    uint32_t length = 0;
+};
+
+/// A batch of entities stored column by column, the bulk alternative to
+/// std::vector<Entity> between backends and layers.
+///
+/// Every column has one value per row.  Optional fields are a bit in
+/// `flags` plus a plain value (0 / empty when the bit is clear), and ids,
+/// names and colors are StringRefs into one shared `strings` pool, so a
+/// batch is a dozen allocations however many rows it holds.  Decoders fill
+/// the columns directly; a repeated string (a dictionary entry, say) may be
+/// referenced by many rows.  A batch's pool is limited to 4 GB.
+struct EntityColumns {
+    enum Flag : uint8_t {
+        kHasLat   = 1 << 0,
+        kHasLon   = 1 << 1,
+        kHasName  = 1 << 2,
+        kHasColor = 1 << 3,
+    };
+
+    std::vector<double> time_start;
+    std::vector<double> time_end;
+    std::vector<double> lat;
+    std::vector<double> lon;
+    std::vector<float> render_offset;
+    std::vector<uint8_t> flags;
+    std::vector<StringRef> id;
+    std::vector<StringRef> name;
+    std::vector<StringRef> color;
+    std::string strings;  ///< pool the StringRefs point into
+
+    size_t size() const { return time_start.size(); }
+    bool empty() const { return time_start.empty(); }
+
+    void reserve(size_t rows, size_t stringBytes = 0);
+    /// Drop every row, keeping the capacity.
+    void clear();
+    /// Grow or shrink to `rows`; new rows are zero with no optional fields.
+    void resize(size_t rows);
+
+    /// Copy `s` into the pool.
+    StringRef addString(std::string_view s);
+    std::string_view str(StringRef ref) const { return {strings.data() + ref.offset, ref.length}; }
+
+    std::string_view idAt(size_t i) const { return str(id[i]); }
+    bool hasLocation(size_t i) const { return (flags[i] & (kHasLat | kHasLon)) == (kHasLat | kHasLon); }
+
+    void push_back(const Entity& e);
+    /// push_back with the name and color already in the pool (used only
+    /// if e has them).
+    void push_back(const Entity& e, StringRef name, StringRef color);
+    /// Bulk append: one insert per column, `other`'s pool appended whole.
+    void append(const EntityColumns& other);
+
+    /// Keep the rows for which keep(i) is true, in order.  The pool is left
+    /// as it is.
+    template<typename Keep>
+    void filter(Keep&& keep) {
+        size_t out = 0;
+        for (size_t i = 0; i < size(); ++i) {
+            if (!keep(i)) continue;
+            if (out != i) moveRow(i, out);
+            ++out;
+        }
+        resize(out);
+    }
+
+    /// Row adapters, for consumers that still take Entity.
+    Entity row(size_t i) const;
+    void appendTo(std::vector<Entity>& out) const;
+    std::vector<Entity> toEntities() const;
+    static EntityColumns fromEntities(const std::vector<Entity>& rows);
+
+private:
+    void moveRow(size_t from, size_t to);
+};
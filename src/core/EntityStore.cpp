@@ -0,0 +1,442 @@
+#include "EntityStore.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <utility>
+
+namespace {
+
+template<typename T>
+void extend(std::vector<T>& column, const std::vector<T>& src, size_t from, size_t to)
+{
+    column.insert(column.end(), src.begin() + from, src.begin() + to);
+}
+
+uint64_t refKey(StringRef ref)
+{
+    return (static_cast<uint64_t>(ref.offset) << 32) | ref.length;
+}
+
+/// Room for `rows` in a segment: geometric growth, but never past a full
+/// segment, so a filled segment carries no slack.
+void reserveRows(EntityColumns& c, size_t rows)
+{
+    size_t capacity = c.time_start.capacity();
+    if (capacity >= rows) return;
+    c.reserve(std::min(EntityStore::kSegmentSize, std::max(rows, 2 * capacity)), c.strings.capacity());
+}
+
+/// Buckets the time index holds at most (some 2900 years of days); rows
+/// past the last are found by binary search alone.
+constexpr size_t kMaxBuckets = size_t(1) << 20;
+
+int64_t bucketOf(double t)
+{
+    double b = t / EntityStore::kBucketSeconds;
+    if (!(b > -1e15)) b = -1e15;  // and NaN
+    if (b > 1e15) b = 1e15;
+    return static_cast<int64_t>(std::floor(b));
+}
+
+/// Row i of `a` and row j of `b` hold the same fields (ids aside).
+bool sameRow(const EntityColumns& a, size_t i, const EntityColumns& b, size_t j)
+{
+    uint8_t f = a.flags[i];
+    return f == b.flags[j] && a.time_start[i] == b.time_start[j] && a.time_end[i] == b.time_end[j] &&
+           a.render_offset[i] == b.render_offset[j] &&
+           (!(f & EntityColumns::kHasLat) || a.lat[i] == b.lat[j]) &&
+           (!(f & EntityColumns::kHasLon) || a.lon[i] == b.lon[j]) &&
+           (!(f & EntityColumns::kHasName) || a.str(a.name[i]) == b.str(b.name[j])) &&
+           (!(f & EntityColumns::kHasColor) || a.str(a.color[i]) == b.str(b.color[j]));
+}
+
+template<typename T>
+size_t capacityBytes(const std::vector<T>& column)
+{
+    return column.capacity() * sizeof(T);
+}
+
+} // namespace
+
+Entity EntityRow::entity() const
+{
+    Entity e;
+    e.id.assign(id);
+    e.time_start = time_start;
+    e.time_end = time_end;
+    e.lat = lat;
+    e.lon = lon;
+    if (name) e.name.emplace(*name);
+    if (color) e.color.emplace(*color);
+    e.render_offset = render_offset;
+    return e;
+}
+
+EntityRow EntityStore::operator[](size_t i) const
+{
+    const EntityColumns& c = m_segments[i / kSegmentSize];
+    size_t r = i % kSegmentSize;
+    uint8_t f = c.flags[r];
+    EntityRow row;
+    row.id = c.idAt(r);
+    row.time_start = c.time_start[r];
+    row.time_end = c.time_end[r];
+    if (f & EntityColumns::kHasLat) row.lat = c.lat[r];
+    if (f & EntityColumns::kHasLon) row.lon = c.lon[r];
+    if (f & EntityColumns::kHasName) row.name = c.str(c.name[r]);
+    if (f & EntityColumns::kHasColor) row.color = c.str(c.color[r]);
+    row.render_offset = c.render_offset[r];
+    return row;
+}
+
+void EntityStore::clear()
+{
+    std::vector<EntityColumns>().swap(m_segments);
+    m_interned.clear();
+    std::vector<StringRef>().swap(m_internedRefs);
+    m_sortedCount = 0;
+    m_firstBucket = 0;
+    std::vector<uint32_t>().swap(m_bucketStarts);
+    m_maxDuration = 0.0;
+    m_indexIds = false;
+    m_ids.clear();
+}
+
+EntityColumns& EntityStore::tail()
+{
+    if (m_segments.empty() || m_segments.back().size() == kSegmentSize) {
+        // Past the first segment the layer is evidently large: size the new
+        // one in full, so it is not reallocated as it fills
+        size_t poolGuess = m_segments.empty() ? 0 : m_segments.back().strings.size();
+        m_segments.emplace_back();
+        if (m_segments.size() > 1) m_segments.back().reserve(kSegmentSize, poolGuess);
+        m_interned.clear();
+        m_internedRefs.clear();
+    }
+    return m_segments.back();
+}
+
+StringRef EntityStore::intern(std::string_view s)
+{
+    // Looked up by view: the values stay in the pool, not in the table
+    EntityColumns& pool = m_segments.back();
+    uint32_t h = IdIndex::hash(s);
+    uint32_t k = m_interned.find(h, [&](uint32_t v) { return pool.str(m_internedRefs[v]) == s; });
+    if (k != IdIndex::kNone) return m_internedRefs[k];
+    StringRef ref = pool.addString(s);
+    if (m_internedRefs.size() < kMaxInterned) {
+        m_interned.insert(h, static_cast<uint32_t>(m_internedRefs.size()));
+        m_internedRefs.push_back(ref);
+    }
+    return ref;
+}
+
+void EntityStore::copyRows(const EntityColumns& src, size_t from, size_t to,
+                           std::unordered_map<uint64_t, StringRef>* refs)
+{
+    EntityColumns& c = m_segments.back();
+    size_t first = size();
+    reserveRows(c, c.size() + (to - from));
+    extend(c.time_start, src.time_start, from, to);
+    extend(c.time_end, src.time_end, from, to);
+    extend(c.lat, src.lat, from, to);
+    extend(c.lon, src.lon, from, to);
+    extend(c.render_offset, src.render_offset, from, to);
+    extend(c.flags, src.flags, from, to);
+
+    auto internRef = [&](StringRef ref) {
+        if (!refs) return intern(src.str(ref));
+        auto [it, added] = refs->try_emplace(refKey(ref));
+        if (added) it->second = intern(src.str(ref));
+        return it->second;
+    };
+    for (size_t i = from; i < to; ++i) {
+        uint8_t f = src.flags[i];
+        c.id.push_back(c.addString(src.idAt(i)));
+        c.name.push_back((f & EntityColumns::kHasName) ? internRef(src.name[i]) : StringRef{});
+        c.color.push_back((f & EntityColumns::kHasColor) ? internRef(src.color[i]) : StringRef{});
+    }
+    indexRows(first, size());
+}
+
+void EntityStore::append(const EntityColumns& batch)
+{
+    // A batch's rows may already share a name (a dictionary entry), so
+    // each distinct ref is interned once per segment
+    std::unordered_map<uint64_t, StringRef> refs;
+    for (size_t i = 0; i < batch.size();) {
+        if (!m_segments.empty() && m_segments.back().size() == kSegmentSize) refs.clear();
+        size_t room = kSegmentSize - tail().size();
+        size_t n = std::min(room, batch.size() - i);
+        copyRows(batch, i, i + n, &refs);
+        i += n;
+    }
+}
+
+void EntityStore::append(const std::vector<Entity>& rows)
+{
+    for (const auto& e : rows) push_back(e);
+}
+
+void EntityStore::push_back(const Entity& e)
+{
+    EntityColumns& c = tail();
+    reserveRows(c, c.size() + 1);
+    StringRef name = e.name ? intern(*e.name) : StringRef{};
+    StringRef color = e.color ? intern(*e.color) : StringRef{};
+    c.push_back(e, name, color);
+    indexRows(size() - 1, size());
+}
+
+void EntityStore::indexRows(size_t from, size_t to)
+{
+    forEach(from, to, [this](const EntityColumns& c, size_t row, size_t i) {
+        if (m_indexIds) m_ids.insert(IdIndex::hash(c.idAt(row)), static_cast<uint32_t>(i));
+
+        double t = c.time_start[row];
+        m_maxDuration = std::max(m_maxDuration, c.time_end[row] - t);
+        // Past the first out-of-order row everything is tail
+        if (m_sortedCount != i || (i > 0 && !(t >= timeAt(i - 1)))) return;
+        ++m_sortedCount;
+
+        int64_t bucket = bucketOf(t);
+        if (m_bucketStarts.empty()) m_firstBucket = bucket;
+        while (m_bucketStarts.size() < kMaxBuckets &&
+               m_firstBucket + static_cast<int64_t>(m_bucketStarts.size()) <= bucket)
+            m_bucketStarts.push_back(static_cast<uint32_t>(i));
+    });
+}
+
+size_t EntityStore::searchTime(double t, bool after) const
+{
+    // The bucket narrows the search to the rows of t's day
+    size_t lo = 0, hi = m_sortedCount;
+    if (!m_bucketStarts.empty()) {
+        int64_t b = bucketOf(t) - m_firstBucket;
+        if (b < 0) return 0;
+        auto n = static_cast<int64_t>(m_bucketStarts.size());
+        lo = m_bucketStarts[std::min(b, n - 1)];
+        if (b + 1 < n) hi = m_bucketStarts[b + 1];
+    }
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        double v = timeAt(mid);
+        if (after ? v <= t : v < t) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+std::pair<size_t, size_t> EntityStore::timeRange(double t0, double t1) const
+{
+    size_t first = searchTime(t0, false);
+    return {first, std::max(first, searchTime(t1, true))};
+}
+
+void EntityStore::rebuild(const std::vector<uint32_t>& rows)
+{
+    // Full segments the new order leaves as they are move over whole, with
+    // their part of the indexes; only the rows after them are copied
+    size_t same = 0;
+    while (same < rows.size() && rows[same] == same) ++same;
+    size_t kept = same / kSegmentSize;
+    size_t keptRows = kept * kSegmentSize;
+
+    EntityStore out;
+    out.m_indexIds = m_indexIds;
+    if (kept > 0) {
+        // The rewritten rows leave the id index one by one, then come back
+        // at their new rows as they are copied
+        if (m_indexIds) {
+            forEach(keptRows, size(), [this](const EntityColumns& c, size_t row, size_t i) {
+                m_ids.erase(IdIndex::hash(c.idAt(row)), static_cast<uint32_t>(i));
+            });
+        }
+        out.m_segments.reserve(m_segments.size());
+        std::move(m_segments.begin(), m_segments.begin() + kept, std::back_inserter(out.m_segments));
+        out.m_sortedCount = std::min(m_sortedCount, keptRows);
+        out.m_firstBucket = m_firstBucket;
+        out.m_bucketStarts = std::move(m_bucketStarts);
+        while (!out.m_bucketStarts.empty() && out.m_bucketStarts.back() >= out.m_sortedCount)
+            out.m_bucketStarts.pop_back();
+        out.m_maxDuration = m_maxDuration;  // still an upper bound
+        out.m_ids = std::move(m_ids);
+    } else if (m_indexIds) {
+        out.m_ids.reserve(rows.size());
+    }
+    out.copyFrom(*this, rows, keptRows);
+    *this = std::move(out);
+}
+
+void EntityStore::copyFrom(const EntityStore& src, const std::vector<uint32_t>& rows, size_t from)
+{
+    for (size_t k = from; k < rows.size();) {
+        // Runs of consecutive rows in one old segment are copied together
+        size_t seg = rows[k] / kSegmentSize;
+        size_t first = rows[k] % kSegmentSize;
+        size_t room = kSegmentSize - tail().size();
+        size_t n = 1;
+        while (n < room && k + n < rows.size() && rows[k + n] == rows[k] + n &&
+               rows[k + n] / kSegmentSize == seg)
+            ++n;
+        copyRows(src.m_segments[seg], first, first + n, nullptr);
+        k += n;
+    }
+}
+
+void EntityStore::erase(const std::vector<uint32_t>& rows)
+{
+    std::vector<uint32_t> keep;
+    keep.reserve(size());
+    size_t k = 0;
+    for (size_t i = 0; i < size(); ++i) {
+        bool dropped = false;
+        for (; k < rows.size() && rows[k] == i; ++k) dropped = true;
+        if (!dropped) keep.push_back(static_cast<uint32_t>(i));
+    }
+    if (keep.size() != size()) rebuild(keep);
+}
+
+void EntityStore::indexIds()
+{
+    if (m_indexIds) return;
+    m_indexIds = true;
+    m_ids.reserve(size());
+    forEach(0, size(), [this](const EntityColumns& c, size_t row, size_t i) {
+        m_ids.insert(IdIndex::hash(c.idAt(row)), static_cast<uint32_t>(i));
+    });
+}
+
+size_t EntityStore::find(std::string_view id) const
+{
+    uint32_t row = m_ids.find(IdIndex::hash(id), [&](uint32_t i) { return idAt(i) == id; });
+    return row == IdIndex::kNone ? npos : row;
+}
+
+void EntityStore::appendRows(const EntityColumns& src, const std::vector<uint32_t>& rows)
+{
+    std::unordered_map<uint64_t, StringRef> refs;
+    for (size_t k = 0; k < rows.size();) {
+        if (!m_segments.empty() && m_segments.back().size() == kSegmentSize) refs.clear();
+        size_t room = kSegmentSize - tail().size();
+        size_t n = 1;
+        while (n < room && k + n < rows.size() && rows[k + n] == rows[k] + n) ++n;
+        copyRows(src, rows[k], rows[k] + n, &refs);
+        k += n;
+    }
+}
+
+void EntityStore::replaceRow(size_t i, const EntityColumns& src, size_t r)
+{
+    EntityColumns& c = m_segments[i / kSegmentSize];
+    size_t row = i % kSegmentSize;
+    uint8_t had = c.flags[row], has = src.flags[r];
+
+    // A name or color that did not change keeps its ref; a new one goes to
+    // this segment's pool (interned if it is the tail), reclaimed when the
+    // segments are next rewritten
+    auto restring = [&](StringRef old, uint8_t flag, StringRef ref) -> StringRef {
+        if (!(has & flag)) return {};
+        std::string_view s = src.str(ref);
+        if ((had & flag) && c.str(old) == s) return old;
+        return &c == &m_segments.back() ? intern(s) : c.addString(s);
+    };
+    c.name[row] = restring(c.name[row], EntityColumns::kHasName, src.name[r]);
+    c.color[row] = restring(c.color[row], EntityColumns::kHasColor, src.color[r]);
+    c.time_end[row] = src.time_end[r];
+    c.lat[row] = src.lat[r];
+    c.lon[row] = src.lon[r];
+    c.render_offset[row] = src.render_offset[r];
+    c.flags[row] = has;
+    m_maxDuration = std::max(m_maxDuration, c.time_end[row] - c.time_start[row]);
+}
+
+EntityStore::UpsertResult EntityStore::upsert(const EntityColumns& batch, std::vector<uint32_t> drop)
+{
+    UpsertResult result;
+    indexIds();
+    std::sort(drop.begin(), drop.end());
+
+    std::vector<uint32_t> picks;  // batch rows to append
+    IdIndex picked;               // their ids -> position in picks
+    std::vector<uint32_t> moved;  // rows re-appended at a new time_start
+    for (size_t r = 0; r < batch.size(); ++r) {
+        std::string_view id = batch.idAt(r);
+        uint32_t h = IdIndex::hash(id);
+        uint32_t p = picked.find(h, [&](uint32_t k) { return batch.idAt(picks[k]) == id; });
+        if (p != IdIndex::kNone) {
+            picks[p] = static_cast<uint32_t>(r);
+            continue;
+        }
+
+        size_t i = find(id);
+        if (i != npos && sameRow(m_segments[i / kSegmentSize], i % kSegmentSize, batch, r)) {
+            ++result.unchanged;
+            continue;
+        }
+        if (i != npos && timeAt(i) == batch.time_start[r]) {
+            replaceRow(i, batch, r);
+            ++result.updated;
+            continue;
+        }
+        if (i == npos) {
+            ++result.inserted;
+        } else {
+            moved.push_back(static_cast<uint32_t>(i));
+            ++result.updated;
+        }
+        picked.insert(h, static_cast<uint32_t>(picks.size()));
+        picks.push_back(static_cast<uint32_t>(r));
+    }
+
+    // One rewrite for the moved rows and the caller's together
+    if (!moved.empty()) {
+        std::sort(moved.begin(), moved.end());
+        std::vector<uint32_t> both(drop.size() + moved.size());
+        std::merge(drop.begin(), drop.end(), moved.begin(), moved.end(), both.begin());
+        drop.swap(both);
+    }
+    if (!drop.empty()) erase(drop);
+    appendRows(batch, picks);
+    return result;
+}
+
+std::vector<uint32_t> EntityStore::timeOrder() const
+{
+    auto byTime = [this](uint32_t a, uint32_t b) { return timeAt(a) < timeAt(b); };
+
+    std::vector<uint32_t> order(size());
+    std::iota(order.begin(), order.end(), 0u);
+    auto tail = order.begin() + m_sortedCount;
+    std::stable_sort(tail, order.end(), byTime);
+    std::inplace_merge(order.begin(), tail, order.end(), byTime);
+    return order;
+}
+
+void EntityStore::mergeByTime()
+{
+    if (sortedByTime()) return;
+    rebuild(timeOrder());
+}
+
+EntityStore EntityStore::mergedByTime() const
+{
+    EntityStore out;
+    out.m_indexIds = m_indexIds;
+    if (m_indexIds) out.m_ids.reserve(size());
+    out.copyFrom(*this, timeOrder(), 0);
+    return out;
+}
+
+size_t EntityStore::memoryBytes() const
+{
+    size_t bytes = m_segments.capacity() * sizeof(EntityColumns) + capacityBytes(m_bucketStarts) +
+                   m_ids.memoryBytes();
+    for (const auto& c : m_segments) {
+        bytes += capacityBytes(c.time_start) + capacityBytes(c.time_end) + capacityBytes(c.lat) +
+                 capacityBytes(c.lon) + capacityBytes(c.render_offset) + capacityBytes(c.flags) +
+                 capacityBytes(c.id) + capacityBytes(c.name) + capacityBytes(c.color) + c.strings.capacity();
+    }
+    return bytes;
+}
@@ -0,0 +1,266 @@
+#pragma once
+
+#include "EntityColumns.h"
+#include "IdIndex.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/// One row of an EntityStore read in place: Entity's fields and helpers,
+/// with the strings as views into the store's pool.  Valid until the store
+/// is next modified; entity() copies it out.
+struct EntityRow {
+    std::string_view id;
+    double time_start = 0.0;
+    double time_end = 0.0;
+    std::optional<double> lat;
+    std::optional<double> lon;
+    std::optional<std::string_view> name;
+    std::optional<std::string_view> color;
+    float render_offset = 0.0f;
+
+    bool is_instant() const { return time_start == time_end; }
+    double duration() const { return time_end - time_start; }
+    double time_mid() const { return (time_start + time_end) / 2.0; }
+    bool has_location() const { return lat.has_value() && lon.has_value(); }
+
+    Entity entity() const;
+};
+
+/// A layer's entities, stored as columns (EntityColumns): contiguous
+/// time_start / time_end / lat / lon / render_offset arrays, a byte of
+/// validity bits per row for the optional fields, and the id, name and
+/// color strings in a pool.  About half the memory of std::vector<Entity>
+/// and no pointer chasing, so the per-frame scans (histogram, picking
+/// index, chunk uploads) read the columns directly.
+///
+/// Rows are kept in segments of kSegmentSize, each an EntityColumns with
+/// its own pool: segment s holds rows [s, s + 1) * kSegmentSize, the same
+/// rows as GPU chunk s (PointRenderer::CHUNK_SIZE).  Appending fills the
+/// last segment and starts new ones, so a full segment's rows do not
+/// change until the store is edited (filter, mergeByTime, clear; the owner
+/// bumps Layer::revision).  Until then the row data pointers within a full
+/// segment are stable, and so is anything derived from its rows; segment
+/// references are not, as starting a segment may move the EntityColumns
+/// objects themselves.
+///
+/// Each pool is a string arena: ids are appended to it, while names and
+/// colors, which take few distinct values (a calendar's colors, a place's
+/// name), are interned, stored once per segment and shared by every row
+/// that has them.  Clearing the store frees a dozen buffers per segment,
+/// however many rows it held.
+///
+/// Rows are kept in time_start order as far as they arrive in it: rows
+/// [0, sortedCount()) are sorted and indexed by day (the first row of each
+/// day), so a time window maps to a contiguous row range in O(log n).  A
+/// row that arrives earlier than the last sorted one starts an unsorted
+/// tail, which scans take as it is until mergeByTime() merges it in.
+///
+/// Ids are not deduplicated by append().  upsert() is: it keeps an IdIndex
+/// over the rows (built by indexIds(), best called while the store is
+/// empty so each append indexes its own rows, then kept up to date by
+/// every edit)
+/// and replaces a row whose id it already holds instead of adding another,
+/// so re-streaming a layer costs the changed rows, not the whole layer.
+///
+/// Code that thinks in rows indexes the store: store[i] is an EntityRow
+/// with Entity's field names, and iteration yields rows in order.
+class EntityStore {
+public:
+    /// Rows per segment; PointRenderer::CHUNK_SIZE is asserted to match.
+    static constexpr size_t kSegmentSize = 50000;
+
+    class const_iterator {
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = EntityRow;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = EntityRow;
+
+        const_iterator(const EntityStore* store, size_t i) : m_store(store), m_i(i) {}
+        EntityRow operator*() const { return (*m_store)[m_i]; }
+        const_iterator& operator++() { ++m_i; return *this; }
+        const_iterator operator++(int) { const_iterator t = *this; ++m_i; return t; }
+        const_iterator& operator+=(difference_type n) { m_i += n; return *this; }
+        difference_type operator-(const const_iterator& o) const {
+            return static_cast<difference_type>(m_i) - static_cast<difference_type>(o.m_i);
+        }
+        bool operator==(const const_iterator& o) const { return m_i == o.m_i; }
+        bool operator!=(const const_iterator& o) const { return m_i != o.m_i; }
+
+    private:
+        const EntityStore* m_store;
+        size_t m_i;
+    };
+
+    size_t size() const {
+        return m_segments.empty() ? 0 : (m_segments.size() - 1) * kSegmentSize + m_segments.back().size();
+    }
+    bool empty() const { return m_segments.empty(); }
+
+    EntityRow operator[](size_t i) const;
+    /// Row i as an Entity (a copy).
+    Entity entity(size_t i) const { return m_segments[i / kSegmentSize].row(i % kSegmentSize); }
+
+    const_iterator begin() const { return {this, 0}; }
+    const_iterator end() const { return {this, size()}; }
+
+    /// The segments, for scans.  Row i is row i % kSegmentSize of segment
+    /// i / kSegmentSize; every segment but the last is full.  The reference
+    /// is valid until the next append.
+    size_t segmentCount() const { return m_segments.size(); }
+    const EntityColumns& segment(size_t s) const { return m_segments[s]; }
+
+    /// Call fn(segment, row, i) for rows [from, to) in order, where
+    /// `row` is row i's index within `segment`.
+    template<typename Fn>
+    void forEach(size_t from, size_t to, Fn&& fn) const {
+        to = std::min(to, size());
+        for (size_t i = from; i < to;) {
+            const EntityColumns& seg = m_segments[i / kSegmentSize];
+            size_t base = i - i % kSegmentSize;
+            size_t end = std::min(to, base + seg.size());
+            for (; i < end; ++i) fn(seg, i - base, i);
+        }
+    }
+
+    /// Call fn(segment, row, i) for every row that may overlap [t0, t1]:
+    /// the sorted rows starting in [t0 - maxDuration(), t1], then the
+    /// unsorted tail.
+    template<typename Fn>
+    void forEachInTime(double t0, double t1, Fn&& fn) const {
+        auto [from, to] = timeRange(t0 - m_maxDuration, t1);
+        forEach(from, to, fn);
+        forEach(m_sortedCount, size(), fn);
+    }
+
+    /// Seconds in a bucket of the time index.
+    static constexpr double kBucketSeconds = 86400.0;
+
+    /// Rows [0, sortedCount()) are in time_start order and indexed.
+    size_t sortedCount() const { return m_sortedCount; }
+    bool sortedByTime() const { return m_sortedCount == size(); }
+    /// The sorted rows with time_start in [t0, t1], as [first, last).
+    std::pair<size_t, size_t> timeRange(double t0, double t1) const;
+    /// Longest time_end - time_start of any row.
+    double maxDuration() const { return m_maxDuration; }
+
+    /// Drop every row and the id index, and release the memory.
+    void clear();
+
+    /// Append a batch, copying its rows into the segments.
+    void append(const EntityColumns& batch);
+    void append(const std::vector<Entity>& rows);
+    void push_back(const Entity& e);
+
+    /// What upsert() did with a batch's rows.
+    struct UpsertResult {
+        size_t inserted = 0;   ///< ids the store did not hold, appended
+        size_t updated = 0;    ///< rows replaced (edits in place: bump Layer::revision)
+        size_t unchanged = 0;  ///< rows the store already held as they are
+    };
+
+    /// Merge a batch by id: a row whose id the store holds replaces that
+    /// row (in place if its time_start is unchanged, else dropped and
+    /// appended again), the rest are appended.  Of rows sharing an id
+    /// within the batch, the last wins.  Rows `drop` (whose ids the batch
+    /// does not hold) are erased in the same rewrite as the moved ones.
+    /// Indexes the ids first if they are not yet.
+    UpsertResult upsert(const EntityColumns& batch, std::vector<uint32_t> drop = {});
+
+    /// Index the rows by id (see upsert); later appends and edits keep the
+    /// index.  O(size()): on an empty store it costs nothing up front.
+    void indexIds();
+    bool indexesIds() const { return m_indexIds; }
+    /// The first row with this id, or npos.  Requires indexesIds().
+    size_t find(std::string_view id) const;
+    static constexpr size_t npos = static_cast<size_t>(-1);
+
+    /// Drop rows `rows` (ascending), rewriting the segments from the one
+    /// holding the first.
+    void erase(const std::vector<uint32_t>& rows);
+
+    /// Keep the rows for which keep(segment, row) is true, in order.
+    /// Rewrites the segments (and their pools) from the first that loses
+    /// a row.
+    template<typename Keep>
+    void filter(Keep&& keep) {
+        std::vector<uint32_t> rows;
+        rows.reserve(size());
+        forEach(0, size(), [&](const EntityColumns& seg, size_t row, size_t i) {
+            if (keep(seg, row)) rows.push_back(static_cast<uint32_t>(i));
+        });
+        if (rows.size() != size()) rebuild(rows);
+    }
+
+    /// Stable-sort the unsorted tail by time_start and merge it into the
+    /// sorted rows, rewriting the segments from the one the earliest tail
+    /// row lands in.
+    void mergeByTime();
+
+    /// A copy of the store with its rows in time order, as mergeByTime()
+    /// leaves them.  Only reads this store, so it may run on a worker while
+    /// other threads read it too, but not while anything edits it.
+    EntityStore mergedByTime() const;
+
+    /// Bytes held by the segments, their pools, the time index and the id
+    /// index (capacity, not size).
+    size_t memoryBytes() const;
+
+    /// Distinct names and colors a segment interns at most; past this, new
+    /// values are stored per row like ids.
+    static constexpr size_t kMaxInterned = 4096;
+    size_t internedCount() const { return m_internedRefs.size(); }
+
+private:
+    /// The segment appends go to, started if the last one is full.
+    EntityColumns& tail();
+    /// Copy rows [from, to) of `src` into the tail segment, which has room.
+    /// `refs` caches src's interned names and colors, if given.
+    void copyRows(const EntityColumns& src, size_t from, size_t to,
+                  std::unordered_map<uint64_t, StringRef>* refs);
+    /// Replace the rows with the old rows `rows` (each at most once), in
+    /// that order.  Full segments before the first row that changes are
+    /// kept as they are.
+    void rebuild(const std::vector<uint32_t>& rows);
+    /// Copy rows rows[from..] of `src` to the end of the store, in that order.
+    void copyFrom(const EntityStore& src, const std::vector<uint32_t>& rows, size_t from);
+    /// Every row, in the order mergeByTime() puts them in.
+    std::vector<uint32_t> timeOrder() const;
+    /// Copy rows `rows` (ascending) of `src` to the end of the store.
+    void appendRows(const EntityColumns& src, const std::vector<uint32_t>& rows);
+    /// Overwrite row i with row `r` of `src`, which has the same id and
+    /// time_start.
+    void replaceRow(size_t i, const EntityColumns& src, size_t r);
+    /// Extend the sorted rows, the time index and the id index over new
+    /// rows [from, to).
+    void indexRows(size_t from, size_t to);
+
+    std::string_view idAt(size_t i) const { return m_segments[i / kSegmentSize].idAt(i % kSegmentSize); }
+    double timeAt(size_t i) const { return m_segments[i / kSegmentSize].time_start[i % kSegmentSize]; }
+    /// First sorted row with time_start >= t (or > t if `after`).
+    size_t searchTime(double t, bool after) const;
+
+    /// `s` in the tail segment's pool: the interned copy if there is one.
+    StringRef intern(std::string_view s);
+
+    std::vector<EntityColumns> m_segments;
+    IdIndex m_interned;                     ///< tail segment: name/color value -> m_internedRefs
+    std::vector<StringRef> m_internedRefs;  ///< the interned values in the tail segment's pool
+
+    size_t m_sortedCount = 0;
+    int64_t m_firstBucket = 0;              ///< bucket of row 0
+    std::vector<uint32_t> m_bucketStarts;   ///< [b]: first sorted row in bucket m_firstBucket + b or later
+    double m_maxDuration = 0.0;
+
+    bool m_indexIds = false;
+    IdIndex m_ids;                          ///< id -> row, if m_indexIds
+};
@@ -0,0 +1,96 @@
+#include "IdIndex.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace {
+
+constexpr size_t kMinSlots = 64;
+
+} // namespace
+
+uint32_t IdIndex::hash(std::string_view id)
+{
+    uint64_t h = 0xcbf29ce484222325ull;
+    for (unsigned char c : id) {
+        h ^= c;
+        h *= 0x100000001b3ull;
+    }
+    auto x = static_cast<uint32_t>(h ^ (h >> 32));
+    // murmur3's finalizer: FNV's low bits are weak for short keys
+    x ^= x >> 16;
+    x *= 0x85ebca6bu;
+    x ^= x >> 13;
+    x *= 0xc2b2ae35u;
+    x ^= x >> 16;
+    return x;
+}
+
+void IdIndex::clear()
+{
+    std::vector<Slot>().swap(m_slots);
+    std::vector<uint64_t>().swap(m_bloom);
+    m_mask = 0;
+    m_size = 0;
+}
+
+void IdIndex::reserve(size_t n)
+{
+    size_t slots = std::max(kMinSlots, m_slots.size());
+    while (slots / 4 * 3 < n) slots *= 2;
+    if (slots != m_slots.size()) rehash(slots);
+}
+
+void IdIndex::insert(uint32_t h, uint32_t row)
+{
+    if ((m_size + 1) > m_slots.size() / 4 * 3) reserve(m_size + 1);
+    place(h, row);
+    ++m_size;
+}
+
+void IdIndex::place(uint32_t h, uint32_t row)
+{
+    size_t i = h & m_mask;
+    while (m_slots[i].row != kNone) i = (i + 1) & m_mask;
+    m_slots[i] = {h, row};
+    m_bloom[bloomWord(h)] |= bloomBits(h);
+}
+
+void IdIndex::erase(uint32_t h, uint32_t row)
+{
+    if (!mayContain(h)) return;
+    size_t i = h & m_mask;
+    for (;; i = (i + 1) & m_mask) {
+        if (m_slots[i].row == kNone) return;
+        if (m_slots[i].hash == h && m_slots[i].row == row) break;
+    }
+    --m_size;
+
+    // Backward shift: an entry further along the run moves into the hole
+    // unless its home lies cyclically in (hole, entry], keeping every
+    // entry reachable from its home and entries of one id in order
+    for (size_t j = (i + 1) & m_mask;; j = (j + 1) & m_mask) {
+        if (m_slots[j].row == kNone) break;
+        size_t home = m_slots[j].hash & m_mask;
+        if (((j - home) & m_mask) < ((j - i) & m_mask)) continue;
+        m_slots[i] = m_slots[j];
+        i = j;
+    }
+    m_slots[i] = Slot{};
+}
+
+void IdIndex::rehash(size_t slots)
+{
+    std::vector<Slot> old(slots);
+    old.swap(m_slots);
+    m_bloom.assign(slots / 8, 0);
+    m_mask = slots - 1;
+    // In probe order from an empty slot, so no run is split and entries of
+    // one id stay in insertion order (find() still returns the first)
+    size_t start = 0;
+    while (start < old.size() && old[start].row != kNone) ++start;
+    for (size_t k = 0; k < old.size(); ++k) {
+        const Slot& s = old[(start + k) % old.size()];
+        if (s.row != kNone) place(s.hash, s.row);
+    }
+}
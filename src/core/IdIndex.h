@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+/// Hash index from entity id to row, for deduplicating a layer (and from
+/// a name or color to its interned copy).
+///
+/// Open addressing with linear probing over 8-byte slots: the id's 32-bit
+/// hash and the row.  The ids themselves stay in the caller's pool; find()
+/// confirms a hash match through the caller's `matches(row)`, so an entry
+/// costs no allocation and a lookup touches one cache line in the common
+/// case.  The table grows by doubling at 3/4 load, rehashing from the
+/// stored hashes.
+///
+/// A blocked Bloom filter (one 64-bit word per id, four bits set) sits in
+/// front of the table: most ids of an incoming batch are new, and for those
+/// find() reads one word of a filter an eighth the table's size and stops.
+///
+/// erase() removes one entry by shifting the rest of its probe run back,
+/// so the table never holds tombstones; the filter keeps the entry's bits
+/// (a false positive costs one probe) until the table next grows.
+class IdIndex {
+public:
+    static constexpr uint32_t kNone = UINT32_MAX;
+
+    /// FNV-1a, folded to 32 bits and mixed so every bit depends on the id.
+    static uint32_t hash(std::string_view id);
+
+    size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+
+    /// Drop every entry and release the memory.
+    void clear();
+    /// Room for `n` entries without growing.
+    void reserve(size_t n);
+
+    /// Record `row` for the id with hash `h`.  An id added twice keeps both
+    /// entries; find() returns the first.
+    void insert(uint32_t h, uint32_t row);
+
+    /// Remove the entry recording `row` for hash `h`, if there is one.
+    void erase(uint32_t h, uint32_t row);
+
+    /// False if no id with hash `h` was ever inserted.
+    bool mayContain(uint32_t h) const {
+        if (m_bloom.empty()) return false;
+        uint64_t bits = bloomBits(h);
+        return (m_bloom[bloomWord(h)] & bits) == bits;
+    }
+
+    /// The row of the first entry with hash `h` for which matches(row) is
+    /// true, or kNone.
+    template<typename Matches>
+    uint32_t find(uint32_t h, Matches&& matches) const {
+        if (!mayContain(h)) return kNone;
+        for (size_t i = h & m_mask;; i = (i + 1) & m_mask) {
+            const Slot& s = m_slots[i];
+            if (s.row == kNone) return kNone;
+            if (s.hash == h && matches(s.row)) return s.row;
+        }
+    }
+
+    /// Bytes held by the table and the filter (capacity, not size).
+    size_t memoryBytes() const {
+        return m_slots.capacity() * sizeof(Slot) + m_bloom.capacity() * sizeof(uint64_t);
+    }
+
+private:
+    struct Slot {
+        uint32_t hash = 0;
+        uint32_t row = kNone;
+    };
+
+    /// The filter word of hash `h`: its high bits after a second mix, so it
+    /// does not follow the slot.
+    size_t bloomWord(uint32_t h) const {
+        return static_cast<size_t>((uint64_t(h * 0x9E3779B1u) * m_bloom.size()) >> 32);
+    }
+    /// The four bits of hash `h` within its word.
+    static uint64_t bloomBits(uint32_t h) {
+        return (uint64_t(1) << (h >> 8 & 63)) | (uint64_t(1) << (h >> 14 & 63)) |
+               (uint64_t(1) << (h >> 20 & 63)) | (uint64_t(1) << (h >> 26));
+    }
+
+    /// Resize to `slots` (a power of two) and re-insert every entry.
+    void rehash(size_t slots);
+    void place(uint32_t h, uint32_t row);
+
+    std::vector<Slot> m_slots;
+    std::vector<uint64_t> m_bloom;  ///< one word per 8 slots
+    size_t m_mask = 0;
+    size_t m_size = 0;
+};
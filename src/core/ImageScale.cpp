@@ -0,0 +1,78 @@
+#include "ImageScale.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+/// Source taps of one output sample along an axis: first source index and
+/// the weight of each, summing to 1.
+struct Taps {
+    int first = 0;
+    std::vector<float> weights;
+};
+
+std::vector<Taps> boxTaps(int srcSize, int outSize)
+{
+    std::vector<Taps> taps(outSize);
+    double scale = static_cast<double>(srcSize) / outSize;
+    for (int o = 0; o < outSize; ++o) {
+        double start = o * scale;
+        double end = (o + 1) * scale;
+        int first = static_cast<int>(std::floor(start));
+        int last = std::min(srcSize - 1, static_cast<int>(std::ceil(end)) - 1);
+        taps[o].first = first;
+        for (int s = first; s <= last; ++s) {
+            double covered = std::min(end, s + 1.0) - std::max(start, static_cast<double>(s));
+            taps[o].weights.push_back(static_cast<float>(covered / scale));
+        }
+    }
+    return taps;
+}
+
+} // namespace
+
+namespace ImageScale {
+
+std::vector<uint8_t> downscaleBox(const uint8_t* rgba, int width, int height,
+                                  int outWidth, int outHeight)
+{
+    std::vector<Taps> xTaps = boxTaps(width, outWidth);
+    std::vector<Taps> yTaps = boxTaps(height, outHeight);
+
+    // Horizontal pass into floats (outWidth x height), then vertical
+    std::vector<float> rows(static_cast<size_t>(outWidth) * height * 4);
+    for (int y = 0; y < height; ++y) {
+        const uint8_t* src = rgba + static_cast<size_t>(y) * width * 4;
+        float* dst = rows.data() + static_cast<size_t>(y) * outWidth * 4;
+        for (int x = 0; x < outWidth; ++x) {
+            const Taps& t = xTaps[x];
+            float acc[4] = {0, 0, 0, 0};
+            for (size_t i = 0; i < t.weights.size(); ++i) {
+                const uint8_t* p = src + static_cast<size_t>(t.first + i) * 4;
+                for (int c = 0; c < 4; ++c) acc[c] += p[c] * t.weights[i];
+            }
+            std::copy(acc, acc + 4, dst + static_cast<size_t>(x) * 4);
+        }
+    }
+
+    std::vector<uint8_t> out(static_cast<size_t>(outWidth) * outHeight * 4);
+    size_t rowFloats = static_cast<size_t>(outWidth) * 4;
+    for (int y = 0; y < outHeight; ++y) {
+        const Taps& t = yTaps[y];
+        uint8_t* dst = out.data() + static_cast<size_t>(y) * rowFloats;
+        for (size_t k = 0; k < rowFloats; ++k) {
+            float acc = 0.0f;
+            for (size_t i = 0; i < t.weights.size(); ++i)
+                acc += rows[(t.first + i) * rowFloats + k] * t.weights[i];
+            dst[k] = static_cast<uint8_t>(std::clamp(acc + 0.5f, 0.0f, 255.0f));
+        }
+    }
+    return out;
+}
+
+int fitHeight(int width, int height, int outWidth)
+{
+    return std::max(1, static_cast<int>(std::lround(static_cast<double>(height) * outWidth / width)));
+}
+
+} // namespace ImageScale
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+/// Image resampling helpers (pure logic, no GL).
+namespace ImageScale {
+
+/// Box-filter (area-average) downscale of an RGBA8 image to
+/// outWidth x outHeight.  Each output pixel averages the source pixels it
+/// covers, weighting partially covered ones by coverage, so non-integer
+/// ratios do not alias.  Sizes must be positive and no larger than the
+/// source's.
+std::vector<uint8_t> downscaleBox(const uint8_t* rgba, int width, int height,
+                                  int outWidth, int outHeight);
+
+/// Height that keeps the aspect ratio of width x height at `outWidth`
+/// (at least 1).
+int fitHeight(int width, int height, int outWidth);
+
+} // namespace ImageScale
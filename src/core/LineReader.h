@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <utility>
+
+/// Incremental '\n' splitter for streamed bodies.
+///
+/// feed() hands out every complete line as a string_view.  Lines that lie
+/// entirely inside one chunk point straight into that chunk (no copy); only
+/// a line straddling a chunk boundary is stitched together in an internal
+/// carry buffer, which is reused across lines.  Each byte is scanned once, so
+/// cost is linear in input size regardless of chunk size.
+///
+/// Views are valid only for the duration of the callback.  The '\n' is not
+/// included; empty lines are reported as empty views.
+class LineReader {
+public:
+    /// Split a chunk.  on_line(std::string_view) returns false to stop early,
+    /// in which case feed() returns false and the rest of the chunk is dropped.
+    template<typename Fn>
+    bool feed(const char* data, size_t len, Fn&& on_line) {
+        const char* p = data;
+        const char* end = data + len;
+
+        if (!m_carry.empty()) {
+            const char* nl = find(p, end);
+            if (!nl) {
+                m_carry.append(p, len);
+                return true;
+            }
+            m_carry.append(p, static_cast<size_t>(nl - p));
+            p = nl + 1;
+            bool keepGoing = on_line(std::string_view(m_carry));
+            m_carry.clear();  // keeps capacity for the next straddling line
+            if (!keepGoing) return false;
+        }
+
+        while (p < end) {
+            const char* nl = find(p, end);
+            if (!nl) {
+                m_carry.assign(p, static_cast<size_t>(end - p));
+                break;
+            }
+            if (!on_line(std::string_view(p, static_cast<size_t>(nl - p)))) return false;
+            p = nl + 1;
+        }
+        return true;
+    }
+
+    template<typename Fn>
+    bool feed(std::string_view chunk, Fn&& on_line) {
+        return feed(chunk.data(), chunk.size(), std::forward<Fn>(on_line));
+    }
+
+    /// Emit the trailing line that had no terminating '\n', if any.
+    template<typename Fn>
+    bool finish(Fn&& on_line) {
+        if (m_carry.empty()) return true;
+        bool keepGoing = on_line(std::string_view(m_carry));
+        m_carry.clear();
+        return keepGoing;
+    }
+
+    /// Bytes of an incomplete line held back from the last chunk.
+    size_t pending() const { return m_carry.size(); }
+
+    void reset() { m_carry.clear(); }
+
+private:
+    static const char* find(const char* p, const char* end) {
+        return static_cast<const char*>(std::memchr(p, '\n', static_cast<size_t>(end - p)));
+    }
+
+    std::string m_carry;
+};
@@ -0,0 +1,160 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+
+/// Counters of an MpscRing.
+struct MpscRingStats {
+    size_t depth = 0;          ///< items queued now (approximate while producers run)
+    size_t highWater = 0;      ///< largest depth seen
+    size_t capacity = 0;
+    uint64_t stalls = 0;       ///< pushes that found the ring full
+    double stallSeconds = 0.0; ///< total time producers waited for space
+};
+
+/// Lock-free bounded FIFO for many producers and one consumer.
+///
+/// A ring of slots, each carrying a sequence number that says whether it is
+/// free for the producer claiming position p (seq == p) or holds the item
+/// for the consumer at p (seq == p + 1).  Producers claim positions with one
+/// CAS on the tail; the consumer never contends with them.  Capacity is
+/// rounded up to a power of two.
+///
+/// push() applies backpressure: while the ring is full the producer backs
+/// off (yield, then sleeps of up to 1 ms) until a slot frees up or its stop
+/// predicate says to give up.  The time producers spend there is counted.
+template<typename T>
+class MpscRing {
+public:
+    using Stats = MpscRingStats;
+
+    explicit MpscRing(size_t capacity)
+        : m_capacity(roundUp(capacity)), m_mask(m_capacity - 1), m_slots(new Slot[m_capacity])
+    {
+        for (size_t i = 0; i < m_capacity; ++i) m_slots[i].seq.store(i, std::memory_order_relaxed);
+    }
+
+    MpscRing(const MpscRing&) = delete;
+    MpscRing& operator=(const MpscRing&) = delete;
+
+    /// Enqueue without waiting.  Returns false (item untouched) if full.
+    bool tryPush(T& item) {
+        size_t pos = m_tail.load(std::memory_order_relaxed);
+        Slot* slot;
+        for (;;) {
+            slot = &m_slots[pos & m_mask];
+            size_t seq = slot->seq.load(std::memory_order_acquire);
+            auto diff = static_cast<std::ptrdiff_t>(seq - pos);
+            if (diff == 0) {
+                if (m_tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            } else if (diff < 0) {
+                return false;  // the consumer has not freed this slot yet
+            } else {
+                pos = m_tail.load(std::memory_order_relaxed);
+            }
+        }
+        slot->value = std::move(item);
+        slot->seq.store(pos + 1, std::memory_order_release);
+
+        size_t depth = std::min(size(), m_capacity);
+        size_t high = m_highWater.load(std::memory_order_relaxed);
+        while (depth > high && !m_highWater.compare_exchange_weak(high, depth, std::memory_order_relaxed)) {}
+        return true;
+    }
+
+    /// Enqueue, waiting while the ring is full.  Returns false, dropping the
+    /// item, if stop() returns true before space frees up.
+    template<typename Stop>
+    bool push(T item, Stop&& stop) {
+        if (tryPush(item)) return true;
+
+        auto t0 = std::chrono::steady_clock::now();
+        m_stalls.fetch_add(1, std::memory_order_relaxed);
+        bool pushed = false;
+        for (int attempt = 0;; ++attempt) {
+            if (stop()) break;
+            if (attempt < 16) {
+                std::this_thread::yield();
+            } else {
+                int shift = std::min(attempt - 16, 5);
+                std::this_thread::sleep_for(std::chrono::microseconds(32 << shift));
+            }
+            if (tryPush(item)) {
+                pushed = true;
+                break;
+            }
+        }
+        auto waited = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - t0).count();
+        m_stallNanos.fetch_add(static_cast<uint64_t>(waited), std::memory_order_relaxed);
+        return pushed;
+    }
+
+    bool push(T item) {
+        return push(std::move(item), [] { return false; });
+    }
+
+    /// Dequeue the oldest item.  Single consumer only.  Returns false if
+    /// empty (an item whose producer has claimed but not filled its slot
+    /// counts as not there yet).
+    bool tryPop(T& out) {
+        size_t pos = m_head.load(std::memory_order_relaxed);
+        Slot& slot = m_slots[pos & m_mask];
+        size_t seq = slot.seq.load(std::memory_order_acquire);
+        if (static_cast<std::ptrdiff_t>(seq - (pos + 1)) < 0) return false;
+        out = std::move(slot.value);
+        slot.value = T{};  // release what the item owned now, not when the slot is reused
+        slot.seq.store(pos + m_capacity, std::memory_order_release);
+        m_head.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    /// Items queued, counting slots claimed but not yet filled.
+    size_t size() const {
+        // Head first: the tail never falls behind a head read earlier
+        size_t head = m_head.load(std::memory_order_acquire);
+        size_t tail = m_tail.load(std::memory_order_acquire);
+        return tail > head ? tail - head : 0;
+    }
+
+    size_t capacity() const { return m_capacity; }
+
+    Stats stats() const {
+        Stats s;
+        s.depth = size();
+        s.highWater = m_highWater.load(std::memory_order_relaxed);
+        s.capacity = m_capacity;
+        s.stalls = m_stalls.load(std::memory_order_relaxed);
+        s.stallSeconds = static_cast<double>(m_stallNanos.load(std::memory_order_relaxed)) * 1e-9;
+        return s;
+    }
+
+private:
+    struct Slot {
+        std::atomic<size_t> seq{0};
+        T value{};
+    };
+
+    static size_t roundUp(size_t n) {
+        size_t c = 2;
+        while (c < n) c <<= 1;
+        return c;
+    }
+
+    const size_t m_capacity;
+    const size_t m_mask;
+    std::unique_ptr<Slot[]> m_slots;
+
+    // Producers share the tail; the consumer owns the head
+    alignas(64) std::atomic<size_t> m_tail{0};
+    alignas(64) std::atomic<size_t> m_head{0};
+
+    alignas(64) std::atomic<size_t> m_highWater{0};
+    std::atomic<uint64_t> m_stalls{0};
+    std::atomic<uint64_t> m_stallNanos{0};
+};
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/// Fixed-size worker pool for CPU work that must stay off both the main
+/// thread and the network reactor (tile decode, image decode, ...).
+/// Tasks run in submission order across the workers.  The destructor runs
+/// every task already queued, then joins.
+class ThreadPool {
+public:
+    explicit ThreadPool(size_t threads) {
+        if (threads == 0) threads = 1;
+        m_threads.reserve(threads);
+        for (size_t i = 0; i < threads; ++i)
+            m_threads.emplace_back([this] { workerLoop(); });
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_cv.notify_all();
+        for (auto& t : m_threads) t.join();
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    void submit(std::function<void()> task) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_tasks.push_back(std::move(task));
+        }
+        m_cv.notify_one();
+    }
+
+    size_t size() const { return m_threads.size(); }
+
+    /// Tasks queued but not yet started.
+    size_t queued() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_tasks.size();
+    }
+
+private:
+    void workerLoop() {
+        for (;;) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_cv.wait(lock, [this] { return m_stop || !m_tasks.empty(); });
+                if (m_tasks.empty()) return;  // stopping and drained
+                task = std::move(m_tasks.front());
+                m_tasks.pop_front();
+            }
+            task();
+        }
+    }
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::deque<std::function<void()>> m_tasks;
+    std::vector<std::thread> m_threads;
+    bool m_stop = false;
+};
@@ -1,40 +1,143 @@
 #include "TimeUtils.h"
 #include <ctime>
-#include <iomanip>
-#include <sstream>
+#include <limits>
 #include <stdexcept>
 
+namespace {
+
+inline bool digit(char c) { return c >= '0' && c <= '9'; }
+
+// Read exactly n decimal digits starting at s[pos].
+inline bool readFixed(std::string_view s, size_t pos, size_t n, int& out)
+{
+    if (pos + n > s.size()) return false;
+    int v = 0;
+    for (size_t i = 0; i < n; ++i) {
+        char c = s[pos + i];
+        if (!digit(c)) return false;
+        v = v * 10 + (c - '0');
+    }
+    out = v;
+    return true;
+}
+
+} // namespace
+
 namespace TimeUtils {
 
-double parse_iso8601(const std::string& iso8601) {
-    std::tm tm = {};
-    std::istringstream ss(iso8601);
+int64_t days_from_civil(int64_t y, unsigned m, unsigned d)
+{
+    // Howard Hinnant's days_from_civil: eras of 400 years, March-based years
+    // so the leap day is the last day of the year.
+    y -= m <= 2;
+    const int64_t era = (y >= 0 ? y : y - 399) / 400;
+    const unsigned yoe = static_cast<unsigned>(y - era * 400);                 // [0, 399]
+    const unsigned doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;      // [0, 365]
+    const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;                // [0, 146096]
+    return era * 146097 + static_cast<int64_t>(doe) - 719468;
+}
+
+bool try_parse_iso8601(std::string_view s, double& out)
+{
+    // Fixed layout: YYYY-MM-DD?HH:MM:SS
+    //               0123456789012345678
+    int year, month, day, hour, minute, second;
+    if (!readFixed(s, 0, 4, year)   || s.size() < 19 || s[4] != '-' ||
+        !readFixed(s, 5, 2, month)  || s[7] != '-' ||
+        !readFixed(s, 8, 2, day)    ||
+        (s[10] != 'T' && s[10] != 't' && s[10] != ' ') ||
+        !readFixed(s, 11, 2, hour)  || s[13] != ':' ||
+        !readFixed(s, 14, 2, minute) || s[16] != ':' ||
+        !readFixed(s, 17, 2, second))
+        return false;
 
-    // Try parsing with 'Z' suffix
-    ss >> std::get_time(&tm, "%Y-%m-%dT%H:%M:%S");
+    if (month < 1 || month > 12 || day < 1 || day > 31 ||
+        hour > 24 || minute > 59 || second > 60)
+        return false;
 
-    if (ss.fail()) {
-        throw std::runtime_error("Failed to parse ISO 8601 timestamp: " + iso8601);
+    size_t pos = 19;
+
+    // Fractional seconds: any number of digits, first 9 are significant
+    double frac = 0.0;
+    if (pos < s.size() && (s[pos] == '.' || s[pos] == ',')) {
+        ++pos;
+        if (pos >= s.size() || !digit(s[pos])) return false;
+        int64_t num = 0;
+        int64_t den = 1;
+        while (pos < s.size() && digit(s[pos])) {
+            if (den < 1000000000) {
+                num = num * 10 + (s[pos] - '0');
+                den *= 10;
+            }
+            ++pos;
+        }
+        frac = static_cast<double>(num) / static_cast<double>(den);
+    }
+
+    // Zone designator: none (UTC), Z, or ±hh[:mm] / ±hhmm
+    int offsetSecs = 0;
+    if (pos < s.size()) {
+        char z = s[pos];
+        if (z == 'Z' || z == 'z') {
+            ++pos;
+        } else if (z == '+' || z == '-') {
+            int oh = 0, om = 0;
+            if (!readFixed(s, pos + 1, 2, oh)) return false;
+            pos += 3;
+            if (pos < s.size() && s[pos] == ':') ++pos;
+            if (pos < s.size()) {
+                if (!readFixed(s, pos, 2, om)) return false;
+                pos += 2;
+            }
+            if (oh > 23 || om > 59) return false;
+            offsetSecs = (oh * 3600 + om * 60) * (z == '-' ? -1 : 1);
+        } else {
+            return false;
+        }
     }
+    if (pos != s.size()) return false;
+
+    int64_t days = days_from_civil(year, static_cast<unsigned>(month), static_cast<unsigned>(day));
+    int64_t secs = days * 86400 + hour * 3600 + minute * 60 + second - offsetSecs;
+    out = static_cast<double>(secs) + frac;
+    return true;
+}
+
+double parse_iso8601(std::string_view iso8601)
+{
+    double ts;
+    if (!try_parse_iso8601(iso8601, ts))
+        throw std::runtime_error("Failed to parse ISO 8601 timestamp: " + std::string(iso8601));
+    return ts;
+}
 
-    // Convert to unix timestamp (assumes UTC)
-    #ifdef _WIN32
-        return static_cast<double>(_mkgmtime(&tm));
-    #else
-        return static_cast<double>(timegm(&tm));
-    #endif
+size_t parse_iso8601_batch(const std::string_view* in, double* out, size_t count)
+{
+    size_t ok = 0;
+    for (size_t i = 0; i < count; ++i) {
+        double ts = std::numeric_limits<double>::quiet_NaN();
+        ok += try_parse_iso8601(in[i], ts) ? 1 : 0;
+        out[i] = ts;
+    }
+    return ok;
 }
 
 std::string to_iso8601(double timestamp) {
     std::time_t t = static_cast<std::time_t>(timestamp);
-    std::tm* tm = std::gmtime(&t);
 
-    if (!tm) {
+    // Reentrant variants: this runs on fetch and export worker threads
+    std::tm tm{};
+#if defined(_WIN32)
+    bool ok = gmtime_s(&tm, &t) == 0;
+#else
+    bool ok = gmtime_r(&t, &tm) != nullptr;
+#endif
+    if (!ok) {
         throw std::runtime_error("Failed to convert timestamp to ISO 8601");
     }
 
     char buf[32];
-    std::strftime(buf, sizeof(buf), "%Y-%m-%dT%H:%M:%SZ", tm);
+    std::strftime(buf, sizeof(buf), "%Y-%m-%dT%H:%M:%SZ", &tm);
     return std::string(buf);
 }
 
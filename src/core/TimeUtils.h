@@ -1,15 +1,31 @@
 #pragma once
 
 #include <string>
+#include <string_view>
+#include <cstddef>
+#include <cstdint>
 
 /// Utilities for converting between ISO 8601 strings and unix timestamps
 namespace TimeUtils {
 
     /// Parse an ISO 8601 timestamp string to unix timestamp (seconds since epoch)
-    /// Format: "YYYY-MM-DDTHH:MM:SSZ" or "YYYY-MM-DDTHH:MM:SS"
+    /// Format: "YYYY-MM-DDTHH:MM:SS[.fff...][Z|+hh:mm|-hh:mm]" ('T' may also be a space).
+    /// No suffix means UTC.  Locale-independent, no allocations.
     /// @param iso8601 ISO 8601 formatted string
     /// @return Unix timestamp as double (seconds since epoch)
-    double parse_iso8601(const std::string& iso8601);
+    /// @throws std::runtime_error if the string is not in the expected format
+    double parse_iso8601(std::string_view iso8601);
+
+    /// Non-throwing variant of parse_iso8601. Returns false (and leaves out
+    /// untouched) if the string is not a valid timestamp.
+    bool try_parse_iso8601(std::string_view iso8601, double& out);
+
+    /// Parse count timestamps in one call. Invalid entries produce NaN.
+    /// @return Number of entries that parsed successfully
+    size_t parse_iso8601_batch(const std::string_view* in, double* out, size_t count);
+
+    /// Days since 1970-01-01 for a proleptic Gregorian date (month 1-12, day 1-31).
+    int64_t days_from_civil(int64_t year, unsigned month, unsigned day);
 
     /// Convert unix timestamp to ISO 8601 string
     /// @param timestamp Unix timestamp (seconds since epoch)
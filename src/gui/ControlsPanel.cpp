@@ -6,6 +6,7 @@ void ControlsPanel::draw(
     const BackendConfig& backendConfig,
     char* backendUrl, size_t backendUrlSize,
     const ServerStats& serverStats, bool hasServerStats,
+    const MpscRingStats& batchQueue, double drainBudget,
     const Renderer& renderer,
     const TimelineRenderer& timelineRenderer,
     const Camera& camera,
@@ -24,13 +25,30 @@ void ControlsPanel::draw(
     ImGui::Separator();
     ImGui::Text("Backend Configuration:");
 
-    const char* backend_types[] = {"Fake Data", "HTTP Backend"};
+    const char* backend_types[] = {"Fake Data", "HTTP Backend", "HTTP + Local Cache", "Synthetic Data"};
     int current_type = static_cast<int>(backendConfig.type);
-    if (ImGui::Combo("Backend Type", &current_type, backend_types, 2))
+    if (ImGui::Combo("Backend Type", &current_type, backend_types, 4))
         actions.switchBackendType = current_type;
 
-    if (backendConfig.type == BackendConfig::Type::Http) {
+    bool viewport = backendConfig.viewportFetch;
+    if (ImGui::Checkbox("Load visible region only", &viewport))
+        actions.viewportFetch = viewport ? 1 : 0;
+
+    bool dedupe = backendConfig.dedupeTimeline;
+    if (ImGui::Checkbox("Hide Timeline fixes GPS has", &dedupe))
+        actions.dedupeTimeline = dedupe ? 1 : 0;
+
+    if (backendConfig.type == BackendConfig::Type::Synthetic) {
+        static int millions = -1;
+        if (millions < 0) millions = static_cast<int>(backendConfig.syntheticGpsPoints / 1000000);
+        ImGui::SliderInt("GPS points (M)", &millions, 1, 50);
+        if (ImGui::Button("Regenerate"))
+            actions.syntheticMillions = millions;
+    } else if (backendConfig.type != BackendConfig::Type::Fake) {
         ImGui::InputText("Backend URL", backendUrl, backendUrlSize);
+        int shards = backendConfig.exportShards;
+        if (ImGui::SliderInt("Export shards", &shards, 1, 16))
+            actions.exportShards = shards;
         if (ImGui::Button("Apply HTTP Config"))
             actions.applyHttpConfig = true;
     }
@@ -103,6 +121,17 @@ void ControlsPanel::draw(
     }
 
     ImGui::Text("Points rendered: %d", renderer.totalPoints());
+    size_t entityBytes = 0;
+    for (const auto& layer : model.layers) entityBytes += layer.entities.memoryBytes();
+    ImGui::Text("Entity memory: %.1f MB", static_cast<double>(entityBytes) / 1e6);
+    ImGui::Text("Batch queue: %zu / %zu (peak %zu)",
+        batchQueue.depth, batchQueue.capacity, batchQueue.highWater);
+    if (batchQueue.stalls > 0)
+        ImGui::Text("  Producers stalled %llu times, %.0f ms",
+            static_cast<unsigned long long>(batchQueue.stalls), batchQueue.stallSeconds * 1000.0);
+    float budgetMs = static_cast<float>(drainBudget * 1000.0);
+    if (ImGui::SliderFloat("Ingest ms/frame", &budgetMs, 0.5f, 16.0f, "%.1f"))
+        actions.drainBudgetMs = budgetMs;
 
     if (model.fetch_latencies.count() > 0) {
         ImGui::Separator();
@@ -146,6 +175,11 @@ void ControlsPanel::draw(
     ImGui::Separator();
     if (ImGui::Button("Reload All Data"))
         actions.reloadAllData = true;
+    if (backendConfig.type == BackendConfig::Type::Cached) {
+        ImGui::SameLine();
+        if (ImGui::Button("Sync Cache"))
+            actions.syncCache = true;
+    }
 
     ImGui::Separator();
     ImGui::Text("Map: center (%.4f, %.4f) zoom %.4f",
@@ -7,6 +7,7 @@
 #include "Renderer.h"
 #include "TimelineRenderer.h"
 #include "core/FpsTracker.h"
+#include "core/MpscRing.h"
 
 /// Actions requested by the controls panel UI.
 /// MainScreen inspects these after draw() and performs the actual mutations.
@@ -14,10 +15,16 @@ struct ControlsActions {
     bool resetMap{false};
     bool resetTimeline{false};
     bool reloadAllData{false};
+    bool syncCache{false};  // fetch only the changed cache buckets
 
     // -1 means no change requested
     int switchBackendType{-1};
     bool applyHttpConfig{false};
+    int exportShards{-1};  // takes effect on the next Apply
+    int viewportFetch{-1};  // 0/1: reload with/without visible-region loading
+    int dedupeTimeline{-1};  // 0/1: reload keeping/dropping Timeline fixes GPS has
+    int syntheticMillions{-1};  // regenerate with this many million GPS points
+    float drainBudgetMs{-1.0f};  // per-frame time for applying fetched batches
 
     // Rendering changes (-1 = no change)
     int tileMode{-1};
@@ -39,6 +46,7 @@ public:
         const BackendConfig& backendConfig,
         char* backendUrl, size_t backendUrlSize,
         const ServerStats& serverStats, bool hasServerStats,
+        const MpscRingStats& batchQueue, double drainBudget,
         const Renderer& renderer,
         const TimelineRenderer& timelineRenderer,
         const Camera& camera,
@@ -1,6 +1,20 @@
 #include "BackendAPI.h"
+#include "ColumnarFormat.h"
+#include "EntityScanner.h"
 #include "core/TimeUtils.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <deque>
+#include <exception>
 #include <iostream>
+#include <iterator>
+#include <limits>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
 
 BackendAPI::BackendAPI(const std::string& base_url, const std::string& api_key)
     : base_url_(base_url)
@@ -33,7 +47,7 @@ ServerStats BackendAPI::fetch_stats() {
     return stats;
 }
 
-std::vector<Entity> BackendAPI::fetch_bbox(
+nlohmann::json BackendAPI::bbox_request(
     const std::string& type,
     const TimeExtent& time_extent,
     const SpatialExtent& spatial_extent,
@@ -60,7 +74,17 @@ std::vector<Entity> BackendAPI::fetch_bbox(
     if (!order.empty()) {
         request["order"] = order;
     }
+    return request;
+}
 
+std::vector<Entity> BackendAPI::fetch_bbox(
+    const std::string& type,
+    const TimeExtent& time_extent,
+    const SpatialExtent& spatial_extent,
+    int limit,
+    const std::string& order
+) {
+    nlohmann::json request = bbox_request(type, time_extent, spatial_extent, limit, order);
     try {
         nlohmann::json response = http_client_.post(base_url_ + "/v1/query/bbox", request);
         return parse_entities(response["entities"]);
@@ -70,6 +94,18 @@ std::vector<Entity> BackendAPI::fetch_bbox(
     }
 }
 
+std::vector<Entity> BackendAPI::fetch_region(
+    const std::string& type,
+    const TimeExtent& time_extent,
+    const SpatialExtent& spatial_extent,
+    int limit
+) {
+    // Oldest first, so a truncated result is at least a contiguous prefix
+    nlohmann::json request = bbox_request(type, time_extent, spatial_extent, limit, "t_start_asc");
+    nlohmann::json response = http_client_.post(base_url_ + "/v1/query/bbox", request);
+    return parse_entities(response.at("entities"));
+}
+
 std::vector<Entity> BackendAPI::fetch_time(
     const std::string& type,
     const TimeExtent& time_extent,
@@ -97,34 +133,492 @@ std::vector<Entity> BackendAPI::fetch_time(
     }
 }
 
+std::vector<Entity> BackendAPI::parse_entities_raw(std::string_view body)
+{
+    std::vector<std::string_view> elements;
+    if (!EntityScanner::splitArray(body, "entities", elements)) {
+        // Unexpected shape: let the DOM parser produce the error (or result)
+        nlohmann::json j = nlohmann::json::parse(body.begin(), body.end());
+        std::vector<Entity> result;
+        for (const auto& e : j.at("entities")) result.push_back(parse_entity(e));
+        return result;
+    }
+
+    EntityScanner scanner;
+    std::vector<Entity> result(elements.size());
+    for (size_t i = 0; i < elements.size(); ++i) {
+        if (!scanner.scan(elements[i], result[i]))
+            result[i] = parse_entity(nlohmann::json::parse(elements[i].begin(), elements[i].end()));
+    }
+    return result;
+}
+
+void BackendAPI::stream_time_pages(
+    const std::string& type,
+    const TimeExtent& time_extent,
+    const std::function<bool(std::vector<Entity>&&)>& on_page,
+    int page_size)
+{
+    auto request_page = [&](double start) {
+        nlohmann::json request = {
+            {"types", nlohmann::json::array({type})},
+            {"start", TimeUtils::to_iso8601(start)},
+            {"end", TimeUtils::to_iso8601(time_extent.end)},
+            {"limit", page_size},
+            {"order", "t_start_asc"}
+        };
+        return http_client_.post_raw_async(base_url_ + "/v1/query/time", request);
+    };
+
+    // Rows already delivered from the cursor's second, which the next page
+    // requests again
+    std::unordered_set<std::string> boundaryIds;
+    double boundarySecond = -1.0;
+    size_t largestPage = 0;
+
+    std::future<std::string> next = request_page(time_extent.start);
+    while (next.valid()) {
+        std::string body = next.get();
+        std::vector<Entity> page = parse_entities_raw(body);
+        body.clear();
+        body.shrink_to_fit();
+        largestPage = std::max(largestPage, page.size());
+
+        // Drop the overlap with the previous page
+        size_t received = page.size();
+        page.erase(std::remove_if(page.begin(), page.end(), [&](const Entity& e) {
+            return std::floor(e.time_start) == boundarySecond && boundaryIds.count(e.id) > 0;
+        }), page.end());
+
+        if (page.empty()) {
+            // Either the end of the range, or a whole page of rows sharing the
+            // cursor's second (more than the server will return at once)
+            if (received > 1 && received == largestPage) {
+                std::cerr << "Backend stream_time_pages: more than " << received
+                          << " '" << type << "' rows at " << TimeUtils::to_iso8601(boundarySecond)
+                          << "; skipping the rest of that second" << std::endl;
+                boundaryIds.clear();
+                boundarySecond += 1.0;
+                next = request_page(boundarySecond);
+                continue;
+            }
+            break;
+        }
+
+        // Advance the cursor and prefetch the next page before handing this one over
+        double cursorSecond = std::floor(page.back().time_start);
+        if (cursorSecond != boundarySecond) {
+            boundaryIds.clear();
+            boundarySecond = cursorSecond;
+        }
+        for (auto it = page.rbegin(); it != page.rend() && std::floor(it->time_start) == boundarySecond; ++it)
+            boundaryIds.insert(it->id);
+        next = request_page(boundarySecond);
+
+        if (!on_page(std::move(page))) break;
+    }
+    // An abandoned prefetch finishes on the transport; its future is discarded
+}
+
 void BackendAPI::fetch_export(
     std::function<void(size_t)> on_total,
-    std::function<bool(Entity&&)> on_entity)
+    std::function<bool(std::vector<Entity>&&)> on_batch)
 {
-    bool first_line = true;
+    fetch_export_columns(std::move(on_total), toColumns(std::move(on_batch)));
+}
 
-    http_client_.get_stream(base_url_ + "/v1/query/export",
-        [&](const std::string& line) -> bool {
-            try {
-                auto j = nlohmann::json::parse(line);
+void BackendAPI::fetch_export_columns(std::function<void(size_t)> on_total, ColumnsCallback on_batch)
+{
+    constexpr double inf = std::numeric_limits<double>::infinity();
+    stream_export_resumable(TimeExtent{-inf, inf}, std::move(on_total), std::move(on_batch));
+}
 
-                if (first_line) {
-                    first_line = false;
-                    if (j.contains("total")) {
-                        on_total(j["total"].get<size_t>());
-                        return true;
+BackendAPI::ColumnsCallback BackendAPI::toColumns(std::function<bool(std::vector<Entity>&&)> on_batch)
+{
+    return [on_batch = std::move(on_batch)](EntityColumns&& batch) {
+        return on_batch(batch.toEntities());
+    };
+}
+
+std::string BackendAPI::export_url(double start, double end) const
+{
+    std::string url = base_url_ + "/v1/query/export";
+    char sep = '?';
+    if (std::isfinite(start)) { url += sep + ("start=" + TimeUtils::to_iso8601(start)); sep = '&'; }
+    if (std::isfinite(end))   { url += sep + ("end=" + TimeUtils::to_iso8601(end)); }
+    return url;
+}
+
+void BackendAPI::stream_export_resumable(
+    const TimeExtent& range,
+    std::function<void(size_t)> on_total,
+    ColumnsCallback on_batch,
+    IngestPipeline::Config config,
+    const std::function<bool()>& stop)
+{
+    constexpr double inf = std::numeric_limits<double>::infinity();
+
+    // Checkpoint: every row before `second` was delivered, and so were the
+    // rows of `second` itself listed in `ids`.  Batches arrive in stream
+    // order, one at a time, so no locking is needed.
+    double second = -inf;
+    std::unordered_set<std::string> ids;
+    size_t delivered = 0;
+    bool ordered = true;
+    bool totalReported = false;
+    int failures = 0;
+
+    for (;;) {
+        size_t deliveredBefore = delivered;
+        double lastSeen = -inf;  // ordering check, per attempt
+        const double resumeSecond = second;
+        const std::unordered_set<std::string> resumeIds = ids;
+        double start = std::max(range.start, second);
+
+        try {
+            stream_export(export_url(start, range.end),
+                [&](size_t total) {
+                    // A resumed stream only counts what is left; keep the first total
+                    if (totalReported) return;
+                    totalReported = true;
+                    if (on_total) on_total(total);
+                },
+                [&](EntityColumns&& batch) -> bool {
+                    batch.filter([&](size_t i) {
+                        double t = batch.time_start[i];
+                        if (t < lastSeen) ordered = false;
+                        lastSeen = std::max(lastSeen, t);
+                        if (!(t >= range.start && t < range.end)) return false;
+                        double s = std::floor(t);
+                        return !(s < resumeSecond ||
+                                 (s == resumeSecond && resumeIds.count(std::string(batch.idAt(i))) > 0));
+                    });
+                    if (batch.empty()) return true;
+
+                    // The checkpoint only needs the ids of the latest second,
+                    // which (the stream being ordered) close the batch
+                    double last = -inf;
+                    for (double t : batch.time_start) last = std::max(last, std::floor(t));
+                    if (last > second) {
+                        second = last;
+                        ids.clear();
                     }
-                    // Unexpected first line — fall through and parse as entity
-                }
+                    for (size_t i = batch.size(); i-- > 0 && std::floor(batch.time_start[i]) == second;)
+                        ids.emplace(batch.idAt(i));
+                    delivered += batch.size();
+                    return on_batch(std::move(batch));
+                },
+                config);
+            return;  // complete, or stopped by on_batch
+        } catch (const std::exception& e) {
+            auto stopRequested = [&] {
+                return (stop && stop()) || (export_retry_.cancelled && export_retry_.cancelled());
+            };
+            if (stopRequested()) return;
+            if (!ordered) {
+                std::cerr << "[EXPORT] stream is not ordered by t_start; cannot resume" << std::endl;
+                throw;
+            }
+            if (delivered > deliveredBefore) failures = 0;  // progress resets the budget
+            if (++failures >= export_retry_.maxAttempts) throw;
 
-                return on_entity(parse_entity(j));
-            } catch (const nlohmann::json::exception& ex) {
-                std::cerr << "Export JSON parse error: " << ex.what() << std::endl;
-                return true;  // Skip bad line, keep streaming
+            double delay = std::min(export_retry_.maxBackoffSec,
+                                    export_retry_.initialBackoffSec * std::pow(2.0, failures - 1));
+            std::cerr << "[EXPORT] stream failed after " << delivered << " entities (" << e.what()
+                      << "); resuming" << (std::isfinite(second) ? " from " + TimeUtils::to_iso8601(second) : "")
+                      << " in " << delay << "s" << std::endl;
+
+            auto wakeAt = std::chrono::steady_clock::now() + std::chrono::duration<double>(delay);
+            while (std::chrono::steady_clock::now() < wakeAt) {
+                if (stopRequested()) return;
+                std::this_thread::sleep_for(std::chrono::milliseconds(20));
             }
+        }
+    }
+}
+
+void BackendAPI::stream_export(
+    const std::string& url,
+    std::function<void(size_t)> on_total,
+    ColumnsCallback on_batch,
+    IngestPipeline::Config config)
+{
+    decode_stream(
+        [&](const std::function<bool(const char*, size_t)>& sink, const std::string& accept) {
+            http_client_.get_raw_stream(url, sink, accept);
+        },
+        std::move(on_total), std::move(on_batch), config);
+}
+
+void BackendAPI::decode_stream(
+    const RawTransfer& transfer,
+    std::function<void(size_t)> on_total,
+    ColumnsCallback on_batch,
+    IngestPipeline::Config config)
+{
+    // The body's first bytes pick the decoder.  Columnar blocks decode here,
+    // on the consuming thread (there is no text to parse); NDJSON goes to an
+    // IngestPipeline, where inflate, line splitting and parsing run on the
+    // pipeline's own threads.
+    std::unique_ptr<IngestPipeline> pipeline;
+    std::unique_ptr<ColumnarFormat::Decoder> columnar;
+    std::string head;
+    bool stopped = false;
+    std::exception_ptr decode_error;
+
+    auto consume = [&](const char* data, size_t len) -> bool {
+        if (pipeline) return pipeline->push(data, len);
+        try {
+            // Throwing through the transport would leave the transfer
+            // running, so a bad block stops the stream and rethrows below.
+            if (!columnar->feedColumns(data, len, on_total, on_batch)) stopped = true;
+        } catch (...) {
+            decode_error = std::current_exception();
+            stopped = true;
+        }
+        return !stopped;
+    };
+    auto choose = [&] {
+        if (ColumnarFormat::sniff(head.data(), head.size()))
+            columnar = std::make_unique<ColumnarFormat::Decoder>();
+        else
+            pipeline = std::make_unique<IngestPipeline>(on_total, on_batch, config);
+    };
+
+    std::exception_ptr network_error;
+    try {
+        transfer(
+            [&](const char* data, size_t len) {
+                if (columnar || pipeline) return consume(data, len);
+                head.append(data, len);
+                if (head.size() < ColumnarFormat::kMagicSize) return true;
+                choose();
+                bool keepGoing = consume(head.data(), head.size());
+                head.clear();
+                return keepGoing;
+            },
+            columnar_export_ ? std::string(ColumnarFormat::kContentType) + ", application/x-ndjson;q=0.5"
+                             : std::string());
+    } catch (...) {
+        network_error = std::current_exception();
+    }
+
+    if (!columnar && !pipeline) {
+        // Body shorter than the magic (or nothing arrived)
+        choose();
+        if (!head.empty()) consume(head.data(), head.size());
+    }
+
+    // Deliver whatever arrived before any network error
+    if (pipeline) pipeline->finish();
+    if (decode_error) std::rethrow_exception(decode_error);
+    if (network_error) std::rethrow_exception(network_error);
+    if (columnar && !stopped) columnar->finish();
+}
+
+std::vector<BucketSummary> BackendAPI::fetch_bucket_hashes(const std::string& type, int bucket_seconds)
+{
+    // Authenticated, unlike /stats, hence get_bytes rather than get
+    std::vector<uint8_t> body = http_client_.get_bytes(
+        base_url_ + "/v1/cache/bucket-hashes?type=" + type + "&bucket_seconds=" + std::to_string(bucket_seconds));
+
+    std::vector<BucketSummary> buckets;
+    try {
+        nlohmann::json response = nlohmann::json::parse(body.begin(), body.end());
+        for (const auto& b : response.at("buckets")) {
+            BucketSummary s;
+            s.start = TimeUtils::parse_iso8601(b.at("start").get<std::string>());
+            s.end = TimeUtils::parse_iso8601(b.at("end").get<std::string>());
+            s.count = b.at("count").get<size_t>();
+            // xxHash64 as 16 hex digits
+            s.hash = std::stoull(b.at("hash").get<std::string>(), nullptr, 16);
+            buckets.push_back(s);
+        }
+    } catch (const std::exception& e) {
+        throw std::runtime_error(std::string("Malformed bucket-hashes response: ") + e.what());
+    }
+    return buckets;
+}
+
+void BackendAPI::stream_bucket_data(
+    const std::string& type,
+    const std::vector<TimeExtent>& buckets,
+    std::function<bool(std::vector<Entity>&&)> on_batch)
+{
+    nlohmann::json request = {{"type", type}, {"buckets", nlohmann::json::array()}};
+    for (const auto& b : buckets)
+        request["buckets"].push_back({{"start", TimeUtils::to_iso8601(b.start)},
+                                      {"end", TimeUtils::to_iso8601(b.end)}});
+
+    auto inBuckets = [&buckets](double t) {
+        auto it = std::upper_bound(buckets.begin(), buckets.end(), t,
+                                   [](double v, const TimeExtent& b) { return v < b.start; });
+        return it != buckets.begin() && t < std::prev(it)->end;
+    };
+
+    decode_stream(
+        [&](const std::function<bool(const char*, size_t)>& sink, const std::string& accept) {
+            http_client_.post_raw_stream(base_url_ + "/v1/cache/bucket-data", request, sink, accept);
+        },
+        [](size_t) {},
+        [&](EntityColumns&& batch) -> bool {
+            batch.filter([&](size_t i) { return inBuckets(batch.time_start[i]); });
+            return batch.empty() || on_batch(batch.toEntities());
         });
 }
 
+std::vector<TimeExtent> BackendAPI::export_shard_ranges(double oldest, double newest, int shards)
+{
+    constexpr double inf = std::numeric_limits<double>::infinity();
+    std::vector<double> cuts;
+    if (shards > 1 && newest > oldest) {
+        double step = (newest - oldest) / shards;
+        for (int i = 1; i < shards; ++i) {
+            double cut = std::floor(oldest + step * i);
+            if (cut > oldest && (cuts.empty() || cut > cuts.back())) cuts.push_back(cut);
+        }
+    }
+
+    std::vector<TimeExtent> ranges;
+    double start = -inf;
+    for (double cut : cuts) {
+        ranges.push_back({start, cut});
+        start = cut;
+    }
+    ranges.push_back({start, inf});
+    return ranges;
+}
+
+void BackendAPI::fetch_export_sharded(
+    const ServerStats& stats,
+    int shards,
+    std::function<void(size_t)> on_total,
+    std::function<bool(std::vector<Entity>&&)> on_batch)
+{
+    fetch_export_sharded_columns(stats, shards, std::move(on_total), toColumns(std::move(on_batch)));
+}
+
+void BackendAPI::fetch_export_sharded_columns(
+    const ServerStats& stats,
+    int shards,
+    std::function<void(size_t)> on_total,
+    ColumnsCallback on_batch)
+{
+    double oldest = 0.0, newest = 0.0;
+    bool haveCoverage = TimeUtils::try_parse_iso8601(stats.oldest_time, oldest) &&
+                        TimeUtils::try_parse_iso8601(stats.newest_time, newest);
+    std::vector<TimeExtent> ranges = haveCoverage
+        ? export_shard_ranges(oldest, newest, shards)
+        : std::vector<TimeExtent>(1);
+    if (ranges.size() <= 1) {
+        fetch_export_columns(std::move(on_total), std::move(on_batch));
+        return;
+    }
+
+    const size_t n = ranges.size();
+
+    // Split the parse workers between the shards instead of oversubscribing
+    IngestPipeline::Config config;
+    size_t hw = std::max(2u, std::thread::hardware_concurrency());
+    config.parseWorkers = std::max<size_t>(1, (hw - 1) / n);
+
+    struct Shard {
+        std::deque<EntityColumns> batches;
+        bool done = false;
+        std::exception_ptr error;
+    };
+    std::vector<Shard> state(n);
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::atomic<bool> cancelled{false};
+    const size_t maxQueued = shard_queue_batches_;
+    size_t highWater = 0;
+
+    size_t totalsReported = 0;
+    size_t totalSum = 0;
+    auto on_shard_total = [&](size_t total) {
+        size_t sum;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            totalSum += total;
+            if (++totalsReported != n) return;
+            sum = totalSum;
+        }
+        if (stats.total_entities > 0 && sum > static_cast<size_t>(stats.total_entities)) {
+            std::cerr << "[EXPORT] shard totals (" << sum << ") exceed server total ("
+                      << stats.total_entities << "); server may ignore start/end" << std::endl;
+            sum = static_cast<size_t>(stats.total_entities);
+        }
+        if (on_total) on_total(sum);
+    };
+
+    std::vector<std::thread> workers;
+    workers.reserve(n);
+    for (size_t i = 0; i < n; ++i) {
+        workers.emplace_back([&, i] {
+            try {
+                stream_export_resumable(ranges[i], on_shard_total,
+                    [&, i](EntityColumns&& batch) {
+                        // A full queue waits for the consumer, holding up this
+                        // shard's pipeline and so its transfer
+                        std::unique_lock<std::mutex> lock(mutex);
+                        cv.wait(lock, [&] { return state[i].batches.size() < maxQueued || cancelled.load(); });
+                        if (cancelled.load()) return false;
+                        state[i].batches.push_back(std::move(batch));
+                        highWater = std::max(highWater, state[i].batches.size());
+                        cv.notify_all();
+                        return true;
+                    },
+                    config,
+                    [&cancelled] { return cancelled.load(); });
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(mutex);
+                state[i].error = std::current_exception();
+            }
+            std::lock_guard<std::mutex> lock(mutex);
+            state[i].done = true;
+            cv.notify_all();
+        });
+    }
+
+    // Reassemble on the calling thread, strictly in shard order
+    std::exception_ptr error;
+    for (size_t i = 0; i < n && !cancelled.load(); ++i) {
+        for (;;) {
+            EntityColumns batch;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                cv.wait(lock, [&] { return !state[i].batches.empty() || state[i].done; });
+                if (state[i].batches.empty()) {
+                    if (state[i].error) {
+                        error = state[i].error;
+                        cancelled.store(true);
+                    }
+                    break;
+                }
+                batch = std::move(state[i].batches.front());
+                state[i].batches.pop_front();
+            }
+            cv.notify_all();  // room for the producer
+            if (!on_batch(std::move(batch))) {
+                cancelled.store(true);
+                break;
+            }
+        }
+    }
+
+    // Stop any shard still streaming after an early exit, waking producers
+    // blocked on a full queue
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        cancelled.store(true);
+    }
+    cv.notify_all();
+    for (auto& t : workers) t.join();
+    shard_queue_high_water_ = highWater;
+    if (error) std::rethrow_exception(error);
+}
+
 Entity BackendAPI::parse_entity(const nlohmann::json& j) {
     Entity e;
     e.id = j["id"].get<std::string>();
@@ -149,6 +643,10 @@ std::vector<uint8_t> BackendAPI::fetch_photo_thumb(const std::string& entity_id)
     return http_client_.get_bytes(base_url_ + "/v1/photo/" + entity_id + "/thumb");
 }
 
+std::future<std::vector<uint8_t>> BackendAPI::fetch_photo_thumb_async(const std::string& entity_id) {
+    return http_client_.get_bytes_async(base_url_ + "/v1/photo/" + entity_id + "/thumb");
+}
+
 std::vector<Entity> BackendAPI::parse_entities(const nlohmann::json& json_array) {
     std::vector<Entity> result;
     result.reserve(json_array.size());
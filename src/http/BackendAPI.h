@@ -1,10 +1,13 @@
 #pragma once
 
 #include "HttpClient.h"
+#include "IngestPipeline.h"
 #include "core/Entity.h"
+#include "core/EntityColumns.h"
 #include "core/TimeExtent.h"
 #include "AppModel.h"
 #include "Backend.h"
+#include <algorithm>
 #include <vector>
 #include <string>
 #include <functional>
@@ -12,8 +15,36 @@
 /// High-level API for fetching entities from the backend
 class BackendAPI {
 public:
+    /// How export streams recover from a dropped connection.
+    struct ExportRetry {
+        int maxAttempts = 6;              ///< Consecutive failures without progress before giving up
+        double initialBackoffSec = 0.5;   ///< Doubles after each failure
+        double maxBackoffSec = 30.0;
+        std::function<bool()> cancelled;  ///< Polled while backing off; true abandons the export
+    };
+
     explicit BackendAPI(const std::string& base_url, const std::string& api_key = "");
 
+    void set_export_retry(ExportRetry retry) { export_retry_ = std::move(retry); }
+    const ExportRetry& export_retry() const { return export_retry_; }
+
+    /// Ask the export for the columnar binary format (ColumnarFormat.h)
+    /// instead of NDJSON.  On by default; servers without it keep sending
+    /// NDJSON, which is detected from the body.
+    void set_columnar_export(bool enabled) { columnar_export_ = enabled; }
+    bool columnar_export() const { return columnar_export_; }
+
+    /// Batches a shard of fetch_export_sharded buffers at most by default
+    /// while it waits for the shards before it.
+    static constexpr size_t kShardQueueBatches = 8;
+
+    /// Past this many buffered batches a shard's stream pauses (the callback
+    /// waits, which stalls its pipeline and the transfer) until the shards
+    /// before it are delivered.  At least 1.
+    void set_shard_queue_batches(size_t batches) { shard_queue_batches_ = std::max<size_t>(1, batches); }
+    /// The most batches any one shard held during the last sharded export.
+    size_t shard_queue_high_water() const { return shard_queue_high_water_; }
+
     /// Fetch server statistics (GET /stats, no auth required)
     ServerStats fetch_stats();
 
@@ -31,6 +62,20 @@ public:
         const std::string& order = ""
     );
 
+    /// Rows per /v1/query/bbox request at most (the server's maximum).
+    static constexpr int kBboxMaxLimit = 10000;
+
+    /// One /v1/query/bbox request for viewport loading: like fetch_bbox,
+    /// but errors propagate so a failed region is retried rather than
+    /// recorded as empty.  A result of `limit` rows means it was truncated.
+    /// @throws std::runtime_error on network/HTTP errors
+    std::vector<Entity> fetch_region(
+        const std::string& type,
+        const TimeExtent& time_extent,
+        const SpatialExtent& spatial_extent,
+        int limit = kBboxMaxLimit
+    );
+
     /// Fetch entities via temporal-only query
     /// @param type Entity type (e.g., "calendar.event")
     /// @param time_extent Temporal bounds
@@ -43,29 +88,187 @@ public:
         const std::string& order = ""
     );
 
+    /// Rows per /v1/query/time request when paging (the server's maximum).
+    static constexpr int kTimePageSize = 10000;
+
+    /// Stream every entity of `type` in `time_extent`, oldest first, as one
+    /// batch per /v1/query/time page.
+    ///
+    /// Keyset pagination: each page starts at the last t_start of the one
+    /// before (the query API has no cursor and `start` is whole-second, so
+    /// the last second is re-requested), and rows already delivered from that
+    /// second are dropped by id.  Nothing is truncated and only two pages are
+    /// held at once.  The next page is requested as soon as the current one
+    /// arrives, so its transfer overlaps parsing and delivery of this one.
+    /// Pages are parsed with EntityScanner (DOM fallback per element).
+    /// Return false from on_page to stop.
+    /// @throws std::runtime_error on network/HTTP errors; earlier pages were
+    ///         already delivered
+    void stream_time_pages(
+        const std::string& type,
+        const TimeExtent& time_extent,
+        const std::function<bool(std::vector<Entity>&&)>& on_page,
+        int page_size = kTimePageSize
+    );
+
     /// Fetch the thumbnail image for a photo entity as raw JPEG/PNG bytes.
     /// Endpoint: GET /v1/photo/{entity_id}/thumb (X-API-Key header auth).
     std::vector<uint8_t> fetch_photo_thumb(const std::string& entity_id);
 
+    /// Non-blocking fetch_photo_thumb; resolves to empty bytes on failure.
+    std::future<std::vector<uint8_t>> fetch_photo_thumb_async(const std::string& entity_id);
+
     /// The configured API key (for external URL construction if needed).
     const std::string& apiKey() const { return http_client_.apiKey(); }
 
     /// Stream all entities from GET /v1/query/export (NDJSON).
     /// First line: {"total": N} — calls on_total once.
-    /// Subsequent lines: one entity JSON per line — calls on_entity for each.
-    /// Return false from on_entity to cancel the stream early.
+    /// Subsequent lines: one entity JSON per line, decoded by an IngestPipeline
+    /// and delivered as batches in stream order (one call at a time, from a
+    /// pipeline worker thread).
+    /// Return false from on_batch to cancel the stream early.
+    ///
+    /// The stream is resumable: it keeps a checkpoint (second and ids of the
+    /// last rows delivered) and, if the connection fails, reconnects with
+    /// ?start=<checkpoint> after a backoff (see ExportRetry), dropping rows it
+    /// already delivered.  No row is lost or repeated, and on_total still
+    /// fires once with the original total.  This relies on the export being
+    /// ordered by t_start; if rows arrive out of order the checkpoint is
+    /// unusable and the error is rethrown instead.
+    /// @throws std::runtime_error when retries are exhausted; batches
+    ///         received before the error are still delivered
     void fetch_export(
         std::function<void(size_t total)> on_total,
-        std::function<bool(Entity&&)> on_entity
+        std::function<bool(std::vector<Entity>&&)> on_batch
+    );
+
+    /// Return false to cancel, like the entity batch callbacks.
+    using ColumnsCallback = std::function<bool(EntityColumns&&)>;
+
+    /// fetch_export delivering EntityColumns.  The export is decoded straight
+    /// into columns; fetch_export converts each batch from them.
+    void fetch_export_columns(
+        std::function<void(size_t total)> on_total,
+        ColumnsCallback on_batch
+    );
+
+    /// Time-sharded export: split the server's time coverage into `shards`
+    /// ranges, stream each from /v1/query/export?start=..&end=.. on its own
+    /// connection and pipeline, and deliver the batches in time order (all of
+    /// shard 0, then shard 1, ...).  Shard 0 is delivered live; later shards
+    /// buffer up to set_shard_queue_batches() batches each, then pause until
+    /// their predecessors finish.
+    /// on_total is called once, with the sum of the shard totals.
+    /// Each shard also filters its entities to its own range, so the result
+    /// stays correct even if the server ignores start/end.
+    /// Falls back to fetch_export when the coverage is unknown or shards <= 1.
+    /// Every shard resumes on its own like fetch_export.
+    /// @throws std::runtime_error like fetch_export; batches before the first
+    ///         failed shard (and that shard's own) are still delivered
+    void fetch_export_sharded(
+        const ServerStats& stats,
+        int shards,
+        std::function<void(size_t total)> on_total,
+        std::function<bool(std::vector<Entity>&&)> on_batch
     );
 
+    /// fetch_export_sharded delivering EntityColumns.
+    void fetch_export_sharded_columns(
+        const ServerStats& stats,
+        int shards,
+        std::function<void(size_t total)> on_total,
+        ColumnsCallback on_batch
+    );
+
+    /// Split [oldest, newest] into up to `shards` contiguous ranges on whole-
+    /// second boundaries.  The first range starts at -inf and the last ends
+    /// at +inf so rows outside the reported coverage still land in a shard.
+    /// Each range is half-open: start <= t_start < end.
+    static std::vector<TimeExtent> export_shard_ranges(double oldest, double newest, int shards);
+
+    /// Per-bucket entity counts and content hashes for `type`
+    /// (GET /v1/cache/bucket-hashes), oldest bucket first.  Only buckets that
+    /// hold data are listed.
+    /// @throws std::runtime_error on network/HTTP errors or a malformed body
+    std::vector<BucketSummary> fetch_bucket_hashes(const std::string& type, int bucket_seconds);
+
+    /// Stream every entity of `type` with t_start in one of `buckets`
+    /// (POST /v1/cache/bucket-data; half-open, finite ranges) ordered by
+    /// (t_start, id).  The body is decoded like the export (columnar or
+    /// NDJSON) and rows outside the ranges are dropped.  Not resumable: a
+    /// failure rethrows after delivering what arrived.
+    /// Return false from on_batch to stop.
+    /// @throws std::runtime_error on network/HTTP/decode errors
+    void stream_bucket_data(
+        const std::string& type,
+        const std::vector<TimeExtent>& buckets,
+        std::function<bool(std::vector<Entity>&&)> on_batch
+    );
+
+    /// Parse a single entity from a JSON object (DOM path; the export stream
+    /// only falls back to it for lines EntityScanner rejects)
+    static Entity parse_entity(const nlohmann::json& j);
+
 private:
-    /// Parse a single entity from a JSON object
-    Entity parse_entity(const nlohmann::json& j);
+
+    /// Export one time range (half-open, infinite ends omitted from the
+    /// query), resuming from its checkpoint after failures.  Rows outside the
+    /// range are dropped.  `stop` is polled, with ExportRetry::cancelled,
+    /// before and during each backoff.
+    void stream_export_resumable(
+        const TimeExtent& range,
+        std::function<void(size_t)> on_total,
+        ColumnsCallback on_batch,
+        IngestPipeline::Config config = {},
+        const std::function<bool()>& stop = {}
+    );
+
+    std::string export_url(double start, double end) const;
+
+    /// The /v1/query/bbox request body.
+    static nlohmann::json bbox_request(
+        const std::string& type,
+        const TimeExtent& time_extent,
+        const SpatialExtent& spatial_extent,
+        int limit,
+        const std::string& order
+    );
+
+    /// Stream one export URL through decode_stream.
+    void stream_export(
+        const std::string& url,
+        std::function<void(size_t)> on_total,
+        ColumnsCallback on_batch,
+        IngestPipeline::Config config = {}
+    );
+
+    /// Runs one request: passes body chunks to the sink (which returns false
+    /// to cancel) and sends the given Accept header.
+    using RawTransfer = std::function<void(const std::function<bool(const char*, size_t)>& sink,
+                                           const std::string& accept)>;
+
+    /// Decode an export-format body, with ColumnarFormat::Decoder or an
+    /// IngestPipeline depending on its leading bytes.
+    void decode_stream(
+        const RawTransfer& transfer,
+        std::function<void(size_t)> on_total,
+        ColumnsCallback on_batch,
+        IngestPipeline::Config config = {}
+    );
+
+    /// Adapts an entity batch callback to columns.
+    static ColumnsCallback toColumns(std::function<bool(std::vector<Entity>&&)> on_batch);
 
     /// Parse entities from JSON response
     std::vector<Entity> parse_entities(const nlohmann::json& json_array);
 
+    /// Parse a raw {"entities": [...]} body without building a DOM
+    static std::vector<Entity> parse_entities_raw(std::string_view body);
+
     std::string base_url_;
     HttpClient http_client_;
+    ExportRetry export_retry_;
+    bool columnar_export_ = true;
+    size_t shard_queue_batches_ = kShardQueueBatches;
+    size_t shard_queue_high_water_ = 0;
 };
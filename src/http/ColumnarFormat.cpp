@@ -0,0 +1,444 @@
+#include "ColumnarFormat.h"
+#include <zlib.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <string_view>
+#include <unordered_map>
+
+namespace ColumnarFormat {
+
+namespace {
+
+constexpr char kMagic[kMagicSize] = {'R', 'K', 'C', 'B'};
+constexpr uint16_t kVersion = 1;
+constexpr size_t kHeaderSize = 16;
+constexpr size_t kBlockHeaderSize = 12;
+constexpr uint32_t kMaxBlockPayload = 256u << 20;  // sanity bound against garbage lengths
+
+constexpr double kTimeScale = 1e6;   // microseconds
+constexpr double kCoordScale = 1e7;  // ~1 cm
+
+enum RowFlag : uint8_t {
+    kHasLat    = 1 << 0,
+    kHasLon    = 1 << 1,
+    kHasEnd    = 1 << 2,
+    kHasName   = 1 << 3,
+    kHasColor  = 1 << 4,
+    kHasRender = 1 << 5,
+};
+
+enum IdMode : uint8_t { kIdDictionary = 0, kIdUuid = 1 };
+
+// --- writing -----------------------------------------------------------
+
+void putU16(std::string& out, uint16_t v) {
+    char b[2] = {static_cast<char>(v), static_cast<char>(v >> 8)};
+    out.append(b, 2);
+}
+
+void putU32(std::string& out, uint32_t v) {
+    char b[4];
+    for (int i = 0; i < 4; ++i) b[i] = static_cast<char>(v >> (8 * i));
+    out.append(b, 4);
+}
+
+void putU64(std::string& out, uint64_t v) {
+    char b[8];
+    for (int i = 0; i < 8; ++i) b[i] = static_cast<char>(v >> (8 * i));
+    out.append(b, 8);
+}
+
+void putVarint(std::string& out, uint64_t v) {
+    while (v >= 0x80) {
+        out.push_back(static_cast<char>((v & 0x7f) | 0x80));
+        v >>= 7;
+    }
+    out.push_back(static_cast<char>(v));
+}
+
+inline uint64_t zigzag(int64_t v) { return (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63); }
+inline int64_t unzigzag(uint64_t v) { return static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1); }
+
+inline int hexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return -1;  // uppercase is not canonical: it would not round-trip
+}
+
+bool isCanonicalUuid(const std::string& s) {
+    if (s.size() != 36) return false;
+    for (size_t i = 0; i < 36; ++i) {
+        if (i == 8 || i == 13 || i == 18 || i == 23) {
+            if (s[i] != '-') return false;
+        } else if (hexValue(s[i]) < 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void putUuid(std::string& out, const std::string& s) {
+    char bytes[16];
+    size_t n = 0;
+    for (size_t i = 0; i < 36; i += (s[i] == '-') ? 1 : 2) {
+        if (s[i] == '-') continue;
+        bytes[n++] = static_cast<char>((hexValue(s[i]) << 4) | hexValue(s[i + 1]));
+    }
+    out.append(bytes, 16);
+}
+
+/// Dictionary column: unique strings in first-seen order, one index per value.
+struct Dictionary {
+    std::unordered_map<std::string_view, uint32_t> index;
+    std::vector<std::string_view> entries;
+    std::vector<uint32_t> refs;
+
+    void add(const std::string& s) {
+        auto [it, inserted] = index.emplace(s, static_cast<uint32_t>(entries.size()));
+        if (inserted) entries.push_back(s);
+        refs.push_back(it->second);
+    }
+
+    void write(std::string& out) const {
+        putVarint(out, entries.size());
+        for (auto s : entries) {
+            putVarint(out, s.size());
+            out.append(s.data(), s.size());
+        }
+        for (uint32_t r : refs) putVarint(out, r);
+    }
+};
+
+// --- reading -----------------------------------------------------------
+
+[[noreturn]] void malformed(const char* what) {
+    throw std::runtime_error(std::string("Columnar block is malformed: ") + what);
+}
+
+uint32_t getU32(const uint8_t* p) {
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+           (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+struct Reader {
+    const uint8_t* p;
+    const uint8_t* end;
+
+    uint8_t byte() {
+        if (p >= end) malformed("truncated");
+        return *p++;
+    }
+
+    uint64_t varint() {
+        uint64_t v = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            uint8_t b = byte();
+            v |= static_cast<uint64_t>(b & 0x7f) << shift;
+            if (!(b & 0x80)) return v;
+        }
+        malformed("varint too long");
+    }
+
+    const uint8_t* take(size_t n) {
+        if (static_cast<size_t>(end - p) < n) malformed("truncated");
+        const uint8_t* at = p;
+        p += n;
+        return at;
+    }
+
+    /// Reads a dictionary into `out`'s string pool.
+    std::vector<StringRef> dictionary(EntityColumns& out) {
+        uint64_t n = varint();
+        if (n > static_cast<uint64_t>(end - p)) malformed("dictionary size");
+        std::vector<StringRef> entries(static_cast<size_t>(n));
+        for (auto& s : entries) {
+            uint64_t len = varint();
+            if (len > static_cast<uint64_t>(end - p)) malformed("string length");
+            const uint8_t* at = take(static_cast<size_t>(len));
+            s = out.addString({reinterpret_cast<const char*>(at), static_cast<size_t>(len)});
+        }
+        return entries;
+    }
+
+    StringRef ref(const std::vector<StringRef>& dict) {
+        uint64_t i = varint();
+        if (i >= dict.size()) malformed("dictionary index");
+        return dict[static_cast<size_t>(i)];
+    }
+};
+
+} // namespace
+
+bool sniff(const char* data, size_t len)
+{
+    return len >= kMagicSize && std::memcmp(data, kMagic, kMagicSize) == 0;
+}
+
+void Encoder::writeHeader(std::string& out, uint64_t total)
+{
+    out.append(kMagic, kMagicSize);
+    putU16(out, kVersion);
+    putU16(out, 0);
+    putU64(out, total);
+}
+
+void Encoder::writeBlock(std::string& out, const Entity* rows, size_t count)
+{
+    if (count == 0) return;  // count 0 is the end marker
+
+    std::string payload;
+    payload.reserve(count * 24);
+
+    bool uuids = true;
+    for (size_t i = 0; i < count && uuids; ++i) uuids = isCanonicalUuid(rows[i].id);
+
+    for (size_t i = 0; i < count; ++i) {
+        const Entity& e = rows[i];
+        uint8_t flags = 0;
+        if (e.lat) flags |= kHasLat;
+        if (e.lon) flags |= kHasLon;
+        if (std::llround(e.time_end * kTimeScale) != std::llround(e.time_start * kTimeScale)) flags |= kHasEnd;
+        if (e.name) flags |= kHasName;
+        if (e.color) flags |= kHasColor;
+        if (e.render_offset != 0.0f) flags |= kHasRender;
+        payload.push_back(static_cast<char>(flags));
+    }
+
+    int64_t prev = 0;
+    for (size_t i = 0; i < count; ++i) {
+        int64_t t = std::llround(rows[i].time_start * kTimeScale);
+        putVarint(payload, zigzag(t - prev));
+        prev = t;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        const Entity& e = rows[i];
+        int64_t d = std::llround(e.time_end * kTimeScale) - std::llround(e.time_start * kTimeScale);
+        if (d != 0) putVarint(payload, zigzag(d));
+    }
+
+    auto coords = [&](const std::optional<double> Entity::*field) {
+        int64_t last = 0;
+        for (size_t i = 0; i < count; ++i) {
+            const auto& v = rows[i].*field;
+            if (!v) continue;
+            int64_t q = std::llround(*v * kCoordScale);
+            putVarint(payload, zigzag(q - last));
+            last = q;
+        }
+    };
+    coords(&Entity::lat);
+    coords(&Entity::lon);
+
+    if (uuids) {
+        payload.push_back(static_cast<char>(kIdUuid));
+        for (size_t i = 0; i < count; ++i) putUuid(payload, rows[i].id);
+    } else {
+        payload.push_back(static_cast<char>(kIdDictionary));
+        Dictionary ids;
+        for (size_t i = 0; i < count; ++i) ids.add(rows[i].id);
+        ids.write(payload);
+    }
+
+    Dictionary names, colors;
+    for (size_t i = 0; i < count; ++i) {
+        if (rows[i].name) names.add(*rows[i].name);
+        if (rows[i].color) colors.add(*rows[i].color);
+    }
+    names.write(payload);
+    colors.write(payload);
+
+    for (size_t i = 0; i < count; ++i) {
+        float f = rows[i].render_offset;
+        if (f == 0.0f) continue;
+        uint32_t bits;
+        std::memcpy(&bits, &f, 4);
+        putU32(payload, bits);
+    }
+
+    if (payload.size() > kMaxBlockPayload)
+        throw std::length_error("Columnar block too large; use fewer rows per block");
+
+    putU32(out, static_cast<uint32_t>(count));
+    putU32(out, static_cast<uint32_t>(payload.size()));
+    putU32(out, static_cast<uint32_t>(crc32(0L, reinterpret_cast<const Bytef*>(payload.data()),
+                                            static_cast<uInt>(payload.size()))));
+    out += payload;
+}
+
+void Encoder::writeEnd(std::string& out)
+{
+    putU32(out, 0);
+    putU32(out, 0);
+    putU32(out, 0);
+}
+
+std::string Encoder::encode(const std::vector<Entity>& rows, size_t blockRows)
+{
+    if (blockRows == 0) blockRows = kDefaultBlockRows;
+    std::string out;
+    writeHeader(out, rows.size());
+    for (size_t i = 0; i < rows.size(); i += blockRows)
+        writeBlock(out, rows.data() + i, std::min(blockRows, rows.size() - i));
+    writeEnd(out);
+    return out;
+}
+
+void Decoder::decodeBlock(const uint8_t* payload, size_t len, size_t count, EntityColumns& out)
+{
+    Reader r{payload, payload + len};
+    const uint8_t* flags = r.take(count);
+
+    const size_t base = out.size();
+    out.resize(base + count);
+    double* timeStart = out.time_start.data() + base;
+    double* timeEnd = out.time_end.data() + base;
+    uint8_t* outFlags = out.flags.data() + base;
+
+    int64_t t = 0;
+    for (size_t i = 0; i < count; ++i) {
+        t += unzigzag(r.varint());
+        timeStart[i] = timeEnd[i] = static_cast<double>(t) / kTimeScale;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        if (!(flags[i] & kHasEnd)) continue;
+        int64_t start = std::llround(timeStart[i] * kTimeScale);
+        timeEnd[i] = static_cast<double>(start + unzigzag(r.varint())) / kTimeScale;
+    }
+
+    auto coords = [&](double* column, uint8_t bit, uint8_t outBit) {
+        int64_t last = 0;
+        for (size_t i = 0; i < count; ++i) {
+            if (!(flags[i] & bit)) continue;
+            last += unzigzag(r.varint());
+            column[i] = static_cast<double>(last) / kCoordScale;
+            outFlags[i] |= outBit;
+        }
+    };
+    coords(out.lat.data() + base, kHasLat, EntityColumns::kHasLat);
+    coords(out.lon.data() + base, kHasLon, EntityColumns::kHasLon);
+
+    StringRef* ids = out.id.data() + base;
+    uint8_t idMode = r.byte();
+    if (idMode == kIdUuid) {
+        static const char kHex[] = "0123456789abcdef";
+        char id[36];
+        for (size_t i = 0; i < count; ++i) {
+            const uint8_t* b = r.take(16);
+            size_t o = 0;
+            for (int k = 0; k < 16; ++k) {
+                if (k == 4 || k == 6 || k == 8 || k == 10) id[o++] = '-';
+                id[o++] = kHex[b[k] >> 4];
+                id[o++] = kHex[b[k] & 0x0f];
+            }
+            ids[i] = out.addString({id, sizeof(id)});
+        }
+    } else if (idMode == kIdDictionary) {
+        auto dict = r.dictionary(out);
+        for (size_t i = 0; i < count; ++i) ids[i] = r.ref(dict);
+    } else {
+        malformed("id mode");
+    }
+
+    // Each dictionary entry goes into the pool once, however many rows use it
+    auto strings = [&](StringRef* column, uint8_t bit, uint8_t outBit) {
+        auto dict = r.dictionary(out);
+        for (size_t i = 0; i < count; ++i) {
+            if (!(flags[i] & bit)) continue;
+            column[i] = r.ref(dict);
+            outFlags[i] |= outBit;
+        }
+    };
+    strings(out.name.data() + base, kHasName, EntityColumns::kHasName);
+    strings(out.color.data() + base, kHasColor, EntityColumns::kHasColor);
+
+    float* render = out.render_offset.data() + base;
+    for (size_t i = 0; i < count; ++i) {
+        if (!(flags[i] & kHasRender)) continue;
+        uint32_t bits = getU32(r.take(4));
+        std::memcpy(&render[i], &bits, 4);
+    }
+
+    if (r.p != r.end) malformed("trailing bytes");
+}
+
+std::vector<Entity> Decoder::decodeBlock(const uint8_t* payload, size_t len, size_t count)
+{
+    EntityColumns columns;
+    decodeBlock(payload, len, count, columns);
+    return columns.toEntities();
+}
+
+bool Decoder::feed(const char* data, size_t len, const TotalCallback& on_total, const BatchCallback& on_batch)
+{
+    return feedColumns(data, len, on_total, [&on_batch](EntityColumns&& batch) {
+        return on_batch(batch.toEntities());
+    });
+}
+
+bool Decoder::feedColumns(const char* data, size_t len, const TotalCallback& on_total,
+                          const ColumnsCallback& on_batch)
+{
+    if (m_complete) return true;  // anything after the end marker is ignored
+    m_buf.append(data, len);
+
+    bool keepGoing = true;
+    for (;;) {
+        const uint8_t* p = reinterpret_cast<const uint8_t*>(m_buf.data()) + m_pos;
+        size_t avail = m_buf.size() - m_pos;
+
+        if (!m_haveHeader) {
+            if (avail < kHeaderSize) break;
+            if (!sniff(reinterpret_cast<const char*>(p), avail))
+                throw std::runtime_error("Columnar stream has a bad magic");
+            uint16_t version = static_cast<uint16_t>(p[4] | (p[5] << 8));
+            if (version != kVersion)
+                throw std::runtime_error("Columnar stream version " + std::to_string(version) + " is not supported");
+            uint64_t total = static_cast<uint64_t>(getU32(p + 8)) | (static_cast<uint64_t>(getU32(p + 12)) << 32);
+            m_haveHeader = true;
+            m_pos += kHeaderSize;
+            if (on_total) on_total(static_cast<size_t>(total));
+            continue;
+        }
+
+        if (avail < kBlockHeaderSize) break;
+        uint32_t count = getU32(p);
+        uint32_t bytes = getU32(p + 4);
+        uint32_t crc = getU32(p + 8);
+        if (count == 0 && bytes == 0) {
+            m_complete = true;
+            m_pos += kBlockHeaderSize;
+            break;
+        }
+        if (bytes > kMaxBlockPayload || count > bytes)
+            throw std::runtime_error("Columnar block header is corrupt");
+        if (avail < kBlockHeaderSize + bytes) break;
+
+        const uint8_t* payload = p + kBlockHeaderSize;
+        if (crc32(0L, payload, bytes) != crc)
+            throw std::runtime_error("Columnar block checksum mismatch");
+        EntityColumns batch;
+        decodeBlock(payload, bytes, count, batch);
+        m_pos += kBlockHeaderSize + bytes;
+        if (!on_batch(std::move(batch))) {
+            keepGoing = false;
+            break;
+        }
+    }
+
+    // Drop consumed bytes; blocks are bounded, so this stays amortized linear
+    if (m_pos > 0 && (m_pos == m_buf.size() || m_pos > (1u << 20))) {
+        m_buf.erase(0, m_pos);
+        m_pos = 0;
+    }
+    return keepGoing;
+}
+
+void Decoder::finish() const
+{
+    if (!m_complete)
+        throw std::runtime_error("Columnar stream ended before its end marker");
+}
+
+} // namespace ColumnarFormat
@@ -0,0 +1,98 @@
+#pragma once
+
+#include "core/Entity.h"
+#include "core/EntityColumns.h"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+/// Columnar binary alternative to the NDJSON export stream.
+///
+/// The client asks for it with `Accept: application/x-reckoner-columns`; a
+/// server that does not know it answers with NDJSON as before, and the
+/// client tells the two apart by the leading magic bytes.
+///
+/// Stream layout (all integers little-endian):
+///
+///     header  "RKCB" | u16 version (1) | u16 flags (0) | u64 total
+///     block*  u32 count | u32 payload bytes | u32 CRC-32 of payload | payload
+///     end     a block header with count = 0 and payload bytes = 0
+///
+/// A block payload stores `count` entities column by column:
+///
+///     flags     u8 per row: lat, lon, t_end != t_start, name, color,
+///               render_offset != 0
+///     t_start   microseconds, zigzag varint delta from the previous row
+///     t_end     zigzag varint (t_end - t_start) in us, rows with the flag
+///     lat, lon  degrees * 1e7, zigzag varint delta from the previous present
+///               value in the block
+///     id        u8 mode: 1 = every id is a canonical lowercase UUID, stored
+///               as 16 raw bytes; 0 = string dictionary (see below)
+///     name      string dictionary, then a varint index per flagged row
+///     color     string dictionary, then a varint index per flagged row
+///     render    f32 per flagged row
+///
+/// A string dictionary is a varint entry count followed by varint-length-
+/// prefixed strings; id mode 0 stores a varint index for every row.
+///
+/// Times round-trip to the microsecond and coordinates to 1e-7 degrees
+/// (about 1 cm); ids, names and colors are exact.
+namespace ColumnarFormat {
+
+constexpr char kContentType[] = "application/x-reckoner-columns";
+constexpr size_t kMagicSize = 4;
+constexpr size_t kDefaultBlockRows = 8192;
+
+/// True if `data` starts with the stream magic (needs kMagicSize bytes).
+bool sniff(const char* data, size_t len);
+
+/// Builds a columnar stream.  Used by stand-in servers and benchmarks.
+class Encoder {
+public:
+    static void writeHeader(std::string& out, uint64_t total);
+    static void writeBlock(std::string& out, const Entity* rows, size_t count);
+    static void writeEnd(std::string& out);
+
+    /// Header, blocks of up to blockRows entities, end marker.
+    static std::string encode(const std::vector<Entity>& rows, size_t blockRows = kDefaultBlockRows);
+};
+
+/// Incremental decoder.  Bytes may arrive in any split; each complete block
+/// is checked against its CRC and decoded straight into an EntityColumns
+/// batch: one pool entry per dictionary string, not one string per row.
+class Decoder {
+public:
+    using TotalCallback = std::function<void(size_t total)>;
+    /// Return false to stop decoding.
+    using BatchCallback = std::function<bool(std::vector<Entity>&&)>;
+    using ColumnsCallback = std::function<bool(EntityColumns&&)>;
+
+    /// Returns false once on_batch has asked to stop.
+    /// @throws std::runtime_error on a bad header, malformed block or
+    ///         checksum mismatch
+    bool feedColumns(const char* data, size_t len, const TotalCallback& on_total, const ColumnsCallback& on_batch);
+
+    /// feedColumns, with each batch converted to entities.
+    bool feed(const char* data, size_t len, const TotalCallback& on_total, const BatchCallback& on_batch);
+
+    /// @throws std::runtime_error if the stream ended before its end marker
+    void finish() const;
+
+    bool complete() const { return m_complete; }
+
+    /// Decode one block payload (no header), appending its rows to `out`.
+    static void decodeBlock(const uint8_t* payload, size_t len, size_t count, EntityColumns& out);
+
+    /// decodeBlock into entities.  For tests.
+    static std::vector<Entity> decodeBlock(const uint8_t* payload, size_t len, size_t count);
+
+private:
+    std::string m_buf;
+    size_t m_pos = 0;
+    bool m_haveHeader = false;
+    bool m_complete = false;
+};
+
+} // namespace ColumnarFormat
@@ -0,0 +1,399 @@
+#include "EntityScanner.h"
+#include "core/TimeUtils.h"
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+// --- Minimal JSON tokenizer over a single NDJSON line ---
+
+namespace {
+
+// Exact powers of ten representable as doubles (Clinger's fast path).
+constexpr double kPow10[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+struct Cursor {
+    const char* p;
+    const char* end;
+
+    bool atEnd() const { return p >= end; }
+
+    void skipWs() {
+        while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')) ++p;
+    }
+
+    bool consume(char c) {
+        skipWs();
+        if (p < end && *p == c) { ++p; return true; }
+        return false;
+    }
+
+    bool consumeLiteral(const char* lit, size_t len) {
+        if (static_cast<size_t>(end - p) < len || std::memcmp(p, lit, len) != 0) return false;
+        p += len;
+        return true;
+    }
+
+    bool peekNull() {
+        skipWs();
+        return p < end && *p == 'n';
+    }
+
+    static int hexValue(char c) {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return -1;
+    }
+
+    bool readHex4(uint32_t& cp) {
+        if (end - p < 4) return false;
+        cp = 0;
+        for (int i = 0; i < 4; ++i) {
+            int h = hexValue(p[i]);
+            if (h < 0) return false;
+            cp = (cp << 4) | static_cast<uint32_t>(h);
+        }
+        p += 4;
+        return true;
+    }
+
+    static void appendUtf8(std::string& dst, uint32_t cp) {
+        if (cp < 0x80) {
+            dst.push_back(static_cast<char>(cp));
+        } else if (cp < 0x800) {
+            dst.push_back(static_cast<char>(0xC0 | (cp >> 6)));
+            dst.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+        } else if (cp < 0x10000) {
+            dst.push_back(static_cast<char>(0xE0 | (cp >> 12)));
+            dst.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+            dst.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+        } else {
+            dst.push_back(static_cast<char>(0xF0 | (cp >> 18)));
+            dst.push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3F)));
+            dst.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+            dst.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+        }
+    }
+
+    // Read a JSON string (cursor on the opening quote) into dst, decoding escapes.
+    // The common no-escape case is a single assign into dst's existing capacity.
+    bool readString(std::string& dst) {
+        skipWs();
+        if (p >= end || *p != '"') return false;
+        ++p;
+
+        const char* start = p;
+        while (p < end && *p != '"' && *p != '\\') ++p;
+        if (p >= end) return false;
+        dst.assign(start, static_cast<size_t>(p - start));
+        if (*p == '"') { ++p; return true; }
+
+        // Slow path: escapes present
+        while (p < end) {
+            char c = *p++;
+            if (c == '"') return true;
+            if (c != '\\') { dst.push_back(c); continue; }
+            if (p >= end) return false;
+            char esc = *p++;
+            switch (esc) {
+                case '"':  dst.push_back('"');  break;
+                case '\\': dst.push_back('\\'); break;
+                case '/':  dst.push_back('/');  break;
+                case 'b':  dst.push_back('\b'); break;
+                case 'f':  dst.push_back('\f'); break;
+                case 'n':  dst.push_back('\n'); break;
+                case 'r':  dst.push_back('\r'); break;
+                case 't':  dst.push_back('\t'); break;
+                case 'u': {
+                    uint32_t cp;
+                    if (!readHex4(cp)) return false;
+                    if (cp >= 0xD800 && cp <= 0xDBFF) {
+                        uint32_t lo;
+                        if (!consumeLiteral("\\u", 2) || !readHex4(lo)) return false;
+                        if (lo < 0xDC00 || lo > 0xDFFF) return false;
+                        cp = 0x10000 + ((cp - 0xD800) << 10) + (lo - 0xDC00);
+                    } else if (cp >= 0xDC00 && cp <= 0xDFFF) {
+                        return false;  // lone low surrogate
+                    }
+                    appendUtf8(dst, cp);
+                    break;
+                }
+                default: return false;
+            }
+        }
+        return false;
+    }
+
+    // Read a string without materializing it.  Keys and timestamps in this
+    // schema never contain escapes, so an escape sends the line to the DOM path.
+    bool readRaw(std::string_view& out) {
+        skipWs();
+        if (p >= end || *p != '"') return false;
+        const char* start = ++p;
+        while (p < end && *p != '"') {
+            if (*p == '\\') return false;
+            ++p;
+        }
+        if (p >= end) return false;
+        out = std::string_view(start, static_cast<size_t>(p - start));
+        ++p;
+        return true;
+    }
+
+    // Parse a JSON number.  Short mantissas with small exponents are converted
+    // exactly with one multiply/divide; everything else goes through strtod.
+    bool readNumber(double& out) {
+        skipWs();
+        const char* start = p;
+        bool neg = false;
+        if (p < end && *p == '-') { neg = true; ++p; }
+        if (p >= end || *p < '0' || *p > '9') return false;
+
+        uint64_t mant = 0;
+        int digits = 0;
+        int exp10 = 0;
+        bool truncated = false;
+
+        auto addDigit = [&](int d, bool frac) {
+            if (digits < 19) {
+                mant = mant * 10 + static_cast<uint64_t>(d);
+                if (mant) ++digits;
+                if (frac) --exp10;
+            } else {
+                if (!frac) ++exp10;
+                truncated = true;
+            }
+        };
+
+        while (p < end && *p >= '0' && *p <= '9') addDigit(*p++ - '0', false);
+        if (p < end && *p == '.') {
+            ++p;
+            if (p >= end || *p < '0' || *p > '9') return false;
+            while (p < end && *p >= '0' && *p <= '9') addDigit(*p++ - '0', true);
+        }
+        if (p < end && (*p == 'e' || *p == 'E')) {
+            ++p;
+            bool expNeg = false;
+            if (p < end && (*p == '+' || *p == '-')) expNeg = (*p++ == '-');
+            if (p >= end || *p < '0' || *p > '9') return false;
+            int e = 0;
+            while (p < end && *p >= '0' && *p <= '9') {
+                if (e < 10000) e = e * 10 + (*p - '0');
+                ++p;
+            }
+            exp10 += expNeg ? -e : e;
+        }
+
+        if (!truncated && mant <= (uint64_t{1} << 53) && exp10 >= -22 && exp10 <= 22) {
+            double v = static_cast<double>(mant);
+            v = (exp10 < 0) ? v / kPow10[-exp10] : v * kPow10[exp10];
+            out = neg ? -v : v;
+            return true;
+        }
+
+        char buf[64];
+        size_t len = static_cast<size_t>(p - start);
+        if (len >= sizeof(buf)) return false;
+        std::memcpy(buf, start, len);
+        buf[len] = '\0';
+        out = std::strtod(buf, nullptr);
+        return true;
+    }
+
+    // Skip any JSON value, including nested objects/arrays.
+    bool skipValue() {
+        skipWs();
+        if (p >= end) return false;
+        char c = *p;
+        if (c == '"') {
+            ++p;
+            while (p < end && *p != '"') {
+                if (*p == '\\') ++p;
+                ++p;
+            }
+            if (p >= end) return false;
+            ++p;
+            return true;
+        }
+        if (c == '{' || c == '[') {
+            int depth = 0;
+            while (p < end) {
+                char d = *p++;
+                if (d == '"') {
+                    while (p < end && *p != '"') {
+                        if (*p == '\\') ++p;
+                        ++p;
+                    }
+                    if (p >= end) return false;
+                    ++p;
+                } else if (d == '{' || d == '[') {
+                    ++depth;
+                } else if (d == '}' || d == ']') {
+                    if (--depth == 0) return true;
+                }
+            }
+            return false;
+        }
+        if (c == 't') return consumeLiteral("true", 4);
+        if (c == 'f') return consumeLiteral("false", 5);
+        if (c == 'n') return consumeLiteral("null", 4);
+        double ignored;
+        return readNumber(ignored);
+    }
+};
+
+// Optional double: null clears, number sets.
+bool readOptionalNumber(Cursor& c, std::optional<double>& out) {
+    if (c.peekNull()) {
+        out.reset();
+        return c.consumeLiteral("null", 4);
+    }
+    double v;
+    if (!c.readNumber(v)) return false;
+    out = v;
+    return true;
+}
+
+// Optional string: null clears, string assigns into the existing buffer if any.
+bool readOptionalString(Cursor& c, std::optional<std::string>& out) {
+    if (c.peekNull()) {
+        out.reset();
+        return c.consumeLiteral("null", 4);
+    }
+    if (!out) out.emplace();
+    return c.readString(*out);
+}
+
+} // namespace
+
+bool EntityScanner::scan(std::string_view line, Entity& out)
+{
+    Cursor c{line.data(), line.data() + line.size()};
+    if (!c.consume('{')) return false;
+
+    bool haveId = false, haveStart = false, haveEnd = false;
+    bool haveLat = false, haveLon = false, haveName = false, haveColor = false;
+    bool endIsNull = false;
+    double tEnd = 0.0;
+    std::string_view ts;
+    out.render_offset = 0.0f;
+
+    if (!c.consume('}')) {
+        for (;;) {
+            std::string_view key;
+            if (!c.readRaw(key) || !c.consume(':')) return false;
+
+            if (key == "id") {
+                if (!c.readString(out.id)) return false;
+                haveId = true;
+            } else if (key == "t_start") {
+                if (!c.readRaw(ts) || !TimeUtils::try_parse_iso8601(ts, out.time_start))
+                    return false;
+                haveStart = true;
+            } else if (key == "t_end") {
+                if (c.peekNull()) {
+                    if (!c.consumeLiteral("null", 4)) return false;
+                    endIsNull = true;
+                } else {
+                    if (!c.readRaw(ts) || !TimeUtils::try_parse_iso8601(ts, tEnd))
+                        return false;
+                    endIsNull = false;
+                }
+                haveEnd = true;
+            } else if (key == "lat") {
+                if (!readOptionalNumber(c, out.lat)) return false;
+                haveLat = true;
+            } else if (key == "lon") {
+                if (!readOptionalNumber(c, out.lon)) return false;
+                haveLon = true;
+            } else if (key == "name") {
+                if (!readOptionalString(c, out.name)) return false;
+                haveName = true;
+            } else if (key == "color") {
+                if (!readOptionalString(c, out.color)) return false;
+                haveColor = true;
+            } else if (key == "render_offset") {
+                std::optional<double> ro;
+                if (!readOptionalNumber(c, ro)) return false;
+                out.render_offset = ro ? static_cast<float>(*ro) : 0.0f;
+            } else {
+                if (!c.skipValue()) return false;
+            }
+
+            if (c.consume(',')) continue;
+            if (c.consume('}')) break;
+            return false;
+        }
+    }
+
+    c.skipWs();
+    if (!c.atEnd() || !haveId || !haveStart) return false;
+
+    out.time_end = (haveEnd && !endIsNull) ? tEnd : out.time_start;
+    if (!haveLat)   out.lat.reset();
+    if (!haveLon)   out.lon.reset();
+    if (!haveName)  out.name.reset();
+    if (!haveColor) out.color.reset();
+    return true;
+}
+
+bool EntityScanner::scan(std::string_view line, EntityColumns& out)
+{
+    if (!scan(line, m_row)) return false;
+    out.push_back(m_row);
+    return true;
+}
+
+bool EntityScanner::scanTotal(std::string_view line, size_t& total)
+{
+    Cursor c{line.data(), line.data() + line.size()};
+    std::string_view key;
+    if (!c.consume('{') || !c.readRaw(key) || key != "total" || !c.consume(':'))
+        return false;
+
+    c.skipWs();
+    if (c.atEnd() || *c.p < '0' || *c.p > '9') return false;
+    size_t n = 0;
+    while (!c.atEnd() && *c.p >= '0' && *c.p <= '9')
+        n = n * 10 + static_cast<size_t>(*c.p++ - '0');
+
+    if (!c.consume('}')) return false;
+    c.skipWs();
+    if (!c.atEnd()) return false;
+
+    total = n;
+    return true;
+}
+
+bool EntityScanner::splitArray(std::string_view body, std::string_view key,
+                               std::vector<std::string_view>& elements)
+{
+    elements.clear();
+    Cursor c{body.data(), body.data() + body.size()};
+    if (!c.consume('{')) return false;
+
+    for (;;) {
+        std::string_view k;
+        if (!c.readRaw(k) || !c.consume(':')) return false;
+        if (k != key) {
+            if (!c.skipValue()) return false;
+            if (c.consume(',')) continue;
+            return false;  // '}' or garbage: key not present
+        }
+
+        if (!c.consume('[')) return false;
+        if (c.consume(']')) return true;
+        for (;;) {
+            c.skipWs();
+            const char* start = c.p;
+            if (!c.skipValue()) return false;
+            elements.emplace_back(start, static_cast<size_t>(c.p - start));
+            if (c.consume(',')) continue;
+            if (c.consume(']')) return true;
+            return false;
+        }
+    }
+}
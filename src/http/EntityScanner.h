@@ -0,0 +1,44 @@
+#pragma once
+
+#include "core/Entity.h"
+#include "core/EntityColumns.h"
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstddef>
+
+/// Streaming scanner for one line of the /v1/query/export NDJSON stream.
+///
+/// Recognizes the fixed entity schema (id, t_start, t_end, lat, lon, name,
+/// color, render_offset) and writes values straight into an Entity without
+/// building a JSON DOM.  Unknown keys are skipped.  scan() returns false for
+/// anything it cannot handle (malformed JSON, wrong value types, missing
+/// id/t_start) so the caller can fall back to nlohmann for that line.
+///
+/// Steady-state scanning does no allocations beyond the Entity's own strings:
+/// keys and timestamps are parsed in place from the line buffer.
+class EntityScanner {
+public:
+    /// Scan an entity object into `out`.  Fields absent from the line are reset
+    /// (lat/lon/name/color cleared, t_end = t_start, render_offset = 0).
+    /// On failure `out` is left in an unspecified but valid state.
+    bool scan(std::string_view line, Entity& out);
+
+    /// scan() into a new last row of `out`; nothing is added on failure.
+    /// Goes through one reused Entity, so steady state allocates nothing per
+    /// line beyond the pool's growth.
+    bool scan(std::string_view line, EntityColumns& out);
+
+    /// Recognize the export header line {"total": N}.
+    static bool scanTotal(std::string_view line, size_t& total);
+
+    /// Split the array stored under `key` in a top-level JSON object (the
+    /// {"entities": [...]} query responses) into views of its elements, each
+    /// of which can be handed to scan().  Only the structure is checked.
+    /// Returns false if the key is missing or the body is malformed.
+    static bool splitArray(std::string_view body, std::string_view key,
+                           std::vector<std::string_view>& elements);
+
+private:
+    Entity m_row{};
+};
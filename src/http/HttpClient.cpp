@@ -1,238 +1,274 @@
 #include "HttpClient.h"
-#include <curl/curl.h>
+#include "core/LineReader.h"
+#include <condition_variable>
+#include <deque>
+#include <mutex>
 #include <stdexcept>
 #include <iostream>
 
-size_t HttpClient::write_callback(void* contents, size_t size, size_t nmemb, void* userp) {
-    size_t total_size = size * nmemb;
-    std::string* response = static_cast<std::string*>(userp);
-    response->append(static_cast<char*>(contents), total_size);
-    return total_size;
-}
-
-size_t HttpClient::bytes_write_callback(void* contents, size_t size, size_t nmemb, void* userp) {
-    size_t total = size * nmemb;
-    auto* buf = static_cast<std::vector<uint8_t>*>(userp);
-    const uint8_t* data = static_cast<const uint8_t*>(contents);
-    buf->insert(buf->end(), data, data + total);
-    return total;
-}
-
 namespace {
-    struct StreamContext {
-        std::string buffer;
-        std::function<bool(const std::string&)> callback;
-        bool stop = false;
-    };
-}
+    /// Bounded hand-off from the transport's reactor thread to the thread
+    /// blocked in a streaming call. When full, the reactor pauses the transfer
+    /// instead of blocking; the consumer resumes it after draining a chunk.
+    /// The paused flag is set under the same lock as the full check, so a
+    /// pause is always seen by a later pop().
+    class StreamChannel {
+    public:
+        static constexpr size_t kCapacity = 16;
+
+        bool offer(const char* data, size_t len) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_chunks.size() >= kCapacity) {
+                m_paused = true;
+                return false;
+            }
+            m_chunks.emplace_back(data, len);
+            m_cv.notify_one();
+            return true;
+        }
 
-size_t HttpClient::stream_write_callback(void* contents, size_t size, size_t nmemb, void* userp) {
-    size_t total = size * nmemb;
-    auto* ctx = static_cast<StreamContext*>(userp);
+        void complete(HttpTransport::Response&& response) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_response = std::move(response);
+            m_done = true;
+            m_cv.notify_one();
+        }
 
-    ctx->buffer.append(static_cast<char*>(contents), total);
+        /// Returns false once the transfer has completed and every chunk was popped.
+        bool pop(std::string& out, bool& needResume) {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cv.wait(lock, [this] { return m_done || !m_chunks.empty(); });
+            if (m_chunks.empty()) return false;
+            out = std::move(m_chunks.front());
+            m_chunks.pop_front();
+            needResume = m_paused;
+            m_paused = false;
+            return true;
+        }
 
-    size_t pos;
-    while ((pos = ctx->buffer.find('\n')) != std::string::npos) {
-        std::string line = ctx->buffer.substr(0, pos);
-        ctx->buffer.erase(0, pos + 1);
-        if (!line.empty()) {
-            if (!ctx->callback(line)) {
-                ctx->stop = true;
-                return 0;  // Signals curl to abort (CURLE_WRITE_ERROR)
-            }
+        HttpTransport::Response waitForResponse() {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cv.wait(lock, [this] { return m_done; });
+            return std::move(m_response);
         }
-    }
 
-    return total;
+    private:
+        std::mutex m_mutex;
+        std::condition_variable m_cv;
+        std::deque<std::string> m_chunks;
+        HttpTransport::Response m_response;
+        bool m_paused = false;
+        bool m_done = false;
+    };
 }
 
-std::vector<uint8_t> HttpClient::get_bytes(const std::string& url) {
-    CURL* curl = curl_easy_init();
-    if (!curl) throw std::runtime_error("Failed to initialize CURL");
-
-    std::vector<uint8_t> buf;
-    buf.reserve(256 * 1024);  // 256 KB initial reserve for thumbnails
-
-    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-    curl_easy_setopt(curl, CURLOPT_HTTPGET, 1L);
-    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, bytes_write_callback);
-    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &buf);
-    curl_easy_setopt(curl, CURLOPT_TIMEOUT, 15L);
-
-    struct curl_slist* headers = nullptr;
-    if (!m_apiKey.empty()) {
-        std::string auth_header = "X-API-Key: " + m_apiKey;
-        headers = curl_slist_append(headers, auth_header.c_str());
-        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
-    }
+void HttpClient::rebuild_headers() {
+    std::vector<std::string> auth;
+    if (!m_apiKey.empty()) auth.push_back("X-API-Key: " + m_apiKey);
 
-    CURLcode res = curl_easy_perform(curl);
-    if (headers) curl_slist_free_all(headers);
+    auto with = [&auth](const char* first) {
+        std::vector<std::string> lines{first};
+        lines.insert(lines.end(), auth.begin(), auth.end());
+        return std::make_shared<const HttpTransport::HeaderList>(lines);
+    };
+    m_authHeaders = auth.empty() ? nullptr : std::make_shared<const HttpTransport::HeaderList>(auth);
+    m_jsonPostHeaders = with("Content-Type: application/json");
+    // Ask for gzip explicitly instead of setting acceptEncoding so curl hands
+    // us the compressed bytes and inflate runs off the network thread.
+    m_rawStreamHeaders = with("Accept-Encoding: gzip");
+}
 
-    if (res != CURLE_OK) {
-        curl_easy_cleanup(curl);
-        throw std::runtime_error(std::string("CURL get_bytes failed: ") + curl_easy_strerror(res));
+void HttpClient::stream_chunks(HttpTransport::Request request,
+                               const std::function<bool(const char*, size_t)>& chunk_callback) {
+    auto channel = std::make_shared<StreamChannel>();
+    request.onData = [channel](const char* data, size_t len) {
+        return channel->offer(data, len) ? HttpTransport::DataAction::Continue
+                                         : HttpTransport::DataAction::Pause;
+    };
+
+    auto& transport = HttpTransport::shared();
+    HttpTransport::RequestId id = transport.submit(std::move(request),
+        [channel](HttpTransport::Response&& r) { channel->complete(std::move(r)); });
+
+    // The user callback runs here, on the calling thread, so it may block
+    // (e.g. IngestPipeline backpressure) without stalling other transfers.
+    bool stopped = false;
+    std::string chunk;
+    bool needResume = false;
+    while (channel->pop(chunk, needResume)) {
+        if (needResume) transport.resume(id);
+        if (!chunk_callback(chunk.data(), chunk.size())) {
+            stopped = true;
+            transport.cancel(id);
+            break;
+        }
     }
 
-    long http_code = 0;
-    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_code);
-    curl_easy_cleanup(curl);
+    HttpTransport::Response response = channel->waitForResponse();
+    if (stopped) return;  // Early cancel by the caller is not an error
 
-    if (http_code < 200 || http_code >= 300)
-        throw std::runtime_error("HTTP get_bytes failed with code " + std::to_string(http_code));
+    if (!response.error.empty())
+        throw std::runtime_error("CURL stream failed: " + response.error);
+    if (response.status < 200 || response.status >= 300)
+        throw std::runtime_error("HTTP stream failed with code " + std::to_string(response.status));
+}
 
-    return buf;
+std::vector<uint8_t> HttpClient::get_bytes(const std::string& url) {
+    HttpTransport::Request request;
+    request.url = url;
+    request.timeoutSec = 15;
+    request.sharedHeaders = m_authHeaders;
+
+    HttpTransport::Response response = HttpTransport::shared().perform(std::move(request));
+    if (!response.error.empty())
+        throw std::runtime_error("CURL get_bytes failed: " + response.error);
+    if (response.status < 200 || response.status >= 300)
+        throw std::runtime_error("HTTP get_bytes failed with code " + std::to_string(response.status));
+
+    return std::vector<uint8_t>(response.body.begin(), response.body.end());
+}
+
+std::future<std::vector<uint8_t>> HttpClient::get_bytes_async(const std::string& url) {
+    HttpTransport::Request request;
+    request.url = url;
+    request.timeoutSec = 15;
+    request.sharedHeaders = m_authHeaders;
+
+    auto promise = std::make_shared<std::promise<std::vector<uint8_t>>>();
+    auto future = promise->get_future();
+    HttpTransport::shared().submit(std::move(request),
+        [promise, url](HttpTransport::Response&& r) {
+            if (!r.ok()) {
+                if (!r.aborted)
+                    std::cerr << "get_bytes_async failed for " << url << ": "
+                              << (r.error.empty() ? "HTTP " + std::to_string(r.status) : r.error) << std::endl;
+                promise->set_value({});
+                return;
+            }
+            promise->set_value(std::vector<uint8_t>(r.body.begin(), r.body.end()));
+        });
+    return future;
 }
 
 void HttpClient::get_stream(const std::string& url,
-                             std::function<bool(const std::string&)> line_callback) {
-    CURL* curl = curl_easy_init();
-    if (!curl) throw std::runtime_error("Failed to initialize CURL");
-
-    StreamContext ctx;
-    ctx.callback = std::move(line_callback);
-
-    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-    curl_easy_setopt(curl, CURLOPT_HTTPGET, 1L);
-    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, stream_write_callback);
-    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &ctx);
-    curl_easy_setopt(curl, CURLOPT_ACCEPT_ENCODING, "gzip");  // Auto-decompress gzip
-    curl_easy_setopt(curl, CURLOPT_TIMEOUT, 300L);            // 5 min for large datasets
-
-    struct curl_slist* headers = nullptr;
-    if (!m_apiKey.empty()) {
-        std::string auth_header = "X-API-Key: " + m_apiKey;
-        headers = curl_slist_append(headers, auth_header.c_str());
-    }
-    if (headers) curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+                             std::function<bool(std::string_view)> line_callback) {
+    HttpTransport::Request request;
+    request.url = url;
+    request.timeoutSec = 300;        // 5 min for large datasets
+    request.acceptEncoding = "gzip";  // Auto-decompress gzip
+    request.sharedHeaders = m_authHeaders;
+
+    LineReader reader;
+    auto onLine = [&line_callback](std::string_view line) {
+        return line.empty() || line_callback(line);
+    };
 
-    CURLcode res = curl_easy_perform(curl);
-    if (headers) curl_slist_free_all(headers);
+    bool stopped = false;
+    stream_chunks(std::move(request), [&](const char* data, size_t len) {
+        stopped = !reader.feed(data, len, onLine);
+        return !stopped;
+    });
 
-    // CURLE_WRITE_ERROR is expected when the callback returns false (early cancel)
-    if (res != CURLE_OK && res != CURLE_WRITE_ERROR) {
-        std::string err = "CURL stream failed: ";
-        err += curl_easy_strerror(res);
-        curl_easy_cleanup(curl);
-        throw std::runtime_error(err);
-    }
+    // Flush any remaining content in the buffer (final line with no trailing newline)
+    if (!stopped) reader.finish(onLine);
+}
 
-    long http_code = 0;
-    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_code);
-    curl_easy_cleanup(curl);
+void HttpClient::get_raw_stream(const std::string& url,
+                                std::function<bool(const char*, size_t)> chunk_callback,
+                                const std::string& accept) {
+    HttpTransport::Request request;
+    request.url = url;
+    request.timeoutSec = 300;  // 5 min for large datasets
+    request.sharedHeaders = m_rawStreamHeaders;
+    if (!accept.empty()) request.headers.push_back("Accept: " + accept);
 
-    if (res == CURLE_OK && (http_code < 200 || http_code >= 300)) {
-        throw std::runtime_error("HTTP stream failed with code " + std::to_string(http_code));
-    }
+    stream_chunks(std::move(request), chunk_callback);
+}
 
-    // Flush any remaining content in the buffer (final line with no trailing newline)
-    if (!ctx.buffer.empty() && !ctx.stop) {
-        ctx.callback(ctx.buffer);
-    }
+void HttpClient::post_raw_stream(const std::string& url,
+                                 const nlohmann::json& json_body,
+                                 std::function<bool(const char*, size_t)> chunk_callback,
+                                 const std::string& accept) {
+    HttpTransport::Request request;
+    request.url = url;
+    request.method = HttpTransport::Method::Post;
+    request.body = json_body.dump();
+    request.timeoutSec = 300;
+    request.sharedHeaders = m_rawStreamHeaders;
+    request.headers.push_back("Content-Type: application/json");
+    if (!accept.empty()) request.headers.push_back("Accept: " + accept);
+
+    stream_chunks(std::move(request), chunk_callback);
 }
 
 nlohmann::json HttpClient::get(const std::string& url) {
     std::cout << "GET: " << url << std::endl;
-    
-    CURL* curl = curl_easy_init();
-    if (!curl) {
-        throw std::runtime_error("Failed to initialize CURL");
-    }
-
-    std::string response_string;
 
-    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-    curl_easy_setopt(curl, CURLOPT_HTTPGET, 1L);
-    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_callback);
-    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response_string);
-    curl_easy_setopt(curl, CURLOPT_TIMEOUT, 10L);
+    HttpTransport::Request request;
+    request.url = url;
+    request.timeoutSec = 10;
 
-    CURLcode res = curl_easy_perform(curl);
+    HttpTransport::Response response = HttpTransport::shared().perform(std::move(request));
 
-    if (res != CURLE_OK) {
-        std::string error_msg = "CURL request failed: ";
-        error_msg += curl_easy_strerror(res);
-        curl_easy_cleanup(curl);
-        throw std::runtime_error(error_msg);
+    if (!response.error.empty()) {
+        throw std::runtime_error("CURL request failed: " + response.error);
     }
 
-    long http_code = 0;
-    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_code);
-    curl_easy_cleanup(curl);
-
-    if (http_code < 200 || http_code >= 300) {
-        throw std::runtime_error("HTTP request failed with code " + std::to_string(http_code));
+    if (response.status < 200 || response.status >= 300) {
+        throw std::runtime_error("HTTP request failed with code " + std::to_string(response.status));
     }
 
     try {
-        return nlohmann::json::parse(response_string);
+        return nlohmann::json::parse(response.body);
     } catch (const nlohmann::json::exception& e) {
         throw std::runtime_error(std::string("Failed to parse JSON response: ") + e.what());
     }
 }
 
-nlohmann::json HttpClient::post(const std::string& url, const nlohmann::json& json_body) {
-    CURL* curl = curl_easy_init();
-    if (!curl) {
-        throw std::runtime_error("Failed to initialize CURL");
-    }
-
-    std::string response_string;
-    std::string request_body = json_body.dump();
-
+std::future<std::string> HttpClient::post_raw_async(const std::string& url, const nlohmann::json& json_body) {
     // Set up the request
-    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-    curl_easy_setopt(curl, CURLOPT_POST, 1L);
-    curl_easy_setopt(curl, CURLOPT_POSTFIELDS, request_body.c_str());
-    curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, request_body.size());
-
-    // Set headers
-    struct curl_slist* headers = nullptr;
-    headers = curl_slist_append(headers, "Content-Type: application/json");
-
-    // Add API key if present
-    if (!m_apiKey.empty()) {
-        std::string auth_header = "X-API-Key: " + m_apiKey;
-        headers = curl_slist_append(headers, auth_header.c_str());
-    }
-
-    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
-
-    // Set up response callback
-    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_callback);
-    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response_string);
-
-    // Set timeout
-    curl_easy_setopt(curl, CURLOPT_TIMEOUT, 30L);
-
-    // Perform the request
-    CURLcode res = curl_easy_perform(curl);
+    HttpTransport::Request request;
+    request.url = url;
+    request.method = HttpTransport::Method::Post;
+    request.body = json_body.dump();
+    request.timeoutSec = 30;
+    request.sharedHeaders = m_jsonPostHeaders;
+
+    auto promise = std::make_shared<std::promise<std::string>>();
+    auto future = promise->get_future();
+    std::string requestBody = request.body;
+    HttpTransport::shared().submit(std::move(request),
+        [promise, requestBody](HttpTransport::Response&& response) {
+            if (!response.error.empty()) {
+                promise->set_exception(std::make_exception_ptr(
+                    std::runtime_error("CURL request failed: " + response.error)));
+                return;
+            }
 
-    // Clean up
-    curl_slist_free_all(headers);
+            // Check HTTP response code
+            if (response.status < 200 || response.status >= 300) {
+                std::cerr << "HTTP " << response.status << " response: " << response.body << std::endl;
+                std::cerr << "Request body: " << requestBody << std::endl;
+                promise->set_exception(std::make_exception_ptr(
+                    std::runtime_error("HTTP request failed with code " + std::to_string(response.status))));
+                return;
+            }
 
-    if (res != CURLE_OK) {
-        std::string error_msg = "CURL request failed: ";
-        error_msg += curl_easy_strerror(res);
-        curl_easy_cleanup(curl);
-        throw std::runtime_error(error_msg);
-    }
+            promise->set_value(std::move(response.body));
+        });
+    return future;
+}
 
-    // Check HTTP response code
-    long http_code = 0;
-    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_code);
-    curl_easy_cleanup(curl);
+std::string HttpClient::post_raw(const std::string& url, const nlohmann::json& json_body) {
+    return post_raw_async(url, json_body).get();
+}
 
-    if (http_code < 200 || http_code >= 300) {
-        std::cerr << "HTTP " << http_code << " response: " << response_string << std::endl;
-        std::cerr << "Request body: " << request_body << std::endl;
-        throw std::runtime_error("HTTP request failed with code " + std::to_string(http_code));
-    }
+nlohmann::json HttpClient::post(const std::string& url, const nlohmann::json& json_body) {
+    std::string body = post_raw(url, json_body);
 
     // Parse JSON response
     try {
-        return nlohmann::json::parse(response_string);
+        return nlohmann::json::parse(body);
     } catch (const nlohmann::json::exception& e) {
         throw std::runtime_error(std::string("Failed to parse JSON response: ") + e.what());
     }
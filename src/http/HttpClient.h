@@ -1,20 +1,33 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <functional>
 #include <vector>
 #include <cstdint>
+#include <future>
 #include <nlohmann/json.hpp>
+#include "HttpTransport.h"
 
-/// Simple HTTP client for making POST requests to the backend
+/// Simple HTTP client for making requests to the backend.
+/// Every call is carried by the shared HttpTransport reactor, so connections
+/// (and HTTP/2 sessions) are reused across calls and across clients.
+/// Header lists are built once per API key and shared by every request.
+/// Keep-alive and connection-cache tuning live on the transport
+/// (HttpTransport::shared().configure()).
+/// The blocking methods wait on the reactor; they must not be called from a
+/// transport callback.
 class HttpClient {
 public:
-    HttpClient() = default;
-    explicit HttpClient(const std::string& api_key) : m_apiKey(api_key) {}
+    HttpClient() { rebuild_headers(); }
+    explicit HttpClient(const std::string& api_key) : m_apiKey(api_key) { rebuild_headers(); }
     ~HttpClient() = default;
 
     /// Set the API key for authenticated requests
-    void setApiKey(const std::string& api_key) { m_apiKey = api_key; }
+    void setApiKey(const std::string& api_key) {
+        m_apiKey = api_key;
+        rebuild_headers();
+    }
 
     /// Get the current API key
     const std::string& apiKey() const { return m_apiKey; }
@@ -32,22 +45,64 @@ public:
     /// @throws std::runtime_error on HTTP errors
     nlohmann::json post(const std::string& url, const nlohmann::json& json_body);
 
+    /// POST a JSON body and return the response body unparsed, for callers
+    /// with their own parser (see EntityScanner::splitArray).
+    /// @throws std::runtime_error on HTTP errors
+    std::string post_raw(const std::string& url, const nlohmann::json& json_body);
+
+    /// Non-blocking post_raw.  The future rethrows the same errors.
+    std::future<std::string> post_raw_async(const std::string& url, const nlohmann::json& json_body);
+
     /// Stream a GET response line-by-line (NDJSON)
     /// Sends Accept-Encoding: gzip; curl decompresses on the fly.
+    /// Lines are split by a LineReader and passed without copying; empty
+    /// lines are skipped.
     /// @param url Full URL to GET
     /// @param line_callback Called for each complete '\n'-delimited line.
+    ///        The view is only valid during the call.
     ///        Return false to cancel the stream early.
     /// @throws std::runtime_error on network errors
     void get_stream(const std::string& url,
-                    std::function<bool(const std::string&)> line_callback);
+                    std::function<bool(std::string_view)> line_callback);
+
+    /// Stream a GET response as raw body chunks, exactly as received.
+    /// Sends Accept-Encoding: gzip but does not decompress; the caller sniffs
+    /// and decodes the body (see IngestPipeline).
+    /// @param chunk_callback Called for each block curl receives.
+    ///        Return false to cancel the stream early.
+    /// @param accept Optional Accept header value (e.g. to negotiate a
+    ///        binary body); empty sends none.
+    /// @throws std::runtime_error on network or HTTP errors
+    void get_raw_stream(const std::string& url,
+                        std::function<bool(const char* data, size_t len)> chunk_callback,
+                        const std::string& accept = "");
+
+    /// get_raw_stream for a POST with a JSON body.
+    /// @throws std::runtime_error on network or HTTP errors
+    void post_raw_stream(const std::string& url,
+                         const nlohmann::json& json_body,
+                         std::function<bool(const char* data, size_t len)> chunk_callback,
+                         const std::string& accept = "");
 
     /// Fetch raw bytes from a GET request (for binary content such as images).
     /// Sends the X-API-Key header if configured. Throws on network/HTTP errors.
     std::vector<uint8_t> get_bytes(const std::string& url);
 
+    /// Non-blocking get_bytes. The future resolves to an empty vector on
+    /// network/HTTP errors (logged) instead of throwing.
+    std::future<std::vector<uint8_t>> get_bytes_async(const std::string& url);
+
 private:
-    static size_t write_callback(void* contents, size_t size, size_t nmemb, void* userp);
-    static size_t bytes_write_callback(void* contents, size_t size, size_t nmemb, void* userp);
-    static size_t stream_write_callback(void* contents, size_t size, size_t nmemb, void* userp);
+    /// Run a streaming GET on the transport, delivering body chunks to
+    /// chunk_callback on the calling thread. Throws on network/HTTP errors.
+    void stream_chunks(HttpTransport::Request request,
+                       const std::function<bool(const char*, size_t)>& chunk_callback);
+
+    /// Rebuild the shared header lists after the API key changes.
+    void rebuild_headers();
+
     std::string m_apiKey;
+    std::shared_ptr<const HttpTransport::HeaderList> m_authHeaders;       ///< X-API-Key (null if no key)
+    std::shared_ptr<const HttpTransport::HeaderList> m_jsonPostHeaders;   ///< Content-Type + auth
+    std::shared_ptr<const HttpTransport::HeaderList> m_rawStreamHeaders;  ///< Accept-Encoding + auth
 };
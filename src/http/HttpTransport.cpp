@@ -0,0 +1,368 @@
+#include "HttpTransport.h"
+#include <curl/curl.h>
+#include <iostream>
+#include <stdexcept>
+
+namespace {
+
+constexpr int kPollTimeoutMs = 1000;
+
+std::mutex g_sharedMutex;
+std::unique_ptr<HttpTransport> g_shared;
+
+} // namespace
+
+struct HttpTransport::Transfer {
+    RequestId id = 0;
+    Request request;
+    Completion done;
+    Response response;
+    CURL* easy = nullptr;
+    curl_slist* headers = nullptr;  // owned; only when shared headers had to be extended
+    bool abortedByData = false;
+
+    ~Transfer() {
+        if (headers) curl_slist_free_all(headers);
+        if (easy) curl_easy_cleanup(easy);
+    }
+
+    static size_t writeCallback(char* data, size_t size, size_t nmemb, void* userp) {
+        auto* t = static_cast<Transfer*>(userp);
+        size_t total = size * nmemb;
+        if (!t->request.onData) {
+            t->response.body.append(data, total);
+            return total;
+        }
+        switch (t->request.onData(data, total)) {
+            case DataAction::Continue: return total;
+            case DataAction::Pause:    return CURL_WRITEFUNC_PAUSE;
+            case DataAction::Abort:    break;
+        }
+        t->abortedByData = true;
+        return 0;  // CURLE_WRITE_ERROR
+    }
+};
+
+HttpTransport& HttpTransport::shared()
+{
+    std::lock_guard<std::mutex> lock(g_sharedMutex);
+    if (!g_shared) g_shared = std::make_unique<HttpTransport>();
+    return *g_shared;
+}
+
+void HttpTransport::shutdownShared()
+{
+    std::lock_guard<std::mutex> lock(g_sharedMutex);
+    if (g_shared) g_shared->shutdown();
+}
+
+HttpTransport::HeaderList::HeaderList(const std::vector<std::string>& lines)
+    : m_lines(lines)
+{
+    for (const auto& line : m_lines) {
+        curl_slist* next = curl_slist_append(m_list, line.c_str());
+        if (!next) {
+            curl_slist_free_all(m_list);
+            throw std::runtime_error("Failed to build CURL header list");
+        }
+        m_list = next;
+    }
+}
+
+HttpTransport::HeaderList::~HeaderList()
+{
+    curl_slist_free_all(m_list);
+}
+
+HttpTransport::HttpTransport()
+{
+    m_multi = curl_multi_init();
+    if (!m_multi) throw std::runtime_error("Failed to initialize CURL multi");
+    curl_multi_setopt(m_multi, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+    applyMultiOptions(m_options);
+    m_reactorOptions = m_options;
+
+    // The multi already shares its connection cache; the share object adds
+    // DNS results and TLS session tickets across (pooled) easy handles.
+    // Only the reactor thread touches it, so no lock callbacks are needed.
+    m_share = curl_share_init();
+    if (m_share) {
+        curl_share_setopt(m_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+        curl_share_setopt(m_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+    }
+
+    m_thread = std::thread(&HttpTransport::run, this);
+}
+
+HttpTransport::~HttpTransport()
+{
+    shutdown();
+    for (CURL* easy : m_idleHandles) curl_easy_cleanup(easy);
+    m_idleHandles.clear();
+    curl_multi_cleanup(m_multi);
+    if (m_share) curl_share_cleanup(m_share);  // after every handle using it is gone
+}
+
+void HttpTransport::configure(const Options& options)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_options = options;
+        m_optionsChanged = true;
+    }
+    curl_multi_wakeup(m_multi);
+}
+
+HttpTransport::Options HttpTransport::options() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_options;
+}
+
+void HttpTransport::applyMultiOptions(const Options& options)
+{
+    curl_multi_setopt(m_multi, CURLMOPT_MAX_HOST_CONNECTIONS, options.maxHostConnections);
+    curl_multi_setopt(m_multi, CURLMOPT_MAXCONNECTS, options.maxCachedConnections);
+}
+
+CURL* HttpTransport::acquireHandle()
+{
+    if (!m_idleHandles.empty()) {
+        CURL* easy = m_idleHandles.back();
+        m_idleHandles.pop_back();
+        return easy;
+    }
+    CURL* easy = curl_easy_init();
+    if (easy) m_handlesCreated.fetch_add(1);
+    return easy;
+}
+
+void HttpTransport::releaseHandle(CURL* easy)
+{
+    if (m_idleHandles.size() >= m_reactorOptions.handlePoolSize) {
+        curl_easy_cleanup(easy);
+        return;
+    }
+    // Drops every option, CURLOPT_SHARE included, but keeps the handle's
+    // buffers; the share link is set again with each request's options
+    curl_easy_reset(easy);
+    m_idleHandles.push_back(easy);
+}
+
+HttpTransport::RequestId HttpTransport::submit(Request request, Completion done)
+{
+    auto t = std::make_unique<Transfer>();
+    t->id = m_nextId.fetch_add(1);
+    t->request = std::move(request);
+    t->done = std::move(done);
+    RequestId id = t->id;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_stopping) {
+            m_inFlight.fetch_add(1);
+            m_incoming.push_back(std::move(t));
+        }
+    }
+    if (t) {
+        // Transport is shut down: fail inline
+        t->response.error = "HTTP transport is shut down";
+        if (t->done) t->done(std::move(t->response));
+        return id;
+    }
+    curl_multi_wakeup(m_multi);
+    return id;
+}
+
+std::future<HttpTransport::Response> HttpTransport::submitFuture(Request request)
+{
+    auto promise = std::make_shared<std::promise<Response>>();
+    auto future = promise->get_future();
+    submit(std::move(request), [promise](Response&& r) { promise->set_value(std::move(r)); });
+    return future;
+}
+
+HttpTransport::Response HttpTransport::perform(Request request)
+{
+    if (onReactorThread())
+        throw std::logic_error("HttpTransport::perform called from the reactor thread");
+    return submitFuture(std::move(request)).get();
+}
+
+void HttpTransport::cancel(RequestId id)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_cancels.push_back(id);
+    }
+    curl_multi_wakeup(m_multi);
+}
+
+void HttpTransport::resume(RequestId id)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_resumes.push_back(id);
+    }
+    curl_multi_wakeup(m_multi);
+}
+
+void HttpTransport::shutdown()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_stopping) return;
+        m_stopping = true;
+    }
+    curl_multi_wakeup(m_multi);
+    if (m_thread.joinable()) m_thread.join();
+}
+
+void HttpTransport::addTransfer(std::unique_ptr<Transfer> t)
+{
+    CURL* easy = acquireHandle();
+    if (!easy) {
+        t->response.error = "Failed to initialize CURL";
+        finishTransfer(t.get(), CURLE_FAILED_INIT);
+        return;
+    }
+    t->easy = easy;
+
+    const Request& req = t->request;
+    const Options& opts = m_reactorOptions;
+    curl_easy_setopt(easy, CURLOPT_URL, req.url.c_str());
+    curl_easy_setopt(easy, CURLOPT_PRIVATE, t.get());
+    curl_easy_setopt(easy, CURLOPT_WRITEFUNCTION, &Transfer::writeCallback);
+    curl_easy_setopt(easy, CURLOPT_WRITEDATA, t.get());
+    curl_easy_setopt(easy, CURLOPT_TIMEOUT, req.timeoutSec);
+    curl_easy_setopt(easy, CURLOPT_NOSIGNAL, 1L);
+    curl_easy_setopt(easy, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_2TLS);
+    curl_easy_setopt(easy, CURLOPT_PIPEWAIT, 1L);  // prefer multiplexing over a new connection
+    // Per request: curl_easy_reset() in releaseHandle() clears it
+    if (m_share) curl_easy_setopt(easy, CURLOPT_SHARE, m_share);
+    curl_easy_setopt(easy, CURLOPT_MAXAGE_CONN, opts.maxConnectionAgeSec);
+    if (opts.tcpKeepAliveIdleSec > 0) {
+        curl_easy_setopt(easy, CURLOPT_TCP_KEEPALIVE, 1L);
+        curl_easy_setopt(easy, CURLOPT_TCP_KEEPIDLE, opts.tcpKeepAliveIdleSec);
+        curl_easy_setopt(easy, CURLOPT_TCP_KEEPINTVL, opts.tcpKeepAliveIntervalSec);
+    }
+    if (req.followRedirects) curl_easy_setopt(easy, CURLOPT_FOLLOWLOCATION, 1L);
+    if (!req.userAgent.empty()) curl_easy_setopt(easy, CURLOPT_USERAGENT, req.userAgent.c_str());
+    if (req.acceptEncoding) curl_easy_setopt(easy, CURLOPT_ACCEPT_ENCODING, req.acceptEncoding);
+
+    if (req.method == Method::Post) {
+        curl_easy_setopt(easy, CURLOPT_POST, 1L);
+        curl_easy_setopt(easy, CURLOPT_POSTFIELDS, req.body.c_str());
+        curl_easy_setopt(easy, CURLOPT_POSTFIELDSIZE, static_cast<long>(req.body.size()));
+    } else {
+        curl_easy_setopt(easy, CURLOPT_HTTPGET, 1L);
+    }
+
+    if (req.sharedHeaders && req.headers.empty()) {
+        curl_easy_setopt(easy, CURLOPT_HTTPHEADER, req.sharedHeaders->get());
+    } else {
+        if (req.sharedHeaders)
+            for (const auto& h : req.sharedHeaders->lines())
+                t->headers = curl_slist_append(t->headers, h.c_str());
+        for (const auto& h : req.headers)
+            t->headers = curl_slist_append(t->headers, h.c_str());
+        if (t->headers) curl_easy_setopt(easy, CURLOPT_HTTPHEADER, t->headers);
+    }
+
+    curl_multi_add_handle(m_multi, easy);
+    RequestId id = t->id;
+    m_active.emplace(id, std::move(t));
+}
+
+void HttpTransport::finishTransfer(Transfer* t, int curlCode)
+{
+    if (t->easy) {
+        curl_easy_getinfo(t->easy, CURLINFO_RESPONSE_CODE, &t->response.status);
+        curl_multi_remove_handle(m_multi, t->easy);
+        releaseHandle(t->easy);
+        t->easy = nullptr;
+    }
+
+    if (t->abortedByData) {
+        t->response.aborted = true;
+    } else if (curlCode != CURLE_OK && t->response.error.empty()) {
+        t->response.error = curl_easy_strerror(static_cast<CURLcode>(curlCode));
+    }
+
+    m_inFlight.fetch_sub(1);
+    if (t->done) {
+        try {
+            t->done(std::move(t->response));
+        } catch (const std::exception& e) {
+            std::cerr << "[HTTP] completion for " << t->request.url << " threw: " << e.what() << std::endl;
+        }
+    }
+}
+
+void HttpTransport::run()
+{
+    for (;;) {
+        std::vector<std::unique_ptr<Transfer>> incoming;
+        std::vector<RequestId> cancels, resumes;
+        bool stopping;
+        bool optionsChanged;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            incoming.swap(m_incoming);
+            cancels.swap(m_cancels);
+            resumes.swap(m_resumes);
+            stopping = m_stopping;
+            optionsChanged = m_optionsChanged;
+            m_optionsChanged = false;
+            if (optionsChanged) m_reactorOptions = m_options;
+        }
+        if (optionsChanged) applyMultiOptions(m_reactorOptions);
+
+        for (auto& t : incoming) {
+            if (stopping) {
+                t->response.aborted = true;
+                t->response.error = "HTTP transport is shut down";
+                finishTransfer(t.get(), CURLE_ABORTED_BY_CALLBACK);
+            } else {
+                addTransfer(std::move(t));
+            }
+        }
+
+        for (RequestId id : resumes) {
+            auto it = m_active.find(id);
+            if (it != m_active.end()) curl_easy_pause(it->second->easy, CURLPAUSE_CONT);
+        }
+
+        if (stopping) {
+            for (auto& [id, t] : m_active) cancels.push_back(id);
+        }
+        for (RequestId id : cancels) {
+            auto it = m_active.find(id);
+            if (it == m_active.end()) continue;
+            std::unique_ptr<Transfer> t = std::move(it->second);
+            m_active.erase(it);
+            t->response.aborted = true;
+            t->response.error = stopping ? "HTTP transport is shut down" : "cancelled";
+            finishTransfer(t.get(), CURLE_ABORTED_BY_CALLBACK);
+        }
+
+        if (stopping) return;
+
+        int running = 0;
+        curl_multi_perform(m_multi, &running);
+
+        int queued = 0;
+        while (CURLMsg* msg = curl_multi_info_read(m_multi, &queued)) {
+            if (msg->msg != CURLMSG_DONE) continue;
+            Transfer* raw = nullptr;
+            curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE, &raw);
+            CURLcode code = msg->data.result;  // read before the handle is removed
+            auto it = m_active.find(raw->id);
+            std::unique_ptr<Transfer> t = std::move(it->second);
+            m_active.erase(it);
+            finishTransfer(t.get(), code);
+        }
+
+        curl_multi_poll(m_multi, nullptr, 0, kPollTimeoutMs, nullptr);
+    }
+}
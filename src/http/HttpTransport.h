@@ -0,0 +1,186 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+typedef void CURLM;
+typedef void CURLSH;
+typedef void CURL;
+struct curl_slist;
+
+/// One curl-multi event loop that carries every outgoing HTTP request:
+/// backend queries and exports, vector and raster tiles, photo thumbnails.
+///
+/// A single reactor thread drives all transfers, so concurrency no longer
+/// costs an OS thread per request, and the multi handle's connection cache
+/// keeps connections warm across callers.  HTTP/2 is negotiated over TLS and
+/// requests to the same host are multiplexed onto one connection when the
+/// server supports it.
+///
+/// Per-request setup is kept off the hot path: finished easy handles are
+/// reset and pooled instead of destroyed, a share object keeps the DNS cache
+/// and TLS session tickets across handles (so a reconnect resumes the TLS
+/// session instead of a full handshake), and callers can pass a prebuilt
+/// HeaderList rather than rebuilding a curl_slist per request.
+///
+/// Completion and data callbacks run on the reactor thread; keep them short
+/// and hand heavy work (decoding, parsing) to another thread.
+class HttpTransport {
+public:
+    using RequestId = uint64_t;
+
+    enum class Method { Get, Post };
+
+    /// Connection reuse and keep-alive tuning.  Applied to transfers started
+    /// after configure(); multi-level limits take effect on the next loop.
+    struct Options {
+        long maxHostConnections = 8;        ///< HTTP/1.1 servers: parallel connections per host
+        long maxCachedConnections = 32;     ///< Idle connections kept open for reuse
+        long maxConnectionAgeSec = 118;     ///< Idle connections older than this are not reused
+        long tcpKeepAliveIdleSec = 30;      ///< 0 disables TCP keep-alive probes
+        long tcpKeepAliveIntervalSec = 15;
+        size_t handlePoolSize = 16;         ///< Reset easy handles kept for reuse
+    };
+
+    /// Immutable, shareable "Name: value" header list.  Build it once and
+    /// hand the same pointer to many requests; the transport uses it as-is.
+    class HeaderList {
+    public:
+        explicit HeaderList(const std::vector<std::string>& lines);
+        ~HeaderList();
+
+        HeaderList(const HeaderList&) = delete;
+        HeaderList& operator=(const HeaderList&) = delete;
+
+        const std::vector<std::string>& lines() const { return m_lines; }
+        curl_slist* get() const { return m_list; }
+
+    private:
+        std::vector<std::string> m_lines;
+        curl_slist* m_list = nullptr;
+    };
+
+    /// What a streaming data callback wants done with the chunk it was given.
+    enum class DataAction {
+        Continue,  ///< Chunk consumed
+        Pause,     ///< Chunk NOT consumed; curl redelivers it after resume()
+        Abort      ///< Stop the transfer (Response::aborted is set)
+    };
+
+    struct Request {
+        std::string url;
+        Method method = Method::Get;
+        std::string body;                  ///< POST body
+        std::vector<std::string> headers;  ///< "Name: value" lines
+        /// Prebuilt headers, reused without copying when `headers` is empty;
+        /// otherwise both are sent.
+        std::shared_ptr<const HeaderList> sharedHeaders;
+        long timeoutSec = 30;
+        bool followRedirects = false;
+        std::string userAgent;
+        /// When set, curl advertises and transparently decodes these encodings
+        /// ("" = everything libcurl supports).  Leave unset to receive the body
+        /// exactly as sent.
+        const char* acceptEncoding = nullptr;
+        /// Streaming body sink, called on the reactor thread.  If unset the
+        /// body is buffered into Response::body.
+        std::function<DataAction(const char* data, size_t len)> onData;
+    };
+
+    struct Response {
+        long status = 0;
+        std::string body;
+        std::string error;     ///< curl error text; empty if the transfer completed
+        bool aborted = false;  ///< Cancelled, or stopped by onData
+
+        bool ok() const { return error.empty() && !aborted && status >= 200 && status < 300; }
+    };
+
+    using Completion = std::function<void(Response&&)>;
+
+    /// Process-wide instance, created on first use.
+    static HttpTransport& shared();
+
+    /// Stop the shared instance if it was ever created.  Call before
+    /// curl_global_cleanup(); later submissions fail immediately.
+    static void shutdownShared();
+
+    HttpTransport();
+    ~HttpTransport();
+
+    HttpTransport(const HttpTransport&) = delete;
+    HttpTransport& operator=(const HttpTransport&) = delete;
+
+    /// Queue a request.  `done` is called exactly once, on the reactor thread
+    /// (or inline if the transport has been shut down).
+    RequestId submit(Request request, Completion done);
+
+    /// Queue a request and get its response as a future.
+    std::future<Response> submitFuture(Request request);
+
+    /// Blocking convenience wrapper.  Must not be called from a reactor callback.
+    Response perform(Request request);
+
+    /// Abort a request; its completion runs with aborted = true.  No-op if it
+    /// already finished.
+    void cancel(RequestId id);
+
+    /// Resume a transfer whose onData returned Pause.
+    void resume(RequestId id);
+
+    /// Abort everything in flight and join the reactor thread.
+    void shutdown();
+
+    /// Replace the connection options.  Thread-safe.
+    void configure(const Options& options);
+    Options options() const;
+
+    /// Easy handles created so far; stays flat once the pool is warm.
+    size_t handlesCreated() const { return m_handlesCreated.load(); }
+
+    /// Requests submitted but not yet completed.
+    size_t inFlight() const { return m_inFlight.load(); }
+
+    /// True when called from the reactor thread.
+    bool onReactorThread() const { return std::this_thread::get_id() == m_thread.get_id(); }
+
+private:
+    struct Transfer;
+
+    void run();
+    void addTransfer(std::unique_ptr<Transfer> t);
+    void finishTransfer(Transfer* t, int curlCode);
+    void applyMultiOptions(const Options& options);
+    CURL* acquireHandle();
+    void releaseHandle(CURL* easy);
+
+    CURLM* m_multi = nullptr;
+    CURLSH* m_share = nullptr;
+    std::thread m_thread;
+    std::atomic<RequestId> m_nextId{1};
+    std::atomic<size_t> m_inFlight{0};
+    std::atomic<size_t> m_handlesCreated{0};
+
+    // Hand-off from caller threads to the reactor
+    mutable std::mutex m_mutex;
+    std::vector<std::unique_ptr<Transfer>> m_incoming;
+    std::vector<RequestId> m_cancels;
+    std::vector<RequestId> m_resumes;
+    bool m_stopping = false;
+    Options m_options;
+    bool m_optionsChanged = false;
+
+    // Reactor-thread only
+    std::unordered_map<RequestId, std::unique_ptr<Transfer>> m_active;
+    std::vector<CURL*> m_idleHandles;
+    Options m_reactorOptions;
+};
@@ -0,0 +1,297 @@
+#include "IngestPipeline.h"
+#include "BackendAPI.h"
+#include "EntityScanner.h"
+#include <zlib.h>
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string_view>
+
+namespace {
+
+constexpr size_t kInflateChunk = 256 * 1024;
+constexpr size_t kMaxWorkers = 8;
+constexpr size_t kBytesPerEntityGuess = 128;  // GPS lines run ~150-170 bytes
+
+size_t defaultWorkerCount()
+{
+    unsigned hw = std::thread::hardware_concurrency();
+    size_t n = (hw > 1) ? hw - 1 : 1;  // leave a core for the network + decode stages
+    return std::min(n, kMaxWorkers);
+}
+
+} // namespace
+
+IngestPipeline::IngestPipeline(TotalCallback on_total, BatchCallback on_batch)
+    : IngestPipeline(std::move(on_total), std::move(on_batch), Config{})
+{
+}
+
+IngestPipeline::IngestPipeline(TotalCallback on_total, BatchCallback on_batch, const Config& config)
+    : m_onTotal(std::move(on_total))
+    , m_onBatch(std::move(on_batch))
+    , m_config(config)
+    , m_raw(config.queueDepth)
+    , m_decoded(config.queueDepth)
+    , m_slabs(2 * (config.parseWorkers ? config.parseWorkers : defaultWorkerCount()))
+{
+    start();
+}
+
+IngestPipeline::IngestPipeline(TotalCallback on_total, ColumnsCallback on_batch, const Config& config)
+    : m_onTotal(std::move(on_total))
+    , m_onColumns(std::move(on_batch))
+    , m_config(config)
+    , m_raw(config.queueDepth)
+    , m_decoded(config.queueDepth)
+    , m_slabs(2 * (config.parseWorkers ? config.parseWorkers : defaultWorkerCount()))
+{
+    start();
+}
+
+void IngestPipeline::start()
+{
+    size_t workers = m_config.parseWorkers ? m_config.parseWorkers : defaultWorkerCount();
+    if (m_config.slabBytes == 0) m_config.slabBytes = 1;
+
+    m_decompressThread = std::thread(&IngestPipeline::decompressLoop, this);
+    m_splitThread = std::thread(&IngestPipeline::splitLoop, this);
+    m_workers.reserve(workers);
+    for (size_t i = 0; i < workers; ++i)
+        m_workers.emplace_back(&IngestPipeline::parseLoop, this);
+}
+
+IngestPipeline::~IngestPipeline()
+{
+    if (!m_finished) cancel();
+    if (m_decompressThread.joinable()) m_decompressThread.join();
+    if (m_splitThread.joinable()) m_splitThread.join();
+    for (auto& t : m_workers)
+        if (t.joinable()) t.join();
+}
+
+bool IngestPipeline::push(const char* data, size_t len)
+{
+    if (m_cancelled.load()) return false;
+    if (len == 0) return true;
+    return m_raw.push(std::string(data, len)) && !m_cancelled.load();
+}
+
+void IngestPipeline::finish()
+{
+    if (m_finished) return;
+    m_finished = true;
+
+    m_raw.close();
+    m_decompressThread.join();
+    m_splitThread.join();
+    for (auto& t : m_workers) t.join();
+
+    std::lock_guard<std::mutex> lock(m_errorMutex);
+    if (!m_error.empty()) throw std::runtime_error(m_error);
+}
+
+void IngestPipeline::cancel()
+{
+    m_cancelled.store(true);
+    for (auto* q : {&m_raw, &m_decoded}) {
+        q->close();
+        q->clear();
+    }
+    m_slabs.close();
+    m_slabs.clear();
+    {
+        std::lock_guard<std::mutex> lock(m_deliverMutex);
+    }
+    m_deliverCv.notify_all();
+}
+
+void IngestPipeline::fail(const std::string& message)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_errorMutex);
+        if (m_error.empty()) m_error = message;
+    }
+    cancel();
+}
+
+// --- Stage 1: gzip (or identity) -> decoded blocks ---
+
+void IngestPipeline::decompressLoop()
+{
+    z_stream zs{};
+    bool sniffed = false;
+    bool gzip = false;
+    bool streamEnd = false;
+    std::string head;  // holds the first bytes until the magic number can be checked
+    std::string block;
+
+    while (m_raw.pop(block)) {
+        if (m_cancelled.load()) break;
+
+        if (!sniffed) {
+            head += block;
+            if (head.size() < 2) continue;
+            sniffed = true;
+            gzip = static_cast<unsigned char>(head[0]) == 0x1f &&
+                   static_cast<unsigned char>(head[1]) == 0x8b;
+            block.swap(head);
+            head.clear();
+            if (gzip && inflateInit2(&zs, 15 + 16) != Z_OK) {
+                gzip = false;
+                fail("IngestPipeline: inflateInit2 failed");
+                break;
+            }
+        }
+
+        if (!gzip) {
+            if (!m_decoded.push(std::move(block))) break;
+            continue;
+        }
+
+        zs.next_in = reinterpret_cast<Bytef*>(block.data());
+        zs.avail_in = static_cast<uInt>(block.size());
+        bool ok = true;
+        for (;;) {
+            if (streamEnd && zs.avail_in > 0) {
+                inflateReset(&zs);  // concatenated gzip member
+                streamEnd = false;
+            }
+            std::string out(kInflateChunk, '\0');
+            zs.next_out = reinterpret_cast<Bytef*>(out.data());
+            zs.avail_out = static_cast<uInt>(out.size());
+
+            int rc = inflate(&zs, Z_NO_FLUSH);
+            if (rc == Z_STREAM_END) {
+                streamEnd = true;
+            } else if (rc != Z_OK && rc != Z_BUF_ERROR) {
+                fail(std::string("IngestPipeline: gzip decode failed: ") + (zs.msg ? zs.msg : "unknown error"));
+                ok = false;
+                break;
+            }
+
+            out.resize(out.size() - zs.avail_out);
+            if (!out.empty() && !m_decoded.push(std::move(out))) { ok = false; break; }
+            if (streamEnd && zs.avail_in == 0) break;
+            if (!streamEnd && zs.avail_in == 0 && zs.avail_out != 0) break;
+        }
+        if (!ok) break;
+    }
+
+    if (!m_cancelled.load()) {
+        if (!sniffed && !head.empty())
+            m_decoded.push(std::move(head));  // body shorter than the gzip magic
+        else if (gzip && !streamEnd)
+            fail("IngestPipeline: gzip stream truncated");
+    }
+    if (gzip) inflateEnd(&zs);
+    m_decoded.close();
+}
+
+// --- Stage 2: decoded blocks -> newline-aligned slabs ---
+
+void IngestPipeline::splitLoop()
+{
+    uint64_t seq = 0;
+    std::string pending;
+    std::string block;
+
+    while (m_decoded.pop(block)) {
+        if (m_cancelled.load()) break;
+        if (pending.empty()) pending.swap(block);
+        else pending.append(block);
+
+        if (pending.size() < m_config.slabBytes) continue;
+        size_t cut = pending.rfind('\n');
+        if (cut == std::string::npos) continue;  // one very long line; keep accumulating
+
+        std::string rest(pending, cut + 1);
+        pending.resize(cut + 1);
+        if (!m_slabs.push(Slab{seq++, std::move(pending)})) break;
+        pending = std::move(rest);
+    }
+
+    if (!m_cancelled.load() && !pending.empty())
+        m_slabs.push(Slab{seq++, std::move(pending)});
+    m_slabs.close();
+}
+
+// --- Stage 3: slabs -> entity batches, delivered in sequence order ---
+
+void IngestPipeline::parseLoop()
+{
+    EntityScanner scanner;
+    Slab slab;
+
+    while (m_slabs.pop(slab)) {
+        if (m_cancelled.load()) break;
+
+        std::vector<Entity> batch;
+        EntityColumns columns;
+        if (m_onColumns) columns.reserve(slab.data.size() / kBytesPerEntityGuess, slab.data.size() / 4);
+        else batch.reserve(slab.data.size() / kBytesPerEntityGuess);
+        bool firstLine = (slab.seq == 0);
+        bool haveTotal = false;
+        size_t total = 0;
+
+        const char* p = slab.data.data();
+        const char* end = p + slab.data.size();
+        while (p < end) {
+            const char* nl = static_cast<const char*>(std::memchr(p, '\n', static_cast<size_t>(end - p)));
+            const char* lineEnd = nl ? nl : end;
+            std::string_view line(p, static_cast<size_t>(lineEnd - p));
+            p = nl ? nl + 1 : end;
+            if (line.empty()) continue;
+
+            bool headerCandidate = firstLine;
+            firstLine = false;
+            if (headerCandidate && EntityScanner::scanTotal(line, total)) {
+                haveTotal = true;
+                continue;
+            }
+
+            // Fast path: schema-aware scanner, no DOM
+            if (m_onColumns) {
+                if (scanner.scan(line, columns)) continue;
+            } else {
+                Entity& e = batch.emplace_back();
+                if (scanner.scan(line, e)) continue;
+                batch.pop_back();
+            }
+
+            // Slow path: full JSON parse for anything the scanner rejected
+            try {
+                auto j = nlohmann::json::parse(line);
+                if (headerCandidate && j.contains("total")) {
+                    total = j["total"].get<size_t>();
+                    haveTotal = true;
+                    continue;
+                }
+                if (m_onColumns) columns.push_back(BackendAPI::parse_entity(j));
+                else batch.push_back(BackendAPI::parse_entity(j));
+            } catch (const std::exception& ex) {
+                std::cerr << "Export JSON parse error: " << ex.what() << std::endl;
+            }
+        }
+
+        {
+            std::unique_lock<std::mutex> lock(m_deliverMutex);
+            m_deliverCv.wait(lock, [&] { return m_cancelled.load() || m_nextSeq == slab.seq; });
+            if (m_cancelled.load()) break;
+        }
+
+        // Only the holder of m_nextSeq gets here, so delivery is serialized
+        // without keeping the lock across the callbacks.
+        if (haveTotal && m_onTotal) m_onTotal(total);
+        bool keepGoing = m_onColumns ? (columns.empty() || m_onColumns(std::move(columns)))
+                                     : (batch.empty() || m_onBatch(std::move(batch)));
+        if (!keepGoing) cancel();
+
+        {
+            std::lock_guard<std::mutex> lock(m_deliverMutex);
+            ++m_nextSeq;
+        }
+        m_deliverCv.notify_all();
+    }
+}
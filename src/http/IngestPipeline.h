@@ -0,0 +1,108 @@
+#pragma once
+
+#include "core/BoundedQueue.h"
+#include "core/Entity.h"
+#include "core/EntityColumns.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/// Multi-stage decoder for the /v1/query/export NDJSON stream.
+///
+///   network thread --push()--> [raw blocks] --> decompress thread
+///     --> [decoded blocks] --> split thread --> [newline-aligned slabs]
+///     --> N parse workers --> in-order delivery to on_batch
+///
+/// Every hop is a BoundedQueue, so a slow consumer backs pressure up to the
+/// socket instead of buffering the whole export.  Slabs carry a sequence
+/// number and parse workers hand batches over strictly in sequence, so
+/// on_batch sees entities in stream order, one call at a time.
+///
+/// Batches are std::vector<Entity> or, with a ColumnsCallback, EntityColumns
+/// scanned straight into the columns.
+///
+/// gzip bodies are detected by their magic bytes; anything else passes
+/// through the decompress stage untouched.
+class IngestPipeline {
+public:
+    struct Config {
+        size_t parseWorkers = 0;          ///< 0 = hardware_concurrency - 1 (at least 1)
+        size_t slabBytes    = 1 << 20;    ///< Target decoded bytes per parse job
+        size_t queueDepth   = 8;          ///< Capacity of the raw and decoded queues
+    };
+
+    using TotalCallback = std::function<void(size_t total)>;
+    /// Return false to cancel the stream.
+    using BatchCallback = std::function<bool(std::vector<Entity>&&)>;
+    using ColumnsCallback = std::function<bool(EntityColumns&&)>;
+
+    IngestPipeline(TotalCallback on_total, BatchCallback on_batch);
+    IngestPipeline(TotalCallback on_total, BatchCallback on_batch, const Config& config);
+    IngestPipeline(TotalCallback on_total, ColumnsCallback on_batch, const Config& config);
+
+    /// Cancels and joins any stage still running.
+    ~IngestPipeline();
+
+    IngestPipeline(const IngestPipeline&) = delete;
+    IngestPipeline& operator=(const IngestPipeline&) = delete;
+
+    /// Feed raw (possibly gzip-compressed) body bytes.  Blocks while the
+    /// pipeline is full.  Returns false once the pipeline has been cancelled,
+    /// either by cancel() or by on_batch returning false.
+    bool push(const char* data, size_t len);
+
+    /// End of input: flush the trailing partial line, wait for every batch to
+    /// be delivered and join all stages.
+    /// @throws std::runtime_error if the compressed stream was corrupt
+    void finish();
+
+    /// Stop all stages as soon as possible; pending batches are discarded.
+    void cancel();
+
+    bool cancelled() const { return m_cancelled.load(); }
+
+    /// Parse-worker count actually in use.
+    size_t workerCount() const { return m_workers.size(); }
+
+private:
+    struct Slab {
+        uint64_t seq = 0;
+        std::string data;
+    };
+
+    void decompressLoop();
+    void splitLoop();
+    void parseLoop();
+    void fail(const std::string& message);
+    void start();
+
+    TotalCallback m_onTotal;
+    BatchCallback m_onBatch;
+    ColumnsCallback m_onColumns;  ///< set instead of m_onBatch
+    Config m_config;
+
+    BoundedQueue<std::string> m_raw;
+    BoundedQueue<std::string> m_decoded;
+    BoundedQueue<Slab> m_slabs;
+
+    std::thread m_decompressThread;
+    std::thread m_splitThread;
+    std::vector<std::thread> m_workers;
+
+    // In-order hand-off: a worker holding slab `seq` waits for m_nextSeq == seq
+    std::mutex m_deliverMutex;
+    std::condition_variable m_deliverCv;
+    uint64_t m_nextSeq = 0;
+
+    std::atomic<bool> m_cancelled{false};
+    bool m_finished = false;
+
+    std::mutex m_errorMutex;
+    std::string m_error;
+};
@@ -3,6 +3,7 @@
 #include "app/App.h"
 #include "AppModel.h"
 #include "screens/MainScreen.h"
+#include "http/HttpTransport.h"
 
 int main()
 {
@@ -17,10 +18,13 @@ int main()
     }
     catch (const std::exception& e) {
         std::cerr << "Error: " << e.what() << std::endl;
+        HttpTransport::shutdownShared();
         curl_global_cleanup();
         return 1;
     }
 
+    // Stop the shared reactor before curl's global state goes away
+    HttpTransport::shutdownShared();
     curl_global_cleanup();
     return 0;
 }
@@ -1,5 +1,6 @@
 #include "CalendarRenderer.h"
 #include <cstddef>
+#include <string_view>
 
 #ifndef SHADER_BASE_DIR
 #define SHADER_BASE_DIR "src/shaders"
@@ -7,7 +8,7 @@
 
 // Parse a "#RRGGBB" hex color string into float RGB components [0, 1].
 // Falls back to a neutral gray if the string is malformed.
-static void parseHexColor(const std::string& hex, float& r, float& g, float& b) {
+static void parseHexColor(std::string_view hex, float& r, float& g, float& b) {
     r = g = b = 0.5f;
     if (hex.size() < 7 || hex[0] != '#') return;
 
@@ -82,32 +83,37 @@ void CalendarRenderer::initBuffers() {
 }
 
 void CalendarRenderer::draw(const Mat3& viewProjection,
-                             const std::vector<Entity>& entities,
+                             const EntityStore& entities,
+                             double timeStart, double timeEnd,
                              float yOffset,
                              int   viewportWidth) {
     if (entities.empty() || !m_shader.valid()) return;
 
-    // Build instance data
+    // Build instance data for the events that can be on screen
     m_buf.clear();
-    m_buf.reserve(entities.size());
 
-    for (const auto& e : entities) {
+    entities.forEachInTime(timeStart, timeEnd, [&](const EntityColumns& c, size_t i, size_t) {
+        if (c.time_end[i] < timeStart) return;
         float r, g, b;
-        if (e.color.has_value()) {
-            parseHexColor(*e.color, r, g, b);
+        if (c.flags[i] & EntityColumns::kHasColor) {
+            parseHexColor(c.str(c.color[i]), r, g, b);
         } else {
             r = 0.298f; g = 0.686f; b = 0.314f;  // #4CAF50 fallback
         }
 
-        float t_end = (e.time_end > e.time_start) ? static_cast<float>(e.time_end)
-                                                   : static_cast<float>(e.time_start) + 1.0f;
+        double start = c.time_start[i];
+        double end = c.time_end[i];
+        float t_end = (end > start) ? static_cast<float>(end)
+                                    : static_cast<float>(start) + 1.0f;
         m_buf.push_back({
-            static_cast<float>(e.time_start),
+            static_cast<float>(start),
             t_end,
-            e.render_offset,
+            c.render_offset[i],
             r, g, b, 0.85f
         });
-    }
+    });
+
+    if (m_buf.empty()) return;
 
     // Upload — reallocate only when capacity is exceeded
     glBindBuffer(GL_ARRAY_BUFFER, m_instanceVbo);
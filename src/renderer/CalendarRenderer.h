@@ -1,6 +1,6 @@
 #pragma once
 
-#include "core/Entity.h"
+#include "core/EntityStore.h"
 #include "core/Mat3.h"
 #include "renderer/Shader.h"
 #include <vector>
@@ -37,10 +37,12 @@ public:
     void shutdown();
 
     /// Build instance buffer from entities and draw.
+    /// timeStart/timeEnd: the visible range; only events overlapping it are uploaded.
     /// yOffset: screen-space NDC shift applied to the whole layer (matches Layer::yOffset).
     /// viewportWidth: used to compute minimum bar width in NDC (avoids zero-width bars).
     void draw(const Mat3& viewProjection,
-              const std::vector<Entity>& entities,
+              const EntityStore& entities,
+              double timeStart, double timeEnd,
               float yOffset = 0.0f,
               int   viewportWidth = 1000);
 
@@ -31,22 +31,42 @@ void HistogramRenderer::shutdown() {
 }
 
 void HistogramRenderer::draw(const Mat3& viewProjection,
-                              const std::vector<Entity>& entities,
+                              const EntityStore& entities, uint64_t revision,
                               double timeStart, double timeEnd,
                               int numBins) {
     if (!m_shader.valid() || entities.empty() || numBins <= 0 || timeStart >= timeEnd)
         return;
 
     // --- Bin entities by time_mid ---
-    std::vector<int> bins(numBins, 0);
+    // Same view and data as last frame plus appends: bin just the new tail
+    bool reuse = &entities == m_binnedSource && revision == m_binnedRevision
+              && entities.size() >= m_binnedCount
+              && timeStart == m_binnedStart && timeEnd == m_binnedEnd
+              && static_cast<int>(m_bins.size()) == numBins;
+    if (!reuse) {
+        m_bins.assign(numBins, 0);
+        m_binnedSource = &entities;
+        m_binnedRevision = revision;
+        m_binnedCount = 0;
+        m_binnedStart = timeStart;
+        m_binnedEnd = timeEnd;
+    }
+
+    std::vector<int>& bins = m_bins;
     double range = timeEnd - timeStart;
-    for (const auto& e : entities) {
-        double t = e.time_mid();
-        if (t < timeStart || t >= timeEnd) continue;
+    auto binRow = [&](const EntityColumns& c, size_t row, size_t) {
+        double t = (c.time_start[row] + c.time_end[row]) / 2.0;
+        if (t < timeStart || t >= timeEnd) return;
         int bin = static_cast<int>((t - timeStart) / range * numBins);
         bin = std::clamp(bin, 0, numBins - 1);
         bins[bin]++;
-    }
+    };
+    // A fresh binning reads only the rows the time index puts in range
+    if (reuse)
+        entities.forEach(m_binnedCount, entities.size(), binRow);
+    else
+        entities.forEachInTime(timeStart, timeEnd, binRow);
+    m_binnedCount = entities.size();
 
     int maxCount = *std::max_element(bins.begin(), bins.end());
     if (maxCount == 0) return;
@@ -1,9 +1,10 @@
 #pragma once
 
 #include "core/Mat3.h"
-#include "core/Entity.h"
+#include "core/EntityStore.h"
 #include "renderer/Shader.h"
 
+#include <cstdint>
 #include <vector>
 
 #define GL_GLEXT_PROTOTYPES
@@ -24,6 +25,11 @@
 /// Entities are binned by time_mid over the visible [timeStart, timeEnd] range.
 /// Each bin becomes a filled rectangle whose height is proportional to its count
 /// relative to the peak bin.  Bars grow upward from the bottom of the timeline.
+///
+/// The bin counts are kept between frames: while the range, bin count and
+/// source revision stay the same, only entities appended since the last
+/// frame are binned, so a streaming load costs O(batch) per frame.  Binning
+/// afresh reads only the visible rows, found with the store's time index.
 class HistogramRenderer {
 public:
     struct TimeRange { float x0, x1; };
@@ -33,12 +39,14 @@ public:
 
     /// Bin entities by time_mid and draw filled bars in timeline coordinate space.
     /// @param viewProjection  The timeline camera transform (same Mat3 passed to PointRenderer).
-    /// @param entities        All loaded entities (iterated each frame; fast for <1M points).
+    /// @param entities        All loaded entities (re-binned in full only when the
+    ///                        range, bins or revision change; appends are binned incrementally).
+    /// @param revision        Layer::revision of entities; a change discards the counts.
     /// @param timeStart       Left edge of the visible time range (Unix seconds).
     /// @param timeEnd         Right edge of the visible time range (Unix seconds).
     /// @param numBins         Number of histogram columns (default 100).
     void draw(const Mat3& viewProjection,
-              const std::vector<Entity>& entities,
+              const EntityStore& entities, uint64_t revision,
               double timeStart, double timeEnd,
               int numBins = 100);
 
@@ -59,4 +67,12 @@ private:
     Shader m_shader;
 
     std::vector<Vertex> m_vertices;
+
+    // Bin counts carried between frames
+    std::vector<int> m_bins;
+    const EntityStore* m_binnedSource = nullptr;
+    uint64_t m_binnedRevision = 0;
+    size_t m_binnedCount = 0;
+    double m_binnedStart = 0.0;
+    double m_binnedEnd = 0.0;
 };
@@ -93,9 +93,9 @@ void PointRenderer::updateChunk(size_t chunkIndex, const PointVertex* data, size
 }
 
 // Draw instances — caller is responsible for shader bind, uniform setup, and blend state.
-void PointRenderer::drawChunkLoop(size_t numActiveChunks) {
-    size_t limit = std::min(numActiveChunks, m_chunkVaos.size());
-    for (size_t i = 0; i < limit; i++) {
+void PointRenderer::drawChunkLoop(size_t firstChunk, size_t endChunk) {
+    size_t limit = std::min(endChunk, m_chunkVaos.size());
+    for (size_t i = firstChunk; i < limit; i++) {
         if (m_chunkPointCounts[i] == 0) continue;
         glBindVertexArray(m_chunkVaos[i]);
         glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4,
@@ -122,17 +122,18 @@ void PointRenderer::drawChunked(const Mat3& viewProjection, float aspectRatio,
 
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE);
-    drawChunkLoop(numActiveChunks);
+    drawChunkLoop(0, numActiveChunks);
     glDisable(GL_BLEND);
     glUseProgram(0);
 }
 
 void PointRenderer::drawForTimeline(const Mat3& viewProjection, float aspectRatio,
-                                     size_t numActiveChunks, float timeMin, float timeMax,
+                                     size_t firstChunk, size_t endChunk,
+                                     float timeMin, float timeMax,
                                      const MapExtent& mapExtent,
                                      int colorMode, float br, float bg, float bb, float ba,
                                      float yOffset, int shape) {
-    if (numActiveChunks == 0) return;
+    if (firstChunk >= endChunk) return;
 
     // Set all uniforms once — u_filterMode will be changed between passes
     m_timelineShader.use();
@@ -155,11 +156,11 @@ void PointRenderer::drawForTimeline(const Mat3& viewProjection, float aspectRati
 
     // Pass 1: out-of-map points (gray) drawn first so they sit behind in-map color
     m_timelineShader.setInt("u_filterMode", 0);
-    drawChunkLoop(numActiveChunks);
+    drawChunkLoop(firstChunk, endChunk);
 
     // Pass 2: in-map points (full turbo color / solid color) drawn on top
     m_timelineShader.setInt("u_filterMode", 1);
-    drawChunkLoop(numActiveChunks);
+    drawChunkLoop(firstChunk, endChunk);
 
     glDisable(GL_BLEND);
     glUseProgram(0);
@@ -69,7 +69,9 @@ public:
     /// Points whose geo_pos falls outside mapExtent are desaturated.
     /// colorMode: 0=turbo colormap, 1=solid baseColor (r,g,b,a).
     /// yOffset: screen-space NDC Y shift applied after projection (positive = up).
-    void drawForTimeline(const Mat3& viewProjection, float aspectRatio, size_t numActiveChunks,
+    /// Draws chunks [firstChunk, endChunk): those holding the visible time range.
+    void drawForTimeline(const Mat3& viewProjection, float aspectRatio,
+                         size_t firstChunk, size_t endChunk,
                          float timeMin, float timeMax, const MapExtent& mapExtent,
                          int colorMode = 0, float br = 1, float bg = 1, float bb = 1, float ba = 1,
                          float yOffset = 0.0f, int shape = 0);
@@ -97,5 +99,5 @@ private:
     void cleanup();
     void allocateChunk();
     // Shared draw loop — shader must already be bound and uniforms set
-    void drawChunkLoop(size_t numActiveChunks);
+    void drawChunkLoop(size_t firstChunk, size_t endChunk);
 };
@@ -0,0 +1,85 @@
+#include "TextureUploader.h"
+
+#include <algorithm>
+#include <cstring>
+
+void TextureUploader::upload(GLuint texture, int width, int height, const uint8_t* rgba,
+                             std::shared_ptr<const void> owner) {
+    if (texture == 0 || width <= 0 || height <= 0 || !rgba) return;
+    cancel(texture);
+    m_jobs.push_back({texture, width, height, 0, rgba, std::move(owner)});
+}
+
+void TextureUploader::cancel(GLuint texture) {
+    m_jobs.erase(std::remove_if(m_jobs.begin(), m_jobs.end(),
+                                [texture](const Job& j) { return j.texture == texture; }),
+                 m_jobs.end());
+}
+
+bool TextureUploader::pending(GLuint texture) const {
+    return std::any_of(m_jobs.begin(), m_jobs.end(),
+                       [texture](const Job& j) { return j.texture == texture; });
+}
+
+TextureUploader::Slot* TextureUploader::acquireSlot() {
+    Slot& slot = m_ring[m_nextSlot];
+    if (slot.fence) {
+        GLenum status = glClientWaitSync(slot.fence, 0, 0);
+        if (status == GL_TIMEOUT_EXPIRED) return nullptr;
+        glDeleteSync(slot.fence);
+        slot.fence = nullptr;
+    }
+    if (slot.pbo == 0) glGenBuffers(1, &slot.pbo);
+    m_nextSlot = (m_nextSlot + 1) % kRingSize;
+    return &slot;
+}
+
+void TextureUploader::process(size_t budgetBytes) {
+    size_t staged = 0;
+    while (!m_jobs.empty() && (staged == 0 || staged < budgetBytes)) {
+        Job& job = m_jobs.front();
+        size_t rowBytes = static_cast<size_t>(job.width) * 4;
+        size_t allowance = std::max(std::min(budgetBytes - std::min(staged, budgetBytes),
+                                             kFrameBudgetBytes), rowBytes);
+        int rows = std::min(job.height - job.nextRow, static_cast<int>(allowance / rowBytes));
+        size_t bytes = rows * rowBytes;
+
+        Slot* slot = acquireSlot();
+        if (!slot) break;  // the GPU is still reading it: carry on next frame
+
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot->pbo);
+        if (slot->capacity < bytes) {
+            slot->capacity = std::max(bytes, kFrameBudgetBytes);
+            glBufferData(GL_PIXEL_UNPACK_BUFFER, slot->capacity, nullptr, GL_STREAM_DRAW);
+        }
+        void* dst = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, bytes,
+                                     GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+        if (!dst) {
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+            break;
+        }
+        std::memcpy(dst, job.rgba + job.nextRow * rowBytes, bytes);
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+        glBindTexture(GL_TEXTURE_2D, job.texture);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, job.nextRow, job.width, rows,
+                        GL_RGBA, GL_UNSIGNED_BYTE, nullptr);  // from offset 0 of the PBO
+        slot->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+        staged += bytes;
+        job.nextRow += rows;
+        if (job.nextRow >= job.height) m_jobs.pop_front();
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void TextureUploader::shutdown() {
+    m_jobs.clear();
+    for (Slot& slot : m_ring) {
+        if (slot.fence) { glDeleteSync(slot.fence); slot.fence = nullptr; }
+        if (slot.pbo) { glDeleteBuffers(1, &slot.pbo); slot.pbo = 0; }
+        slot.capacity = 0;
+    }
+    m_nextSlot = 0;
+}
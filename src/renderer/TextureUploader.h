@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+
+#define GL_GLEXT_PROTOTYPES
+#ifdef __APPLE__
+#define GL_SILENCE_DEPRECATION
+#include <OpenGL/gl3.h>
+#else
+#include <GL/gl.h>
+#endif
+#ifdef __APPLE__
+#include <OpenGL/glext.h>
+#else
+#include <GL/glext.h>
+#endif
+
+/// Streams RGBA8 pixels into textures through a small ring of pixel buffer
+/// objects, at most a fixed number of bytes per frame.
+///
+/// Each upload is cut into row stripes.  process() copies a stripe into the
+/// next PBO of the ring and issues glTexSubImage2D from it, so the driver
+/// transfers from the buffer asynchronously instead of the frame stalling
+/// on one large client-memory upload.  A PBO is written again only once the
+/// fence placed after its last transfer has signalled; if it has not, the
+/// rest waits for the next frame.  Main thread only.
+class TextureUploader {
+public:
+    static constexpr size_t kRingSize = 3;
+    /// Bytes staged per frame, and the size of each PBO.
+    static constexpr size_t kFrameBudgetBytes = 1u << 20;
+
+    TextureUploader() = default;
+    ~TextureUploader() = default;
+
+    TextureUploader(const TextureUploader&) = delete;
+    TextureUploader& operator=(const TextureUploader&) = delete;
+
+    /// Queue `rgba` (width x height, tightly packed) for level 0 of
+    /// `texture`, which must already have storage of that size.  `owner`
+    /// keeps the pixels alive until the upload finishes or is cancelled.
+    void upload(GLuint texture, int width, int height, const uint8_t* rgba,
+                std::shared_ptr<const void> owner);
+
+    /// Drop queued work for `texture` (call before deleting it).
+    void cancel(GLuint texture);
+
+    /// True while rows of `texture` are still waiting to be staged.
+    bool pending(GLuint texture) const;
+
+    /// Once per frame: stage up to `budgetBytes` (at least one stripe).
+    void process(size_t budgetBytes = kFrameBudgetBytes);
+
+    /// Delete the PBOs and fences.  Needs the GL context; call from onDetach.
+    void shutdown();
+
+private:
+    struct Job {
+        GLuint texture = 0;
+        int width = 0;
+        int height = 0;
+        int nextRow = 0;
+        const uint8_t* rgba = nullptr;
+        std::shared_ptr<const void> owner;
+    };
+
+    struct Slot {
+        GLuint pbo = 0;
+        size_t capacity = 0;
+        GLsync fence = nullptr;
+    };
+
+    /// The next PBO if its previous transfer has completed, else null.
+    Slot* acquireSlot();
+
+    std::deque<Job> m_jobs;
+    Slot m_ring[kRingSize];
+    size_t m_nextSlot = 0;
+};
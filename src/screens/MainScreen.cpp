@@ -42,6 +42,7 @@ void MainScreen::onUpdate(double dt)
     // Frame heartbeat — printed every 60 frames so we know the main thread is alive
     static int s_frame = 0;
     if (++s_frame % 60 == 0) {
+        auto queue = m_fetchOrchestrator.queueStats();
         std::cerr << "[FRAME " << s_frame
                   << "] gps=" << m_model->layers[0].entities.size()
                   << " photos=" << m_model->layers[1].entities.size()
@@ -51,6 +52,9 @@ void MainScreen::onUpdate(double dt)
                   << " photo_fetching=" << m_model->layers[1].is_fetching
                   << " calendar_fetching=" << m_model->layers[2].is_fetching
                   << " gtimeline_fetching=" << m_model->layers[3].is_fetching
+                  << " queue=" << queue.depth << "/" << queue.capacity
+                  << " peak=" << queue.highWater
+                  << " stalled_ms=" << static_cast<long>(queue.stallSeconds * 1000.0)
                   << "\n";
     }
 
@@ -65,6 +69,12 @@ void MainScreen::onUpdate(double dt)
             m_interaction.markPickersDirty();
         log_slow("drainCompletedBatches", t);
     }
+    {
+        auto t = Clock::now();
+        if (m_fetchOrchestrator.updateViewport(*m_model))
+            m_interaction.markPickersDirty();
+        log_slow("updateViewport", t);
+    }
     { auto t = Clock::now(); m_interaction.update(*m_model);     log_slow("interaction.update", t, 5); }
     { auto t = Clock::now(); m_interaction.drainPhotoTexture();  log_slow("drainPhotoTexture", t, 5); }
 
@@ -218,6 +228,7 @@ void MainScreen::onGui()
         m_fpsTracker, *m_model, m_backendConfig,
         m_backendUrl, sizeof(m_backendUrl),
         m_serverStats, m_hasServerStats,
+        m_fetchOrchestrator.queueStats(), m_fetchOrchestrator.drainBudget(),
         m_renderer, m_timelineRenderer,
         m_camera, m_timelineCamera,
         actions);
@@ -319,10 +330,27 @@ void MainScreen::applyControlsActions(const ControlsActions& actions)
     if (actions.resetMap) m_camera.reset();
     if (actions.resetTimeline) m_timelineCamera.reset();
 
+    if (actions.exportShards >= 1)
+        m_backendConfig.exportShards = actions.exportShards;
     if (actions.switchBackendType >= 0)
         switchBackend(static_cast<BackendConfig::Type>(actions.switchBackendType));
     if (actions.applyHttpConfig)
-        switchBackend(BackendConfig::Type::Http);
+        switchBackend(m_backendConfig.type);
+    if (actions.syntheticMillions > 0) {
+        m_backendConfig.syntheticGpsPoints = static_cast<size_t>(actions.syntheticMillions) * 1000000;
+        switchBackend(m_backendConfig.type);
+    }
+    if (actions.viewportFetch >= 0) {
+        m_backendConfig.viewportFetch = actions.viewportFetch != 0;
+        switchBackend(m_backendConfig.type);
+    }
+    if (actions.dedupeTimeline >= 0) {
+        m_backendConfig.dedupeTimeline = actions.dedupeTimeline != 0;
+        switchBackend(m_backendConfig.type);
+    }
+
+    if (actions.drainBudgetMs > 0.0f)
+        m_fetchOrchestrator.setDrainBudget(actions.drainBudgetMs / 1000.0);
 
     if (actions.tileMode >= 0)
         m_renderer.setTileMode(static_cast<TileMode>(actions.tileMode));
@@ -341,6 +369,8 @@ void MainScreen::applyControlsActions(const ControlsActions& actions)
         m_interaction.resetPickers();
         m_fetchOrchestrator.startFullLoad(*m_model);
     }
+    if (actions.syncCache)
+        m_fetchOrchestrator.startSync();
 }
 
 void MainScreen::switchBackend(BackendConfig::Type type)
@@ -350,18 +380,22 @@ void MainScreen::switchBackend(BackendConfig::Type type)
 
     m_backendConfig.type = type;
     m_fetchOrchestrator.setBackends(createBackends(m_backendConfig, m_backendUrl), type);
+    m_fetchOrchestrator.setViewportFetch(m_backendConfig.viewportFetch);
+    std::optional<DuplicateRule> dedupe;
+    if (m_backendConfig.dedupeTimeline) dedupe = DuplicateRule{};
+    m_fetchOrchestrator.setDuplicateRule(dedupe);
 
     auto& backends = m_fetchOrchestrator.backends();
     if (backends.photo) {
         Backend* pb = backends.photo.get();
-        m_interaction.setPhotoFetcher([pb](const std::string& id) -> std::vector<uint8_t> {
-            return pb->fetchPhotoThumb(id);
+        m_interaction.setPhotoFetcher([pb](const std::string& id) {
+            return pb->fetchPhotoThumbAsync(id);
         });
     } else {
         m_interaction.setPhotoFetcher({});
     }
 
-    if (type == BackendConfig::Type::Http) {
+    if (type != BackendConfig::Type::Fake) {
         auto [stats, ok] = m_fetchOrchestrator.fetchServerStats();
         m_serverStats = stats;
         m_hasServerStats = ok;
@@ -1,5 +1,4 @@
 #include "tiles/RasterTileCache.h"
-#include <curl/curl.h>
 #include <algorithm>
 #include <string>
 
@@ -7,44 +6,20 @@
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 
-static size_t curlWrite(void* contents, size_t size, size_t nmemb, void* userp) {
-    auto* buf = static_cast<std::vector<uint8_t>*>(userp);
-    size_t total = size * nmemb;
-    buf->insert(buf->end(),
-                static_cast<uint8_t*>(contents),
-                static_cast<uint8_t*>(contents) + total);
-    return total;
-}
-
 RasterTileCache::RasterTileCache(std::string urlTemplate)
     : m_urlTemplate(std::move(urlTemplate)) {}
 
 RasterTileCache::~RasterTileCache() {
-    for (auto& f : m_inFlight) { if (f.valid()) f.wait(); }
-    for (auto* h : m_curlPool) curl_easy_cleanup(h);
+    for (const auto& [key, id] : m_requests) HttpTransport::shared().cancel(id);
+    std::unique_lock<std::mutex> lock(m_resultMutex);
+    m_resultCv.wait(lock, [this] { return m_outstanding == 0; });
 }
 
-CURL* RasterTileCache::acquireCurl() {
-    std::lock_guard<std::mutex> lock(m_curlPoolMutex);
-    if (!m_curlPool.empty()) {
-        CURL* h = m_curlPool.back();
-        m_curlPool.pop_back();
-        return h;
-    }
-    CURL* h = curl_easy_init();
-    if (h) {
-        curl_easy_setopt(h, CURLOPT_WRITEFUNCTION, curlWrite);
-        curl_easy_setopt(h, CURLOPT_USERAGENT,     "reckoner/1.0");
-        curl_easy_setopt(h, CURLOPT_TIMEOUT,       10L);
-        curl_easy_setopt(h, CURLOPT_FOLLOWLOCATION, 1L);
-        curl_easy_setopt(h, CURLOPT_ACCEPT_ENCODING, "");
-    }
-    return h;
-}
-
-void RasterTileCache::releaseCurl(CURL* h) {
-    std::lock_guard<std::mutex> lock(m_curlPoolMutex);
-    m_curlPool.push_back(h);
+void RasterTileCache::completeFetch(FetchResult&& result) {
+    std::lock_guard<std::mutex> lock(m_resultMutex);
+    m_completedFetches.push_back(std::move(result));
+    --m_outstanding;
+    m_resultCv.notify_all();  // under the lock: the destructor may be waiting
 }
 
 static std::string replaceAll(std::string s,
@@ -55,37 +30,16 @@ static std::string replaceAll(std::string s,
     return s;
 }
 
-RasterTileCache::FetchResult RasterTileCache::downloadAndDecode(const TileKey& key) {
+RasterTileCache::FetchResult RasterTileCache::decode(const TileKey& key, const std::string& encoded) {
     FetchResult result;
     result.key = key;
 
-    CURL* curl = acquireCurl();
-    if (!curl) return result;
-
-    // Substitute {z}, {x}, {y} in the URL template
-    std::string url = m_urlTemplate;
-    url = replaceAll(url, "{z}", std::to_string(key.z));
-    url = replaceAll(url, "{x}", std::to_string(key.x));
-    url = replaceAll(url, "{y}", std::to_string(key.y));
-
-    std::vector<uint8_t> raw;
-    curl_easy_setopt(curl, CURLOPT_URL,       url.c_str());
-    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &raw);
-
-    CURLcode res  = curl_easy_perform(curl);
-    long httpCode = 0;
-    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &httpCode);
-    releaseCurl(curl);
-
-    if (res != CURLE_OK || httpCode != 200 || raw.empty())
-        return result;
-
     // Decode image into RGBA with stb_image.
     // Flip vertically so texture origin matches OpenGL (bottom-left).
     int w, h, ch;
     stbi_set_flip_vertically_on_load(1);
-    uint8_t* data = stbi_load_from_memory(raw.data(),
-                                           static_cast<int>(raw.size()),
+    uint8_t* data = stbi_load_from_memory(reinterpret_cast<const stbi_uc*>(encoded.data()),
+                                           static_cast<int>(encoded.size()),
                                            &w, &h, &ch, 4);
     if (!data) return result;
 
@@ -98,20 +52,37 @@ RasterTileCache::FetchResult RasterTileCache::downloadAndDecode(const TileKey& k
 }
 
 void RasterTileCache::fetchTileAsync(const TileKey& key) {
-    // Remove finished futures
-    m_inFlight.erase(
-        std::remove_if(m_inFlight.begin(), m_inFlight.end(),
-            [](const std::future<void>& f) {
-                return f.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
-            }),
-        m_inFlight.end());
-
     m_tiles[key].state = TileState::Fetching;
-    m_inFlight.push_back(std::async(std::launch::async, [this, key]() {
-        auto result = downloadAndDecode(key);
+
+    // Substitute {z}, {x}, {y} in the URL template
+    std::string url = m_urlTemplate;
+    url = replaceAll(url, "{z}", std::to_string(key.z));
+    url = replaceAll(url, "{x}", std::to_string(key.x));
+    url = replaceAll(url, "{y}", std::to_string(key.y));
+
+    HttpTransport::Request request;
+    request.url             = std::move(url);
+    request.userAgent       = "reckoner/1.0";
+    request.timeoutSec      = 10;
+    request.followRedirects = true;
+    request.acceptEncoding  = "";
+
+    {
         std::lock_guard<std::mutex> lock(m_resultMutex);
-        m_completedFetches.push_back(std::move(result));
-    }));
+        ++m_outstanding;
+    }
+    m_requests[key] = HttpTransport::shared().submit(std::move(request),
+        [this, key](HttpTransport::Response&& response) {
+            if (response.status != 200 || !response.error.empty() || response.aborted || response.body.empty()) {
+                FetchResult failed;
+                failed.key = key;
+                completeFetch(std::move(failed));
+                return;
+            }
+            m_decodePool.submit([this, key, body = std::move(response.body)]() {
+                completeFetch(decode(key, body));
+            });
+        });
 }
 
 void RasterTileCache::processCompletedFetches() {
@@ -124,6 +95,7 @@ void RasterTileCache::processCompletedFetches() {
     }
 
     for (auto& r : results) {
+        m_requests.erase(r.key);
         auto& entry = m_tiles[r.key];
         if (r.success) {
             entry.pixels = std::move(r.pixels);
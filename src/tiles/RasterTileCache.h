@@ -1,17 +1,17 @@
 #pragma once
 
 #include "tiles/TileCache.h" // for TileKey, TileKeyHash, TileState
+#include "core/ThreadPool.h"
+#include "http/HttpTransport.h"
 
 #include <unordered_map>
 #include <vector>
 #include <mutex>
-#include <future>
+#include <condition_variable>
 #include <deque>
 #include <string>
 #include <cstdint>
 
-typedef void CURL;
-
 struct RasterTileEntry {
     TileState state = TileState::Empty;
     std::vector<uint8_t> pixels; // RGBA, width*height*4 bytes
@@ -55,17 +55,19 @@ private:
     uint64_t m_frameCounter = 0;
 
     std::mutex m_resultMutex;
+    std::condition_variable m_resultCv;
     std::deque<FetchResult> m_completedFetches;
-    std::vector<std::future<void>> m_inFlight;
+    int m_outstanding = 0;  // guarded by m_resultMutex
     std::deque<TileKey> m_pendingQueue;
 
-    std::mutex m_curlPoolMutex;
-    std::vector<CURL*> m_curlPool;
+    std::unordered_map<TileKey, HttpTransport::RequestId, TileKeyHash> m_requests;  // main thread only
     static constexpr int MaxConcurrentFetches = 6;
 
     void fetchTileAsync(const TileKey& key);
     void drainPendingQueue();
-    FetchResult downloadAndDecode(const TileKey& key);
-    CURL* acquireCurl();
-    void releaseCurl(CURL* curl);
+    void completeFetch(FetchResult&& result);
+    static FetchResult decode(const TileKey& key, const std::string& encoded);
+
+    // PNG decode pool; declared last so it is joined before the members its tasks touch
+    ThreadPool m_decodePool{2};
 };
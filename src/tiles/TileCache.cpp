@@ -4,55 +4,26 @@
 #include <iostream>
 #include <algorithm>
 
-static size_t curlWriteCallback(void* contents, size_t size, size_t nmemb, void* userp) {
-    auto* buffer = static_cast<std::vector<uint8_t>*>(userp);
-    size_t totalSize = size * nmemb;
-    buffer->insert(buffer->end(), static_cast<uint8_t*>(contents),
-                   static_cast<uint8_t*>(contents) + totalSize);
-    return totalSize;
-}
-
 TileCache::TileCache() = default;
 
 TileCache::~TileCache() {
-    for (auto& f : m_inFlight) {
-        if (f.valid()) f.wait();
-    }
-    for (auto* curl : m_curlPool) {
-        curl_easy_cleanup(curl);
+    for (const auto& [key, id] : m_requests) {
+        HttpTransport::shared().cancel(id);
     }
+    std::unique_lock<std::mutex> lock(m_resultMutex);
+    m_resultCv.wait(lock, [this] { return m_outstanding == 0; });
 }
 
-CURL* TileCache::acquireCurl() {
-    std::lock_guard<std::mutex> lock(m_curlPoolMutex);
-    if (!m_curlPool.empty()) {
-        CURL* curl = m_curlPool.back();
-        m_curlPool.pop_back();
-        return curl;
-    }
-    // Create a new handle with common options pre-set
-    CURL* curl = curl_easy_init();
-    if (curl) {
-        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, curlWriteCallback);
-        curl_easy_setopt(curl, CURLOPT_USERAGENT, "reckoner/1.0");
-        curl_easy_setopt(curl, CURLOPT_TIMEOUT, 10L);
-        curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
-        curl_easy_setopt(curl, CURLOPT_ACCEPT_ENCODING, "");
-    }
-    return curl;
+void TileCache::completeFetch(FetchResult&& result) {
+    // Notify under the lock: the destructor may be waiting to tear down m_resultCv
+    std::lock_guard<std::mutex> lock(m_resultMutex);
+    m_completedFetches.push_back(std::move(result));
+    --m_outstanding;
+    m_resultCv.notify_all();
 }
 
-void TileCache::releaseCurl(CURL* curl) {
-    std::lock_guard<std::mutex> lock(m_curlPoolMutex);
-    m_curlPool.push_back(curl);
-}
-
-TileCache::FetchResult TileCache::downloadAndDecode(const TileKey& key) {
-    FetchResult result;
-    result.key = key;
-
-    CURL* curl = acquireCurl();
-    if (!curl) return result;
+void TileCache::fetchTileAsync(const TileKey& key) {
+    m_tiles[key].state = TileState::Fetching;
 
     // Versatiles OSM vector tiles (free, no API key)
     char url[256];
@@ -60,45 +31,33 @@ TileCache::FetchResult TileCache::downloadAndDecode(const TileKey& key) {
              "https://tiles.versatiles.org/tiles/osm/%d/%d/%d.pbf",
              key.z, key.x, key.y);
 
-    std::vector<uint8_t> rawData;
-    curl_easy_setopt(curl, CURLOPT_URL, url);
-    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &rawData);
-
-    CURLcode res = curl_easy_perform(curl);
+    HttpTransport::Request request;
+    request.url = url;
+    request.userAgent = "reckoner/1.0";
+    request.timeoutSec = 10;
+    request.followRedirects = true;
+    request.acceptEncoding = "";
 
-    long httpCode = 0;
-    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &httpCode);
-    releaseCurl(curl);
-
-    if (res != CURLE_OK || httpCode != 200) {
-        return result;
+    {
+        std::lock_guard<std::mutex> lock(m_resultMutex);
+        ++m_outstanding;
     }
-
-    // Decode MVT protobuf into line segments
-    result.lines = MvtDecoder::decode(rawData.data(), rawData.size(),
-                                       key.x, key.y, key.z);
-    result.success = true;
-    return result;
-}
-
-void TileCache::fetchTileAsync(const TileKey& key) {
-    // Clean up completed futures
-    m_inFlight.erase(
-        std::remove_if(m_inFlight.begin(), m_inFlight.end(),
-            [](const std::future<void>& f) {
-                return f.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
-            }),
-        m_inFlight.end());
-
-    m_tiles[key].state = TileState::Fetching;
-
-    m_inFlight.push_back(std::async(std::launch::async, [this, key]() {
-        auto result = downloadAndDecode(key);
-        {
-            std::lock_guard<std::mutex> lock(m_resultMutex);
-            m_completedFetches.push_back(std::move(result));
-        }
-    }));
+    m_requests[key] = HttpTransport::shared().submit(std::move(request),
+        [this, key](HttpTransport::Response&& response) {
+            if (response.status != 200 || !response.error.empty() || response.aborted) {
+                completeFetch(FetchResult{key, {}, false});
+                return;
+            }
+            // Decode MVT protobuf into line segments on the decode pool
+            m_decodePool.submit([this, key, body = std::move(response.body)]() {
+                FetchResult result;
+                result.key = key;
+                result.lines = MvtDecoder::decode(reinterpret_cast<const uint8_t*>(body.data()), body.size(),
+                                                   key.x, key.y, key.z);
+                result.success = true;
+                completeFetch(std::move(result));
+            });
+        });
 }
 
 void TileCache::processCompletedFetches() {
@@ -111,6 +70,7 @@ void TileCache::processCompletedFetches() {
     }
 
     for (auto& result : results) {
+        m_requests.erase(result.key);
         auto& entry = m_tiles[result.key];
         if (result.success) {
             entry.lines = std::move(result.lines);
@@ -1,15 +1,15 @@
 #pragma once
 
 #include "tiles/MvtDecoder.h"
+#include "core/ThreadPool.h"
+#include "http/HttpTransport.h"
 #include <unordered_map>
 #include <vector>
 #include <mutex>
-#include <future>
+#include <condition_variable>
 #include <deque>
 #include <cstdint>
 
-typedef void CURL;
-
 struct TileKey {
     int z, x, y;
     bool operator==(const TileKey& o) const { return z == o.z && x == o.x && y == o.y; }
@@ -58,18 +58,20 @@ private:
     uint64_t m_frameCounter = 0;
 
     std::mutex m_resultMutex;
+    std::condition_variable m_resultCv;
     std::deque<FetchResult> m_completedFetches;
-    std::vector<std::future<void>> m_inFlight;
+    int m_outstanding = 0;  // submitted but not yet in m_completedFetches (guarded by m_resultMutex)
     std::deque<TileKey> m_pendingQueue;
 
-    // Pool of reusable CURL handles — each keeps its TCP+TLS connection alive
-    std::mutex m_curlPoolMutex;
-    std::vector<CURL*> m_curlPool;
+    // Requests on the shared transport (main thread only; used to cancel on destruction)
+    std::unordered_map<TileKey, HttpTransport::RequestId, TileKeyHash> m_requests;
     static constexpr int MaxConcurrentFetches = 10;
 
     void fetchTileAsync(const TileKey& key);
     void drainPendingQueue();
-    FetchResult downloadAndDecode(const TileKey& key);
-    CURL* acquireCurl();
-    void releaseCurl(CURL* curl);
+    void completeFetch(FetchResult&& result);
+
+    // MVT decode runs here, off both the main thread and the network reactor.
+    // Declared last so it is joined before the members its tasks touch.
+    ThreadPool m_decodePool{2};
 };
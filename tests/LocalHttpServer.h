@@ -0,0 +1,270 @@
+#pragma once
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+/// Minimal HTTP/1.1 server on 127.0.0.1 for transport tests and the
+/// benchmarks' stand-in server.  One thread per connection, keep-alive;
+/// Content-Length bodies, or chunked ones from a Response::stream.
+class LocalHttpServer {
+public:
+    struct Request {
+        std::string method;
+        std::string target;   ///< path + query, as sent
+        std::map<std::string, std::string> headers;  ///< lower-cased names
+        std::string body;
+
+        std::string header(const std::string& name) const {
+            auto it = headers.find(name);
+            return it == headers.end() ? std::string() : it->second;
+        }
+    };
+
+    struct Response {
+        int status = 200;
+        std::string body;
+        std::vector<std::pair<std::string, std::string>> headers;
+        size_t chunkBytes = 0;  ///< >0: write the body in pieces of this size
+        int chunkDelayMs = 0;   ///< pause between pieces
+        int delayMs = 0;        ///< pause before the status line
+        size_t abortAfterBytes = 0;  ///< >0: drop the connection after this many body bytes
+        double bytesPerSecond = 0;   ///< >0: pace the body to this rate
+        /// If set, the body is produced piece by piece instead (sent chunked):
+        /// called until it returns false, each call replacing `piece` with
+        /// the next part (possibly empty; the last call's is sent too).
+        /// Destroyed without finishing if the client goes away.
+        std::function<bool(std::string& piece)> stream;
+    };
+
+    using Handler = std::function<Response(const Request&)>;
+
+    /// @param port 0 picks a free one
+    explicit LocalHttpServer(Handler handler, int port = 0) : m_handler(std::move(handler)) {
+        m_listenFd = ::socket(AF_INET, SOCK_STREAM, 0);
+        if (m_listenFd < 0) throw std::runtime_error("socket() failed");
+        int one = 1;
+        ::setsockopt(m_listenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = htons(static_cast<uint16_t>(port));
+        if (::bind(m_listenFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+            ::listen(m_listenFd, 64) != 0)
+            throw std::runtime_error("bind/listen failed");
+
+        socklen_t len = sizeof(addr);
+        ::getsockname(m_listenFd, reinterpret_cast<sockaddr*>(&addr), &len);
+        m_port = ntohs(addr.sin_port);
+
+        m_acceptThread = std::thread([this] { acceptLoop(); });
+    }
+
+    ~LocalHttpServer() {
+        m_stopping = true;
+        ::shutdown(m_listenFd, SHUT_RDWR);
+        ::close(m_listenFd);
+        m_acceptThread.join();
+
+        std::vector<std::thread> threads;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            for (int fd : m_connFds) ::shutdown(fd, SHUT_RDWR);
+            threads.swap(m_connThreads);
+        }
+        for (auto& t : threads) t.join();
+    }
+
+    LocalHttpServer(const LocalHttpServer&) = delete;
+    LocalHttpServer& operator=(const LocalHttpServer&) = delete;
+
+    int port() const { return m_port; }
+    std::string url() const { return "http://127.0.0.1:" + std::to_string(m_port); }
+
+    size_t connectionsAccepted() const { return m_connections.load(); }
+    size_t requestsServed() const { return m_requests.load(); }
+
+private:
+    void acceptLoop() {
+        while (!m_stopping) {
+            int fd = ::accept(m_listenFd, nullptr, nullptr);
+            if (fd < 0) {
+                if (m_stopping) return;
+                continue;
+            }
+            int one = 1;
+            ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+            ++m_connections;
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_connFds.push_back(fd);
+            m_connThreads.emplace_back([this, fd] { serve(fd); });
+        }
+    }
+
+    void closeConnection(int fd) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_connFds.erase(std::remove(m_connFds.begin(), m_connFds.end(), fd), m_connFds.end());
+        ::close(fd);
+    }
+
+    static bool sendAll(int fd, const char* data, size_t len) {
+        while (len > 0) {
+            ssize_t n = ::send(fd, data, len, MSG_NOSIGNAL);
+            if (n <= 0) return false;
+            data += n;
+            len -= static_cast<size_t>(n);
+        }
+        return true;
+    }
+
+    /// Sends body bytes, sleeping as needed to hold `bytesPerSecond`
+    /// (measured from `start` over the `sent` bytes so far).
+    static bool sendPaced(int fd, const char* data, size_t len, double bytesPerSecond,
+                          std::chrono::steady_clock::time_point start, size_t& sent) {
+        if (bytesPerSecond <= 0) {
+            sent += len;
+            return sendAll(fd, data, len);
+        }
+        constexpr size_t kSlice = 16384;
+        for (size_t off = 0; off < len; off += kSlice) {
+            size_t n = std::min(kSlice, len - off);
+            sent += n;
+            std::this_thread::sleep_until(start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                std::chrono::duration<double>(sent / bytesPerSecond)));
+            if (!sendAll(fd, data + off, n)) return false;
+        }
+        return true;
+    }
+
+    /// A Response::stream body in chunked transfer encoding.
+    static bool sendStream(int fd, Response& resp) {
+        auto start = std::chrono::steady_clock::now();
+        size_t sent = 0;
+        std::string piece;
+        bool more = true;
+        while (more) {
+            piece.clear();
+            more = resp.stream(piece);
+            if (piece.empty()) continue;
+            char size[24];
+            int n = std::snprintf(size, sizeof(size), "%zx\r\n", piece.size());
+            piece += "\r\n";
+            if (!sendAll(fd, size, static_cast<size_t>(n)) ||
+                !sendPaced(fd, piece.data(), piece.size(), resp.bytesPerSecond, start, sent))
+                return false;
+        }
+        return sendAll(fd, "0\r\n\r\n", 5);
+    }
+
+    void serve(int fd) {
+        std::string buf;
+        char tmp[16384];
+        for (;;) {
+            size_t headerEnd;
+            while ((headerEnd = buf.find("\r\n\r\n")) == std::string::npos) {
+                ssize_t n = ::recv(fd, tmp, sizeof(tmp), 0);
+                if (n <= 0) { closeConnection(fd); return; }
+                buf.append(tmp, static_cast<size_t>(n));
+            }
+
+            Request req;
+            std::string head = buf.substr(0, headerEnd);
+            size_t lineEnd = head.find("\r\n");
+            std::string requestLine = head.substr(0, lineEnd);
+            size_t sp1 = requestLine.find(' ');
+            size_t sp2 = requestLine.find(' ', sp1 + 1);
+            req.method = requestLine.substr(0, sp1);
+            req.target = requestLine.substr(sp1 + 1, sp2 - sp1 - 1);
+
+            size_t pos = (lineEnd == std::string::npos) ? head.size() : lineEnd + 2;
+            while (pos < head.size()) {
+                size_t e = head.find("\r\n", pos);
+                if (e == std::string::npos) e = head.size();
+                std::string line = head.substr(pos, e - pos);
+                size_t colon = line.find(':');
+                if (colon != std::string::npos) {
+                    std::string name = line.substr(0, colon);
+                    for (auto& c : name) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+                    size_t v = line.find_first_not_of(' ', colon + 1);
+                    req.headers[name] = (v == std::string::npos) ? "" : line.substr(v);
+                }
+                pos = e + 2;
+            }
+
+            size_t contentLength = 0;
+            if (!req.header("content-length").empty())
+                contentLength = std::stoul(req.header("content-length"));
+            buf.erase(0, headerEnd + 4);
+            while (buf.size() < contentLength) {
+                ssize_t n = ::recv(fd, tmp, sizeof(tmp), 0);
+                if (n <= 0) { closeConnection(fd); return; }
+                buf.append(tmp, static_cast<size_t>(n));
+            }
+            req.body = buf.substr(0, contentLength);
+            buf.erase(0, contentLength);
+
+            Response resp = m_handler(req);
+            ++m_requests;
+            if (resp.delayMs > 0)
+                std::this_thread::sleep_for(std::chrono::milliseconds(resp.delayMs));
+
+            std::string out = "HTTP/1.1 " + std::to_string(resp.status) + " X\r\n";
+            if (resp.stream)
+                out += "Transfer-Encoding: chunked\r\n";
+            else
+                out += "Content-Length: " + std::to_string(resp.body.size()) + "\r\n";
+            for (const auto& [k, v] : resp.headers) out += k + ": " + v + "\r\n";
+            out += "\r\n";
+            if (!sendAll(fd, out.data(), out.size())) { closeConnection(fd); return; }
+
+            if (resp.stream) {
+                if (!sendStream(fd, resp)) { closeConnection(fd); return; }
+                continue;
+            }
+
+            auto start = std::chrono::steady_clock::now();
+            size_t sent = 0;
+            size_t step = resp.chunkBytes ? resp.chunkBytes : resp.body.size();
+            size_t limit = resp.abortAfterBytes ? std::min(resp.abortAfterBytes, resp.body.size())
+                                                : resp.body.size();
+            for (size_t off = 0; off < limit; off += step) {
+                size_t n = std::min(step, limit - off);
+                if (!sendPaced(fd, resp.body.data() + off, n, resp.bytesPerSecond, start, sent)) {
+                    closeConnection(fd);
+                    return;
+                }
+                if (resp.chunkDelayMs > 0)
+                    std::this_thread::sleep_for(std::chrono::milliseconds(resp.chunkDelayMs));
+            }
+            if (limit < resp.body.size()) { closeConnection(fd); return; }
+        }
+    }
+
+    Handler m_handler;
+    int m_listenFd = -1;
+    int m_port = 0;
+    std::atomic<bool> m_stopping{false};
+    std::atomic<size_t> m_connections{0};
+    std::atomic<size_t> m_requests{0};
+    std::thread m_acceptThread;
+    std::mutex m_mutex;
+    std::vector<int> m_connFds;
+    std::vector<std::thread> m_connThreads;
+};
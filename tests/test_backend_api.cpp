@@ -0,0 +1,660 @@
+#include <catch2/catch_test_macros.hpp>
+#include "http/BackendAPI.h"
+#include "http/ColumnarFormat.h"
+#include "HttpBackend.h"
+#include "core/TimeUtils.h"
+#include "LocalHttpServer.h"
+#include <atomic>
+#include <algorithm>
+#include <cmath>
+#include <chrono>
+#include <cstdio>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+/// Stand-in for the backend's /stats, /v1/query/export, /v1/query/time and
+/// /v1/query/bbox endpoints over a fixed, t_start-ordered dataset.  Honours start
+/// (inclusive) and end (exclusive) on the export unless told to ignore them.
+/// `groupSize` consecutive rows share one t_start; the time query returns
+/// such ties in a different order on every call and clamps `limit` to
+/// maxLimit, like the real server's cap.  With `columnar` set, an export
+/// request that accepts ColumnarFormat gets it instead of NDJSON.  The
+/// /v1/cache endpoints summarise and serve the rows by bucket.
+struct ExportServer {
+    /// Injected failure for one export request: a status other than 200,
+    /// or a connection dropped after `abortAfterBytes` of the body.
+    struct Fault {
+        int status = 200;
+        size_t abortAfterBytes = 0;
+    };
+
+    std::vector<Entity> rows;
+    std::atomic<bool> ignoreRange{false};
+    std::atomic<bool> unordered{false};
+    std::atomic<bool> columnar{false};
+    size_t columnarBlockRows = 500;
+    std::mutex faultMutex;
+    std::deque<Fault> faults;  ///< consumed one per export request
+    std::vector<std::string> exportTargets;
+    std::atomic<int> timeQueries{0};
+    std::vector<std::string> bucketDataBodies;
+    std::vector<std::string> bboxBodies;
+    int maxLimit = 10000;
+    LocalHttpServer server;
+
+    explicit ExportServer(size_t count, size_t groupSize = 1)
+        : server([this](const LocalHttpServer::Request& req) { return handle(req); })
+    {
+        const double t0 = 1500000000.0;  // 2017-07-14
+        for (size_t i = 0; i < count; ++i) {
+            Entity e;
+            char id[32];
+            std::snprintf(id, sizeof(id), "e%06zu", i);
+            e.id = id;
+            e.time_start = e.time_end = t0 + static_cast<double>(i / groupSize) * 3600.0 * 7 + 0.25;
+            e.lat = 30.0 + (i % 100) * 0.01;
+            e.lon = -120.0 + (i % 37) * 0.01;
+            rows.push_back(e);
+        }
+    }
+
+    std::string url() const { return server.url(); }
+
+    static std::string param(const std::string& target, const std::string& name) {
+        size_t q = target.find('?');
+        if (q == std::string::npos) return {};
+        std::string query = target.substr(q + 1);
+        size_t pos = 0;
+        while (pos < query.size()) {
+            size_t amp = query.find('&', pos);
+            if (amp == std::string::npos) amp = query.size();
+            std::string kv = query.substr(pos, amp - pos);
+            if (kv.compare(0, name.size() + 1, name + "=") == 0) return kv.substr(name.size() + 1);
+            pos = amp + 1;
+        }
+        return {};
+    }
+
+    static std::string line(const Entity& e) {
+        return "{\"id\":\"" + e.id + "\",\"t_start\":\"" + TimeUtils::to_iso8601(e.time_start) +
+               "\",\"t_end\":null,\"lat\":" + std::to_string(*e.lat) +
+               ",\"lon\":" + std::to_string(*e.lon) + "}";
+    }
+
+    LocalHttpServer::Response timeQuery(const LocalHttpServer::Request& req) {
+        int call = ++timeQueries;
+        auto q = nlohmann::json::parse(req.body);
+        double start = TimeUtils::parse_iso8601(q["start"].get<std::string>());
+        double end = TimeUtils::parse_iso8601(q["end"].get<std::string>());
+        size_t limit = static_cast<size_t>(std::min(q.value("limit", 2000), maxLimit));
+
+        std::vector<const Entity*> hits;
+        for (const auto& e : rows)
+            if (e.time_start >= start && e.time_start <= end) hits.push_back(&e);
+        // Same t_start order, but ties shuffled differently per call
+        std::stable_sort(hits.begin(), hits.end(), [call](const Entity* a, const Entity* b) {
+            if (a->time_start != b->time_start) return a->time_start < b->time_start;
+            return (call % 2) ? a->id > b->id : a->id < b->id;
+        });
+        if (hits.size() > limit) hits.resize(limit);
+
+        LocalHttpServer::Response r;
+        r.body = "{\"entities\": [";
+        for (size_t i = 0; i < hits.size(); ++i) r.body += (i ? "," : "") + line(*hits[i]);
+        r.body += "]}";
+        return r;
+    }
+
+    LocalHttpServer::Response bboxQuery(const LocalHttpServer::Request& req) {
+        {
+            std::lock_guard<std::mutex> lock(faultMutex);
+            bboxBodies.push_back(req.body);
+        }
+        auto q = nlohmann::json::parse(req.body);
+        auto bbox = q["bbox"];
+        double start = TimeUtils::parse_iso8601(q["time"]["start"].get<std::string>());
+        double end = TimeUtils::parse_iso8601(q["time"]["end"].get<std::string>());
+        size_t limit = static_cast<size_t>(std::min(q.value("limit", 5000), maxLimit));
+
+        LocalHttpServer::Response r;
+        r.body = "{\"entities\": [";
+        size_t n = 0;
+        for (const auto& e : rows) {
+            if (n == limit) break;
+            if (e.time_start < start || e.time_start > end ||
+                *e.lon < bbox[0].get<double>() || *e.lat < bbox[1].get<double>() ||
+                *e.lon > bbox[2].get<double>() || *e.lat > bbox[3].get<double>())
+                continue;
+            r.body += (n++ ? "," : "") + line(e);
+        }
+        r.body += "]}";
+        return r;
+    }
+
+    /// Like Python's isoformat(), which the real endpoint uses
+    static std::string pyIso(double t) {
+        std::string s = TimeUtils::to_iso8601(t);
+        return s.substr(0, s.size() - 1) + "+00:00";
+    }
+
+    LocalHttpServer::Response bucketHashes(const LocalHttpServer::Request& req) {
+        double width = std::stod(param(req.target, "bucket_seconds"));
+        std::map<double, std::pair<size_t, std::string>> buckets;
+        for (const auto& e : rows) {
+            auto& b = buckets[std::floor(e.time_start / width) * width];
+            ++b.first;
+            b.second += line(e);
+        }
+        nlohmann::json out = {{"type", param(req.target, "type")}, {"buckets", nlohmann::json::array()}};
+        for (const auto& [start, b] : buckets) {
+            char hash[17];
+            std::snprintf(hash, sizeof(hash), "%016llx",
+                          static_cast<unsigned long long>(std::hash<std::string>{}(b.second)));
+            out["buckets"].push_back({{"start", pyIso(start)}, {"end", pyIso(start + width)},
+                                      {"count", b.first}, {"hash", hash}});
+        }
+        LocalHttpServer::Response r;
+        r.body = out.dump();
+        return r;
+    }
+
+    LocalHttpServer::Response bucketData(const LocalHttpServer::Request& req) {
+        {
+            std::lock_guard<std::mutex> lock(faultMutex);
+            bucketDataBodies.push_back(req.body);
+        }
+        auto q = nlohmann::json::parse(req.body);
+        std::vector<Entity> hits;
+        for (const auto& e : rows) {
+            for (const auto& b : q["buckets"]) {
+                if (e.time_start >= TimeUtils::parse_iso8601(b["start"].get<std::string>()) &&
+                    e.time_start < TimeUtils::parse_iso8601(b["end"].get<std::string>())) {
+                    hits.push_back(e);
+                    break;
+                }
+            }
+        }
+        LocalHttpServer::Response r;
+        if (columnar && req.header("accept").find(ColumnarFormat::kContentType) != std::string::npos) {
+            r.body = ColumnarFormat::Encoder::encode(hits, columnarBlockRows);
+            r.headers.push_back({"Content-Type", ColumnarFormat::kContentType});
+            return r;
+        }
+        r.body = "{\"total\":" + std::to_string(hits.size()) + "}\n";
+        for (const auto& e : hits) r.body += line(e) + "\n";
+        return r;
+    }
+
+    LocalHttpServer::Response handle(const LocalHttpServer::Request& req) {
+        if (req.target == "/v1/query/time") return timeQuery(req);
+        if (req.target == "/v1/query/bbox") return bboxQuery(req);
+        if (req.target.rfind("/v1/cache/bucket-hashes", 0) == 0) return bucketHashes(req);
+        if (req.target == "/v1/cache/bucket-data") return bucketData(req);
+        LocalHttpServer::Response r;
+        if (req.target == "/stats") {
+            r.body = "{\"total_entities\":" + std::to_string(rows.size()) +
+                     ",\"time_coverage\":{\"oldest\":\"" + TimeUtils::to_iso8601(rows.front().time_start) +
+                     "\",\"newest\":\"" + TimeUtils::to_iso8601(rows.back().time_start) + "\"}}";
+            return r;
+        }
+        if (req.target.rfind("/v1/query/export", 0) != 0) {
+            r.status = 404;
+            return r;
+        }
+        Fault fault;
+        {
+            std::lock_guard<std::mutex> lock(faultMutex);
+            exportTargets.push_back(req.target);
+            if (!faults.empty()) {
+                fault = faults.front();
+                faults.pop_front();
+            }
+        }
+        if (fault.status != 200) {
+            r.status = fault.status;
+            r.body = "unavailable";
+            return r;
+        }
+        r.abortAfterBytes = fault.abortAfterBytes;
+        double start = -INFINITY, end = INFINITY;
+        if (!ignoreRange) {
+            std::string s = param(req.target, "start"), e = param(req.target, "end");
+            if (!s.empty()) start = TimeUtils::parse_iso8601(s);
+            if (!e.empty()) end = TimeUtils::parse_iso8601(e);
+        }
+        std::vector<const Entity*> hits;
+        auto emit = [&](const Entity& e) {
+            if (e.time_start >= start && e.time_start < end) hits.push_back(&e);
+        };
+        if (unordered) {
+            for (size_t i = 0; i < rows.size(); i += 2) emit(rows[i]);
+            for (size_t i = 1; i < rows.size(); i += 2) emit(rows[i]);
+        } else {
+            for (const auto& e : rows) emit(e);
+        }
+        r.chunkBytes = 4096;
+
+        if (columnar && req.header("accept").find(ColumnarFormat::kContentType) != std::string::npos) {
+            std::vector<Entity> selected;
+            for (const Entity* e : hits) selected.push_back(*e);
+            r.body = ColumnarFormat::Encoder::encode(selected, columnarBlockRows);
+            r.headers.push_back({"Content-Type", ColumnarFormat::kContentType});
+            return r;
+        }
+        r.body = "{\"total\":" + std::to_string(hits.size()) + "}\n";
+        for (const Entity* e : hits) r.body += line(*e) + "\n";
+        return r;
+    }
+};
+
+struct Collected {
+    std::vector<std::string> ids;
+    size_t total = 0;
+    size_t totalCalls = 0;
+};
+
+Collected collectExport(BackendAPI& api, const ServerStats* stats, int shards)
+{
+    Collected c;
+    auto on_total = [&c](size_t t) { c.total = t; ++c.totalCalls; };
+    auto on_batch = [&c](std::vector<Entity>&& batch) {
+        for (const auto& e : batch) c.ids.push_back(e.id);
+        return true;
+    };
+    if (stats) api.fetch_export_sharded(*stats, shards, on_total, on_batch);
+    else api.fetch_export(on_total, on_batch);
+    return c;
+}
+
+} // namespace
+
+TEST_CASE("export_shard_ranges covers the timeline without gaps", "[backend_api]") {
+    auto ranges = BackendAPI::export_shard_ranges(1000.5, 2000.0, 4);
+    REQUIRE(ranges.size() == 4);
+    REQUIRE(std::isinf(ranges.front().start));
+    REQUIRE(std::isinf(ranges.back().end));
+    for (size_t i = 1; i < ranges.size(); ++i) {
+        REQUIRE(ranges[i].start == ranges[i - 1].end);
+        REQUIRE(ranges[i].start == std::floor(ranges[i].start));
+    }
+
+    REQUIRE(BackendAPI::export_shard_ranges(1000.0, 1000.0, 8).size() == 1);
+    REQUIRE(BackendAPI::export_shard_ranges(1000.0, 1002.0, 8).size() == 2);  // whole seconds only
+    REQUIRE(BackendAPI::export_shard_ranges(1000.0, 5000.0, 1).size() == 1);
+}
+
+TEST_CASE("Sharded export matches the single stream", "[backend_api]") {
+    ExportServer backend(6000);
+    BackendAPI api(backend.url(), "key");
+    ServerStats stats = api.fetch_stats();
+    REQUIRE(stats.total_entities == 6000);
+
+    Collected single = collectExport(api, nullptr, 1);
+    REQUIRE(single.ids.size() == 6000);
+    REQUIRE(single.total == 6000);
+
+    for (int shards : {2, 3, 7}) {
+        Collected sharded = collectExport(api, &stats, shards);
+        REQUIRE(sharded.ids == single.ids);
+        REQUIRE(sharded.total == single.total);
+        REQUIRE(sharded.totalCalls == 1);
+    }
+}
+
+TEST_CASE("Sharded export stays correct when the server ignores the range", "[backend_api]") {
+    ExportServer backend(3000);
+    backend.ignoreRange = true;
+    BackendAPI api(backend.url(), "key");
+    ServerStats stats = api.fetch_stats();
+
+    Collected sharded = collectExport(api, &stats, 4);
+    Collected single = collectExport(api, nullptr, 1);
+    REQUIRE(sharded.ids == single.ids);
+    REQUIRE(sharded.total == 3000);  // clamped to /stats
+}
+
+TEST_CASE("Sharded export falls back without coverage and stops early on request", "[backend_api]") {
+    ExportServer backend(2000);
+    BackendAPI api(backend.url(), "key");
+
+    ServerStats noCoverage;
+    Collected fallback = collectExport(api, &noCoverage, 4);
+    REQUIRE(fallback.ids.size() == 2000);
+
+    ServerStats stats = api.fetch_stats();
+    size_t batches = 0;
+    api.fetch_export_sharded(stats, 4, nullptr, [&batches](std::vector<Entity>&&) {
+        ++batches;
+        return false;
+    });
+    REQUIRE(batches == 1);
+}
+
+TEST_CASE("Sharded export bounds what later shards buffer", "[backend_api]") {
+    ExportServer backend(8000);
+    backend.columnar = true;
+    backend.columnarBlockRows = 50;  // 40 batches per shard
+    BackendAPI api(backend.url(), "key");
+    api.set_shard_queue_batches(3);
+    ServerStats stats = api.fetch_stats();
+    Collected single = collectExport(api, nullptr, 1);
+
+    // A slow consumer: the later shards fill their queues long before shard
+    // 0 is delivered, and must pause there
+    std::vector<std::string> ids;
+    api.fetch_export_sharded_columns(stats, 4, nullptr, [&ids](EntityColumns&& batch) {
+        for (size_t i = 0; i < batch.size(); ++i) ids.emplace_back(batch.idAt(i));
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        return true;
+    });
+    REQUIRE(ids == single.ids);
+    REQUIRE(api.shard_queue_high_water() > 0);
+    REQUIRE(api.shard_queue_high_water() <= 3);
+}
+
+TEST_CASE("HttpBackend streams the sharded export in time order", "[backend_api]") {
+    ExportServer backend(4000);
+    HttpBackend http(backend.url(), "key", "location.gps");
+    http.setExportShards(5);
+
+    std::vector<double> times;
+    size_t total = 0;
+    http.streamAllEntities(
+        [&total](size_t t) { total = t; },
+        [&times](std::vector<Entity>&& batch) {
+            for (const auto& e : batch) times.push_back(e.time_start);
+        });
+    REQUIRE(total == 4000);
+    REQUIRE(times.size() == 4000);
+    for (size_t i = 1; i < times.size(); ++i) REQUIRE(times[i - 1] < times[i]);
+}
+
+TEST_CASE("HttpBackend streams the export as columns", "[backend_api]") {
+    ExportServer backend(3000);
+    HttpBackend http(backend.url(), "key", "location.gps");
+    http.setExportShards(3);
+
+    std::vector<std::string> rowIds;
+    http.streamAllEntities(nullptr, [&rowIds](std::vector<Entity>&& batch) {
+        for (const auto& e : batch) rowIds.push_back(e.id);
+    });
+
+    std::vector<std::string> columnIds;
+    size_t total = 0;
+    http.streamAllColumns(
+        [&total](size_t t) { total = t; },
+        [&columnIds](EntityColumns&& batch) {
+            for (size_t i = 0; i < batch.size(); ++i) columnIds.emplace_back(batch.idAt(i));
+        });
+    REQUIRE(total == 3000);
+    REQUIRE(columnIds.size() == 3000);
+    REQUIRE(columnIds == rowIds);
+}
+
+TEST_CASE("stream_time_pages delivers every row once across pages", "[backend_api]") {
+    ExportServer backend(1000, 3);  // ties in threes
+    BackendAPI api(backend.url(), "key");
+
+    SECTION("page size honoured by the server") {}
+    SECTION("server caps the page below the request") { backend.maxLimit = 40; }
+
+    std::vector<std::string> ids;
+    std::vector<double> times;
+    size_t pages = 0;
+    api.stream_time_pages("photo", TimeExtent{0.0, 2000000000.0}, [&](std::vector<Entity>&& page) {
+        ++pages;
+        REQUIRE(page.size() <= 100);
+        for (const auto& e : page) {
+            ids.push_back(e.id);
+            times.push_back(e.time_start);
+        }
+        return true;
+    }, 100);
+
+    REQUIRE(ids.size() == 1000);
+    REQUIRE(std::set<std::string>(ids.begin(), ids.end()).size() == 1000);
+    REQUIRE(std::is_sorted(times.begin(), times.end()));
+    REQUIRE(pages >= 10);
+}
+
+TEST_CASE("stream_time_pages stops when asked", "[backend_api]") {
+    ExportServer backend(1000);
+    BackendAPI api(backend.url(), "key");
+
+    size_t pages = 0;
+    api.stream_time_pages("photo", TimeExtent{0.0, 2000000000.0}, [&](std::vector<Entity>&&) {
+        ++pages;
+        return false;
+    }, 100);
+    REQUIRE(pages == 1);
+    REQUIRE(backend.timeQueries <= 2);  // the first page plus at most one prefetch
+}
+
+TEST_CASE("HttpBackend streamAllByType is no longer capped", "[backend_api]") {
+    ExportServer backend(25000);
+    HttpBackend http(backend.url(), "key", "photo");
+
+    size_t batches = 0, rows = 0;
+    http.streamAllByType(0.0, 4000000000.0, [&](std::vector<Entity>&& batch) {
+        ++batches;
+        rows += batch.size();
+    });
+    REQUIRE(rows == 25000);
+    REQUIRE(batches == 3);
+}
+
+namespace {
+
+BackendAPI::ExportRetry fastRetry(int attempts)
+{
+    BackendAPI::ExportRetry retry;
+    retry.maxAttempts = attempts;
+    retry.initialBackoffSec = 0.01;
+    retry.maxBackoffSec = 0.05;
+    return retry;
+}
+
+} // namespace
+
+TEST_CASE("Export resumes from its checkpoint after failures", "[backend_api]") {
+    ExportServer backend(5000, 3);  // ties in threes straddle the cut points
+    BackendAPI api(backend.url(), "key");
+    api.set_export_retry(fastRetry(3));
+    Collected clean = collectExport(api, nullptr, 1);
+
+    backend.exportTargets.clear();
+    backend.faults = {{200, 120000}, {503, 0}, {200, 61111}, {200, 7}};
+    Collected resumed = collectExport(api, nullptr, 1);
+
+    REQUIRE(resumed.ids == clean.ids);
+    REQUIRE(resumed.total == 5000);
+    REQUIRE(resumed.totalCalls == 1);
+    REQUIRE(backend.exportTargets.size() == 5);
+    REQUIRE(backend.exportTargets[0] == "/v1/query/export");
+    REQUIRE(backend.exportTargets[1].find("start=") != std::string::npos);
+}
+
+TEST_CASE("Sharded export resumes each shard independently", "[backend_api]") {
+    ExportServer backend(6000, 2);
+    BackendAPI api(backend.url(), "key");
+    api.set_export_retry(fastRetry(4));
+    ServerStats stats = api.fetch_stats();
+    Collected clean = collectExport(api, nullptr, 1);
+
+    backend.faults = {{200, 30000}, {200, 20000}, {503, 0}, {200, 45000}, {200, 10000}};
+    Collected sharded = collectExport(api, &stats, 3);
+    REQUIRE(sharded.ids == clean.ids);
+    REQUIRE(sharded.total == 6000);
+    REQUIRE(sharded.totalCalls == 1);
+}
+
+TEST_CASE("Export gives up, or stops, without progress", "[backend_api]") {
+    ExportServer backend(1000);
+    BackendAPI api(backend.url(), "key");
+
+    SECTION("retries are bounded") {
+        api.set_export_retry(fastRetry(3));
+        backend.faults = {{503, 0}, {503, 0}, {503, 0}, {503, 0}};
+        REQUIRE_THROWS(collectExport(api, nullptr, 1));
+        REQUIRE(backend.exportTargets.size() == 3);
+    }
+
+    SECTION("cancellation ends the backoff") {
+        auto retry = fastRetry(10);
+        retry.initialBackoffSec = retry.maxBackoffSec = 30.0;
+        retry.cancelled = [] { return true; };
+        api.set_export_retry(retry);
+        backend.faults = {{200, 20000}};
+        Collected partial = collectExport(api, nullptr, 1);
+        REQUIRE(!partial.ids.empty());
+        REQUIRE(partial.ids.size() < 1000);
+        REQUIRE(backend.exportTargets.size() == 1);
+    }
+
+    SECTION("an unordered stream is not resumed") {
+        api.set_export_retry(fastRetry(3));
+        backend.unordered = true;
+        backend.faults = {{200, 60000}};
+        REQUIRE_THROWS(collectExport(api, nullptr, 1));
+        REQUIRE(backend.exportTargets.size() == 1);
+    }
+}
+
+TEST_CASE("Export negotiates the columnar format and falls back to NDJSON", "[backend_api]") {
+    ExportServer backend(3000, 2);
+    BackendAPI api(backend.url(), "key");
+    Collected ndjson = collectExport(api, nullptr, 1);
+
+    backend.columnar = true;
+    std::vector<Entity> received;
+    size_t total = 0;
+    api.fetch_export([&](size_t t) { total = t; },
+                     [&](std::vector<Entity>&& batch) {
+                         for (auto& e : batch) received.push_back(std::move(e));
+                         return true;
+                     });
+    REQUIRE(total == 3000);
+    REQUIRE(received.size() == backend.rows.size());
+    for (size_t i = 0; i < received.size(); ++i) {
+        const Entity& want = backend.rows[i];
+        REQUIRE(received[i].id == want.id);
+        REQUIRE(std::abs(received[i].time_start - want.time_start) <= 1e-6);
+        REQUIRE(std::abs(*received[i].lat - *want.lat) <= 1e-6);
+        REQUIRE(std::abs(*received[i].lon - *want.lon) <= 1e-6);
+    }
+
+    // Switched off, the client stops asking and the server sends NDJSON
+    api.set_columnar_export(false);
+    Collected plain = collectExport(api, nullptr, 1);
+    REQUIRE(plain.ids == ndjson.ids);
+}
+
+TEST_CASE("Columnar export resumes from its checkpoint after failures", "[backend_api]") {
+    ExportServer backend(5000, 3);
+    backend.columnar = true;
+    backend.columnarBlockRows = 100;  // several blocks fit before each cut
+    BackendAPI api(backend.url(), "key");
+    api.set_export_retry(fastRetry(4));
+    Collected clean = collectExport(api, nullptr, 1);
+    REQUIRE(clean.ids.size() == 5000);
+
+    backend.exportTargets.clear();
+    backend.faults = {{200, 9000}, {503, 0}, {200, 4000}, {200, 3}};
+    Collected resumed = collectExport(api, nullptr, 1);
+    REQUIRE(resumed.ids == clean.ids);
+    REQUIRE(resumed.total == 5000);
+    REQUIRE(resumed.totalCalls == 1);
+    REQUIRE(backend.exportTargets.size() == 5);
+}
+
+TEST_CASE("Bucket hashes and bucket data round-trip through the cache endpoints", "[backend_api]") {
+    ExportServer backend(2000);  // one row every 7 hours
+    BackendAPI api(backend.url(), "key");
+
+    auto buckets = api.fetch_bucket_hashes("location.gps", 86400);
+    REQUIRE_FALSE(buckets.empty());
+    size_t counted = 0;
+    for (const auto& b : buckets) {
+        REQUIRE(std::fmod(b.start, 86400.0) == 0.0);
+        REQUIRE(b.end == b.start + 86400.0);
+        REQUIRE(b.hash != 0);
+        counted += b.count;
+    }
+    REQUIRE(counted == backend.rows.size());
+
+    // Two separate days, and a request range wider than the data it returns
+    std::vector<TimeExtent> ranges = {{buckets[3].start, buckets[3].end},
+                                      {buckets[10].start, buckets[12].end}};
+    std::vector<std::string> expected;
+    for (const auto& e : backend.rows)
+        for (const auto& r : ranges)
+            if (e.time_start >= r.start && e.time_start < r.end) expected.push_back(e.id);
+
+    for (bool columnar : {false, true}) {
+        backend.columnar = columnar;
+        std::vector<std::string> ids;
+        api.stream_bucket_data("location.gps", ranges, [&ids](std::vector<Entity>&& batch) {
+            for (const auto& e : batch) ids.push_back(e.id);
+            return true;
+        });
+        REQUIRE(ids == expected);
+    }
+    auto request = nlohmann::json::parse(backend.bucketDataBodies.at(0));
+    REQUIRE(request["type"] == "location.gps");
+    REQUIRE(request["buckets"].size() == 2);
+}
+
+TEST_CASE("HttpBackend reports missing cache endpoints as unavailable", "[backend_api]") {
+    LocalHttpServer server([](const LocalHttpServer::Request&) {
+        LocalHttpServer::Response r;
+        r.status = 404;
+        return r;
+    });
+    HttpBackend backend(server.url(), "key", "location.gps");
+    REQUIRE_FALSE(backend.fetchBucketSummaries(86400).has_value());
+    REQUIRE_FALSE(backend.streamBuckets({{0.0, 86400.0}}, [](std::vector<Entity>&&) {}));
+}
+
+TEST_CASE("HttpBackend fetchRegion reports truncation and failure", "[backend_api]") {
+    ExportServer backend(2000);
+    HttpBackend http(backend.url(), "key", "location.gps");
+    SpatialExtent space;
+    space.min_lat = 30.0;
+    space.max_lat = 30.5;
+    space.min_lon = -120.0;
+    space.max_lon = -119.0;
+    TimeExtent time{backend.rows.front().time_start, backend.rows.back().time_start};
+
+    size_t expected = 0;
+    for (const auto& e : backend.rows) expected += *e.lat <= 30.5 ? 1 : 0;
+
+    std::vector<Entity> got;
+    auto collect = [&got](std::vector<Entity>&& batch) { got = std::move(batch); };
+    REQUIRE(http.fetchRegion(time, space, collect) == RegionStatus::Complete);
+    REQUIRE(got.size() == expected);
+    auto request = nlohmann::json::parse(backend.bboxBodies.at(0));
+    REQUIRE(request["limit"] == BackendAPI::kBboxMaxLimit);
+    REQUIRE(request["order"] == "t_start_asc");
+
+    http.setRegionLimit(100);
+    REQUIRE(http.fetchRegion(time, space, collect) == RegionStatus::Truncated);
+    REQUIRE(got.size() == 100);
+
+    LocalHttpServer down([](const LocalHttpServer::Request&) {
+        LocalHttpServer::Response r;
+        r.status = 503;
+        return r;
+    });
+    HttpBackend unavailable(down.url(), "key", "location.gps");
+    bool called = false;
+    REQUIRE(unavailable.fetchRegion(time, space, [&called](std::vector<Entity>&&) { called = true; })
+            == RegionStatus::Failed);
+    REQUIRE_FALSE(called);
+}
@@ -1,5 +1,8 @@
 #include <catch2/catch_test_macros.hpp>
 #include "BackendFactory.h"
+#include "CacheBackend.h"
+#include "HttpBackend.h"
+#include "SyntheticBackend.h"
 
 TEST_CASE("BackendFactory creates fake backends", "[backend_factory]") {
     BackendConfig config{BackendConfig::Type::Fake};
@@ -26,6 +29,16 @@ TEST_CASE("BackendFactory creates http backends", "[backend_factory]") {
     REQUIRE(set.googleTimeline->entityType() == "location.googletimeline");
 }
 
+TEST_CASE("BackendFactory passes the export shard count to the gps backend", "[backend_factory]") {
+    BackendConfig config{BackendConfig::Type::Http};
+    config.exportShards = 6;
+    BackendSet set = createBackends(config, "http://localhost:8000");
+
+    auto* gps = dynamic_cast<HttpBackend*>(set.gps.get());
+    REQUIRE(gps != nullptr);
+    REQUIRE(gps->exportShards() == 6);
+}
+
 TEST_CASE("BackendSet byIndex returns correct backends", "[backend_factory]") {
     BackendConfig config{BackendConfig::Type::Http};
     BackendSet set = createBackends(config, "http://localhost:8000");
@@ -45,3 +58,31 @@ TEST_CASE("BackendSet cancelAll is safe on null backends", "[backend_factory]")
     // Should not crash even though photo/calendar/googleTimeline are null
     set.cancelAll();
 }
+
+TEST_CASE("BackendFactory puts a cache in front of each http backend", "[backend_factory]") {
+    BackendConfig config{BackendConfig::Type::Cached};
+    config.cacheDir = "/tmp/reckoner-cache";
+    config.exportShards = 3;
+    BackendSet set = createBackends(config, "http://localhost:8000");
+
+    for (int i = 0; i < 4; ++i) {
+        auto* cached = dynamic_cast<CacheBackend*>(set.byIndex(i));
+        REQUIRE(cached != nullptr);
+        REQUIRE(dynamic_cast<HttpBackend*>(cached->upstream()) != nullptr);
+        REQUIRE(cached->cachePath() == "/tmp/reckoner-cache/" + cached->entityType() + ".rkcf");
+    }
+    REQUIRE(set.googleTimeline->entityType() == "location.googletimeline");
+    REQUIRE(dynamic_cast<HttpBackend*>(static_cast<CacheBackend*>(set.gps.get())->upstream())->exportShards() == 3);
+}
+
+TEST_CASE("BackendFactory creates synthetic backends for every layer", "[backend_factory]") {
+    BackendConfig config{BackendConfig::Type::Synthetic};
+    config.syntheticGpsPoints = 1000;
+    BackendSet set = createBackends(config);
+
+    REQUIRE(set.gps->entityType() == "location.gps");
+    REQUIRE(set.photo->entityType() == "photo");
+    REQUIRE(set.calendar->entityType() == "calendar.event");
+    REQUIRE(set.googleTimeline->entityType() == "location.googletimeline");
+    REQUIRE(dynamic_cast<SyntheticBackend*>(set.gps.get())->config().gpsPoints == 1000);
+}
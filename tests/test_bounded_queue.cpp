@@ -0,0 +1,60 @@
+#include <catch2/catch_test_macros.hpp>
+#include "core/BoundedQueue.h"
+#include <thread>
+#include <vector>
+
+TEST_CASE("BoundedQueue is FIFO", "[bounded_queue]") {
+    BoundedQueue<int> q(4);
+    REQUIRE(q.push(1));
+    REQUIRE(q.push(2));
+    REQUIRE(q.push(3));
+    REQUIRE(q.size() == 3);
+
+    int v = 0;
+    REQUIRE(q.pop(v));
+    REQUIRE(v == 1);
+    REQUIRE(q.pop(v));
+    REQUIRE(v == 2);
+    REQUIRE(q.size() == 1);
+}
+
+TEST_CASE("BoundedQueue close drains then stops", "[bounded_queue]") {
+    BoundedQueue<int> q(4);
+    q.push(7);
+    q.close();
+    REQUIRE_FALSE(q.push(8));
+
+    int v = 0;
+    REQUIRE(q.pop(v));
+    REQUIRE(v == 7);
+    REQUIRE_FALSE(q.pop(v));
+}
+
+TEST_CASE("BoundedQueue blocks producer at capacity", "[bounded_queue]") {
+    BoundedQueue<int> q(2);
+    std::vector<int> received;
+
+    std::thread consumer([&] {
+        int v;
+        while (q.pop(v)) received.push_back(v);
+    });
+    for (int i = 0; i < 1000; ++i) {
+        REQUIRE(q.size() <= q.capacity());
+        q.push(i);
+    }
+    q.close();
+    consumer.join();
+
+    REQUIRE(received.size() == 1000);
+    for (int i = 0; i < 1000; ++i) REQUIRE(received[i] == i);
+}
+
+TEST_CASE("BoundedQueue close wakes a blocked producer", "[bounded_queue]") {
+    BoundedQueue<int> q(1);
+    q.push(1);
+    bool pushed = true;
+    std::thread producer([&] { pushed = q.push(2); });
+    q.close();
+    producer.join();
+    REQUIRE_FALSE(pushed);
+}
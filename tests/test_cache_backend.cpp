@@ -0,0 +1,185 @@
+#include <catch2/catch_test_macros.hpp>
+#include "CacheBackend.h"
+#include "cache/CacheWriter.h"
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+namespace fs = std::filesystem;
+
+struct TempDir {
+    fs::path path;
+    TempDir() {
+        path = fs::temp_directory_path() / ("reckoner_cache_backend_test_" + std::to_string(std::random_device{}()));
+        fs::remove_all(path);
+        fs::create_directories(path);
+    }
+    ~TempDir() {
+        std::error_code ec;
+        fs::remove_all(path, ec);
+    }
+    std::string file(const std::string& name) const { return (path / name).string(); }
+};
+
+/// Upstream stand-in: serves a fixed dataset in batches and counts loads.
+class ScriptedBackend : public Backend {
+public:
+    std::vector<Entity> rows;
+    int loads = 0;
+    bool failNext = false;
+
+    explicit ScriptedBackend(size_t n) {
+        for (size_t i = 0; i < n; ++i) {
+            Entity e;
+            e.id = "row-" + std::to_string(i);
+            e.time_start = e.time_end = 1700000000.0 + static_cast<double>(i) * 600.0;
+            e.lat = 34.0;
+            e.lon = -118.0;
+            rows.push_back(e);
+        }
+    }
+
+    void fetchEntities(const TimeExtent&, const SpatialExtent&,
+                       std::function<void(std::vector<Entity>&&)> callback) override {
+        callback(std::vector<Entity>(rows));
+    }
+
+    void streamAllEntities(std::function<void(size_t)> on_total,
+                           std::function<void(std::vector<Entity>&&)> batch_callback) override {
+        if (on_total) on_total(rows.size());
+        deliver(-1e18, 1e18, batch_callback);
+    }
+
+    void streamAllByType(double start, double end,
+                         std::function<void(std::vector<Entity>&&)> batch_callback) override {
+        deliver(start, end, batch_callback);
+    }
+
+    bool lastStreamComplete() const override { return m_complete; }
+
+    const std::string& entityType() const override {
+        static const std::string type = "location.gps";
+        return type;
+    }
+
+private:
+    void deliver(double start, double end, const std::function<void(std::vector<Entity>&&)>& cb) {
+        ++loads;
+        std::vector<Entity> batch;
+        for (const auto& e : rows) {
+            if (e.time_start < start || e.time_start > end) continue;
+            batch.push_back(e);
+            if (batch.size() == 100) {
+                cb(std::move(batch));
+                batch.clear();
+            }
+            if (failNext && e.id == "row-150") break;  // a dropped stream
+        }
+        if (!batch.empty()) cb(std::move(batch));
+        m_complete = !failNext;
+        failNext = false;
+    }
+
+    bool m_complete = true;
+};
+
+std::vector<std::string> streamIds(Backend& backend, size_t* total = nullptr)
+{
+    std::vector<std::string> ids;
+    backend.streamAllEntities(
+        [total](size_t t) { if (total) *total = t; },
+        [&ids](std::vector<Entity>&& batch) {
+            for (const auto& e : batch) ids.push_back(e.id);
+        });
+    return ids;
+}
+
+} // namespace
+
+TEST_CASE("CacheBackend fills the cache on a miss and serves later loads from it", "[cache_backend]") {
+    TempDir dir;
+    auto upstream = std::make_unique<ScriptedBackend>(1234);
+    ScriptedBackend* source = upstream.get();
+    CacheBackend backend(std::move(upstream), dir.file("location.gps.rkcf"), "location.gps");
+
+    auto first = streamIds(backend);
+    REQUIRE(first.size() == 1234);
+    REQUIRE(source->loads == 1);
+    REQUIRE_FALSE(backend.lastLoadFromCache());
+    REQUIRE(fs::exists(backend.cachePath()));
+
+    size_t total = 0;
+    auto second = streamIds(backend, &total);
+    REQUIRE(source->loads == 1);  // upstream untouched
+    REQUIRE(backend.lastLoadFromCache());
+    REQUIRE(backend.lastStreamComplete());
+    REQUIRE(total == 1234);
+    REQUIRE(second == first);
+}
+
+TEST_CASE("CacheBackend does not cache an incomplete load", "[cache_backend]") {
+    TempDir dir;
+    auto upstream = std::make_unique<ScriptedBackend>(400);
+    upstream->failNext = true;
+    ScriptedBackend* source = upstream.get();
+    CacheBackend backend(std::move(upstream), dir.file("location.gps.rkcf"), "location.gps");
+
+    streamIds(backend);
+    REQUIRE_FALSE(backend.lastStreamComplete());
+    REQUIRE_FALSE(fs::exists(backend.cachePath()));
+
+    REQUIRE(streamIds(backend).size() == 400);
+    REQUIRE(source->loads == 2);
+    REQUIRE(fs::exists(backend.cachePath()));
+}
+
+TEST_CASE("CacheBackend replaces a corrupt or foreign cache file", "[cache_backend]") {
+    TempDir dir;
+    std::string path = dir.file("location.gps.rkcf");
+    auto upstream = std::make_unique<ScriptedBackend>(300);
+    ScriptedBackend* source = upstream.get();
+    CacheBackend backend(std::move(upstream), path, "location.gps");
+
+    SECTION("garbage") {
+        std::ofstream(path, std::ios::binary) << "not a cache file at all";
+    }
+    SECTION("another type") {
+        CacheWriter::write(path, "photo", source->rows);
+    }
+
+    REQUIRE(streamIds(backend).size() == 300);
+    REQUIRE(source->loads == 1);
+    REQUIRE(streamIds(backend).size() == 300);
+    REQUIRE(source->loads == 1);
+    REQUIRE(backend.lastLoadFromCache());
+}
+
+TEST_CASE("CacheBackend serves time ranges and only caches whole-timeline loads", "[cache_backend]") {
+    TempDir dir;
+    auto upstream = std::make_unique<ScriptedBackend>(500);
+    ScriptedBackend* source = upstream.get();
+    CacheBackend backend(std::move(upstream), dir.file("location.gps.rkcf"), "location.gps");
+
+    size_t got = 0;
+    auto count = [&got](std::vector<Entity>&& b) { got += b.size(); };
+    double t10 = source->rows[10].time_start, t19 = source->rows[19].time_start;
+
+    backend.streamAllByType(t10, t19, count);
+    REQUIRE(got == 10);
+    REQUIRE_FALSE(fs::exists(backend.cachePath()));
+
+    got = 0;
+    backend.streamAllByType(0.0, 2000000000.0, count);
+    REQUIRE(got == 500);
+    REQUIRE(fs::exists(backend.cachePath()));
+
+    got = 0;
+    backend.streamAllByType(t10, t19, count);  // inclusive end, like the HTTP path
+    REQUIRE(got == 10);
+    REQUIRE(backend.lastLoadFromCache());
+    REQUIRE(source->loads == 2);
+}
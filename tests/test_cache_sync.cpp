@@ -0,0 +1,302 @@
+#include <catch2/catch_test_macros.hpp>
+#include "CacheBackend.h"
+#include "cache/CacheReader.h"
+#include "cache/CacheSync.h"
+#include "cache/CacheWriter.h"
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <iterator>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+namespace fs = std::filesystem;
+
+constexpr double kDay = 86400.0;
+constexpr double kT0 = 1700006400.0;  // midnight UTC
+
+struct TempDir {
+    fs::path path;
+    TempDir() {
+        path = fs::temp_directory_path() / ("reckoner_cache_sync_test_" + std::to_string(std::random_device{}()));
+        fs::remove_all(path);
+        fs::create_directories(path);
+    }
+    ~TempDir() {
+        std::error_code ec;
+        fs::remove_all(path, ec);
+    }
+    std::string file(const std::string& name) const { return (path / name).string(); }
+};
+
+/// Server stand-in with bucket summaries: rows can be edited between syncs,
+/// and the hashes follow the content like the real endpoint's.
+class SyncedBackend : public Backend {
+public:
+    std::vector<Entity> rows;
+    bool summariesAvailable = true;
+    bool failFetch = false;
+    std::vector<std::vector<TimeExtent>> fetches;  ///< ranges of each streamBuckets call
+    std::function<void()> beforeFetch;             ///< runs between summaries and data
+
+    /// `perDay` rows on each of `days` consecutive days.
+    SyncedBackend(int days, int perDay) {
+        for (int d = 0; d < days; ++d)
+            for (int i = 0; i < perDay; ++i) add(d, i);
+    }
+
+    void add(int day, int i, double lat = 34.0) {
+        Entity e;
+        e.id = "d" + std::to_string(day) + "-" + std::to_string(i);
+        e.time_start = e.time_end = kT0 + day * kDay + i * 60.0;
+        e.lat = lat;
+        e.lon = -118.0;
+        rows.push_back(e);
+    }
+
+    void fetchEntities(const TimeExtent&, const SpatialExtent&,
+                       std::function<void(std::vector<Entity>&&)> callback) override {
+        callback(std::vector<Entity>(rows));
+    }
+
+    void streamAllEntities(std::function<void(size_t)> on_total,
+                           std::function<void(std::vector<Entity>&&)> batch_callback) override {
+        if (on_total) on_total(rows.size());
+        batch_callback(std::vector<Entity>(rows));
+    }
+
+    std::optional<std::vector<BucketSummary>> fetchBucketSummaries(int bucketSeconds) override {
+        if (!summariesAvailable) return std::nullopt;
+        std::map<double, std::pair<size_t, std::string>> byBucket;
+        for (const auto& e : rows) {
+            double start = std::floor(e.time_start / bucketSeconds) * bucketSeconds;
+            std::ostringstream key;
+            key << e.id << '|' << e.time_start << '|' << *e.lat << ';';
+            ++byBucket[start].first;
+            byBucket[start].second += key.str();
+        }
+        std::vector<BucketSummary> out;
+        for (const auto& [start, b] : byBucket)
+            out.push_back({start, start + bucketSeconds, b.first, std::hash<std::string>{}(b.second) | 1});
+        return out;
+    }
+
+    bool streamBuckets(const std::vector<TimeExtent>& ranges,
+                       std::function<void(std::vector<Entity>&&)> batch_callback) override {
+        fetches.push_back(ranges);
+        if (beforeFetch) beforeFetch();
+        std::vector<Entity> batch;
+        for (const auto& e : rows)
+            for (const auto& r : ranges)
+                if (e.time_start >= r.start && e.time_start < r.end) batch.push_back(e);
+        if (failFetch) batch.resize(batch.size() / 2);
+        batch_callback(std::move(batch));
+        return !failFetch;
+    }
+
+    const std::string& entityType() const override {
+        static const std::string type = "location.gps";
+        return type;
+    }
+};
+
+/// The cache file's content as (id, lat) pairs, in file order.
+std::vector<std::pair<std::string, float>> cacheContent(const std::string& path)
+{
+    CacheReader reader(path);
+    std::vector<std::pair<std::string, float>> out;
+    for (size_t i = 0; i < reader.size(); ++i) {
+        Entity e = reader.entity(i);
+        out.emplace_back(e.id, static_cast<float>(*e.lat));
+    }
+    return out;
+}
+
+std::vector<std::pair<std::string, float>> serverContent(std::vector<Entity> rows)
+{
+    std::stable_sort(rows.begin(), rows.end(), [](const Entity& a, const Entity& b) {
+        return a.time_start != b.time_start ? a.time_start < b.time_start : a.id < b.id;
+    });
+    std::vector<std::pair<std::string, float>> out;
+    for (const auto& e : rows) out.emplace_back(e.id, static_cast<float>(*e.lat));
+    return out;
+}
+
+/// A cache of the server's current rows, with its current bucket hashes.
+void writeSyncedCache(const std::string& path, SyncedBackend& server)
+{
+    CacheWriter writer("location.gps");
+    writer.add(server.rows);
+    auto summaries = server.fetchBucketSummaries(86400);
+    for (const auto& s : *summaries) writer.setBucketHash(s.start, s.hash, s.count);
+    writer.finish(path);
+}
+
+} // namespace
+
+TEST_CASE("CacheSync plan finds new, changed, unknown and deleted buckets", "[cache_sync]") {
+    TempDir dir;
+    std::string path = dir.file("location.gps.rkcf");
+    SyncedBackend server(6, 10);
+
+    SECTION("a synced cache needs nothing") {
+        writeSyncedCache(path, server);
+        CacheReader reader(path);
+        REQUIRE(CacheSync::plan(reader, *server.fetchBucketSummaries(86400)).empty());
+    }
+
+    SECTION("buckets without hashes are all stale, and coalesce") {
+        CacheWriter::write(path, "location.gps", server.rows);
+        CacheReader reader(path);
+        auto plan = CacheSync::plan(reader, *server.fetchBucketSummaries(86400));
+        REQUIRE(plan.fetchBuckets == 6);
+        REQUIRE(plan.fetch.size() == 1);
+        REQUIRE(plan.fetch[0].start == kT0);
+        REQUIRE(plan.fetch[0].end == kT0 + 6 * kDay);
+    }
+
+    SECTION("edits, appends and deletions") {
+        writeSyncedCache(path, server);
+        server.rows[12].lat = 35.0;                    // day 1 changed
+        server.add(7, 0);                              // day 7 is new
+        server.rows.erase(server.rows.begin() + 30,    // day 3 deleted
+                          server.rows.begin() + 40);
+        CacheReader reader(path);
+        auto plan = CacheSync::plan(reader, *server.fetchBucketSummaries(86400));
+        REQUIRE(plan.fetchBuckets == 2);
+        REQUIRE(plan.fetch.size() == 2);
+        REQUIRE(plan.fetch[0].start == kT0 + kDay);
+        REQUIRE(plan.fetch[1].start == kT0 + 7 * kDay);
+        REQUIRE(plan.dropBuckets == 1);
+        REQUIRE(plan.drop.size() == 1);
+        REQUIRE(plan.drop[0].start == kT0 + 3 * kDay);
+        REQUIRE(plan.drop[0].end == kT0 + 4 * kDay);
+    }
+}
+
+TEST_CASE("CacheSync fetches only the changed buckets and splices them in", "[cache_sync]") {
+    TempDir dir;
+    std::string path = dir.file("location.gps.rkcf");
+    SyncedBackend server(30, 50);
+    writeSyncedCache(path, server);
+
+    server.rows[100].lat = 35.5;  // day 2
+    for (int i = 50; i < 60; ++i) server.add(29, i);  // more today
+    server.add(30, 0);                                // and tomorrow
+    server.rows.erase(server.rows.begin() + 500, server.rows.begin() + 550);  // day 10 gone
+
+    CacheSync::Result result = CacheSync::sync(path, "location.gps", server);
+    REQUIRE(result.ok);
+    REQUIRE(result.bucketsChecked == 30);
+    REQUIRE(result.bucketsFetched == 3);
+    REQUIRE(result.bucketsDropped == 1);
+    REQUIRE(server.fetches.size() == 1);
+    REQUIRE(server.fetches[0].size() == 2);  // day 2, then days 29-30 coalesced
+    REQUIRE(result.replaced.size() == 3);
+    REQUIRE(result.replaced[1].start == kT0 + 10 * kDay);
+    REQUIRE(result.entities.size() == 50 + 60 + 1);
+
+    REQUIRE(cacheContent(path) == serverContent(server.rows));
+
+    // Now current: the next sync transfers nothing
+    server.fetches.clear();
+    CacheSync::Result again = CacheSync::sync(path, "location.gps", server);
+    REQUIRE(again.ok);
+    REQUIRE(again.bucketsFetched == 0);
+    REQUIRE(again.replaced.empty());
+    REQUIRE(server.fetches.empty());
+}
+
+TEST_CASE("CacheSync leaves the cache alone when it cannot finish", "[cache_sync]") {
+    TempDir dir;
+    std::string path = dir.file("location.gps.rkcf");
+    SyncedBackend server(5, 20);
+    writeSyncedCache(path, server);
+    auto before = cacheContent(path);
+    server.add(5, 0);
+
+    SECTION("incomplete bucket fetch") {
+        server.failFetch = true;
+    }
+    SECTION("no summaries") {
+        server.summariesAvailable = false;
+    }
+
+    CacheSync::Result result = CacheSync::sync(path, "location.gps", server);
+    REQUIRE_FALSE(result.ok);
+    REQUIRE(result.replaced.empty());
+    REQUIRE(cacheContent(path) == before);
+    REQUIRE_FALSE(fs::exists(path + ".tmp"));
+}
+
+TEST_CASE("CacheSync refetches a bucket that changed while it was fetched", "[cache_sync]") {
+    TempDir dir;
+    std::string path = dir.file("location.gps.rkcf");
+    SyncedBackend server(3, 10);
+    writeSyncedCache(path, server);
+
+    server.add(2, 10);
+    server.beforeFetch = [&server] { server.add(2, 11); };  // lands after the summary
+    REQUIRE(CacheSync::sync(path, "location.gps", server).ok);
+    {
+        CacheReader reader(path);
+        REQUIRE(reader.bucketCount() == 3);
+        REQUIRE(reader.buckets()[2].entity_count == 12);
+        REQUIRE(reader.buckets()[2].hash == 0);  // unknown, not the stale summary's
+        REQUIRE(reader.buckets()[1].hash != 0);
+    }
+
+    server.beforeFetch = nullptr;
+    server.fetches.clear();
+    CacheSync::Result result = CacheSync::sync(path, "location.gps", server);
+    REQUIRE(result.bucketsFetched == 1);
+    REQUIRE(cacheContent(path) == serverContent(server.rows));
+}
+
+TEST_CASE("CacheBackend stores bucket hashes on a miss and refreshes in place", "[cache_sync]") {
+    TempDir dir;
+    auto upstream = std::make_unique<SyncedBackend>(10, 20);
+    SyncedBackend* server = upstream.get();
+    CacheBackend backend(std::move(upstream), dir.file("location.gps.rkcf"), "location.gps");
+
+    std::vector<Entity> layer;
+    auto append = [&layer](std::vector<Entity>&& batch) {
+        layer.insert(layer.end(), std::make_move_iterator(batch.begin()), std::make_move_iterator(batch.end()));
+    };
+    backend.streamAllEntities(nullptr, append);
+    REQUIRE(layer.size() == 200);
+    {
+        CacheReader reader(backend.cachePath());
+        for (size_t b = 0; b < reader.bucketCount(); ++b) REQUIRE(reader.buckets()[b].hash != 0);
+    }
+
+    int updates = 0;
+    backend.refresh([&](std::vector<TimeExtent>&&, std::vector<Entity>&&) { ++updates; });
+    REQUIRE(updates == 0);
+    REQUIRE(server->fetches.empty());
+
+    server->add(10, 0);
+    server->rows[5].lat = 36.0;
+    std::vector<TimeExtent> replaced;
+    std::vector<Entity> fresh;
+    backend.refresh([&](std::vector<TimeExtent>&& ranges, std::vector<Entity>&& entities) {
+        ++updates;
+        replaced = std::move(ranges);
+        fresh = std::move(entities);
+    });
+    REQUIRE(updates == 1);
+    REQUIRE(replaced.size() == 2);
+    REQUIRE(fresh.size() == 21);
+
+    // The next start is served from the spliced cache
+    layer.clear();
+    backend.streamAllEntities(nullptr, append);
+    REQUIRE(backend.lastLoadFromCache());
+    REQUIRE(layer.size() == 201);
+    REQUIRE(layer[5].lat.value() == 36.0);
+}
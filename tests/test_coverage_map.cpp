@@ -0,0 +1,154 @@
+#include <catch2/catch_test_macros.hpp>
+#include "CoverageMap.h"
+#include <random>
+
+static SpatialExtent extent(double minLat, double maxLat, double minLon, double maxLon) {
+    SpatialExtent s;
+    s.min_lat = minLat;
+    s.max_lat = maxLat;
+    s.min_lon = minLon;
+    s.max_lon = maxLon;
+    return s;
+}
+
+static size_t totalCells(const std::vector<CoverageMap::Request>& requests, double timeCell) {
+    size_t n = 0;
+    for (const auto& r : requests)
+        n += r.cells() * static_cast<size_t>(r.time.duration() / timeCell);
+    return n;
+}
+
+TEST_CASE("CoverageMap sizes cells to the view and the window", "[coverage_map]") {
+    CoverageMap map;
+    REQUIRE(map.levelFor(extent(-90, 90, -180, 180)) == 2);
+    // 0.7 degrees across: 4 cells need cells of at most 0.175 degrees
+    int level = map.levelFor(extent(33.95, 34.20, -118.80, -118.10));
+    REQUIRE(360.0 / (1 << level) <= 0.7 / 4);
+    REQUIRE(360.0 / (1 << (level - 1)) > 0.7 / 4);
+
+    REQUIRE(map.timeCellFor({0.0, 86400.0}) == 8192.0);  // largest power of two <= 10800
+    REQUIRE(map.timeCellFor({0.0, 100.0}) == 64.0);
+}
+
+TEST_CASE("CoverageMap plans the whole view once, then nothing", "[coverage_map]") {
+    CoverageMap map;
+    SpatialExtent view = extent(33.95, 34.20, -118.80, -118.10);
+    TimeExtent window{1700000000.0, 1700086400.0};
+    double w = map.timeCellFor(window);
+
+    auto requests = map.plan(view, window);
+    REQUIRE_FALSE(requests.empty());
+    for (const auto& r : requests) {
+        REQUIRE(r.cells() * static_cast<size_t>(r.time.duration() / w) <= map.config().maxCellsPerRequest);
+        REQUIRE(r.space.min_lon <= view.max_lon);
+        REQUIRE(r.space.max_lon >= view.min_lon);
+    }
+    // Adjacent cells are coalesced: far fewer requests than cells
+    REQUIRE(requests.size() * 4 <= totalCells(requests, w));
+
+    for (const auto& r : requests) map.markCovered(r);
+    REQUIRE(map.plan(view, window).empty());
+
+    // A sub-view and a sub-window are covered too
+    REQUIRE(map.plan(extent(34.0, 34.1, -118.5, -118.3), {1700010000.0, 1700020000.0}).empty());
+}
+
+TEST_CASE("CoverageMap fetches only the newly exposed part after a pan", "[coverage_map]") {
+    CoverageMap map;
+    SpatialExtent view = extent(34.0, 34.2, -118.4, -118.2);
+    TimeExtent window{1700000000.0, 1700086400.0};
+    for (const auto& r : map.plan(view, window)) map.markCovered(r);
+
+    SpatialExtent panned = extent(34.0, 34.2, -118.3, -118.1);  // half a view east
+    auto requests = map.plan(panned, window);
+    REQUIRE_FALSE(requests.empty());
+    for (const auto& r : requests) {
+        REQUIRE(r.space.min_lon >= -118.2 - 360.0 / (1 << r.level));
+        REQUIRE_FALSE(r.owns(34.1, -118.35, 1700040000.0));
+    }
+    int owners = 0;
+    for (const auto& r : requests) owners += r.owns(34.1, -118.11, 1700040000.0) ? 1 : 0;
+    REQUIRE(owners == 1);
+
+    // Zoomed out, the covered area is not requested again
+    SpatialExtent wide = extent(33.0, 35.0, -119.0, -117.0);
+    for (const auto& r : map.plan(wide, window))
+        REQUIRE_FALSE(r.owns(34.1, -118.3, 1700040000.0));
+}
+
+TEST_CASE("CoverageMap regions own every point exactly once", "[coverage_map]") {
+    CoverageMap::Config config;
+    config.maxCellsPerRequest = 3;
+    CoverageMap map(config);
+    SpatialExtent view = extent(-10.0, 10.0, 20.0, 40.0);
+    TimeExtent window{0.0, 100000.0};
+    auto requests = map.plan(view, window);
+    REQUIRE(requests.size() > 1);
+
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<double> lat(-10.0, 10.0), lon(20.0, 40.0), t(0.0, 100000.0);
+    for (int i = 0; i < 2000; ++i) {
+        double a = lat(rng), o = lon(rng), s = t(rng);
+        int owners = 0;
+        for (const auto& r : requests) owners += r.owns(a, o, s) ? 1 : 0;
+        REQUIRE(owners == 1);
+    }
+    // Cell edges belong to the cell above/right of them
+    auto cellEdge = CoverageMap::bounds({requests[0].level, requests[0].x0, requests[0].y0});
+    int owners = 0;
+    for (const auto& r : requests) owners += r.owns(cellEdge.max_lat, cellEdge.max_lon, 50000.0) ? 1 : 0;
+    REQUIRE(owners == 1);
+}
+
+TEST_CASE("CoverageMap splits dense cells into their children", "[coverage_map]") {
+    CoverageMap map;
+    SpatialExtent view = extent(34.0, 34.2, -118.4, -118.2);
+    TimeExtent window{1700000000.0, 1700000000.0 + 8 * 3600.0};
+
+    auto first = map.plan(view, window);
+    const CoverageMap::Request dense = first.front();
+    map.markDense(dense);
+    for (size_t i = 1; i < first.size(); ++i) map.markCovered(first[i]);
+
+    auto second = map.plan(view, window);
+    REQUIRE_FALSE(second.empty());
+    for (const auto& r : second) {
+        REQUIRE(r.level == dense.level + 1);
+        REQUIRE(r.time.start >= dense.time.start);
+        REQUIRE(r.time.end <= dense.time.end);
+    }
+    for (const auto& r : second) map.markCovered(r);
+    REQUIRE(map.plan(view, window).empty());
+
+    // At the finest level a region is not split further
+    CoverageMap::Config config;
+    config.maxLevel = dense.level;
+    CoverageMap capped(config);
+    capped.markDense(dense);
+    for (const auto& r : capped.plan(view, window)) REQUIRE(r.level == dense.level);
+}
+
+TEST_CASE("CoverageMap retain keeps only the view's block", "[coverage_map]") {
+    CoverageMap map;
+    TimeExtent window{1700000000.0, 1700086400.0};
+    SpatialExtent la = extent(34.0, 34.2, -118.4, -118.2);
+    SpatialExtent sf = extent(37.7, 37.9, -122.5, -122.3);
+    for (const auto& r : map.plan(la, window)) map.markCovered(r);
+    for (const auto& r : map.plan(sf, window)) map.markCovered(r);
+    size_t nodes = map.nodeCount();
+
+    CoverageMap::Request keep = map.retain(la, window);
+    REQUIRE(map.nodeCount() < nodes);
+    REQUIRE(keep.owns(34.1, -118.3, 1700040000.0));
+    REQUIRE_FALSE(keep.owns(37.8, -122.4, 1700040000.0));
+    REQUIRE(map.plan(la, window).empty());
+    REQUIRE_FALSE(map.plan(sf, window).empty());
+
+    // Coverage recorded coarser than the view is cut down to the view
+    CoverageMap world;
+    SpatialExtent everywhere = extent(-90, 90, -180, 180);
+    for (const auto& r : world.plan(everywhere, window)) world.markCovered(r);
+    world.retain(la, window);
+    REQUIRE(world.plan(la, window).empty());
+    REQUIRE_FALSE(world.plan(sf, window).empty());
+}
@@ -0,0 +1,172 @@
+#include <catch2/catch_test_macros.hpp>
+#include "cache/CacheReader.h"
+#include "cache/CacheWriter.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+namespace fs = std::filesystem;
+
+/// Fresh temporary directory, removed on scope exit.
+struct TempDir {
+    fs::path path;
+    TempDir() {
+        path = fs::temp_directory_path() / ("reckoner_cache_test_" + std::to_string(std::random_device{}()));
+        fs::remove_all(path);
+        fs::create_directories(path);
+    }
+    ~TempDir() {
+        std::error_code ec;
+        fs::remove_all(path, ec);
+    }
+    std::string file(const std::string& name) const { return (path / name).string(); }
+};
+
+std::vector<Entity> makeEntities(size_t n)
+{
+    std::vector<Entity> out;
+    for (size_t i = 0; i < n; ++i) {
+        Entity e;
+        e.id = "gps-" + std::to_string(i);
+        // Written out of order on purpose; the writer sorts
+        e.time_start = 1600000000.0 + static_cast<double>((i * 7919) % n) * 3600.0;
+        e.time_end = (i % 4 == 0) ? e.time_start + 120.0 : e.time_start;
+        if (i % 10 != 0) {
+            e.lat = 34.0 + static_cast<double>(i % 100) * 0.001;
+            e.lon = -118.0 + static_cast<double>(i % 50) * 0.001;
+        }
+        if (i % 3 == 0) e.name = "Place " + std::to_string(i % 5);
+        if (i % 5 == 0) e.color = "#FF8800";
+        e.render_offset = (i % 7 == 0) ? 0.5f : 0.0f;
+        out.push_back(e);
+    }
+    return out;
+}
+
+void patch(const std::string& path, size_t offset, const void* bytes, size_t len)
+{
+    std::fstream f(path, std::ios::in | std::ios::out | std::ios::binary);
+    f.seekp(static_cast<std::streamoff>(offset));
+    f.write(static_cast<const char*>(bytes), static_cast<std::streamsize>(len));
+}
+
+} // namespace
+
+TEST_CASE("Cache round-trips entities in time order", "[entity_cache]") {
+    TempDir dir;
+    auto entities = makeEntities(1000);
+    std::string path = dir.file("sub/location.gps.rkcf");  // parent is created
+    CacheWriter::write(path, "location.gps", entities);
+    REQUIRE_FALSE(fs::exists(path + ".tmp"));
+
+    CacheReader reader(path);
+    REQUIRE(reader.entityType() == "location.gps");
+    REQUIRE(reader.size() == entities.size());
+    REQUIRE(reader.header().entity_offset % 64 == 0);
+
+    std::vector<Entity> sorted = entities;
+    std::stable_sort(sorted.begin(), sorted.end(), [](const Entity& a, const Entity& b) {
+        return a.time_start != b.time_start ? a.time_start < b.time_start : a.id < b.id;
+    });
+
+    auto batches = reader.readBatches(0, reader.size(), 128, 4);
+    REQUIRE(batches.size() == 8);
+    size_t i = 0;
+    for (const auto& batch : batches) {
+        for (const auto& e : batch) {
+            const Entity& want = sorted[i++];
+            REQUIRE(e.id == want.id);
+            REQUIRE(e.time_start == want.time_start);
+            REQUIRE(e.time_end == want.time_end);
+            REQUIRE(e.lat.has_value() == want.lat.has_value());
+            if (want.lat) {
+                REQUIRE(std::abs(*e.lat - *want.lat) < 1e-5);
+                REQUIRE(std::abs(*e.lon - *want.lon) < 1e-5);
+            }
+            REQUIRE(e.name == want.name);
+            REQUIRE(e.color == want.color);
+            REQUIRE(e.render_offset == want.render_offset);
+        }
+    }
+    REQUIRE(i == sorted.size());
+}
+
+TEST_CASE("Cache bucket index partitions the records by day", "[entity_cache]") {
+    TempDir dir;
+    auto entities = makeEntities(500);
+    std::string path = dir.file("t.rkcf");
+    CacheWriter::write(path, "photo", entities);
+
+    CacheReader reader(path);
+    REQUIRE(reader.header().bucket_seconds == 86400);
+    REQUIRE(reader.bucketCount() > 1);
+    size_t next = 0;
+    for (size_t b = 0; b < reader.bucketCount(); ++b) {
+        const CacheBucket& bucket = reader.buckets()[b];
+        REQUIRE(bucket.entity_start_idx == next);
+        REQUIRE(std::fmod(bucket.bucket_start, 86400.0) == 0.0);
+        for (size_t i = 0; i < bucket.entity_count; ++i) {
+            double t = reader.records()[next + i].time_start;
+            REQUIRE(t >= bucket.bucket_start);
+            REQUIRE(t < bucket.bucket_start + 86400.0);
+        }
+        next += bucket.entity_count;
+    }
+    REQUIRE(next == reader.size());
+
+    size_t at = reader.lowerBound(reader.records()[100].time_start);
+    REQUIRE(at <= 100);
+    REQUIRE(reader.records()[at].time_start == reader.records()[100].time_start);
+    REQUIRE(reader.lowerBound(0.0) == 0);
+    REQUIRE(reader.lowerBound(1e12) == reader.size());
+}
+
+TEST_CASE("Cache reader rejects invalid files", "[entity_cache]") {
+    TempDir dir;
+    std::string path = dir.file("bad.rkcf");
+    CacheWriter::write(path, "location.gps", makeEntities(50));
+
+    SECTION("missing file") {
+        REQUIRE_THROWS_AS(CacheReader(dir.file("missing.rkcf")), std::runtime_error);
+    }
+
+    SECTION("bad magic") {
+        patch(path, 0, "JSON", 4);
+        REQUIRE_THROWS_AS(CacheReader(path), std::runtime_error);
+    }
+
+    SECTION("truncated records") {
+        fs::resize_file(path, fs::file_size(path) - 200);
+        REQUIRE_THROWS_AS(CacheReader(path), std::runtime_error);
+    }
+
+    SECTION("string reference outside the table") {
+        CacheReader probe(path);
+        size_t recordAt = static_cast<size_t>(probe.header().entity_offset);
+        uint32_t offset = static_cast<uint32_t>(probe.header().string_table_size);
+        patch(path, recordAt + offsetof(CacheEntity, id_offset), &offset, sizeof(offset));
+
+        CacheReader reader(path);
+        REQUIRE_THROWS_AS(reader.readBatches(0, reader.size(), 10, 2), std::runtime_error);
+    }
+}
+
+TEST_CASE("Cache readBatches stops early when cancelled", "[entity_cache]") {
+    TempDir dir;
+    std::string path = dir.file("c.rkcf");
+    CacheWriter::write(path, "location.gps", makeEntities(300));
+
+    CacheReader reader(path);
+    std::atomic<bool> cancelled{true};
+    REQUIRE(reader.readBatches(0, reader.size(), 10, 2, &cancelled).empty());
+    REQUIRE(reader.readBatches(290, 1000, 10, 2).size() == 1);
+}
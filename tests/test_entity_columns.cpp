@@ -0,0 +1,98 @@
+#include <catch2/catch_test_macros.hpp>
+#include "core/EntityColumns.h"
+#include <string>
+#include <vector>
+
+namespace {
+
+Entity makeEntity(int i)
+{
+    Entity e;
+    e.id = "e" + std::to_string(i);
+    e.time_start = 1000.0 + i;
+    e.time_end = e.time_start + (i % 2 ? 60.0 : 0.0);
+    if (i % 3 != 0) {
+        e.lat = 34.0 + i * 0.01;
+        e.lon = -118.0 - i * 0.01;
+    }
+    if (i % 4 == 0) e.name = "place " + std::to_string(i);
+    if (i % 5 == 0) e.color = "#ff0000";
+    e.render_offset = 0.5f * static_cast<float>(i % 3);
+    return e;
+}
+
+std::vector<Entity> makeEntities(int n)
+{
+    std::vector<Entity> rows;
+    for (int i = 0; i < n; ++i) rows.push_back(makeEntity(i));
+    return rows;
+}
+
+void requireSame(const Entity& got, const Entity& want)
+{
+    REQUIRE(got.id == want.id);
+    REQUIRE(got.time_start == want.time_start);
+    REQUIRE(got.time_end == want.time_end);
+    REQUIRE(got.lat == want.lat);
+    REQUIRE(got.lon == want.lon);
+    REQUIRE(got.name == want.name);
+    REQUIRE(got.color == want.color);
+    REQUIRE(got.render_offset == want.render_offset);
+}
+
+} // namespace
+
+TEST_CASE("EntityColumns round-trips entities", "[entity_columns]") {
+    auto rows = makeEntities(50);
+    EntityColumns columns = EntityColumns::fromEntities(rows);
+    REQUIRE(columns.size() == 50);
+
+    auto back = columns.toEntities();
+    REQUIRE(back.size() == rows.size());
+    for (size_t i = 0; i < rows.size(); ++i) {
+        requireSame(back[i], rows[i]);
+        REQUIRE(columns.idAt(i) == rows[i].id);
+        REQUIRE(columns.hasLocation(i) == rows[i].has_location());
+    }
+}
+
+TEST_CASE("EntityColumns append rebases string offsets", "[entity_columns]") {
+    auto rows = makeEntities(20);
+    EntityColumns a = EntityColumns::fromEntities({rows.begin(), rows.begin() + 8});
+    EntityColumns b = EntityColumns::fromEntities({rows.begin() + 8, rows.end()});
+
+    a.append(b);
+    REQUIRE(a.size() == 20);
+    for (size_t i = 0; i < rows.size(); ++i) requireSame(a.row(i), rows[i]);
+}
+
+TEST_CASE("EntityColumns filter keeps rows in order", "[entity_columns]") {
+    auto rows = makeEntities(30);
+    EntityColumns columns = EntityColumns::fromEntities(rows);
+
+    columns.filter([&columns](size_t i) { return columns.hasLocation(i); });
+    std::vector<Entity> want;
+    for (const auto& e : rows)
+        if (e.has_location()) want.push_back(e);
+
+    REQUIRE(columns.size() == want.size());
+    for (size_t i = 0; i < want.size(); ++i) requireSame(columns.row(i), want[i]);
+}
+
+TEST_CASE("EntityColumns rows may share a pooled string", "[entity_columns]") {
+    EntityColumns columns;
+    StringRef shared = columns.addString("Home");
+    columns.resize(3);
+    for (size_t i = 0; i < 3; ++i) {
+        columns.id[i] = columns.addString("id" + std::to_string(i));
+        columns.name[i] = shared;
+        columns.flags[i] = EntityColumns::kHasName;
+    }
+
+    for (size_t i = 0; i < 3; ++i) REQUIRE(*columns.row(i).name == "Home");
+    REQUIRE(columns.strings.size() == 4 + 3 * 3);
+
+    columns.clear();
+    REQUIRE(columns.empty());
+    REQUIRE(columns.strings.empty());
+}
@@ -20,6 +20,12 @@ static Entity makeTimeOnlyEntity(double timeMid, float renderOffset = 0.0f) {
     return e;
 }
 
+static EntityStore storeOf(const std::vector<Entity>& entities) {
+    EntityStore store;
+    store.append(entities);
+    return store;
+}
+
 TEST_CASE("EntityPicker pickMap finds nearest entity", "[entity_picker]") {
     std::vector<Entity> entities = {
         makeEntity(1000.0, -118.25, 34.05),
@@ -27,8 +33,9 @@ TEST_CASE("EntityPicker pickMap finds nearest entity", "[entity_picker]") {
         makeEntity(3000.0,  151.21, -33.87),
     };
 
+    EntityStore store = storeOf(entities);
     EntityPicker picker;
-    picker.rebuild(entities);
+    picker.rebuild(store);
 
     int idx = picker.pickMap(-118.26, 34.06, 0.1);
     REQUIRE(idx == 0);  // closest to first entity
@@ -39,8 +46,9 @@ TEST_CASE("EntityPicker pickMap returns -1 when out of radius", "[entity_picker]
         makeEntity(1000.0, -118.25, 34.05),
     };
 
+    EntityStore store = storeOf(entities);
     EntityPicker picker;
-    picker.rebuild(entities);
+    picker.rebuild(store);
 
     int idx = picker.pickMap(0.0, 0.0, 0.01);  // far away
     REQUIRE(idx == -1);
@@ -58,8 +66,9 @@ TEST_CASE("EntityPicker pickTimeline finds nearest by time", "[entity_picker]")
         makeTimeOnlyEntity(3000.0, 0.0f),
     };
 
+    EntityStore store = storeOf(entities);
     EntityPicker picker;
-    picker.rebuild(entities);
+    picker.rebuild(store);
 
     int idx = picker.pickTimeline(1950.0, 0.0f, 200.0, 0.5f);
     REQUIRE(idx == 1);  // closest to 2000.0
@@ -70,8 +79,9 @@ TEST_CASE("EntityPicker pickTimeline returns -1 when out of radius", "[entity_pi
         makeTimeOnlyEntity(1000.0, 0.0f),
     };
 
+    EntityStore store = storeOf(entities);
     EntityPicker picker;
-    picker.rebuild(entities);
+    picker.rebuild(store);
 
     int idx = picker.pickTimeline(5000.0, 0.0f, 100.0, 0.5f);
     REQUIRE(idx == -1);
@@ -87,26 +97,83 @@ TEST_CASE("EntityPicker addEntities incrementally", "[entity_picker]") {
         makeEntity(1000.0, -118.25, 34.05),
     };
 
+    EntityStore store = storeOf(entities);
     EntityPicker picker;
-    picker.rebuild(entities);
+    picker.rebuild(store);
 
     // Add a second entity
-    entities.push_back(makeEntity(2000.0, -118.30, 34.10));
-    picker.addEntities(entities, 1);
+    store.push_back(makeEntity(2000.0, -118.30, 34.10));
+    picker.addEntities(store, 1);
 
     // Both should be findable
     REQUIRE(picker.pickMap(-118.25, 34.05, 0.02) == 0);
     REQUIRE(picker.pickMap(-118.30, 34.10, 0.02) == 1);
 }
 
+TEST_CASE("EntityPicker addEntities in bounded steps across time runs", "[entity_picker]") {
+    // Out of time order, spanning several runs of the timeline index
+    const size_t n = EntityPicker::TIME_RUN_SIZE * 2 + 100;
+    std::vector<Entity> entities;
+    entities.reserve(n);
+    for (size_t i = 0; i < n; ++i)
+        entities.push_back(makeTimeOnlyEntity(static_cast<double>((i * 7919) % n) * 10.0));
+
+    EntityStore store = storeOf(entities);
+    EntityPicker stepped;
+    for (size_t from = 0; from < n; from += 30000)
+        stepped.addEntities(store, from, from + 30000);
+    REQUIRE(stepped.indexedCount() == n);
+
+    EntityPicker whole;
+    whole.rebuild(store);
+
+    for (size_t i = 0; i < n; i += 997) {
+        int idx = stepped.pickTimeline(entities[i].time_mid(), 0.0f, 1.0, 0.5f);
+        REQUIRE(idx == static_cast<int>(i));
+        REQUIRE(whole.pickTimeline(entities[i].time_mid(), 0.0f, 1.0, 0.5f) == idx);
+    }
+
+    // Entities past toIdx are not indexed yet
+    EntityPicker partial;
+    partial.addEntities(store, 0, 10);
+    REQUIRE(partial.indexedCount() == 10);
+    REQUIRE(partial.pickTimeline(entities[20].time_mid(), 0.0f, 1.0, 0.5f) == -1);
+}
+
+TEST_CASE("EntityPicker nearestInTime lists neighbours nearest first", "[entity_picker]") {
+    // Indices out of time order, across two time runs
+    std::vector<Entity> entities(EntityPicker::TIME_RUN_SIZE + 10, makeTimeOnlyEntity(0.0));
+    entities[3] = makeTimeOnlyEntity(1000.0);
+    entities[5] = makeTimeOnlyEntity(1100.0);
+    entities[7] = makeTimeOnlyEntity(1150.0);
+    entities[EntityPicker::TIME_RUN_SIZE + 2] = makeTimeOnlyEntity(1070.0);
+    entities[EntityPicker::TIME_RUN_SIZE + 4] = makeTimeOnlyEntity(1300.0);
+    for (size_t i = 0; i < entities.size(); ++i)
+        if (entities[i].time_start == 0.0) entities[i] = makeTimeOnlyEntity(5000.0 + i);
+
+    EntityStore store = storeOf(entities);
+    EntityPicker picker;
+    picker.rebuild(store);
+
+    auto near = picker.nearestInTime(static_cast<int>(EntityPicker::TIME_RUN_SIZE + 2), 2);
+    REQUIRE(near == std::vector<int>{5, 3, 7});
+
+    near = picker.nearestInTime(5, 1);
+    REQUIRE(near == std::vector<int>{static_cast<int>(EntityPicker::TIME_RUN_SIZE + 2), 7});
+
+    REQUIRE(picker.nearestInTime(-1, 2).empty());
+    REQUIRE(picker.nearestInTime(static_cast<int>(entities.size()), 2).empty());
+}
+
 TEST_CASE("EntityPicker pickTimeline considers renderOffset", "[entity_picker]") {
     std::vector<Entity> entities = {
         makeTimeOnlyEntity(1000.0, -0.5f),
         makeTimeOnlyEntity(1000.0,  0.5f),
     };
 
+    EntityStore store = storeOf(entities);
     EntityPicker picker;
-    picker.rebuild(entities);
+    picker.rebuild(store);
 
     // Query near renderOffset 0.5 should find entity 1
     int idx = picker.pickTimeline(1000.0, 0.4f, 200.0, 0.5f);
@@ -116,3 +183,22 @@ TEST_CASE("EntityPicker pickTimeline considers renderOffset", "[entity_picker]")
     idx = picker.pickTimeline(1000.0, -0.4f, 200.0, 0.5f);
     REQUIRE(idx == 0);
 }
+
+TEST_CASE("EntityPicker left stale by an edit returns only rows the store has", "[entity_picker]") {
+    std::vector<Entity> entities;
+    for (int i = 0; i < 20; ++i) entities.push_back(makeEntity(1000.0 + i, -118.0 + i * 0.001, 34.0));
+    EntityStore store = storeOf(entities);
+    EntityPicker picker;
+    picker.rebuild(store);
+
+    // The store shrinks before the picker is indexed again
+    store.filter([](const EntityColumns& c, size_t row) { return c.time_start[row] < 1005.0; });
+    REQUIRE(store.size() == 5);
+
+    REQUIRE(picker.pickMap(-118.0 + 15 * 0.001, 34.0, 0.0005) == -1);
+    REQUIRE(picker.pickTimeline(1015.0, 0.0f, 0.5, 0.1f) == -1);
+    int idx = picker.pickTimeline(1003.0, 0.0f, 0.5, 0.1f);
+    REQUIRE(idx == 3);
+    for (int near : picker.nearestInTime(2, 10)) REQUIRE(near < 5);
+    REQUIRE(picker.nearestInTime(15, 2).empty());
+}
@@ -0,0 +1,135 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_approx.hpp>
+#include "http/EntityScanner.h"
+#include "http/BackendAPI.h"
+#include <cstdlib>
+
+TEST_CASE("EntityScanner parses a full GPS line", "[entity_scanner]") {
+    EntityScanner scanner;
+    Entity e;
+    REQUIRE(scanner.scan(
+        R"({"id":"a1b2","t_start":"2020-01-01T00:00:00Z","t_end":"2020-01-01T00:01:00Z",)"
+        R"("lat":34.0522,"lon":-118.2437,"name":"Home","color":"#4CAF50","render_offset":0.25})", e));
+
+    REQUIRE(e.id == "a1b2");
+    REQUIRE(e.time_start == Catch::Approx(1577836800.0));
+    REQUIRE(e.time_end == Catch::Approx(1577836860.0));
+    REQUIRE(e.lat.has_value());
+    REQUIRE(*e.lat == 34.0522);
+    REQUIRE(*e.lon == -118.2437);
+    REQUIRE(*e.name == "Home");
+    REQUIRE(*e.color == "#4CAF50");
+    REQUIRE(e.render_offset == Catch::Approx(0.25f));
+}
+
+TEST_CASE("EntityScanner handles nulls and missing fields", "[entity_scanner]") {
+    EntityScanner scanner;
+    Entity e;
+    e.lat = 1.0;
+    e.name = "stale";
+    e.render_offset = 0.5f;
+
+    REQUIRE(scanner.scan(R"({"id":"x","t_start":"2020-01-01T00:00:00Z","t_end":null,"lat":null})", e));
+    REQUIRE(e.time_end == e.time_start);
+    REQUIRE_FALSE(e.lat.has_value());
+    REQUIRE_FALSE(e.lon.has_value());
+    REQUIRE_FALSE(e.name.has_value());
+    REQUIRE_FALSE(e.color.has_value());
+    REQUIRE(e.render_offset == 0.0f);
+}
+
+TEST_CASE("EntityScanner skips unknown keys and nested values", "[entity_scanner]") {
+    EntityScanner scanner;
+    Entity e;
+    REQUIRE(scanner.scan(
+        R"( { "type" : "photo", "props": {"a": [1, {"b": "}"}]}, "id": "p", "ok": true,)"
+        R"( "t_start": "2021-06-15T12:30:00Z", "score": -1.5e3 } )", e));
+    REQUIRE(e.id == "p");
+    REQUIRE(e.time_start == Catch::Approx(1623760200.0));
+}
+
+TEST_CASE("EntityScanner decodes string escapes", "[entity_scanner]") {
+    EntityScanner scanner;
+    Entity e;
+    REQUIRE(scanner.scan(
+        R"({"id":"q\"uote","t_start":"2020-01-01T00:00:00Z","name":"caf\u00e9 \ud83d\ude00\n"})", e));
+    REQUIRE(e.id == "q\"uote");
+    REQUIRE(*e.name == "caf\xC3\xA9 \xF0\x9F\x98\x80\n");
+}
+
+TEST_CASE("EntityScanner number parsing matches strtod", "[entity_scanner]") {
+    const char* numbers[] = {
+        "0", "-0.5", "34.052235", "-118.243683", "1e-7", "12345678901234567890.5",
+        "0.000000000000000000000000123", "1.7976931348623157e308"
+    };
+    EntityScanner scanner;
+    for (const char* num : numbers) {
+        std::string line = std::string(R"({"id":"n","t_start":"2020-01-01T00:00:00Z","lat":)") + num + "}";
+        Entity e;
+        REQUIRE(scanner.scan(line, e));
+        REQUIRE(*e.lat == std::strtod(num, nullptr));
+    }
+}
+
+TEST_CASE("EntityScanner rejects malformed lines", "[entity_scanner]") {
+    EntityScanner scanner;
+    Entity e;
+    REQUIRE_FALSE(scanner.scan("", e));
+    REQUIRE_FALSE(scanner.scan("not json", e));
+    REQUIRE_FALSE(scanner.scan(R"({"id":"x","t_start":"2020-01-01T00:00:00Z")", e));       // unterminated
+    REQUIRE_FALSE(scanner.scan(R"({"id":"x","t_start":"2020-01-01T00:00:00Z"} trailing)", e));
+    REQUIRE_FALSE(scanner.scan(R"({"t_start":"2020-01-01T00:00:00Z"})", e));               // no id
+    REQUIRE_FALSE(scanner.scan(R"({"id":"x"})", e));                                       // no t_start
+    REQUIRE_FALSE(scanner.scan(R"({"id":42,"t_start":"2020-01-01T00:00:00Z"})", e));       // wrong type
+    REQUIRE_FALSE(scanner.scan(R"({"id":"x","t_start":"yesterday"})", e));                 // bad timestamp
+}
+
+TEST_CASE("EntityScanner scanTotal recognizes the header line", "[entity_scanner]") {
+    size_t total = 0;
+    REQUIRE(EntityScanner::scanTotal(R"({"total": 4200000})", total));
+    REQUIRE(total == 4200000);
+    REQUIRE_FALSE(EntityScanner::scanTotal(R"({"id":"x","t_start":"2020-01-01T00:00:00Z"})", total));
+    REQUIRE_FALSE(EntityScanner::scanTotal(R"({"total": 5, "extra": 1})", total));
+}
+
+TEST_CASE("EntityScanner splitArray extracts response elements", "[entity_scanner]") {
+    std::vector<std::string_view> elements;
+    std::string body = R"({"meta": {"x": [1, "]"]}, "entities": [ {"id":"a","t_start":"2021-01-01T00:00:00Z"} ,)"
+                       R"({"id":"b","t_start":"2021-01-02T00:00:00Z","name":"}"}], "next": null})";
+    REQUIRE(EntityScanner::splitArray(body, "entities", elements));
+    REQUIRE(elements.size() == 2);
+
+    EntityScanner scanner;
+    Entity e;
+    REQUIRE(scanner.scan(elements[0], e));
+    REQUIRE(e.id == "a");
+    REQUIRE(scanner.scan(elements[1], e));
+    REQUIRE(e.name == "}");
+
+    REQUIRE(EntityScanner::splitArray(R"({"entities": []})", "entities", elements));
+    REQUIRE(elements.empty());
+    REQUIRE_FALSE(EntityScanner::splitArray(R"({"other": []})", "entities", elements));
+    REQUIRE_FALSE(EntityScanner::splitArray(R"({"entities": [{"id":"a")", "entities", elements));
+}
+
+TEST_CASE("EntityScanner agrees with the DOM parser", "[entity_scanner]") {
+    const char* lines[] = {
+        R"({"id":"g1","t_start":"2023-03-04T05:06:07Z","t_end":null,"lat":34.1,"lon":-118.3,"name":null,"color":null})",
+        R"({"id":"c1","t_start":"2023-03-04T05:06:07Z","t_end":"2023-03-04T06:06:07Z","name":"Standup","color":"#FF0000","render_offset":-0.3})",
+    };
+    EntityScanner scanner;
+    for (const char* line : lines) {
+        Entity fast;
+        REQUIRE(scanner.scan(line, fast));
+        Entity slow = BackendAPI::parse_entity(nlohmann::json::parse(line));
+
+        REQUIRE(fast.id == slow.id);
+        REQUIRE(fast.time_start == slow.time_start);
+        REQUIRE(fast.time_end == slow.time_end);
+        REQUIRE(fast.lat == slow.lat);
+        REQUIRE(fast.lon == slow.lon);
+        REQUIRE(fast.name == slow.name);
+        REQUIRE(fast.color == slow.color);
+        REQUIRE(fast.render_offset == slow.render_offset);
+    }
+}
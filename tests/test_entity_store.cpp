@@ -0,0 +1,405 @@
+#include <catch2/catch_test_macros.hpp>
+#include "core/EntityStore.h"
+#include <algorithm>
+#include <string>
+#include <vector>
+
+namespace {
+
+Entity makeEntity(int i, double t)
+{
+    Entity e;
+    e.id = "entity-" + std::to_string(i);
+    e.time_start = t;
+    e.time_end = t + (i % 2 ? 30.0 : 0.0);
+    if (i % 3 != 0) {
+        e.lat = 34.0 + i * 0.001;
+        e.lon = -118.0 + i * 0.001;
+    }
+    if (i % 4 == 0) e.name = "Home";
+    if (i % 5 == 0) e.color = "#4CAF50";
+    e.render_offset = 0.1f * static_cast<float>(i % 5);
+    return e;
+}
+
+} // namespace
+
+TEST_CASE("EntityStore rows read like entities", "[entity_store]") {
+    std::vector<Entity> rows;
+    for (int i = 0; i < 40; ++i) rows.push_back(makeEntity(i, 1000.0 + i));
+    EntityStore store;
+    store.append(rows);
+    REQUIRE(store.size() == 40);
+
+    size_t i = 0;
+    for (const auto& row : store) {
+        const Entity& want = rows[i];
+        REQUIRE(row.id == want.id);
+        REQUIRE(row.time_mid() == want.time_mid());
+        REQUIRE(row.has_location() == want.has_location());
+        REQUIRE(row.lat == want.lat);
+        REQUIRE(row.name.has_value() == want.name.has_value());
+        if (want.name) REQUIRE(*row.name == *want.name);
+        REQUIRE(row.color.has_value() == want.color.has_value());
+        REQUIRE(row.render_offset == want.render_offset);
+
+        Entity copy = store.entity(i);
+        REQUIRE(copy.id == want.id);
+        REQUIRE(copy.lon == want.lon);
+        REQUIRE(copy.color == want.color);
+        REQUIRE(row.entity().name == want.name);
+        ++i;
+    }
+    REQUIRE(i == 40);
+}
+
+TEST_CASE("EntityStore appends batches and filters, rewriting the pool", "[entity_store]") {
+    EntityStore store;
+    for (int b = 0; b < 4; ++b) {
+        std::vector<Entity> batch;
+        for (int i = 0; i < 250; ++i) batch.push_back(makeEntity(b * 250 + i, b * 250.0 + i));
+        store.append(EntityColumns::fromEntities(batch));
+    }
+    REQUIRE(store.size() == 1000);
+    size_t poolBefore = store.segment(0).strings.size();
+
+    // Keep one row in ten: the pool is rewritten for the survivors
+    store.filter([](const EntityColumns& c, size_t row) { return static_cast<int>(c.time_start[row]) % 10 == 0; });
+    REQUIRE(store.size() == 100);
+    REQUIRE(store.segment(0).strings.size() < poolBefore / 2);
+    for (size_t i = 0; i < store.size(); ++i) {
+        int n = static_cast<int>(store[i].time_start);
+        REQUIRE(store[i].id == "entity-" + std::to_string(n));
+        REQUIRE(store.entity(i).name == makeEntity(n, 0.0).name);
+        REQUIRE(store.entity(i).color == makeEntity(n, 0.0).color);
+    }
+}
+
+TEST_CASE("EntityStore fills fixed segments without moving them", "[entity_store]") {
+    const size_t seg = EntityStore::kSegmentSize;
+    const size_t n = 2 * seg + 1234;
+    EntityStore store;
+    const double* firstTimes = nullptr;
+    EntityRow early;
+    for (size_t from = 0; from < n; from += 7777) {
+        std::vector<Entity> batch;
+        for (size_t i = from; i < std::min(n, from + 7777); ++i)
+            batch.push_back(makeEntity(static_cast<int>(i), static_cast<double>(i)));
+        store.append(EntityColumns::fromEntities(batch));
+        if (store.segmentCount() == 2 && !firstTimes) {
+            firstTimes = store.segment(0).time_start.data();
+            early = store[10];
+        }
+    }
+
+    REQUIRE(store.size() == n);
+    REQUIRE(store.segmentCount() == 3);
+    REQUIRE(store.segment(0).size() == seg);
+    REQUIRE(store.segment(1).size() == seg);
+    REQUIRE(store.segment(2).size() == 1234);
+    REQUIRE(store.segment(0).time_start.data() == firstTimes);  // never reallocated
+    REQUIRE(early.id == "entity-10");                           // views into it still valid
+
+    size_t visited = 0;
+    store.forEach(seg - 5, seg + 5, [&](const EntityColumns& c, size_t row, size_t i) {
+        REQUIRE(c.time_start[row] == static_cast<double>(i));
+        ++visited;
+    });
+    REQUIRE(visited == 10);
+    REQUIRE(store[seg + 3].id == "entity-" + std::to_string(seg + 3));
+
+    // Dropping rows repacks the segments
+    store.filter([](const EntityColumns& c, size_t row) { return static_cast<size_t>(c.time_start[row]) % 2 == 0; });
+    REQUIRE(store.size() == (n + 1) / 2);
+    REQUIRE(store.segmentCount() == 2);
+    REQUIRE(store.segment(0).size() == seg);
+    REQUIRE(store[seg].time_start == 2.0 * seg);
+    REQUIRE(store.sortedByTime());
+}
+
+TEST_CASE("EntityStore merges an appended tail into time order", "[entity_store]") {
+    EntityStore store;
+    for (int i = 0; i < 10; ++i) store.push_back(makeEntity(i, i * 10.0));
+    REQUIRE(store.sortedByTime());
+
+    store.append(std::vector<Entity>{makeEntity(100, 95.0), makeEntity(101, 5.0), makeEntity(102, 55.0),
+                                     makeEntity(103, 55.0)});
+    REQUIRE_FALSE(store.sortedByTime());
+    REQUIRE(store.sortedCount() == 11);  // 95 still extends the sorted rows; 5 starts the tail
+
+    // The copy a worker makes matches the merge in place, id index included
+    store.indexIds();
+    EntityStore merged = store.mergedByTime();
+    REQUIRE_FALSE(store.sortedByTime());
+    REQUIRE(merged.sortedByTime());
+    REQUIRE(merged.indexesIds());
+    REQUIRE(merged.find("entity-101") == 1);
+
+    store.mergeByTime();
+    REQUIRE(merged.size() == store.size());
+    for (size_t i = 0; i < store.size(); ++i) REQUIRE(merged[i].id == store[i].id);
+    REQUIRE(store.sortedByTime());
+    REQUIRE(store.sortedCount() == 14);
+    REQUIRE(store[1].id == "entity-101");
+    REQUIRE(store[7].id == "entity-102");  // equal times keep their order
+    REQUIRE(store[8].id == "entity-103");
+    REQUIRE(store[13].id == "entity-100");
+    REQUIRE(store[8].has_location());
+}
+
+TEST_CASE("EntityStore maps a time window to a row range", "[entity_store]") {
+    // Ten days, unevenly filled: 3-hour steps with gaps, several rows per second
+    EntityStore store;
+    std::vector<double> times;
+    for (int i = 0; i < 400; ++i) {
+        double t = 1700000000.0 + (i / 3) * 3 * 3600.0 + (i % 3);
+        if ((i / 30) % 4 == 1) continue;  // a gap of several days
+        times.push_back(t);
+        store.push_back(makeEntity(i, t));
+    }
+    REQUIRE(store.sortedByTime());
+    REQUIRE(store.maxDuration() == 30.0);
+
+    auto brute = [&times](double t0, double t1) {
+        size_t first = 0, last = 0;
+        while (first < times.size() && times[first] < t0) ++first;
+        while (last < times.size() && times[last] <= t1) ++last;
+        return std::make_pair(first, std::max(first, last));
+    };
+    for (double t0 = 1699900000.0; t0 < 1702000000.0; t0 += 7777.0)
+        for (double len : {0.0, 1.0, 3600.0, 86400.0, 5 * 86400.0})
+            REQUIRE(store.timeRange(t0, t0 + len) == brute(t0, t0 + len));
+    REQUIRE(store.timeRange(times[5], times[5]) == brute(times[5], times[5]));
+    REQUIRE(store.timeRange(0.0, 1e12) == std::make_pair(size_t(0), times.size()));
+    REQUIRE(store.timeRange(1e12, 2e12).first == times.size());
+
+    // Rows out of order wait in the tail, but scans of a window still see them
+    Entity late = makeEntity(1000, times[3] + 0.5);
+    store.push_back(late);
+    store.push_back(makeEntity(1001, times.back() + 1.0));
+    REQUIRE(store.sortedCount() == times.size());
+    std::vector<std::string> seen;
+    store.forEachInTime(times[3], times[4], [&](const EntityColumns& c, size_t row, size_t) {
+        seen.emplace_back(c.idAt(row));
+    });
+    REQUIRE(std::find(seen.begin(), seen.end(), late.id) != seen.end());
+
+    store.mergeByTime();
+    REQUIRE(store.sortedByTime());
+    auto [first, last] = store.timeRange(late.time_start, late.time_start);
+    REQUIRE(last == first + 1);
+    REQUIRE(store[first].id == late.id);
+}
+
+TEST_CASE("EntityStore windows include long events that started earlier", "[entity_store]") {
+    EntityStore store;
+    Entity trip = makeEntity(1, 0.0);
+    trip.time_end = 25 * 86400.0;
+    store.push_back(trip);
+    for (int i = 2; i < 50; ++i) store.push_back(makeEntity(2 * i, i * 86400.0));
+
+    std::vector<std::string> seen;
+    store.forEachInTime(20 * 86400.0, 21 * 86400.0, [&](const EntityColumns& c, size_t row, size_t) {
+        seen.emplace_back(c.idAt(row));
+    });
+    REQUIRE(seen.front() == trip.id);
+    REQUIRE(seen.back() == "entity-42");
+    REQUIRE(seen.size() == 21);  // the trip and days 2-21, not the whole layer
+}
+
+TEST_CASE("EntityStore interns names and colors", "[entity_store]") {
+    const char* colors[] = {"#4CAF50", "#2196F3", "#FF9800"};
+    auto event = [&colors](int i) {
+        Entity e;
+        e.id = "event-" + std::to_string(i);
+        e.time_start = i * 60.0;
+        e.time_end = e.time_start + 30.0;
+        e.color = colors[i % 3];
+        if (i % 2 == 0) e.name = "Standup";
+        return e;
+    };
+
+    // Row by row, and as batches whose pools hold a copy per row
+    EntityStore store;
+    size_t idBytes = 0;
+    for (int i = 0; i < 300; ++i) {
+        if (i < 100) store.push_back(event(i));
+        idBytes += event(i).id.size();
+    }
+    for (int b = 1; b < 3; ++b) {
+        EntityColumns batch;
+        for (int i = b * 100; i < (b + 1) * 100; ++i) batch.push_back(event(i));
+        store.append(std::move(batch));
+    }
+
+    REQUIRE(store.size() == 300);
+    REQUIRE(store.internedCount() == 4);
+    REQUIRE(store.segment(0).strings.size() == idBytes + 3 * 7 + 7);
+    for (size_t i = 0; i < store.size(); ++i) {
+        Entity want = event(static_cast<int>(i));
+        REQUIRE(store[i].id == want.id);
+        REQUIRE(*store[i].color == *want.color);
+        REQUIRE(store.entity(i).name == want.name);
+    }
+
+    // A filter keeps them shared
+    store.filter([](const EntityColumns& c, size_t row) { return c.time_start[row] >= 270 * 60.0; });
+    REQUIRE(store.size() == 30);
+    REQUIRE(store.internedCount() == 4);
+    REQUIRE(store.entity(0).color == event(270).color);
+    REQUIRE(store.entity(29).name == event(299).name);
+}
+
+TEST_CASE("EntityStore stores names past the intern limit per row", "[entity_store]") {
+    EntityStore store;
+    const size_t n = EntityStore::kMaxInterned + 50;
+    for (size_t i = 0; i < n; ++i) {
+        Entity e = makeEntity(static_cast<int>(i), static_cast<double>(i));
+        e.name = "place " + std::to_string(i);
+        store.push_back(e);
+    }
+    REQUIRE(store.internedCount() == EntityStore::kMaxInterned);
+    for (size_t i = 0; i < n; i += 97) REQUIRE(*store[i].name == "place " + std::to_string(i));
+    REQUIRE(*store[n - 1].name == "place " + std::to_string(n - 1));
+}
+
+TEST_CASE("EntityStore holds half what a vector of entities does", "[entity_store]") {
+    // GPS fixes: uuid-sized id, location, no name or color; appended in
+    // export-sized batches
+    const size_t n = 3 * EntityStore::kSegmentSize;
+    std::vector<Entity> rows;
+    EntityStore store;
+    EntityColumns batch;
+    for (size_t i = 0; i < n; ++i) {
+        Entity e;
+        e.id = "0b5f3e1c-7a2d-4f11-9c3e-" + std::to_string(100000000000 + i);
+        e.time_start = e.time_end = static_cast<double>(i);
+        e.lat = 34.0;
+        e.lon = -118.0;
+        rows.push_back(e);
+        batch.push_back(e);
+        if (batch.size() == 8000 || i + 1 == n) {
+            store.append(batch);
+            batch.clear();
+        }
+    }
+
+    size_t vectorBytes = rows.size() * sizeof(Entity);
+    for (const auto& e : rows) vectorBytes += e.id.capacity() + 1;
+    REQUIRE(store.memoryBytes() * 2 < vectorBytes);
+
+    store.clear();
+    REQUIRE(store.empty());
+    REQUIRE(store.memoryBytes() == 0);  // released, not just emptied
+}
+
+TEST_CASE("EntityStore upserts a batch by id", "[entity_store]") {
+    std::vector<Entity> rows;
+    for (int i = 0; i < 100; ++i) rows.push_back(makeEntity(i, 1000.0 + i));
+    EntityStore store;
+    store.append(rows);
+    REQUIRE_FALSE(store.indexesIds());
+
+    // The same rows again: nothing to do
+    auto again = store.upsert(EntityColumns::fromEntities(rows));
+    REQUIRE(store.indexesIds());
+    REQUIRE(again.unchanged == 100);
+    REQUIRE(again.inserted + again.updated == 0);
+    REQUIRE(store.size() == 100);
+
+    // A changed name in place, a moved row, two new rows (one given twice)
+    std::vector<Entity> delta;
+    Entity renamed = rows[10];
+    renamed.name = "Work";
+    delta.push_back(renamed);
+    Entity moved = rows[20];
+    moved.time_start = moved.time_end = 1500.0;
+    delta.push_back(moved);
+    Entity added = makeEntity(200, 1050.5);
+    delta.push_back(added);
+    delta.push_back(makeEntity(201, 1200.0));
+    added.lat = 10.0;
+    delta.push_back(added);
+    delta.push_back(rows[30]);
+
+    auto result = store.upsert(EntityColumns::fromEntities(delta));
+    REQUIRE(result.inserted == 2);
+    REQUIRE(result.updated == 2);
+    REQUIRE(result.unchanged == 1);
+    REQUIRE(store.size() == 102);
+
+    REQUIRE(*store[store.find("entity-10")].name == "Work");
+    REQUIRE(store.find("entity-10") == 10);
+    REQUIRE(store[store.find("entity-20")].time_start == 1500.0);
+    REQUIRE(store[store.find("entity-200")].lat == 10.0);
+    REQUIRE(store.find("entity-999") == EntityStore::npos);
+
+    // Merging keeps the index in step with the moved rows
+    store.mergeByTime();
+    REQUIRE(store.sortedByTime());
+    for (size_t i = 0; i < store.size(); ++i) REQUIRE(store.find(store[i].id) == i);
+    REQUIRE(store.upsert(EntityColumns::fromEntities(delta)).inserted == 0);
+    REQUIRE(store.size() == 102);
+    REQUIRE(store[store.find("entity-200")].lat == 10.0);
+}
+
+TEST_CASE("EntityStore erases rows and keeps the id index", "[entity_store]") {
+    EntityStore store;
+    for (int i = 0; i < 50; ++i) store.push_back(makeEntity(i, static_cast<double>(i)));
+    store.indexIds();
+
+    store.erase({0, 7, 7, 49});
+    REQUIRE(store.size() == 47);
+    REQUIRE(store.find("entity-0") == EntityStore::npos);
+    REQUIRE(store.find("entity-7") == EntityStore::npos);
+    REQUIRE(store.find("entity-8") == 6);
+
+    // Later appends are indexed too
+    store.push_back(makeEntity(60, 60.0));
+    REQUIRE(store.find("entity-60") == 47);
+
+    store.clear();
+    REQUIRE_FALSE(store.indexesIds());
+    REQUIRE(store.memoryBytes() == 0);
+}
+
+TEST_CASE("EntityStore edits near the end leave earlier segments in place", "[entity_store]") {
+    const size_t seg = EntityStore::kSegmentSize;
+    const size_t n = 3 * seg + 500;
+    std::vector<Entity> rows;
+    rows.reserve(n);
+    for (size_t i = 0; i < n; ++i) rows.push_back(makeEntity(static_cast<int>(i), static_cast<double>(i)));
+    EntityStore store;
+    store.append(EntityColumns::fromEntities(rows));
+    store.indexIds();
+    const double* first = store.segment(0).time_start.data();
+    const double* second = store.segment(1).time_start.data();
+    EntityRow early = store[10];
+
+    // A small refresh of the last segments: one row moved later, one new,
+    // one dropped
+    std::vector<Entity> delta;
+    Entity moved = rows[2 * seg + 100];
+    moved.time_start = moved.time_end = static_cast<double>(n) + 5.0;
+    delta.push_back(moved);
+    delta.push_back(makeEntity(static_cast<int>(n), 2.5 * seg));
+    auto result = store.upsert(EntityColumns::fromEntities(delta), {static_cast<uint32_t>(3 * seg + 7)});
+    REQUIRE(result.updated == 1);
+    REQUIRE(result.inserted == 1);
+    REQUIRE(store.size() == n);
+    store.mergeByTime();
+
+    REQUIRE(store.segment(0).time_start.data() == first);  // not copied
+    REQUIRE(store.segment(1).time_start.data() == second);
+    REQUIRE(early.id == "entity-10");
+    REQUIRE(store.sortedByTime());
+    for (size_t i = 1; i < store.size(); ++i) REQUIRE(store[i - 1].time_start <= store[i].time_start);
+    for (size_t i = 0; i < store.size(); i += 997) REQUIRE(store.find(store[i].id) == i);
+    REQUIRE(store.find(moved.id) == n - 1);
+    REQUIRE(store.find("entity-" + std::to_string(3 * seg + 7)) == EntityStore::npos);
+    REQUIRE(store.find("entity-" + std::to_string(n)) != EntityStore::npos);
+
+    auto [from, to] = store.timeRange(100.0, 199.0);
+    REQUIRE(to - from == 100);
+    REQUIRE(store[from].id == "entity-100");
+}
@@ -2,6 +2,206 @@
 #include "FetchOrchestrator.h"
 #include "FakeBackend.h"
 #include "BackendFactory.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+Entity trackPoint(const std::string& id, double t)
+{
+    Entity e;
+    e.id = id;
+    e.time_start = e.time_end = t;
+    e.lat = 34.0;
+    e.lon = -118.0;
+    return e;
+}
+
+/// Streams a time-ordered track, then reports one refreshed range.
+class RefreshingBackend : public Backend {
+public:
+    std::atomic<int> refreshes{0};
+
+    void fetchEntities(const TimeExtent&, const SpatialExtent&,
+                       std::function<void(std::vector<Entity>&&)> callback) override {
+        callback({});
+    }
+
+    void streamAllEntities(std::function<void(size_t)>,
+                           std::function<void(std::vector<Entity>&&)> batch_callback) override {
+        std::vector<Entity> track;
+        for (int i = 0; i < 10; ++i) track.push_back(trackPoint("row-" + std::to_string(i), i * 100.0));
+        batch_callback(std::move(track));
+    }
+
+    void refresh(RangeUpdate on_update) override {
+        ++refreshes;
+        on_update({{400.0, 600.0}}, {trackPoint("new-b", 450.0), trackPoint("new-a", 420.0)});
+    }
+};
+
+/// Streams `rows`; refresh() reports `refreshRows` for `refreshRange`, if any.
+class ListBackend : public Backend {
+public:
+    std::vector<Entity> rows;
+    std::vector<Entity> refreshRows;
+    TimeExtent refreshRange{0.0, 0.0};
+
+    void fetchEntities(const TimeExtent&, const SpatialExtent&,
+                       std::function<void(std::vector<Entity>&&)> callback) override {
+        callback({});
+    }
+
+    void streamAllEntities(std::function<void(size_t)>,
+                           std::function<void(std::vector<Entity>&&)> batch_callback) override {
+        batch_callback(std::vector<Entity>(rows));
+    }
+
+    void streamAllByType(double, double, std::function<void(std::vector<Entity>&&)> batch_callback) override {
+        batch_callback(std::vector<Entity>(rows));
+    }
+
+    void refresh(RangeUpdate on_update) override {
+        if (!refreshRows.empty()) on_update({refreshRange}, std::vector<Entity>(refreshRows));
+    }
+};
+
+/// A 20x20 grid of points over (34.0-34.2, -118.4 to -118.2), one a minute,
+/// served by region with a small row limit so dense regions get split.
+class GridBackend : public Backend {
+public:
+    static constexpr double kT0 = 1700000000.0;
+    std::vector<Entity> points;
+    std::atomic<int> regionCalls{0};
+    std::atomic<int> streams{0};
+    size_t limit = 60;
+
+    GridBackend() {
+        for (int y = 0; y < 20; ++y)
+            for (int x = 0; x < 20; ++x) {
+                Entity e = trackPoint("p" + std::to_string(y) + "-" + std::to_string(x),
+                                      kT0 + (y * 20 + x) * 60.0);
+                e.lat = 34.005 + y * 0.01;
+                e.lon = -118.395 + x * 0.01;
+                points.push_back(e);
+            }
+    }
+
+    void fetchEntities(const TimeExtent&, const SpatialExtent&,
+                       std::function<void(std::vector<Entity>&&)> callback) override {
+        callback({});
+    }
+
+    RegionStatus fetchRegion(const TimeExtent& time, const SpatialExtent& space,
+                             std::function<void(std::vector<Entity>&&)> callback) override {
+        ++regionCalls;
+        std::vector<Entity> hits;
+        for (const auto& e : points)
+            if (*e.lat >= space.min_lat && *e.lat <= space.max_lat &&
+                *e.lon >= space.min_lon && *e.lon <= space.max_lon &&
+                e.time_start >= time.start && e.time_start <= time.end)
+                hits.push_back(e);
+        bool truncated = hits.size() >= limit;
+        if (truncated) hits.resize(limit);
+        callback(std::move(hits));
+        return truncated ? RegionStatus::Truncated : RegionStatus::Complete;
+    }
+
+    void streamAllEntities(std::function<void(size_t)>,
+                           std::function<void(std::vector<Entity>&&)>) override {
+        ++streams;
+    }
+};
+
+/// Streams `batches` small batches as fast as it can, until cancelled.
+class FloodBackend : public Backend {
+public:
+    int batches;
+    std::atomic<int> delivered{0};
+    std::atomic<bool> cancelled{false};
+
+    explicit FloodBackend(int batches) : batches(batches) {}
+
+    void fetchEntities(const TimeExtent&, const SpatialExtent&,
+                       std::function<void(std::vector<Entity>&&)> callback) override {
+        callback({});
+    }
+
+    void streamAllEntities(std::function<void(size_t)>,
+                           std::function<void(std::vector<Entity>&&)> batch_callback) override {
+        cancelled = false;
+        for (int b = 0; b < batches && !cancelled; ++b) {
+            std::vector<Entity> batch;
+            for (int i = 0; i < 10; ++i) batch.push_back(trackPoint("b" + std::to_string(b), b * 10.0 + i));
+            batch_callback(std::move(batch));
+            ++delivered;
+        }
+    }
+
+    void cancelFetch() override { cancelled = true; }
+};
+
+/// Streams `batches` time-ordered batches of ten, latest batch first.
+class ReversedBackend : public Backend {
+public:
+    int batches;
+
+    explicit ReversedBackend(int batches) : batches(batches) {}
+
+    void fetchEntities(const TimeExtent&, const SpatialExtent&,
+                       std::function<void(std::vector<Entity>&&)> callback) override {
+        callback({});
+    }
+
+    void streamAllEntities(std::function<void(size_t)>,
+                           std::function<void(std::vector<Entity>&&)> batch_callback) override {
+        for (int b = batches - 1; b >= 0; --b) {
+            std::vector<Entity> batch;
+            for (int i = 0; i < 10; ++i)
+                batch.push_back(trackPoint("b" + std::to_string(b) + "-" + std::to_string(i), b * 100.0 + i));
+            batch_callback(std::move(batch));
+        }
+    }
+};
+
+SpatialExtent viewOf(double minLat, double maxLat, double minLon, double maxLon)
+{
+    SpatialExtent s;
+    s.min_lat = minLat;
+    s.max_lat = maxLat;
+    s.min_lon = minLon;
+    s.max_lon = maxLon;
+    return s;
+}
+
+/// Run frames until layer 0's view is fully covered.
+void settleViewport(FetchOrchestrator& orchestrator, AppModel& model)
+{
+    for (int frame = 0; frame < 5000; ++frame) {
+        orchestrator.drainCompletedBatches(model);
+        orchestrator.updateViewport(model);
+        if (orchestrator.coverage(0).plan(model.spatial_extent, model.time_extent).empty()) {
+            orchestrator.cancelAndWaitAll();  // the worker's last endFetch
+            return;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    FAIL("viewport never settled");
+}
+
+std::vector<std::string> layerIds(const Layer& layer)
+{
+    std::vector<std::string> ids;
+    for (const auto& e : layer.entities) ids.emplace_back(e.id);
+    return ids;
+}
+
+} // namespace
 
 TEST_CASE("FetchOrchestrator startFullLoad populates model with FakeBackend", "[fetch_orchestrator]") {
     AppModel model;
@@ -96,3 +296,379 @@ TEST_CASE("FetchOrchestrator multiple drains accumulate entities", "[fetch_orche
     REQUIRE_FALSE(drained);
     REQUIRE(model.layers[0].entities.size() == 100);
 }
+
+TEST_CASE("FetchOrchestrator applies a refresh in place after the load", "[fetch_orchestrator]") {
+    AppModel model;
+    FetchOrchestrator orchestrator;
+
+    auto backend = std::make_unique<RefreshingBackend>();
+    RefreshingBackend* source = backend.get();
+    BackendSet backends;
+    backends.gps = std::move(backend);
+    orchestrator.setBackends(std::move(backends), BackendConfig::Type::Cached);
+
+    orchestrator.startFullLoad(model);
+    uint64_t loaded = model.layers[0].revision;  // the reload itself bumps it
+    orchestrator.cancelAndWaitAll();
+    REQUIRE(source->refreshes == 1);
+
+    REQUIRE(orchestrator.drainCompletedBatches(model));
+    const std::vector<std::string> expected = {
+        "row-0", "row-1", "row-2", "row-3", "new-a", "new-b", "row-6", "row-7", "row-8", "row-9"};
+    REQUIRE(layerIds(model.layers[0]) == expected);
+    REQUIRE(model.layers[0].revision == loaded + 1);
+
+    // A manual sync reports the same range again: merged by id, it leaves
+    // the layer as it is
+    REQUIRE(orchestrator.startSync());
+    orchestrator.cancelAndWaitAll();
+    REQUIRE(source->refreshes == 2);
+    REQUIRE(orchestrator.drainCompletedBatches(model));
+    REQUIRE(layerIds(model.layers[0]) == expected);
+    REQUIRE(model.layers[0].revision == loaded + 1);
+    REQUIRE(model.layers[0].entities.indexesIds());
+}
+
+TEST_CASE("FetchOrchestrator merges batches that arrive out of time order", "[fetch_orchestrator]") {
+    AppModel model;
+    FetchOrchestrator orchestrator;
+
+    BackendSet backends;
+    backends.gps = std::make_unique<ReversedBackend>(40);
+    orchestrator.setBackends(std::move(backends), BackendConfig::Type::Http);
+    orchestrator.setDrainBudget(0.0);
+
+    orchestrator.startFullLoad(model);
+    uint64_t loaded = model.layers[0].revision;
+    orchestrator.cancelAndWaitAll();
+
+    // Loaded and nothing queued: one merge puts the layer in time order
+    REQUIRE(orchestrator.drainCompletedBatches(model));
+    const EntityStore& entities = model.layers[0].entities;
+    REQUIRE(entities.size() == 400);
+    REQUIRE(entities.sortedByTime());
+    REQUIRE(entities.indexesIds());  // indexed as it loaded, ready for the refresh
+    REQUIRE(model.layers[0].revision == loaded + 1);
+    REQUIRE(entities[0].id == "b0-0");
+    REQUIRE(entities[399].id == "b39-9");
+
+    auto [first, last] = entities.timeRange(500.0, 599.0);
+    REQUIRE(last - first == 10);
+    REQUIRE(entities[first].id == "b5-0");
+
+    REQUIRE_FALSE(orchestrator.drainCompletedBatches(model));
+    REQUIRE(model.layers[0].revision == loaded + 1);
+}
+
+TEST_CASE("FetchOrchestrator merges a large layer on a worker and swaps it in", "[fetch_orchestrator]") {
+    AppModel model;
+    FetchOrchestrator orchestrator;
+    orchestrator.setDrainBudget(0.0);
+    orchestrator.setBackgroundMergeRows(100);
+
+    auto backend = std::make_unique<ListBackend>();
+    ListBackend* source = backend.get();
+    for (int i = 299; i >= 0; --i) source->rows.push_back(trackPoint("row-" + std::to_string(i), i * 10.0));
+    BackendSet backends;
+    backends.gps = std::move(backend);
+    orchestrator.setBackends(std::move(backends), BackendConfig::Type::Http);
+
+    orchestrator.startFullLoad(model);
+    uint64_t loaded = model.layers[0].revision;
+    orchestrator.cancelAndWaitAll();
+
+    // The drain appends the rows and leaves the merge to a worker
+    REQUIRE(orchestrator.drainCompletedBatches(model));
+    const EntityStore& entities = model.layers[0].entities;
+    REQUIRE(entities.size() == 300);
+    REQUIRE_FALSE(entities.sortedByTime());
+    REQUIRE(orchestrator.merging(0));
+    REQUIRE(model.layers[0].revision == loaded);
+
+    // A refresh queued meanwhile is applied once the merged layer is in
+    source->refreshRows = {trackPoint("row-5", 50.0), trackPoint("row-new", 55.0)};
+    source->refreshRows[0].lat = 35.0;
+    source->refreshRange = {50.0, 60.0};
+    REQUIRE(orchestrator.startSync());
+    for (int wait = 0; wait < 5000 && orchestrator.queueStats().depth == 0; ++wait)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    REQUIRE(orchestrator.queueStats().depth == 1);
+    for (int frame = 0; frame < 5000 && (orchestrator.merging(0) || !entities.sortedByTime()); ++frame) {
+        orchestrator.drainCompletedBatches(model);
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    orchestrator.cancelAndWaitAll();
+    REQUIRE_FALSE(orchestrator.merging(0));
+    REQUIRE(entities.sortedByTime());
+    REQUIRE(entities.size() == 301);
+    REQUIRE(entities[5].lat == 35.0);
+    REQUIRE(entities.find("row-new") == 6);
+    REQUIRE(entities.find("row-299") == 300);
+    // The load's merge, the refresh's edit, and the merge of its new row
+    REQUIRE(model.layers[0].revision == loaded + 3);
+}
+
+TEST_CASE("FetchOrchestrator leaves an idle layer's small tail to a frame with budget", "[fetch_orchestrator]") {
+    AppModel model;
+    FetchOrchestrator orchestrator;
+
+    BackendSet backends;
+    backends.gps = std::make_unique<ReversedBackend>(40);
+    orchestrator.setBackends(std::move(backends), BackendConfig::Type::Http);
+    orchestrator.startFullLoad(model);
+    orchestrator.cancelAndWaitAll();
+
+    // One batch a frame: the tail is merged whenever it reaches a quarter
+    // of the layer, but the last frame's budget is spent by its batch
+    orchestrator.setDrainBudget(1e-9);
+    while (orchestrator.queueStats().depth > 0) orchestrator.drainCompletedBatches(model);
+    const EntityStore& entities = model.layers[0].entities;
+    REQUIRE(entities.size() == 400);
+    REQUIRE(entities.sortedCount() > 300);
+    REQUIRE_FALSE(entities.sortedByTime());
+
+    uint64_t revision = model.layers[0].revision;
+    orchestrator.setDrainBudget(FetchOrchestrator::kDefaultDrainBudget);
+    REQUIRE(orchestrator.drainCompletedBatches(model));
+    REQUIRE(entities.sortedByTime());
+    REQUIRE(model.layers[0].revision == revision + 1);
+}
+
+TEST_CASE("FetchOrchestrator viewport mode loads what is on screen, once", "[fetch_orchestrator]") {
+    AppModel model;
+    FetchOrchestrator orchestrator;
+    orchestrator.setViewportFetch(true);
+
+    auto backend = std::make_unique<GridBackend>();
+    GridBackend* source = backend.get();
+    BackendSet backends;
+    backends.gps = std::move(backend);
+    orchestrator.setBackends(std::move(backends), BackendConfig::Type::Http);
+
+    model.spatial_extent = viewOf(34.0, 34.1, -118.4, -118.3);  // the south-west quarter
+    model.time_extent = {GridBackend::kT0, GridBackend::kT0 + 86400.0};
+    orchestrator.startFullLoad(model);
+    REQUIRE(model.initial_load_complete.load());
+    settleViewport(orchestrator, model);
+    REQUIRE(source->streams == 0);
+
+    auto inView = [&model](const Entity& e) {
+        return *e.lat >= model.spatial_extent.min_lat && *e.lat < model.spatial_extent.max_lat &&
+               *e.lon >= model.spatial_extent.min_lon && *e.lon < model.spatial_extent.max_lon;
+    };
+    auto checkLayer = [&] {
+        std::set<std::string> ids;
+        for (const auto& e : model.layers[0].entities) REQUIRE(ids.emplace(e.id).second);  // no duplicates
+        for (const auto& e : source->points)
+            if (inView(e)) REQUIRE(ids.count(e.id) == 1);
+    };
+    checkLayer();
+    REQUIRE(model.layers[0].entities.size() >= 100);
+
+    // Nothing left to fetch for the same view
+    int calls = source->regionCalls;
+    orchestrator.updateViewport(model);
+    orchestrator.cancelAndWaitAll();
+    REQUIRE(source->regionCalls == calls);
+
+    // Zooming out fetches the rest and nothing twice
+    model.spatial_extent = viewOf(34.0, 34.2, -118.4, -118.2);
+    settleViewport(orchestrator, model);
+    checkLayer();
+    REQUIRE(model.layers[0].entities.size() == 400);
+
+    // Regions arrive out of time order; the first drain after they are all
+    // in merges them
+    orchestrator.drainCompletedBatches(model);
+    REQUIRE(model.layers[0].entities.sortedByTime());
+
+    // Over budget, panning away evicts what is no longer on screen
+    orchestrator.setViewportBudget(100);
+    uint64_t revision = model.layers[0].revision;
+    model.spatial_extent = viewOf(34.1, 34.2, -118.3, -118.2);
+    REQUIRE(orchestrator.updateViewport(model));
+    REQUIRE(model.layers[0].revision == revision + 1);
+    orchestrator.cancelAndWaitAll();
+    orchestrator.drainCompletedBatches(model);
+    REQUIRE(model.layers[0].entities.size() < 400);
+    REQUIRE(model.layers[0].entities.size() >= 100);
+    checkLayer();
+}
+
+TEST_CASE("FetchOrchestrator bounds the batch queue and slows producers down", "[fetch_orchestrator]") {
+    AppModel model;
+    FetchOrchestrator orchestrator(4);
+
+    BackendSet backends;
+    backends.gps = std::make_unique<FloodBackend>(200);
+    orchestrator.setBackends(std::move(backends), BackendConfig::Type::Http);
+
+    orchestrator.startFullLoad(model);
+    for (int frame = 0; frame < 100000 && model.layers[0].entities.size() < 2000; ++frame) {
+        orchestrator.drainCompletedBatches(model);
+        REQUIRE(orchestrator.queueStats().depth <= 4);
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+    orchestrator.cancelAndWaitAll();
+    orchestrator.drainCompletedBatches(model);
+    REQUIRE(model.layers[0].entities.size() == 2000);
+
+    auto stats = orchestrator.queueStats();
+    REQUIRE(stats.capacity == 4);
+    REQUIRE(stats.highWater <= 4);
+    REQUIRE(stats.stalls > 0);
+    REQUIRE(stats.stallSeconds > 0.0);
+}
+
+TEST_CASE("FetchOrchestrator drains within its budget and carries the rest over", "[fetch_orchestrator]") {
+    AppModel model;
+    FetchOrchestrator orchestrator;
+
+    auto backend = std::make_unique<FloodBackend>(20);
+    FloodBackend* source = backend.get();
+    BackendSet backends;
+    backends.gps = std::move(backend);
+    orchestrator.setBackends(std::move(backends), BackendConfig::Type::Http);
+    orchestrator.startFullLoad(model);
+    while (source->delivered < 20) std::this_thread::yield();
+    orchestrator.cancelAndWaitAll();
+    REQUIRE(orchestrator.queueStats().depth == 20);
+
+    // A spent budget still applies one batch per frame
+    orchestrator.setDrainBudget(1e-9);
+    REQUIRE(orchestrator.drainCompletedBatches(model));
+    REQUIRE(model.layers[0].entities.size() == 10);
+    REQUIRE(orchestrator.queueStats().depth == 19);
+    REQUIRE(orchestrator.drainCompletedBatches(model));
+    REQUIRE(model.layers[0].entities.size() == 20);
+
+    // Batches keep their order across frames
+    REQUIRE(model.layers[0].entities[9].id == "b0");
+    REQUIRE(model.layers[0].entities[10].id == "b1");
+
+    // No budget: everything queued
+    orchestrator.setDrainBudget(0.0);
+    REQUIRE(orchestrator.drainCompletedBatches(model));
+    REQUIRE(model.layers[0].entities.size() == 200);
+    REQUIRE(orchestrator.queueStats().depth == 0);
+    REQUIRE_FALSE(orchestrator.drainCompletedBatches(model));
+}
+
+TEST_CASE("FetchOrchestrator cancel releases producers blocked on a full queue", "[fetch_orchestrator]") {
+    AppModel model;
+    FetchOrchestrator orchestrator(2);
+
+    auto backend = std::make_unique<FloodBackend>(1000);
+    FloodBackend* source = backend.get();
+    BackendSet backends;
+    backends.gps = std::move(backend);
+    orchestrator.setBackends(std::move(backends), BackendConfig::Type::Http);
+
+    orchestrator.startFullLoad(model);
+    while (orchestrator.queueStats().stalls == 0) std::this_thread::yield();
+    orchestrator.cancelAndWaitAll();  // nothing drains: must not wait for space
+    REQUIRE(source->delivered < 1000);
+
+    orchestrator.drainCompletedBatches(model);
+    REQUIRE(model.layers[0].entities.size() <= 2 * 10);
+}
+
+TEST_CASE("FetchOrchestrator edits a refreshed range only where it changed", "[fetch_orchestrator]") {
+    AppModel model;
+    FetchOrchestrator orchestrator;
+    orchestrator.setDrainBudget(0.0);
+
+    auto backend = std::make_unique<ListBackend>();
+    ListBackend* source = backend.get();
+    for (int i = 0; i < 10; ++i) source->rows.push_back(trackPoint("row-" + std::to_string(i), i * 100.0));
+    BackendSet backends;
+    backends.gps = std::move(backend);
+    orchestrator.setBackends(std::move(backends), BackendConfig::Type::Http);
+
+    orchestrator.startFullLoad(model);
+    uint64_t loaded = model.layers[0].revision;
+    orchestrator.cancelAndWaitAll();
+    REQUIRE(orchestrator.drainCompletedBatches(model));
+    REQUIRE(model.layers[0].revision == loaded);
+
+    // The whole layer again, one fix moved in place
+    source->refreshRows = source->rows;
+    source->refreshRows[3].lat = 35.0;
+    source->refreshRange = {0.0, 1000.0};
+    REQUIRE(orchestrator.startSync());
+    orchestrator.cancelAndWaitAll();
+    REQUIRE(orchestrator.drainCompletedBatches(model));
+    const EntityStore& entities = model.layers[0].entities;
+    REQUIRE(entities.size() == 10);
+    REQUIRE(entities[3].lat == 35.0);
+    REQUIRE(model.layers[0].revision == loaded + 1);
+
+    // Unchanged: no edit
+    REQUIRE(orchestrator.startSync());
+    orchestrator.cancelAndWaitAll();
+    REQUIRE(orchestrator.drainCompletedBatches(model));
+    REQUIRE(entities.size() == 10);
+    REQUIRE(model.layers[0].revision == loaded + 1);
+}
+
+TEST_CASE("FetchOrchestrator drops Timeline fixes the GPS layer has", "[fetch_orchestrator]") {
+    AppModel model;
+    FetchOrchestrator orchestrator;
+    orchestrator.setDrainBudget(0.0);
+    orchestrator.setDuplicateRule(DuplicateRule{});
+
+    auto gps = std::make_unique<ListBackend>();
+    auto timeline = std::make_unique<ListBackend>();
+    ListBackend* timelineSource = timeline.get();
+    for (int i = 0; i < 10; ++i) {
+        Entity fix = trackPoint("gps-" + std::to_string(i), i * 100.0);
+        fix.lon = -118.0 + i * 0.01;
+        gps->rows.push_back(fix);
+        if (i < 5) {
+            // ~11 m north, 10 s later: the same fix
+            Entity copy = fix;
+            copy.id = "gt-" + std::to_string(i);
+            copy.time_start = copy.time_end = fix.time_start + 10.0;
+            copy.lat = *fix.lat + 0.0001;
+            timeline->rows.push_back(copy);
+        }
+    }
+    Entity far = trackPoint("gt-far", 100.0);
+    far.lon = -117.0;
+    Entity late = trackPoint("gt-late", 700.0 + 120.0);
+    late.lon = -118.0 + 7 * 0.01;
+    Entity visit = trackPoint("gt-visit", 0.0);
+    visit.time_end = 1000.0;
+    timeline->rows.push_back(far);
+    timeline->rows.push_back(late);
+    timeline->rows.push_back(visit);
+    std::sort(timeline->rows.begin(), timeline->rows.end(),
+              [](const Entity& a, const Entity& b) { return a.time_start < b.time_start; });
+
+    BackendSet backends;
+    backends.gps = std::move(gps);
+    backends.googleTimeline = std::move(timeline);
+    orchestrator.setBackends(std::move(backends), BackendConfig::Type::Http);
+
+    orchestrator.startFullLoad(model);
+    uint64_t loaded = model.layers[3].revision;
+    orchestrator.cancelAndWaitAll();
+    REQUIRE(orchestrator.drainCompletedBatches(model));
+    REQUIRE(model.layers[0].entities.size() == 10);
+    const std::vector<std::string> kept = {"gt-visit", "gt-far", "gt-late"};
+    REQUIRE(layerIds(model.layers[3]) == kept);
+    REQUIRE(model.layers[3].revision == loaded + 1);
+
+    // Rows drained once the GPS layer has been swept are checked as they
+    // arrive: a refresh repeating the duplicates leaves the layer as it is
+    Entity copy9 = trackPoint("gt-9", 905.0);
+    copy9.lon = -118.0 + 9 * 0.01;
+    timelineSource->refreshRows = timelineSource->rows;
+    timelineSource->refreshRows.push_back(copy9);
+    timelineSource->refreshRange = {0.0, 2000.0};
+    REQUIRE(orchestrator.startSync());
+    orchestrator.cancelAndWaitAll();
+    REQUIRE(orchestrator.drainCompletedBatches(model));
+    REQUIRE(layerIds(model.layers[3]) == kept);
+    REQUIRE(model.layers[3].revision == loaded + 1);
+}
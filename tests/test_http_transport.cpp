@@ -0,0 +1,266 @@
+#include <catch2/catch_test_macros.hpp>
+#include "http/HttpTransport.h"
+#include "http/HttpClient.h"
+#include "LocalHttpServer.h"
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+LocalHttpServer::Response echo(const LocalHttpServer::Request& req)
+{
+    LocalHttpServer::Response r;
+    if (req.target == "/missing") {
+        r.status = 404;
+        r.body = "nope";
+    } else if (req.target == "/big") {
+        r.body.assign(1 << 20, 'x');
+        r.chunkBytes = 64 * 1024;
+    } else if (req.target == "/chunked") {
+        auto left = std::make_shared<int>(100);
+        r.stream = [left](std::string& piece) {
+            piece.assign(1000, static_cast<char>('a' + *left % 26));
+            return --*left > 0;
+        };
+    } else if (req.target == "/paced") {
+        r.body.assign(64 * 1024, 'p');
+        r.bytesPerSecond = 640.0 * 1024;
+    } else if (req.target == "/slow") {
+        r.delayMs = 2000;
+        r.body = "late";
+    } else {
+        r.body = req.method + " " + req.target + " " + req.header("x-api-key") + " " + req.body;
+    }
+    return r;
+}
+
+} // namespace
+
+TEST_CASE("HttpTransport performs GET and reports status", "[http_transport]") {
+    LocalHttpServer server(echo);
+    HttpTransport transport;
+
+    HttpTransport::Request req;
+    req.url = server.url() + "/hello?x=1";
+    auto resp = transport.perform(req);
+    REQUIRE(resp.ok());
+    REQUIRE(resp.status == 200);
+    REQUIRE(resp.body == "GET /hello?x=1  ");
+
+    req.url = server.url() + "/missing";
+    resp = transport.perform(req);
+    REQUIRE_FALSE(resp.ok());
+    REQUIRE(resp.error.empty());
+    REQUIRE(resp.status == 404);
+}
+
+TEST_CASE("HttpTransport sends POST body and headers", "[http_transport]") {
+    LocalHttpServer server(echo);
+    HttpTransport transport;
+
+    HttpTransport::Request req;
+    req.url = server.url() + "/q";
+    req.method = HttpTransport::Method::Post;
+    req.body = "{\"a\":1}";
+    req.headers = {"X-API-Key: k1"};
+    auto resp = transport.perform(req);
+    REQUIRE(resp.ok());
+    REQUIRE(resp.body == "POST /q k1 {\"a\":1}");
+}
+
+TEST_CASE("HttpTransport reads chunked and paced bodies", "[http_transport]") {
+    LocalHttpServer server(echo);
+    HttpTransport transport;
+
+    HttpTransport::Request req;
+    req.url = server.url() + "/chunked";
+    auto resp = transport.perform(req);
+    REQUIRE(resp.ok());
+    REQUIRE(resp.body.size() == 100 * 1000);
+    REQUIRE(resp.body.substr(0, 3) == "www");  // 100 % 26
+    REQUIRE(resp.body.substr(resp.body.size() - 3) == "bbb");
+
+    req.url = server.url() + "/paced";
+    auto t0 = std::chrono::steady_clock::now();
+    resp = transport.perform(req);
+    REQUIRE(resp.ok());
+    REQUIRE(resp.body.size() == 64 * 1024);
+    REQUIRE(std::chrono::steady_clock::now() - t0 >= std::chrono::milliseconds(90));
+}
+
+TEST_CASE("HttpTransport runs many requests on one reactor and reuses connections", "[http_transport]") {
+    LocalHttpServer server(echo);
+    HttpTransport transport;
+
+    const int n = 64;
+    std::vector<std::future<HttpTransport::Response>> futures;
+    for (int i = 0; i < n; ++i) {
+        HttpTransport::Request req;
+        req.url = server.url() + "/r" + std::to_string(i);
+        futures.push_back(transport.submitFuture(std::move(req)));
+    }
+    for (int i = 0; i < n; ++i) {
+        auto resp = futures[i].get();
+        REQUIRE(resp.ok());
+        REQUIRE(resp.body == "GET /r" + std::to_string(i) + "  ");
+    }
+    REQUIRE(server.requestsServed() == static_cast<size_t>(n));
+    REQUIRE(server.connectionsAccepted() <= 8);
+    REQUIRE(transport.inFlight() == 0);
+}
+
+TEST_CASE("HttpTransport pools easy handles and keeps one connection warm", "[http_transport]") {
+    LocalHttpServer server(echo);
+    HttpTransport transport;
+
+    for (int i = 0; i < 20; ++i) {
+        HttpTransport::Request req;
+        req.url = server.url() + "/seq";
+        REQUIRE(transport.perform(std::move(req)).ok());
+    }
+    REQUIRE(transport.handlesCreated() == 1);
+    REQUIRE(server.connectionsAccepted() == 1);
+
+    HttpTransport::Options opts = transport.options();
+    opts.handlePoolSize = 0;
+    opts.tcpKeepAliveIdleSec = 0;
+    transport.configure(opts);
+    REQUIRE(transport.options().handlePoolSize == 0);
+    for (int i = 0; i < 3; ++i) {
+        HttpTransport::Request req;
+        req.url = server.url() + "/seq";
+        REQUIRE(transport.perform(std::move(req)).ok());
+    }
+    // The pooled handle is used once more, then nothing is kept
+    REQUIRE(transport.handlesCreated() == 3);
+    REQUIRE(server.connectionsAccepted() == 1);  // connection cache lives on the multi
+}
+
+TEST_CASE("HttpTransport sends shared header lists", "[http_transport]") {
+    LocalHttpServer server(echo);
+    HttpTransport transport;
+    auto shared = std::make_shared<const HttpTransport::HeaderList>(
+        std::vector<std::string>{"X-API-Key: shared"});
+
+    HttpTransport::Request req;
+    req.url = server.url() + "/h";
+    req.sharedHeaders = shared;
+    REQUIRE(transport.perform(req).body == "GET /h shared ");
+
+    // Extra per-request headers are appended to the shared ones
+    std::string seen;
+    LocalHttpServer tagged([&seen](const LocalHttpServer::Request& r) {
+        seen = r.header("x-api-key") + "|" + r.header("x-extra");
+        return LocalHttpServer::Response{};
+    });
+    req.url = tagged.url() + "/h";
+    req.headers = {"X-Extra: 1"};
+    REQUIRE(transport.perform(req).ok());
+    REQUIRE(seen == "shared|1");
+}
+
+TEST_CASE("HttpTransport streams with pause and resume", "[http_transport]") {
+    LocalHttpServer server(echo);
+    HttpTransport transport;
+
+    std::atomic<size_t> received{0};
+    std::atomic<int> pauses{0};
+    std::atomic<bool> paused{false};
+    HttpTransport::RequestId id = 0;
+
+    HttpTransport::Request req;
+    req.url = server.url() + "/big";
+    req.onData = [&](const char*, size_t len) {
+        // Refuse every other chunk once, forcing a pause/resume cycle
+        if (!paused && pauses < 5) {
+            paused = true;
+            ++pauses;
+            return HttpTransport::DataAction::Pause;
+        }
+        paused = false;
+        received += len;
+        return HttpTransport::DataAction::Continue;
+    };
+
+    std::promise<HttpTransport::Response> done;
+    id = transport.submit(std::move(req), [&](HttpTransport::Response&& r) { done.set_value(std::move(r)); });
+    auto future = done.get_future();
+    while (future.wait_for(std::chrono::milliseconds(5)) != std::future_status::ready) {
+        if (paused) transport.resume(id);
+    }
+    auto resp = future.get();
+    REQUIRE(resp.ok());
+    REQUIRE(resp.body.empty());
+    REQUIRE(received == (1u << 20));
+    REQUIRE(pauses == 5);
+}
+
+TEST_CASE("HttpTransport cancel and abort", "[http_transport]") {
+    LocalHttpServer server(echo);
+    HttpTransport transport;
+
+    HttpTransport::Request slow;
+    slow.url = server.url() + "/slow";
+    std::promise<HttpTransport::Response> done;
+    auto id = transport.submit(slow, [&](HttpTransport::Response&& r) { done.set_value(std::move(r)); });
+    transport.cancel(id);
+    auto resp = done.get_future().get();
+    REQUIRE(resp.aborted);
+    REQUIRE_FALSE(resp.ok());
+
+    HttpTransport::Request big;
+    big.url = server.url() + "/big";
+    big.onData = [](const char*, size_t) { return HttpTransport::DataAction::Abort; };
+    resp = transport.perform(big);
+    REQUIRE(resp.aborted);
+    REQUIRE(resp.error.empty());
+}
+
+TEST_CASE("HttpTransport reports connection errors and shutdown", "[http_transport]") {
+    HttpTransport transport;
+    int deadPort;
+    {
+        LocalHttpServer server(echo);
+        deadPort = server.port();
+    }
+    HttpTransport::Request req;
+    req.url = "http://127.0.0.1:" + std::to_string(deadPort) + "/";
+    auto resp = transport.perform(req);
+    REQUIRE_FALSE(resp.error.empty());
+
+    transport.shutdown();
+    resp = transport.perform(req);
+    REQUIRE_FALSE(resp.ok());
+    REQUIRE_FALSE(resp.error.empty());
+}
+
+TEST_CASE("HttpClient runs over the shared transport", "[http_transport]") {
+    LocalHttpServer server([](const LocalHttpServer::Request& req) {
+        LocalHttpServer::Response r;
+        if (req.target == "/json") r.body = R"({"ok": true})";
+        else if (req.target == "/lines") r.body = "a\n\nbb\nccc";
+        else if (req.target == "/bytes") r.body = std::string("\x00\x01\x02", 3);
+        else if (req.method == "POST") r.body = req.body;
+        else r.status = 500;
+        return r;
+    });
+    HttpClient client("secret");
+
+    REQUIRE(client.get(server.url() + "/json")["ok"] == true);
+    REQUIRE(client.post(server.url() + "/p", {{"n", 3}})["n"] == 3);
+    REQUIRE(client.get_bytes(server.url() + "/bytes") == std::vector<uint8_t>{0, 1, 2});
+    REQUIRE(client.get_bytes_async(server.url() + "/bytes").get().size() == 3);
+    REQUIRE(client.get_bytes_async(server.url() + "/fail").get().empty());
+    REQUIRE_THROWS(client.get(server.url() + "/fail"));
+
+    std::vector<std::string> lines;
+    client.get_stream(server.url() + "/lines", [&](std::string_view line) {
+        lines.emplace_back(line);
+        return true;
+    });
+    REQUIRE(lines == std::vector<std::string>{"a", "bb", "ccc"});
+}
@@ -0,0 +1,87 @@
+#include <catch2/catch_test_macros.hpp>
+#include "core/IdIndex.h"
+#include <string>
+#include <vector>
+
+namespace {
+
+std::string idOf(size_t i)
+{
+    return "0b5f3e1c-7a2d-4f11-9c3e-" + std::to_string(100000000000 + i);
+}
+
+} // namespace
+
+TEST_CASE("IdIndex finds every id it holds across growth", "[id_index]") {
+    std::vector<std::string> ids;
+    IdIndex index;
+    for (size_t i = 0; i < 20000; ++i) {
+        ids.push_back(idOf(i));
+        index.insert(IdIndex::hash(ids.back()), static_cast<uint32_t>(i));
+    }
+    REQUIRE(index.size() == 20000);
+
+    for (size_t i = 0; i < ids.size(); i += 7) {
+        const std::string& id = ids[i];
+        REQUIRE(index.find(IdIndex::hash(id), [&](uint32_t row) { return ids[row] == id; }) == i);
+    }
+    std::string missing = idOf(999999);
+    REQUIRE(index.find(IdIndex::hash(missing), [&](uint32_t row) { return ids[row] == missing; }) ==
+            IdIndex::kNone);
+
+    // 8 bytes a slot and a byte of filter per slot, at most 3/4 full
+    REQUIRE(index.memoryBytes() <= 9 * 32768);
+
+    index.clear();
+    REQUIRE(index.empty());
+    REQUIRE(index.memoryBytes() == 0);
+    REQUIRE_FALSE(index.mayContain(IdIndex::hash(ids[0])));
+}
+
+TEST_CASE("IdIndex returns the first entry of a repeated id", "[id_index]") {
+    std::vector<std::string> rows = {"a", "b", "a"};
+    IdIndex index;
+    for (size_t i = 0; i < rows.size(); ++i) index.insert(IdIndex::hash(rows[i]), static_cast<uint32_t>(i));
+    index.reserve(1000);  // rehashing keeps the order
+
+    auto first = [&](const std::string& id) {
+        return index.find(IdIndex::hash(id), [&](uint32_t row) { return rows[row] == id; });
+    };
+    REQUIRE(first("a") == 0);
+    REQUIRE(first("b") == 1);
+    // A match on the hash alone is not enough
+    REQUIRE(index.find(IdIndex::hash("a"), [](uint32_t row) { return row == 2; }) == 2);
+}
+
+TEST_CASE("IdIndex's filter rejects most ids it never saw", "[id_index]") {
+    IdIndex index;
+    for (size_t i = 0; i < 10000; ++i) index.insert(IdIndex::hash(idOf(i)), static_cast<uint32_t>(i));
+    for (size_t i = 0; i < 10000; ++i) REQUIRE(index.mayContain(IdIndex::hash(idOf(i))));
+
+    size_t falsePositives = 0;
+    for (size_t i = 10000; i < 20000; ++i) falsePositives += index.mayContain(IdIndex::hash(idOf(i)));
+    REQUIRE(falsePositives < 500);
+}
+
+TEST_CASE("IdIndex erase removes one entry and keeps the rest findable", "[id_index]") {
+    std::vector<std::string> ids;
+    IdIndex index;
+    for (size_t i = 0; i < 5000; ++i) {
+        ids.push_back(idOf(i));
+        index.insert(IdIndex::hash(ids.back()), static_cast<uint32_t>(i));
+    }
+    index.insert(IdIndex::hash(ids[10]), 5000);  // a second entry for one id
+    size_t bytes = index.memoryBytes();
+
+    for (size_t i = 3000; i < 5000; ++i) index.erase(IdIndex::hash(ids[i]), static_cast<uint32_t>(i));
+    index.erase(IdIndex::hash(ids[10]), 10);
+    index.erase(IdIndex::hash(ids[20]), 21);  // no such entry
+    REQUIRE(index.size() == 3000);
+    REQUIRE(index.memoryBytes() == bytes);
+
+    auto find = [&](size_t i) {
+        return index.find(IdIndex::hash(ids[i]), [&](uint32_t row) { return row == 5000 ? i == 10 : ids[row] == ids[i]; });
+    };
+    for (size_t i = 0; i < 3000; ++i) REQUIRE(find(i) == (i == 10 ? 5000 : i));
+    for (size_t i = 3000; i < 5000; ++i) REQUIRE(find(i) == IdIndex::kNone);
+}
@@ -0,0 +1,45 @@
+#include <catch2/catch_test_macros.hpp>
+#include "core/ImageScale.h"
+
+namespace {
+
+std::vector<uint8_t> solid(int width, int height, uint8_t r, uint8_t g, uint8_t b, uint8_t a)
+{
+    std::vector<uint8_t> px;
+    for (int i = 0; i < width * height; ++i) px.insert(px.end(), {r, g, b, a});
+    return px;
+}
+
+} // namespace
+
+TEST_CASE("Box downscale by an integer factor averages each block", "[image_scale]") {
+    // 4x2 -> 2x1: left block black/white checker, right block all 200
+    std::vector<uint8_t> src = {
+          0,   0,   0, 255,  255, 255, 255, 255,  200, 200, 200, 255,  200, 200, 200, 255,
+        255, 255, 255, 255,    0,   0,   0, 255,  200, 200, 200, 255,  200, 200, 200, 255,
+    };
+    auto out = ImageScale::downscaleBox(src.data(), 4, 2, 2, 1);
+    REQUIRE(out == std::vector<uint8_t>{128, 128, 128, 255, 200, 200, 200, 255});
+}
+
+TEST_CASE("Box downscale weights partly covered pixels", "[image_scale]") {
+    // 3 -> 2 wide: each output covers one pixel and half of the middle one
+    std::vector<uint8_t> src = {
+        0, 0, 0, 255,  90, 90, 90, 255,  240, 240, 240, 255,
+    };
+    auto out = ImageScale::downscaleBox(src.data(), 3, 1, 2, 1);
+    REQUIRE(out == std::vector<uint8_t>{30, 30, 30, 255, 190, 190, 190, 255});
+}
+
+TEST_CASE("Box downscale keeps a flat image flat", "[image_scale]") {
+    auto src = solid(1000, 750, 12, 34, 56, 78);
+    int height = ImageScale::fitHeight(1000, 750, 384);
+    REQUIRE(height == 288);
+    auto out = ImageScale::downscaleBox(src.data(), 1000, 750, 384, height);
+    REQUIRE(out == solid(384, 288, 12, 34, 56, 78));
+}
+
+TEST_CASE("fitHeight never returns zero", "[image_scale]") {
+    REQUIRE(ImageScale::fitHeight(4000, 10, 100) == 1);
+    REQUIRE(ImageScale::fitHeight(640, 480, 640) == 480);
+}
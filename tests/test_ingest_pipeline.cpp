@@ -0,0 +1,183 @@
+#include <catch2/catch_test_macros.hpp>
+#include "http/IngestPipeline.h"
+#include "core/TimeUtils.h"
+#include <zlib.h>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+std::string makeExport(size_t n)
+{
+    std::string body = "{\"total\": " + std::to_string(n) + "}\n";
+    for (size_t i = 0; i < n; ++i) {
+        body += "{\"id\":\"e" + std::to_string(i) + "\",\"t_start\":\"" +
+                TimeUtils::to_iso8601(1600000000.0 + static_cast<double>(i)) +
+                "\",\"t_end\":null,\"lat\":34.0,\"lon\":-118.0}\n";
+    }
+    return body;
+}
+
+std::string gzip(const std::string& in)
+{
+    z_stream zs{};
+    deflateInit2(&zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY);
+    std::string out(deflateBound(&zs, static_cast<uLong>(in.size())), '\0');
+    zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(in.data()));
+    zs.avail_in = static_cast<uInt>(in.size());
+    zs.next_out = reinterpret_cast<Bytef*>(out.data());
+    zs.avail_out = static_cast<uInt>(out.size());
+    deflate(&zs, Z_FINISH);
+    out.resize(zs.total_out);
+    deflateEnd(&zs);
+    return out;
+}
+
+// Feed body in random-sized chunks, as curl would.
+void feed(IngestPipeline& pipeline, const std::string& body, unsigned seed)
+{
+    std::mt19937 rng(seed);
+    size_t pos = 0;
+    while (pos < body.size()) {
+        size_t len = std::min<size_t>(1 + rng() % 5000, body.size() - pos);
+        if (!pipeline.push(body.data() + pos, len)) break;
+        pos += len;
+    }
+}
+
+IngestPipeline::Config smallSlabs()
+{
+    IngestPipeline::Config cfg;
+    cfg.parseWorkers = 4;
+    cfg.slabBytes = 4096;  // many slabs so ordering is exercised
+    cfg.queueDepth = 2;
+    return cfg;
+}
+
+} // namespace
+
+TEST_CASE("IngestPipeline delivers plain NDJSON in order", "[ingest_pipeline]") {
+    const size_t n = 5000;
+    size_t total = 0;
+    std::vector<std::string> ids;
+    size_t batches = 0;
+
+    IngestPipeline pipeline(
+        [&](size_t t) { total = t; },
+        [&](std::vector<Entity>&& batch) {
+            ++batches;
+            for (auto& e : batch) ids.push_back(e.id);
+            return true;
+        },
+        smallSlabs());
+    feed(pipeline, makeExport(n), 1);
+    pipeline.finish();
+
+    REQUIRE(total == n);
+    REQUIRE(batches > 1);
+    REQUIRE(ids.size() == n);
+    for (size_t i = 0; i < n; ++i) REQUIRE(ids[i] == "e" + std::to_string(i));
+}
+
+TEST_CASE("IngestPipeline inflates gzip bodies", "[ingest_pipeline]") {
+    const size_t n = 3000;
+    size_t total = 0;
+    std::vector<Entity> all;
+
+    IngestPipeline pipeline(
+        [&](size_t t) { total = t; },
+        [&](std::vector<Entity>&& batch) {
+            all.insert(all.end(), batch.begin(), batch.end());
+            return true;
+        },
+        smallSlabs());
+    feed(pipeline, gzip(makeExport(n)), 2);
+    pipeline.finish();
+
+    REQUIRE(total == n);
+    REQUIRE(all.size() == n);
+    for (size_t i = 0; i < n; ++i) {
+        REQUIRE(all[i].id == "e" + std::to_string(i));
+        REQUIRE(all[i].time_start == 1600000000.0 + static_cast<double>(i));
+        REQUIRE(*all[i].lat == 34.0);
+    }
+}
+
+TEST_CASE("IngestPipeline delivers columns when asked", "[ingest_pipeline]") {
+    const size_t n = 4000;
+    size_t total = 0;
+    size_t rows = 0;
+    bool inOrder = true;
+
+    IngestPipeline pipeline(
+        [&](size_t t) { total = t; },
+        [&](EntityColumns&& batch) {
+            for (size_t i = 0; i < batch.size(); ++i, ++rows) {
+                inOrder = inOrder && batch.idAt(i) == "e" + std::to_string(rows) &&
+                          batch.time_start[i] == 1600000000.0 + static_cast<double>(rows) &&
+                          batch.hasLocation(i) && batch.lat[i] == 34.0;
+            }
+            return true;
+        },
+        smallSlabs());
+    feed(pipeline, gzip(makeExport(n)), 4);
+    pipeline.finish();
+
+    REQUIRE(total == n);
+    REQUIRE(rows == n);
+    REQUIRE(inOrder);
+}
+
+TEST_CASE("IngestPipeline handles a final line without newline and bad lines", "[ingest_pipeline]") {
+    std::string body =
+        "{\"total\": 2}\n"
+        "{\"id\":\"a\",\"t_start\":\"2020-01-01T00:00:00Z\"}\n"
+        "garbage\n"
+        "\n"
+        "{\"id\":\"b\",\"t_start\":\"2020-01-01T00:00:01Z\"}";
+    std::vector<std::string> ids;
+    IngestPipeline pipeline(nullptr, [&](std::vector<Entity>&& batch) {
+        for (auto& e : batch) ids.push_back(e.id);
+        return true;
+    });
+    pipeline.push(body.data(), body.size());
+    pipeline.finish();
+
+    REQUIRE(ids == std::vector<std::string>{"a", "b"});
+}
+
+TEST_CASE("IngestPipeline stops when the consumer returns false", "[ingest_pipeline]") {
+    size_t batches = 0;
+    IngestPipeline pipeline(nullptr, [&](std::vector<Entity>&&) {
+        ++batches;
+        return false;
+    }, smallSlabs());
+
+    std::string body = makeExport(20000);
+    feed(pipeline, body, 3);
+    pipeline.finish();
+
+    REQUIRE(batches == 1);
+    REQUIRE(pipeline.cancelled());
+    REQUIRE_FALSE(pipeline.push("x", 1));
+}
+
+TEST_CASE("IngestPipeline reports corrupt gzip", "[ingest_pipeline]") {
+    std::string gz = gzip(makeExport(100));
+    gz.resize(gz.size() / 2);  // truncated
+
+    IngestPipeline pipeline(nullptr, [](std::vector<Entity>&&) { return true; });
+    pipeline.push(gz.data(), gz.size());
+    REQUIRE_THROWS_AS(pipeline.finish(), std::runtime_error);
+}
+
+TEST_CASE("IngestPipeline destructor cancels mid-stream", "[ingest_pipeline]") {
+    std::string body = makeExport(2000);
+    {
+        IngestPipeline pipeline(nullptr, [](std::vector<Entity>&&) { return true; }, smallSlabs());
+        pipeline.push(body.data(), body.size() / 2);
+    }  // must join without finish()
+    SUCCEED();
+}
@@ -0,0 +1,86 @@
+#include <catch2/catch_test_macros.hpp>
+#include "core/LineReader.h"
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+std::vector<std::string> splitAll(const std::string& body, size_t chunk)
+{
+    LineReader reader;
+    std::vector<std::string> lines;
+    auto collect = [&](std::string_view line) {
+        lines.emplace_back(line);
+        return true;
+    };
+    for (size_t pos = 0; pos < body.size(); pos += chunk)
+        reader.feed(body.data() + pos, std::min(chunk, body.size() - pos), collect);
+    reader.finish(collect);
+    return lines;
+}
+
+} // namespace
+
+TEST_CASE("LineReader splits lines within one chunk", "[line_reader]") {
+    auto lines = splitAll("a\nbb\n\nccc\n", 1000);
+    REQUIRE(lines == std::vector<std::string>{"a", "bb", "", "ccc"});
+}
+
+TEST_CASE("LineReader stitches lines across chunks", "[line_reader]") {
+    std::string body = "first line\nsecond\nthird and last";
+    std::vector<std::string> expected{"first line", "second", "third and last"};
+    for (size_t chunk = 1; chunk <= body.size(); ++chunk)
+        REQUIRE(splitAll(body, chunk) == expected);
+}
+
+TEST_CASE("LineReader reports pending bytes and finish flushes them", "[line_reader]") {
+    LineReader reader;
+    size_t count = 0;
+    auto onLine = [&](std::string_view) { ++count; return true; };
+
+    reader.feed(std::string_view("abc\nde"), onLine);
+    REQUIRE(count == 1);
+    REQUIRE(reader.pending() == 2);
+
+    std::string last;
+    reader.finish([&](std::string_view line) { last = line; return true; });
+    REQUIRE(last == "de");
+    REQUIRE(reader.pending() == 0);
+}
+
+TEST_CASE("LineReader stops when the callback returns false", "[line_reader]") {
+    LineReader reader;
+    std::vector<std::string> seen;
+    bool ok = reader.feed(std::string_view("1\n2\n3\n"), [&](std::string_view line) {
+        seen.emplace_back(line);
+        return seen.size() < 2;
+    });
+    REQUIRE_FALSE(ok);
+    REQUIRE(seen == std::vector<std::string>{"1", "2"});
+}
+
+TEST_CASE("LineReader matches a naive split for random chunking", "[line_reader]") {
+    std::mt19937 rng(11);
+    std::string body;
+    std::vector<std::string> expected;
+    for (int i = 0; i < 500; ++i) {
+        std::string line(rng() % 300, static_cast<char>('a' + i % 26));
+        expected.push_back(line);
+        body += line + "\n";
+    }
+
+    LineReader reader;
+    std::vector<std::string> lines;
+    size_t pos = 0;
+    while (pos < body.size()) {
+        size_t len = std::min<size_t>(1 + rng() % 700, body.size() - pos);
+        reader.feed(body.data() + pos, len, [&](std::string_view line) {
+            lines.emplace_back(line);
+            return true;
+        });
+        pos += len;
+    }
+    REQUIRE(reader.pending() == 0);
+    REQUIRE(lines == expected);
+}
@@ -0,0 +1,102 @@
+#include <catch2/catch_test_macros.hpp>
+#include "core/MpscRing.h"
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+TEST_CASE("MpscRing is FIFO and bounded", "[mpsc_ring]") {
+    MpscRing<int> q(3);
+    REQUIRE(q.capacity() == 4);  // rounded up to a power of two
+
+    for (int i = 0; i < 4; ++i) {
+        int v = i;
+        REQUIRE(q.tryPush(v));
+    }
+    int extra = 99;
+    REQUIRE_FALSE(q.tryPush(extra));
+    REQUIRE(extra == 99);  // left untouched
+    REQUIRE(q.size() == 4);
+
+    int v = -1;
+    REQUIRE(q.tryPop(v));
+    REQUIRE(v == 0);
+    REQUIRE(q.tryPush(extra));
+    for (int expected : {1, 2, 3, 99}) {
+        REQUIRE(q.tryPop(v));
+        REQUIRE(v == expected);
+    }
+    REQUIRE_FALSE(q.tryPop(v));
+    REQUIRE(q.size() == 0);
+    REQUIRE(q.stats().highWater == 4);
+}
+
+TEST_CASE("MpscRing releases what a popped item owned", "[mpsc_ring]") {
+    MpscRing<std::vector<int>> q(2);
+    q.push(std::vector<int>(1000, 7));
+    std::vector<int> out;
+    REQUIRE(q.tryPop(out));
+    REQUIRE(out.size() == 1000);
+    // The slot no longer holds a copy: popping again finds nothing
+    REQUIRE_FALSE(q.tryPop(out));
+}
+
+TEST_CASE("MpscRing delivers every item once under contention", "[mpsc_ring]") {
+    MpscRing<std::pair<int, int>> q(8);
+    constexpr int kProducers = 4;
+    constexpr int kItems = 20000;
+
+    std::vector<std::thread> producers;
+    for (int p = 0; p < kProducers; ++p)
+        producers.emplace_back([&q, p] {
+            for (int i = 0; i < kItems; ++i) q.push({p, i});
+        });
+
+    std::vector<int> next(kProducers, 0);
+    int received = 0;
+    std::pair<int, int> item;
+    while (received < kProducers * kItems) {
+        if (!q.tryPop(item)) {
+            std::this_thread::yield();
+            continue;
+        }
+        REQUIRE(item.second == next[item.first]);  // each producer's order is kept
+        ++next[item.first];
+        ++received;
+    }
+    for (auto& t : producers) t.join();
+
+    auto stats = q.stats();
+    REQUIRE(stats.depth == 0);
+    REQUIRE(stats.highWater <= q.capacity());
+    REQUIRE(stats.stalls > 0);  // 4 producers outrun one consumer through 8 slots
+}
+
+TEST_CASE("MpscRing push waits for space, or gives up when told to", "[mpsc_ring]") {
+    MpscRing<int> q(2);
+    q.push(1);
+    q.push(2);
+
+    SECTION("a pop lets a blocked producer through") {
+        std::atomic<bool> pushed{false};
+        std::thread producer([&] { pushed = q.push(3); });
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        REQUIRE_FALSE(pushed);
+        int v;
+        REQUIRE(q.tryPop(v));
+        producer.join();
+        REQUIRE(pushed);
+        REQUIRE(q.stats().stallSeconds > 0.01);
+    }
+
+    SECTION("stop drops the item") {
+        std::atomic<bool> stop{false};
+        bool pushed = true;
+        std::thread producer([&] { pushed = q.push(3, [&stop] { return stop.load(); }); });
+        stop = true;
+        producer.join();
+        REQUIRE_FALSE(pushed);
+        REQUIRE(q.size() == 2);
+    }
+}
@@ -0,0 +1,174 @@
+#include <catch2/catch_test_macros.hpp>
+#include "SyntheticBackend.h"
+#include <algorithm>
+#include <set>
+#include <stdexcept>
+
+namespace {
+
+constexpr double kDay = 86400.0;
+
+/// Ninety days from 2020-01-01 at 500 GPS samples a day
+SyntheticBackend::Config smallWorld(unsigned threads = 0)
+{
+    SyntheticBackend::Config c;
+    c.seed = 7;
+    c.start = 1577836800.0;
+    c.end = c.start + 90 * kDay;
+    c.gpsPoints = 90 * 500;
+    c.batchRows = 2000;
+    c.threads = threads;
+    return c;
+}
+
+bool sameEntities(const std::vector<Entity>& a, const std::vector<Entity>& b)
+{
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (a[i].id != b[i].id || a[i].time_start != b[i].time_start || a[i].time_end != b[i].time_end ||
+            a[i].lat != b[i].lat || a[i].lon != b[i].lon || a[i].name != b[i].name || a[i].color != b[i].color)
+            return false;
+    }
+    return true;
+}
+
+} // namespace
+
+TEST_CASE("SyntheticBackend output depends only on the seed", "[synthetic_backend]") {
+    for (const char* type : {"location.gps", "photo", "calendar.event", "location.googletimeline"}) {
+        SyntheticBackend one(type, smallWorld(1));
+        SyntheticBackend many(type, smallWorld(8));
+        auto a = one.generate(0.0, 2e9);
+        REQUIRE(!a.empty());
+        REQUIRE(sameEntities(a, many.generate(0.0, 2e9)));
+
+        auto other = smallWorld();
+        other.seed = 8;
+        REQUIRE_FALSE(sameEntities(a, SyntheticBackend(type, other).generate(0.0, 2e9)));
+    }
+}
+
+TEST_CASE("SyntheticBackend ranges are slices of the whole", "[synthetic_backend]") {
+    SyntheticBackend gps("location.gps", smallWorld());
+    auto all = gps.generate(0.0, 2e9);
+    double from = gps.config().start + 20.3 * kDay;
+    double to = gps.config().start + 41.7 * kDay;
+
+    std::vector<Entity> expected;
+    std::copy_if(all.begin(), all.end(), std::back_inserter(expected),
+                 [&](const Entity& e) { return e.time_start >= from && e.time_start <= to; });
+    REQUIRE(sameEntities(gps.generate(from, to), expected));
+    REQUIRE(gps.count(from, to) == expected.size());
+}
+
+TEST_CASE("SyntheticBackend streams in time order with unique ids", "[synthetic_backend]") {
+    for (const char* type : {"location.gps", "photo", "calendar.event", "location.googletimeline"}) {
+        SyntheticBackend backend(type, smallWorld());
+        size_t total = 0, received = 0;
+        double last = 0.0;
+        bool ordered = true;
+        std::set<std::string> ids;
+        backend.streamAllEntities(
+            [&](size_t n) { total = n; },
+            [&](std::vector<Entity>&& batch) {
+                received += batch.size();
+                for (const auto& e : batch) {
+                    ordered = ordered && e.time_start >= last;
+                    last = e.time_start;
+                    ids.insert(e.id);
+                    REQUIRE(e.id.size() == 16);
+                    REQUIRE(e.time_end >= e.time_start);
+                }
+            });
+        REQUIRE(backend.lastStreamComplete());
+        REQUIRE(total == received);
+        REQUIRE(ids.size() == received);
+        REQUIRE(ordered);
+        REQUIRE(backend.fetchStats().total_entities == static_cast<int>(total));
+    }
+}
+
+TEST_CASE("SyntheticBackend GPS follows an itinerary with gaps", "[synthetic_backend]") {
+    auto config = smallWorld();
+    SyntheticBackend gps("location.gps", config);
+    auto points = gps.generate(0.0, 2e9);
+
+    // Roughly the requested size
+    REQUIRE(points.size() > config.gpsPoints * 8 / 10);
+    REQUIRE(points.size() < config.gpsPoints * 12 / 10);
+
+    size_t longGaps = 0, fast = 0;
+    for (size_t i = 1; i < points.size(); ++i) {
+        REQUIRE(points[i].has_location());
+        double dt = points[i].time_start - points[i - 1].time_start;
+        if (dt > 3600.0) ++longGaps;
+        double dlat = (*points[i].lat - *points[i - 1].lat) * 111320.0;
+        if (dt > 0.0 && dt < 3600.0 && std::abs(dlat) / dt > 200.0) ++fast;
+    }
+    REQUIRE(longGaps > 0);             // outages and phone-off days
+    REQUIRE(fast < points.size() / 100);  // a continuous track, not noise
+}
+
+TEST_CASE("SyntheticBackend layers carry their display fields", "[synthetic_backend]") {
+    auto events = SyntheticBackend("calendar.event", smallWorld()).generate(0.0, 2e9);
+    REQUIRE(std::all_of(events.begin(), events.end(), [](const Entity& e) {
+        return e.name && e.color && e.color->size() == 7 && e.duration() > 0.0;
+    }));
+
+    auto timeline = SyntheticBackend("location.googletimeline", smallWorld()).generate(0.0, 2e9);
+    std::set<std::string> names;
+    for (const auto& e : timeline) {
+        REQUIRE(e.has_location());
+        names.insert(*e.name);
+    }
+    REQUIRE(names.count("Home"));
+    REQUIRE(names.count("Work"));
+    REQUIRE((names.count("Driving") || names.count("Walking")));
+
+    auto photos = SyntheticBackend("photo", smallWorld()).generate(0.0, 2e9);
+    REQUIRE(std::all_of(photos.begin(), photos.end(), [](const Entity& e) {
+        return e.has_location() && e.is_instant() && e.name;
+    }));
+    auto thumb = SyntheticBackend("photo", smallWorld()).fetchPhotoThumb(photos.front().id);
+    REQUIRE(thumb.size() > 54);
+    REQUIRE(thumb[0] == 'B');
+    REQUIRE(thumb[1] == 'M');
+}
+
+TEST_CASE("SyntheticBackend fetchEntities filters by region", "[synthetic_backend]") {
+    SyntheticBackend gps("location.gps", smallWorld());
+    auto all = gps.generate(0.0, 2e9);
+    const Entity& probe = all[all.size() / 2];
+
+    SpatialExtent space;
+    space.min_lat = *probe.lat - 0.05;
+    space.max_lat = *probe.lat + 0.05;
+    space.min_lon = *probe.lon - 0.05;
+    space.max_lon = *probe.lon + 0.05;
+    TimeExtent time{probe.time_start - kDay, probe.time_start + kDay};
+
+    size_t inside = 0;
+    gps.fetchEntities(time, space, [&](std::vector<Entity>&& batch) {
+        for (const auto& e : batch) {
+            REQUIRE(time.contains(e.time_start));
+            REQUIRE(*e.lat >= space.min_lat);
+            REQUIRE(*e.lon <= space.max_lon);
+        }
+        inside += batch.size();
+    });
+    REQUIRE(inside > 0);
+}
+
+TEST_CASE("SyntheticBackend stops when cancelled", "[synthetic_backend]") {
+    SyntheticBackend gps("location.gps", smallWorld());
+    size_t batches = 0;
+    gps.streamAllEntities(nullptr, [&](std::vector<Entity>&&) {
+        if (++batches == 2) gps.cancelFetch();
+    });
+    REQUIRE(batches == 2);
+    REQUIRE_FALSE(gps.lastStreamComplete());
+}
+
+TEST_CASE("SyntheticBackend rejects unknown types", "[synthetic_backend]") {
+    REQUIRE_THROWS_AS(SyntheticBackend("location.unknown"), std::runtime_error);
+}
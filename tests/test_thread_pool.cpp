@@ -0,0 +1,43 @@
+#include <catch2/catch_test_macros.hpp>
+#include "core/ThreadPool.h"
+#include <atomic>
+#include <mutex>
+#include <set>
+#include <thread>
+
+TEST_CASE("ThreadPool runs every submitted task", "[thread_pool]") {
+    std::atomic<int> count{0};
+    {
+        ThreadPool pool(3);
+        REQUIRE(pool.size() == 3);
+        for (int i = 0; i < 1000; ++i)
+            pool.submit([&count] { ++count; });
+    }  // destructor drains the queue before joining
+    REQUIRE(count == 1000);
+}
+
+TEST_CASE("ThreadPool runs tasks off the calling thread", "[thread_pool]") {
+    std::mutex m;
+    std::set<std::thread::id> ids;
+    {
+        ThreadPool pool(2);
+        for (int i = 0; i < 50; ++i)
+            pool.submit([&] {
+                std::lock_guard<std::mutex> lock(m);
+                ids.insert(std::this_thread::get_id());
+            });
+    }
+    REQUIRE_FALSE(ids.empty());
+    REQUIRE(ids.size() <= 2);
+    REQUIRE(ids.count(std::this_thread::get_id()) == 0);
+}
+
+TEST_CASE("ThreadPool with zero threads still makes progress", "[thread_pool]") {
+    std::atomic<bool> ran{false};
+    {
+        ThreadPool pool(0);
+        REQUIRE(pool.size() == 1);
+        pool.submit([&ran] { ran = true; });
+    }
+    REQUIRE(ran);
+}
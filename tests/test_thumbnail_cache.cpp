@@ -0,0 +1,278 @@
+#include <catch2/catch_test_macros.hpp>
+#include "ThumbnailCache.h"
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <thread>
+
+namespace {
+
+namespace fs = std::filesystem;
+
+struct TempDir {
+    fs::path path;
+    TempDir() {
+        path = fs::temp_directory_path() / ("reckoner_thumb_cache_test_" + std::to_string(std::random_device{}()));
+        fs::remove_all(path);
+    }
+    ~TempDir() {
+        std::error_code ec;
+        fs::remove_all(path, ec);
+    }
+};
+
+/// Backend stand-in: "img:<id>" for every id except "bad", optionally held
+/// back until the gate opens.  Records the order of fetches and how many
+/// ran at once.
+struct FakeThumbs {
+    std::mutex mutex;
+    std::vector<std::string> fetched;
+    int running = 0;
+    int maxRunning = 0;
+    std::promise<void> gate;
+    std::shared_future<void> opened = gate.get_future().share();
+
+    FakeThumbs(bool held = false) {
+        if (!held) gate.set_value();
+    }
+
+    ThumbnailCache::Fetcher fetcher() {
+        return [this](const std::string& id) {
+            return std::async(std::launch::deferred, [this, id] {
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    fetched.push_back(id);
+                    maxRunning = std::max(maxRunning, ++running);
+                }
+                opened.wait();
+                std::lock_guard<std::mutex> lock(mutex);
+                --running;
+                if (id == "bad") return std::vector<uint8_t>{};
+                std::string body = "img:" + id;
+                return std::vector<uint8_t>(body.begin(), body.end());
+            });
+        };
+    }
+
+    std::vector<std::string> order() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return fetched;
+    }
+};
+
+/// One byte wide per encoded byte, one pixel high
+bool fakeDecode(const std::vector<uint8_t>& encoded, Thumbnail& out)
+{
+    out.width = static_cast<int>(encoded.size());
+    out.height = 1;
+    out.rgba.assign(encoded.size() * 4, 0xff);
+    return true;
+}
+
+ThumbnailCache::Config config(size_t maxConcurrent = 4, std::string dir = "")
+{
+    ThumbnailCache::Config c;
+    c.maxConcurrent = maxConcurrent;
+    c.diskDir = std::move(dir);
+    return c;
+}
+
+/// Poll until none of `ids` is queued or loading.
+void settle(ThumbnailCache& cache, const std::vector<std::string>& ids)
+{
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    for (;;) {
+        cache.poll();
+        bool busy = std::any_of(ids.begin(), ids.end(), [&](const std::string& id) {
+            auto s = cache.state(id);
+            return s == ThumbnailCache::State::Queued || s == ThumbnailCache::State::Loading;
+        });
+        if (!busy) return;
+        REQUIRE(std::chrono::steady_clock::now() < deadline);
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+} // namespace
+
+TEST_CASE("ThumbnailCache serves repeats from memory, then from disk", "[thumbnail_cache]") {
+    TempDir dir;
+    FakeThumbs backend;
+    {
+        ThumbnailCache cache(fakeDecode, config(4, dir.path.string()));
+        cache.setFetcher(backend.fetcher());
+        cache.request("p1");
+        settle(cache, {"p1"});
+        auto thumb = cache.get("p1");
+        REQUIRE(thumb);
+        REQUIRE(thumb->width == 6);  // "img:p1"
+
+        cache.request("p1");
+        REQUIRE(cache.state("p1") == ThumbnailCache::State::Ready);
+        REQUIRE(backend.order().size() == 1);
+        REQUIRE(cache.stats().fetches == 1);
+    }
+
+    // A new session finds it on disk
+    ThumbnailCache cache(fakeDecode, config(4, dir.path.string()));
+    cache.setFetcher(backend.fetcher());
+    cache.request("p1");
+    settle(cache, {"p1"});
+    REQUIRE(cache.get("p1"));
+    REQUIRE(backend.order().size() == 1);
+    REQUIRE(cache.stats().diskHits == 1);
+}
+
+TEST_CASE("ThumbnailCache evicts the least recently used past its byte cap", "[thumbnail_cache]") {
+    FakeThumbs backend;
+    auto c = config();
+    c.memoryBytes = 3 * 5 * 4;  // three "img:x" thumbnails
+    ThumbnailCache cache(fakeDecode, c);
+    cache.setFetcher(backend.fetcher());
+
+    for (const char* id : {"a", "b", "c"}) cache.request(id);
+    settle(cache, {"a", "b", "c"});
+    REQUIRE(cache.stats().entries == 3);
+
+    REQUIRE(cache.get("a"));  // now b is the oldest
+    cache.request("d");
+    settle(cache, {"d"});
+    REQUIRE(cache.stats().entries == 3);
+    REQUIRE(cache.stats().bytes <= c.memoryBytes);
+    REQUIRE(cache.state("b") == ThumbnailCache::State::Missing);
+    REQUIRE(cache.get("a"));
+    REQUIRE(cache.get("c"));
+    REQUIRE(cache.get("d"));
+}
+
+TEST_CASE("ThumbnailCache caps concurrent loads", "[thumbnail_cache]") {
+    FakeThumbs backend(true);
+    ThumbnailCache cache(fakeDecode, config(3));
+    cache.setFetcher(backend.fetcher());
+
+    std::vector<std::string> ids = {"n1", "n2", "n3", "n4", "n5", "n6"};
+    cache.prefetch(ids);
+    cache.poll();
+    REQUIRE(cache.state("n1") == ThumbnailCache::State::Loading);
+    REQUIRE(cache.state("n2") == ThumbnailCache::State::Loading);
+    REQUIRE(cache.state("n3") == ThumbnailCache::State::Queued);  // the slot left for requests
+
+    cache.request("n6");
+    REQUIRE(cache.state("n6") == ThumbnailCache::State::Loading);
+
+    backend.gate.set_value();
+    settle(cache, ids);
+    REQUIRE(cache.stats().entries == 6);
+    REQUIRE(backend.maxRunning <= 3);
+}
+
+TEST_CASE("ThumbnailCache puts requests ahead of prefetches and cancels stale ones", "[thumbnail_cache]") {
+    FakeThumbs backend(true);
+    ThumbnailCache cache(fakeDecode, config(1));
+    cache.setFetcher(backend.fetcher());
+
+    cache.prefetch({"n1", "n2", "n3", "n4"});
+    cache.request("selected");
+    REQUIRE(cache.state("selected") == ThumbnailCache::State::Queued);
+    while (backend.order().empty()) std::this_thread::yield();  // n1 is fetching
+
+    // The view moved on: n1, n2 and n3 are no longer wanted
+    cache.prefetch({"n5", "n4"});
+    REQUIRE(cache.state("n2") == ThumbnailCache::State::Missing);
+    REQUIRE(cache.state("n3") == ThumbnailCache::State::Missing);
+
+    backend.gate.set_value();
+    settle(cache, {"n1", "selected", "n4", "n5"});
+    REQUIRE(backend.order() == std::vector<std::string>{"n1", "selected", "n5", "n4"});
+    REQUIRE(cache.state("n1") == ThumbnailCache::State::Missing);  // dropped before decoding
+}
+
+TEST_CASE("ThumbnailCache drops a running prefetch the view no longer names before decoding", "[thumbnail_cache]") {
+    TempDir dir;
+    FakeThumbs backend(true);
+    std::atomic<int> decoded{0};
+    auto decode = [&decoded](const std::vector<uint8_t>& encoded, Thumbnail& out) {
+        ++decoded;
+        return fakeDecode(encoded, out);
+    };
+    ThumbnailCache cache(decode, config(2, dir.path.string()));
+    cache.setFetcher(backend.fetcher());
+
+    cache.prefetch({"n1", "n2"});
+    while (backend.order().empty()) std::this_thread::yield();  // n1 is fetching
+    cache.prefetch({"n2", "n3"});
+
+    backend.gate.set_value();
+    settle(cache, {"n1", "n2", "n3"});
+    REQUIRE(cache.state("n1") == ThumbnailCache::State::Missing);  // not Failed
+    REQUIRE(cache.stats().cancelled == 1);
+    REQUIRE(cache.stats().failures == 0);
+    REQUIRE(decoded == 2);
+
+    // What it fetched was kept on disk
+    cache.request("n1");
+    settle(cache, {"n1"});
+    REQUIRE(cache.get("n1"));
+    REQUIRE(backend.order().size() == 3);
+    REQUIRE(cache.stats().diskHits == 1);
+}
+
+TEST_CASE("ThumbnailCache retries a failed thumbnail only on request", "[thumbnail_cache]") {
+    FakeThumbs backend;
+    ThumbnailCache cache(fakeDecode, config());
+    cache.setFetcher(backend.fetcher());
+
+    cache.request("bad");
+    settle(cache, {"bad"});
+    REQUIRE(cache.state("bad") == ThumbnailCache::State::Failed);
+    REQUIRE(cache.stats().failures == 1);
+
+    cache.prefetch({"bad"});
+    REQUIRE(cache.state("bad") == ThumbnailCache::State::Failed);
+
+    cache.request("bad");
+    settle(cache, {"bad"});
+    REQUIRE(backend.order().size() == 2);
+}
+
+TEST_CASE("ThumbnailCache cancelAndWait drops queued loads", "[thumbnail_cache]") {
+    FakeThumbs backend(true);
+    ThumbnailCache cache(fakeDecode, config(1));
+    cache.setFetcher(backend.fetcher());
+
+    cache.prefetch({"n1", "n2", "n3"});
+    while (backend.order().empty()) std::this_thread::yield();  // n1 is running
+    std::thread opener([&backend] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        backend.gate.set_value();
+    });
+    cache.cancelAndWait();
+    opener.join();
+
+    REQUIRE(backend.order() == std::vector<std::string>{"n1"});
+    REQUIRE(cache.state("n1") == ThumbnailCache::State::Ready);  // finished loads are kept
+    REQUIRE(cache.state("n2") == ThumbnailCache::State::Missing);
+}
+
+TEST_CASE("ThumbnailCache downscales loads to its max width", "[thumbnail_cache]") {
+    FakeThumbs backend;
+    auto c = config();
+    c.maxWidth = 8;
+    ThumbnailCache cache(fakeDecode, c);
+    cache.setFetcher(backend.fetcher());
+
+    cache.request("wide-image");  // "img:wide-image" decodes 14 wide
+    cache.request("p1");          // 6 wide, left alone
+    settle(cache, {"wide-image", "p1"});
+    REQUIRE(cache.get("wide-image")->width == 8);
+    REQUIRE(cache.get("wide-image")->rgba.size() == 8 * 4);
+    REQUIRE(cache.get("p1")->width == 6);
+
+    cache.setMaxWidth(4);
+    cache.request("p2");
+    settle(cache, {"p2"});
+    REQUIRE(cache.get("p2")->width == 4);
+    REQUIRE(cache.get("wide-image")->width == 8);
+}
@@ -0,0 +1,145 @@
+#include <catch2/catch_test_macros.hpp>
+#include "cache/ThumbnailStore.h"
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <thread>
+
+namespace {
+
+namespace fs = std::filesystem;
+
+struct TempDir {
+    fs::path path;
+    TempDir() {
+        path = fs::temp_directory_path() / ("reckoner_thumb_store_test_" + std::to_string(std::random_device{}()));
+        fs::remove_all(path);
+    }
+    ~TempDir() {
+        std::error_code ec;
+        fs::remove_all(path, ec);
+    }
+};
+
+std::vector<uint8_t> image(const std::string& s)
+{
+    return std::vector<uint8_t>(s.begin(), s.end());
+}
+
+size_t objectCount(const fs::path& dir)
+{
+    size_t n = 0;
+    for (const auto& entry : fs::recursive_directory_iterator(dir / "objects"))
+        if (entry.is_regular_file()) ++n;
+    return n;
+}
+
+} // namespace
+
+TEST_CASE("ThumbnailStore keeps thumbnails across reopening", "[thumbnail_store]") {
+    TempDir dir;
+    {
+        ThumbnailStore store(dir.path.string());
+        REQUIRE(store.get("p1").empty());
+        store.put("p1", image("jpeg one"));
+        store.put("p2", image("jpeg two"));
+        REQUIRE(store.get("p1") == image("jpeg one"));
+    }
+
+    ThumbnailStore reopened(dir.path.string());
+    REQUIRE(reopened.size() == 2);
+    REQUIRE(reopened.get("p1") == image("jpeg one"));
+    REQUIRE(reopened.get("p2") == image("jpeg two"));
+
+    // A newer thumbnail for an id replaces the old one
+    reopened.put("p1", image("jpeg one, re-encoded"));
+    ThumbnailStore again(dir.path.string());
+    REQUIRE(again.get("p1") == image("jpeg one, re-encoded"));
+}
+
+TEST_CASE("ThumbnailStore stores identical images once", "[thumbnail_store]") {
+    TempDir dir;
+    ThumbnailStore store(dir.path.string());
+    store.put("a", image("same bytes"));
+    store.put("b", image("same bytes"));
+    store.put("c", image("other bytes"));
+    REQUIRE(store.size() == 3);
+    REQUIRE(objectCount(dir.path) == 2);
+    REQUIRE(store.get("b") == image("same bytes"));
+}
+
+TEST_CASE("ThumbnailStore treats a damaged object as a miss", "[thumbnail_store]") {
+    TempDir dir;
+    ThumbnailStore store(dir.path.string());
+    store.put("p1", image("original"));
+
+    for (const auto& entry : fs::recursive_directory_iterator(dir.path / "objects"))
+        if (entry.is_regular_file()) std::ofstream(entry.path(), std::ios::trunc) << "garbage!";
+
+    REQUIRE(store.get("p1").empty());
+    REQUIRE(store.size() == 0);
+    REQUIRE(objectCount(dir.path) == 0);
+
+    // Storing it again repairs it
+    store.put("p1", image("original"));
+    REQUIRE(store.get("p1") == image("original"));
+}
+
+TEST_CASE("ThumbnailStore without a directory holds nothing", "[thumbnail_store]") {
+    ThumbnailStore store("");
+    store.put("p1", image("bytes"));
+    REQUIRE(store.get("p1").empty());
+    REQUIRE(store.size() == 0);
+}
+
+TEST_CASE("ThumbnailStore evicts the least recently used past its byte budget", "[thumbnail_store]") {
+    TempDir dir;
+    {
+        ThumbnailStore store(dir.path.string(), 30);  // three 10-byte images
+        store.put("a", image("aaaaaaaaaa"));
+        store.put("b", image("bbbbbbbbbb"));
+        store.put("c", image("cccccccccc"));
+        REQUIRE(store.bytes() == 30);
+
+        REQUIRE(store.get("a") == image("aaaaaaaaaa"));  // now b is the oldest
+        store.put("d", image("dddddddddd"));
+        REQUIRE(store.bytes() == 30);
+        REQUIRE(objectCount(dir.path) == 3);
+        REQUIRE(store.get("b").empty());
+        REQUIRE(store.get("a") == image("aaaaaaaaaa"));
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        REQUIRE(store.get("c") == image("cccccccccc"));
+    }
+
+    // The order survives reopening; a smaller budget evicts on open
+    ThumbnailStore reopened(dir.path.string(), 10);
+    REQUIRE(reopened.bytes() == 10);
+    REQUIRE(reopened.size() == 1);
+    REQUIRE(reopened.get("c") == image("cccccccccc"));
+    REQUIRE(reopened.get("a").empty());
+}
+
+TEST_CASE("ThumbnailStore rewrites an index of mostly superseded lines", "[thumbnail_store]") {
+    TempDir dir;
+    {
+        ThumbnailStore store(dir.path.string());
+        for (int i = 0; i < 2000; ++i) store.put("p" + std::to_string(i % 10), image("v" + std::to_string(i)));
+    }
+    auto indexLines = [&] {
+        std::ifstream in(dir.path / "index");
+        size_t n = 0;
+        for (std::string line; std::getline(in, line);) ++n;
+        return n;
+    };
+    REQUIRE(indexLines() == 2000);
+
+    ThumbnailStore reopened(dir.path.string());
+    REQUIRE(indexLines() == 10);
+    REQUIRE(reopened.size() == 10);
+    REQUIRE(reopened.get("p3") == image("v1993"));
+
+    ThumbnailStore again(dir.path.string());
+    REQUIRE(again.get("p3") == image("v1993"));
+}
@@ -1,6 +1,8 @@
 #include <catch2/catch_test_macros.hpp>
 #include <catch2/catch_approx.hpp>
 #include "core/TimeUtils.h"
+#include <cmath>
+#include <string>
 
 TEST_CASE("TimeUtils parse_iso8601 known epoch", "[time_utils]") {
     // 2020-01-01T00:00:00Z = 1577836800
@@ -29,3 +31,58 @@ TEST_CASE("TimeUtils unix epoch", "[time_utils]") {
     double ts = TimeUtils::parse_iso8601("1970-01-01T00:00:00Z");
     REQUIRE(ts == Catch::Approx(0.0));
 }
+
+TEST_CASE("TimeUtils days_from_civil known dates", "[time_utils]") {
+    REQUIRE(TimeUtils::days_from_civil(1970, 1, 1) == 0);
+    REQUIRE(TimeUtils::days_from_civil(2000, 3, 1) == 11017);
+    REQUIRE(TimeUtils::days_from_civil(1969, 12, 31) == -1);
+    REQUIRE(TimeUtils::days_from_civil(2024, 2, 29) == 19782);
+    REQUIRE(TimeUtils::days_from_civil(1600, 1, 1) == -135140);
+}
+
+TEST_CASE("TimeUtils parse fractional seconds", "[time_utils]") {
+    REQUIRE(TimeUtils::parse_iso8601("2020-01-01T00:00:00.5Z") == 1577836800.5);
+    REQUIRE(TimeUtils::parse_iso8601("2020-01-01T00:00:00.123456") == Catch::Approx(1577836800.123456));
+    REQUIRE(TimeUtils::parse_iso8601("1969-12-31T23:59:59.25Z") == -0.75);
+}
+
+TEST_CASE("TimeUtils parse zone offsets", "[time_utils]") {
+    double utc = 1577836800.0;
+    REQUIRE(TimeUtils::parse_iso8601("2020-01-01T00:00:00+00:00") == utc);
+    REQUIRE(TimeUtils::parse_iso8601("2020-01-01T02:00:00+02:00") == utc);
+    REQUIRE(TimeUtils::parse_iso8601("2019-12-31T16:00:00-08:00") == utc);
+    REQUIRE(TimeUtils::parse_iso8601("2020-01-01T05:30:00+0530") == utc);
+    REQUIRE(TimeUtils::parse_iso8601("2020-01-01T01:00:00.000+01") == utc);
+    REQUIRE(TimeUtils::parse_iso8601("2020-01-01 00:00:00Z") == utc);
+}
+
+TEST_CASE("TimeUtils rejects malformed timestamps", "[time_utils]") {
+    double ts = 42.0;
+    REQUIRE_FALSE(TimeUtils::try_parse_iso8601("", ts));
+    REQUIRE_FALSE(TimeUtils::try_parse_iso8601("2020-01-01", ts));
+    REQUIRE_FALSE(TimeUtils::try_parse_iso8601("2020-13-01T00:00:00Z", ts));
+    REQUIRE_FALSE(TimeUtils::try_parse_iso8601("2020-01-01T00:00:00Zjunk", ts));
+    REQUIRE_FALSE(TimeUtils::try_parse_iso8601("2020-01-01T00:00:00.Z", ts));
+    REQUIRE_FALSE(TimeUtils::try_parse_iso8601("2020/01/01T00:00:00Z", ts));
+    REQUIRE(ts == 42.0);
+    REQUIRE_THROWS(TimeUtils::parse_iso8601("yesterday"));
+}
+
+TEST_CASE("TimeUtils batch parse", "[time_utils]") {
+    std::string_view in[] = {
+        "2020-01-01T00:00:00Z", "bogus", "2024-06-15T12:30:00+00:00"
+    };
+    double out[3];
+    REQUIRE(TimeUtils::parse_iso8601_batch(in, out, 3) == 2);
+    REQUIRE(out[0] == 1577836800.0);
+    REQUIRE(std::isnan(out[1]));
+    REQUIRE(out[2] == TimeUtils::parse_iso8601("2024-06-15T12:30:00Z"));
+}
+
+TEST_CASE("TimeUtils roundtrip across centuries", "[time_utils]") {
+    // Every ~3.7 days from 1901 to 2100, plus odd seconds, round-trips through to_iso8601
+    for (double t = -2145916800.0; t < 4102444800.0; t += 321987.0) {
+        std::string s = TimeUtils::to_iso8601(t);
+        REQUIRE(TimeUtils::parse_iso8601(s) == t);
+    }
+}